@@ -223,7 +223,7 @@ void ImportContext::gatherMeshes()
 }
 
 
-void ImportContext::gatherSamples(double time, nvc::InputGeomCache *igc)
+nvc::GeomCacheData ImportContext::gatherSample(double time)
 {
     aiContextUpdateSamples(m_ctx, time);
 
@@ -311,6 +311,12 @@ void ImportContext::gatherSamples(double time, nvc::InputGeomCache *igc)
     odata.meshes = m_geomeshes.data();
     odata.submeshCount = m_geosubmeshes.size();
     odata.submeshes = m_geosubmeshes.data();
+    return odata;
+}
+
+void ImportContext::gatherSamples(double time, nvc::InputGeomCache *igc)
+{
+    const auto odata = gatherSample(time);
     nvcIGCAddData(igc, (float)time, &odata);
 }
 
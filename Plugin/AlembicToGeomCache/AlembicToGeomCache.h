@@ -48,6 +48,9 @@ public:
     void gatherTimes();
     void gatherMeshes();
     InputGeomCache* gatherSamples();
+    // reads the sample at time, the returned data points into the context's buffers until the next call
+    nvc::GeomCacheData gatherSample(double time);
+    const InputGeomCacheConstantData* getConstantData() const { return m_igcconst; }
 
 private:
     void gatherMeshes(aiObject *obj);
@@ -1,5 +1,7 @@
 #include "Plugin/PrecompiledHeader.h"
 #include "./AlembicToGeomCache.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
 
 nvcabcAPI nvc::InputGeomCache* nvcabcAlembicToInputGeomCache(const char *path_to_abc, const nvcabc::ImportOptions& options)
 {
@@ -10,6 +12,9 @@ nvcabcAPI nvc::InputGeomCache* nvcabcAlembicToInputGeomCache(const char *path_to
     ic.gatherTimes();
     ic.gatherMeshes();
     auto ret = ic.gatherSamples();
+    if (ret && options.optimize_vertex_order) {
+        nvcIGCOptimizeVertexOrder(ret);
+    }
     return ret;
 }
 
@@ -30,21 +35,112 @@ nvcabcAPI int nvcabcOpen(nvcabc::ImportContext *self, const char *path_to_abc, c
     return false;
 }
 
+namespace {
+
+nvc::QuantisationSettings getQuantisationSettings(const nvcabc::ExportOptions& options)
+{
+    nvc::QuantisationSettings settings;
+    settings.PointBits = (uint32_t)options.point_bits;
+    settings.VelocityBits = (uint32_t)options.velocity_bits;
+    settings.NormalBits = (uint32_t)options.normal_bits;
+    settings.TangentBits = (uint32_t)options.tangent_bits;
+    settings.UVBits = (uint32_t)options.uv_bits;
+    settings.PointTolerance = options.point_tolerance;
+    settings.BoundsBlockSize = (uint32_t)std::max(options.bounds_block_size, 0);
+    return settings;
+}
+
+nvcabc::AttributeError toAttributeError(const nvc::QuantisationError& error)
+{
+    nvcabc::AttributeError ret;
+    ret.bits = (int)error.Bits;
+    ret.max_error = error.MaxError;
+    ret.rms_error = error.RmsError;
+    return ret;
+}
+
+void toExportReport(const nvc::QuantisationReport& qr, nvcabc::ExportReport* report)
+{
+    if (report) {
+        report->points = toAttributeError(qr.Points);
+        report->velocities = toAttributeError(qr.Velocities);
+        report->normals = toAttributeError(qr.Normals);
+        report->tangents = toAttributeError(qr.Tangents);
+        report->uv0 = toAttributeError(qr.UV0);
+        report->uv1 = toAttributeError(qr.UV1);
+    }
+}
+
+// compress the samples one at a time as they're read (see nvcabc::ExportOptions::stream_frames)
+bool exportStreamed(nvcabc::ImportContext& ctx, const char* path_to_nvc, const nvcabc::ExportOptions& options, nvc::QuantisationReport& qr)
+{
+    using namespace nvc;
+
+    // the attributes kept, and where they are in the context's
+    std::vector<nvc::GeomCacheDesc> descs;
+    std::vector<size_t> attributes;
+    for (size_t i = 0; ctx.m_descs[i].semantic != nullptr; ++i) {
+        const char* semantic = ctx.m_descs[i].semantic;
+        if ((options.omit_normals && strcmp(semantic, nvcSEMANTIC_NORMALS) == 0)
+            || (options.omit_tangents && strcmp(semantic, nvcSEMANTIC_TANGENTS) == 0)) {
+            continue;
+        }
+        descs.push_back(ctx.m_descs[i]);
+        attributes.push_back(i);
+    }
+    descs.push_back(GEOM_CACHE_DESCRIPTOR_END);
+
+    const auto settings = getQuantisationSettings(options);
+    auto qe = nvcQCBegin(path_to_nvc, descs.data(), ctx.getConstantData(), (int)ctx.m_timesamples.size(), &settings);
+    if (!qe) {
+        return false;
+    }
+
+    void* vertices[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+    for (auto ts : ctx.m_timesamples) {
+        auto data = ctx.gatherSample(ts);
+        for (size_t i = 0; i < attributes.size(); ++i) {
+            vertices[i] = data.vertices[attributes[i]];
+        }
+        data.vertices = vertices;
+        nvcQCAddFrame(qe, (float)ts, &data);
+    }
+    return nvcQCFinish(qe, &qr) != 0;
+}
+
+} // namespace
+
 // convert and export to file
-nvcabcAPI int nvcabcExportNVC(nvcabc::ImportContext *self, const char *path_to_nvc, const nvcabc::ExportOptions* options)
+nvcabcAPI int nvcabcExportNVC(nvcabc::ImportContext *self, const char *path_to_nvc, const nvcabc::ExportOptions* options, nvcabc::ExportReport* report)
 {
-    if (self) {
-        //// Import -> output .nvc
-        //nvcabc::ImportOptions opt;
+    if (self && path_to_nvc && options) {
+        self->gatherTimes();
+        self->gatherMeshes();
+        if (options->stream_frames && options->compression_type == nvc::CompressionType::Quantize) {
+            nvc::QuantisationReport qr;
+            const bool ret = exportStreamed(*self, path_to_nvc, *options, qr);
+            toExportReport(qr, report);
+            return ret;
+        }
 
-        //const auto abcIgc = nvcabcAlembicToInputGeomCache(abcFilename, opt);
-        //assert(abcIgc);
+        auto igc = self->gatherSamples();
+        if (!igc) {
+            return false;
+        }
+        if (options->omit_normals) {
+            nvcIGCRemoveAttribute(igc, nvcSEMANTIC_NORMALS);
+        }
+        if (options->omit_tangents) {
+            nvcIGCRemoveAttribute(igc, nvcSEMANTIC_TANGENTS);
+        }
 
-        //nvc::FileStream fs{ nvcFilename, FileStream::OpenModes::Random_ReadWrite };
-        //nvc::Compressor nc{};
-        //nc.compress(*abcIgc, &fs);
+        const auto settings = getQuantisationSettings(*options);
+        nvc::QuantisationReport qr;
+        const int ret = nvcIGCExport(igc, path_to_nvc, options->compression_type, &settings, &qr);
+        nvcIGCRelease(igc);
 
-        //nvcIGCRelease(abcIgc);
+        toExportReport(qr, report);
+        return ret;
     }
     return false;
 }
@@ -62,6 +62,8 @@ struct ImportOptions
 
     // followings are extended options for nvcabc
     bool import_points = true;
+    // reorder triangles and vertices for the vertex cache (see InputGeomCache::optimizeVertexOrder())
+    bool optimize_vertex_order = false;
 };
 
 struct ExportOptions
@@ -69,6 +71,42 @@ struct ExportOptions
     // compression settings
     CompressionType compression_type = CompressionType::Quantize;
     int block_size = 30;
+
+    // quantisation precision in bits per component, 1 to 16 (see nvc::QuantisationSettings)
+    int point_bits = 16;
+    int velocity_bits = 16;
+    int normal_bits = 16;
+    int tangent_bits = 16;
+    int uv_bits = 16;
+    // if > 0, points get the fewest bits keeping them within this world space distance (point_bits is ignored)
+    float point_tolerance = 0.0f;
+    // points and velocities are quantised per mesh, or per block of this many vertices of a mesh if > 0
+    int bounds_block_size = 0;
+    // leave normals (and tangents) out of the file, nvc::GeomCache reconstructs them from the points when playing
+    // if the player enables it (nvcGCSetReconstruction())
+    bool omit_normals = false;
+    bool omit_tangents = false;
+    // with Quantize, compress each sample as it's read instead of gathering the whole sequence first. memory stays
+    // bounded by a seek window, but the file can't share the topology or the constant vertices of the sequence.
+    bool stream_frames = false;
+};
+
+// achieved quantisation error of an attribute over all frames (see nvc::QuantisationError)
+struct AttributeError
+{
+    int bits = 0; // 0 if the attribute isn't stored
+    float max_error = 0.0f;
+    float rms_error = 0.0f;
+};
+
+struct ExportReport
+{
+    AttributeError points;
+    AttributeError velocities;
+    AttributeError normals;
+    AttributeError tangents;
+    AttributeError uv0;
+    AttributeError uv1;
 };
 
 struct XformData
@@ -109,8 +147,9 @@ nvcabcAPI nvcabc::ImportContext* nvcabcCreateContext();
 nvcabcAPI void nvcabcReleaseContext(nvcabc::ImportContext *self);
 nvcabcAPI int nvcabcOpen(nvcabc::ImportContext *self, const char *path_to_abc, const nvcabc::ImportOptions* options);
 
-// convert and export to file
-nvcabcAPI int nvcabcExportNVC(nvcabc::ImportContext *self, const char *path_to_nvc, const nvcabc::ExportOptions* options);
+// convert and export to file, once per nvcabcOpen(). report (optional) receives the quantisation errors.
+// path_to_nvc has to name the compression type for the file to be reopened (see nvcIGCExport()).
+nvcabcAPI int nvcabcExportNVC(nvcabc::ImportContext *self, const char *path_to_nvc, const nvcabc::ExportOptions* options, nvcabc::ExportReport* report);
 
 nvcabcAPI int nvcabcGetNodeCount(nvcabc::ImportContext *self);
 nvcabcAPI const char* nvcabcGetNodeName(nvcabc::ImportContext *self, int i);
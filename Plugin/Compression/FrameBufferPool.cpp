@@ -0,0 +1,197 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "FrameBufferPool.h"
+
+namespace nvc
+{
+
+namespace
+{
+	void* alignedMalloc(size_t size)
+	{
+#if defined(_MSC_VER)
+		return _aligned_malloc(size, FrameBufferPool::Alignment);
+#else
+		void* block = nullptr;
+		if (posix_memalign(&block, FrameBufferPool::Alignment, size) != 0)
+		{
+			return nullptr;
+		}
+		return block;
+#endif
+	}
+
+	void alignedFree(void* block)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(block);
+#else
+		free(block);
+#endif
+	}
+
+	size_t alignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+	clear();
+}
+
+// Size classes are quarter steps between powers of two, so a recycled block wastes less than 25%.
+size_t FrameBufferPool::getBlockSize(size_t size)
+{
+	size = alignUp(__max(size, Alignment), Alignment);
+
+	size_t step = Alignment;
+	while ((step << 3) <= size)
+	{
+		step <<= 1;
+	}
+
+	return alignUp(size, step);
+}
+
+void* FrameBufferPool::allocate(size_t size)
+{
+	const size_t blockSize = getBlockSize(size);
+
+	{
+		spin_mutex::lock_t lock(m_Mutex);
+
+		auto it = m_FreeBlocks.find(blockSize);
+		if (it != m_FreeBlocks.end() && !it->second.empty())
+		{
+			void* block = it->second.back();
+			it->second.pop_back();
+			m_PooledSize -= blockSize;
+			return block;
+		}
+
+		++m_HeapAllocationCount;
+	}
+
+	return alignedMalloc(blockSize);
+}
+
+void FrameBufferPool::deallocate(void* block, size_t size)
+{
+	if (block == nullptr)
+	{
+		return;
+	}
+
+	const size_t blockSize = getBlockSize(size);
+
+	{
+		spin_mutex::lock_t lock(m_Mutex);
+
+		if (m_PooledSize + blockSize <= m_MaxPooledSize)
+		{
+			// Growing the free lists touches the heap too.
+			auto it = m_FreeBlocks.find(blockSize);
+			if (it == m_FreeBlocks.end())
+			{
+				it = m_FreeBlocks.emplace(blockSize, std::vector<void*>()).first;
+				++m_HeapAllocationCount;
+			}
+			if (it->second.size() == it->second.capacity())
+			{
+				++m_HeapAllocationCount;
+			}
+
+			it->second.push_back(block);
+			m_PooledSize += blockSize;
+			return;
+		}
+	}
+
+	alignedFree(block);
+}
+
+void* FrameBufferPool::allocateFrame(GeomCacheData& data, const GeomCacheDesc* desc, size_t& blockSize)
+{
+	const size_t attributeCount = data.vertexCount > 0 ? getAttributeCount(desc) : 0;
+
+	// Layout: vertex pointer table, meshes, submeshes, indices, then one array per attribute.
+	size_t attributeOffsets[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	size_t size = sizeof(void*) * attributeCount;
+
+	size = alignUp(size, Alignment);
+	const size_t meshesOffset = size;
+	size += sizeof(GeomMesh) * data.meshCount;
+
+	size = alignUp(size, Alignment);
+	const size_t submeshesOffset = size;
+	size += sizeof(GeomSubmesh) * data.submeshCount;
+
+	size = alignUp(size, Alignment);
+	const size_t indicesOffset = size;
+	size += sizeof(int32_t) * data.indexCount;
+
+	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	{
+		size = alignUp(size, Alignment);
+		attributeOffsets[iAttribute] = size;
+		size += getSizeOfDataFormat(desc[iAttribute].format) * data.vertexCount;
+	}
+
+	blockSize = size;
+	uint8_t* block = static_cast<uint8_t*>(allocate(size));
+	if (block == nullptr)
+	{
+		blockSize = 0;
+		return nullptr;
+	}
+
+	data.meshes = reinterpret_cast<GeomMesh*>(block + meshesOffset);
+	data.submeshes = reinterpret_cast<GeomSubmesh*>(block + submeshesOffset);
+	data.indices = data.indexCount > 0 ? block + indicesOffset : nullptr;
+	data.vertices = nullptr;
+
+	if (attributeCount > 0)
+	{
+		data.vertices = reinterpret_cast<void**>(block);
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			data.vertices[iAttribute] = block + attributeOffsets[iAttribute];
+		}
+	}
+
+	return block;
+}
+
+void FrameBufferPool::clear()
+{
+	spin_mutex::lock_t lock(m_Mutex);
+
+	for (auto& freeBlocks : m_FreeBlocks)
+	{
+		for (void* block : freeBlocks.second)
+		{
+			alignedFree(block);
+		}
+	}
+
+	m_FreeBlocks.clear();
+	m_PooledSize = 0;
+}
+
+size_t FrameBufferPool::getPooledSize() const
+{
+	spin_mutex::lock_t lock(m_Mutex);
+	return m_PooledSize;
+}
+
+size_t FrameBufferPool::getHeapAllocationCount() const
+{
+	spin_mutex::lock_t lock(m_Mutex);
+	return m_HeapAllocationCount;
+}
+
+} // namespace nvc
@@ -0,0 +1,57 @@
+#pragma once
+
+//! Project Includes.
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/Foundation/Concurrency.h"
+
+namespace nvc
+{
+
+// Recycles the memory of decoded frames.
+// A frame is a single block holding all of its arrays, freed blocks are kept per size class and handed
+// out again for the next frame of similar size, so steady state playback doesn't touch the heap.
+class FrameBufferPool final
+{
+public:
+	static constexpr size_t Alignment = 64;
+	static constexpr size_t DefaultMaxPooledSize = 64 * 1024 * 1024;
+
+private:
+	std::map<size_t, std::vector<void*>> m_FreeBlocks; // Size class => free blocks.
+	size_t m_PooledSize = 0;
+	size_t m_MaxPooledSize = DefaultMaxPooledSize;
+	size_t m_HeapAllocationCount = 0;
+
+	mutable spin_mutex m_Mutex;
+
+public:
+	FrameBufferPool() = default;
+	~FrameBufferPool();
+
+	// Blocks are Alignment aligned, size is rounded up to its size class.
+	void* allocate(size_t size);
+	void deallocate(void* block, size_t size);
+
+	// Allocates one block holding every array of a frame and points data at it, each array Alignment aligned.
+	// The counts of data must be set, attribute formats come from desc. Returns the block, its size in blockSize.
+	void* allocateFrame(GeomCacheData& data, const GeomCacheDesc* desc, size_t& blockSize);
+
+	// Releases the free blocks. Blocks in use stay valid.
+	void clear();
+
+	// Free blocks above this size are returned to the heap.
+	void setMaxPooledSize(size_t bytes) { m_MaxPooledSize = bytes; }
+	size_t getPooledSize() const;
+	// Heap allocations of blocks and of the free lists.
+	size_t getHeapAllocationCount() const;
+
+	static size_t getBlockSize(size_t size);
+
+	//...
+	FrameBufferPool(const FrameBufferPool&) = delete;
+	FrameBufferPool(FrameBufferPool&&) = delete;
+	FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+	FrameBufferPool& operator=(FrameBufferPool&&) = delete;
+};
+
+} // namespace nvc
@@ -0,0 +1,189 @@
+#pragma once
+
+//! Local Includes.
+#include "IDecompressor.h"
+
+namespace nvc
+{
+
+// Decoded frames of a decompressor: one slot per frame, the least recently used list of the frames counted
+// against the cache budget and the pinned range around the playhead, which is never evicted.
+// FrameDataType has a Size (bytes counted against the budget, frames of size 0 aren't listed) and the
+// LruPrev/LruNext links (frame indices).
+// Not thread safe, decompressors guard it with their loaded frames mutex.
+template <typename FrameDataType>
+class FrameSlotCache final
+{
+private:
+	// A slot is valid where m_IsFrameLoaded is set.
+	std::vector<FrameDataType> m_FrameSlots;
+	std::vector<bool> m_IsFrameLoaded;
+
+	// Frames unloaded by evict() for the caller to free, room for every frame is reserved so eviction
+	// doesn't touch the heap.
+	std::vector<FrameDataType> m_EvictedFrames;
+
+	size_t m_CacheBudget = DefaultFrameCacheBudget;
+	size_t m_CacheSize = 0;
+	size_t m_LruHead = InvalidFrameIndex; // Most recently used.
+	size_t m_LruTail = InvalidFrameIndex; // Least recently used, evicted first.
+	size_t m_PinnedFrame = 0;
+	size_t m_PinnedRange = 0;
+	size_t m_HeapAllocationCount = 0;
+
+public:
+	FrameSlotCache() = default;
+
+	// Every frame starts unloaded.
+	void resize(size_t frameCount)
+	{
+		m_HeapAllocationCount += frameCount > m_FrameSlots.capacity() ? 1 : 0;
+		m_HeapAllocationCount += frameCount > m_IsFrameLoaded.capacity() ? 1 : 0;
+		m_HeapAllocationCount += frameCount > m_EvictedFrames.capacity() ? 1 : 0;
+
+		m_FrameSlots.resize(frameCount);
+		m_IsFrameLoaded.resize(frameCount, false);
+		m_EvictedFrames.reserve(frameCount);
+	}
+
+	// Forgets every frame, the caller frees the loaded ones first. The budget stays.
+	void clear()
+	{
+		m_FrameSlots.clear();
+		m_IsFrameLoaded.clear();
+		m_EvictedFrames.clear();
+		m_CacheSize = 0;
+		m_LruHead = InvalidFrameIndex;
+		m_LruTail = InvalidFrameIndex;
+		m_PinnedFrame = 0;
+		m_PinnedRange = 0;
+	}
+
+	size_t getFrameCount() const { return m_FrameSlots.size(); }
+	bool isLoaded(size_t frameIndex) const { return m_IsFrameLoaded[frameIndex]; }
+	FrameDataType& operator[](size_t frameIndex) { return m_FrameSlots[frameIndex]; }
+	const FrameDataType& operator[](size_t frameIndex) const { return m_FrameSlots[frameIndex]; }
+
+	// Loads a frame into its slot as the most recently used one.
+	void insert(size_t frameIndex, const FrameDataType& data)
+	{
+		m_FrameSlots[frameIndex] = data;
+		m_IsFrameLoaded[frameIndex] = true;
+
+		if (data.Size > 0)
+		{
+			m_CacheSize += data.Size;
+			link(frameIndex);
+		}
+	}
+
+	// Moves a loaded frame to the front of the LRU list.
+	void touch(size_t frameIndex)
+	{
+		if (m_FrameSlots[frameIndex].Size > 0 && m_LruHead != frameIndex)
+		{
+			unlink(frameIndex);
+			link(frameIndex);
+		}
+	}
+
+	// Unloads least recently used frames until the cache fits its budget, they're appended to
+	// getEvictedFrames() for the caller to free. The playhead window stays, and so does the most recently
+	// used frame, even if it alone exceeds the budget.
+	void evict()
+	{
+		size_t iFrame = m_LruTail;
+		while (m_CacheBudget > 0 && m_CacheSize > m_CacheBudget && iFrame != m_LruHead)
+		{
+			const size_t prevFrame = m_FrameSlots[iFrame].LruPrev;
+
+			if (!isPinned(iFrame))
+			{
+				unlink(iFrame);
+				m_CacheSize -= m_FrameSlots[iFrame].Size;
+				m_IsFrameLoaded[iFrame] = false;
+				if (m_EvictedFrames.size() == m_EvictedFrames.capacity())
+				{
+					++m_HeapAllocationCount;
+				}
+				m_EvictedFrames.push_back(m_FrameSlots[iFrame]);
+				m_FrameSlots[iFrame] = FrameDataType{};
+			}
+
+			iFrame = prevFrame;
+		}
+	}
+
+	// The caller clears it once the frames are freed.
+	std::vector<FrameDataType>& getEvictedFrames() { return m_EvictedFrames; }
+
+	void setBudget(size_t bytes) { m_CacheBudget = bytes; }
+	size_t getBudget() const { return m_CacheBudget; }
+	size_t getSize() const { return m_CacheSize; }
+
+	// Heap allocations of the slots and of the evicted frames list, the frames themselves aren't counted.
+	size_t getHeapAllocationCount() const { return m_HeapAllocationCount; }
+
+	void setPinnedRange(size_t frameIndex, size_t range)
+	{
+		m_PinnedFrame = frameIndex;
+		m_PinnedRange = range;
+	}
+
+	bool isPinned(size_t frameIndex) const
+	{
+		return frameIndex >= m_PinnedFrame && frameIndex - m_PinnedFrame < m_PinnedRange;
+	}
+
+	//...
+	FrameSlotCache(const FrameSlotCache&) = delete;
+	FrameSlotCache(FrameSlotCache&&) = delete;
+	FrameSlotCache& operator=(const FrameSlotCache&) = delete;
+	FrameSlotCache& operator=(FrameSlotCache&&) = delete;
+
+private:
+	void link(size_t frameIndex)
+	{
+		FrameDataType& frame = m_FrameSlots[frameIndex];
+		frame.LruPrev = InvalidFrameIndex;
+		frame.LruNext = m_LruHead;
+
+		if (m_LruHead != InvalidFrameIndex)
+		{
+			m_FrameSlots[m_LruHead].LruPrev = frameIndex;
+		}
+		else
+		{
+			m_LruTail = frameIndex;
+		}
+		m_LruHead = frameIndex;
+	}
+
+	void unlink(size_t frameIndex)
+	{
+		FrameDataType& frame = m_FrameSlots[frameIndex];
+
+		if (frame.LruPrev != InvalidFrameIndex)
+		{
+			m_FrameSlots[frame.LruPrev].LruNext = frame.LruNext;
+		}
+		else
+		{
+			m_LruHead = frame.LruNext;
+		}
+
+		if (frame.LruNext != InvalidFrameIndex)
+		{
+			m_FrameSlots[frame.LruNext].LruPrev = frame.LruPrev;
+		}
+		else
+		{
+			m_LruTail = frame.LruPrev;
+		}
+
+		frame.LruPrev = InvalidFrameIndex;
+		frame.LruNext = InvalidFrameIndex;
+	}
+};
+
+} // namespace nvc
@@ -0,0 +1,186 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "FrameTopology.h"
+
+//! Project Includes.
+#include "FrameBufferPool.h"
+#include "IndexCoding.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/Stream/Stream.h"
+
+namespace nvc
+{
+
+bool hasSameTopology(const GeomCacheData& lhs, const GeomCacheData& rhs)
+{
+	if (lhs.meshCount != rhs.meshCount
+		|| lhs.submeshCount != rhs.submeshCount
+		|| lhs.indexCount != rhs.indexCount)
+	{
+		return false;
+	}
+
+	return (lhs.meshCount == 0 || memcmp(lhs.meshes, rhs.meshes, sizeof(GeomMesh) * lhs.meshCount) == 0)
+		&& (lhs.submeshCount == 0 || memcmp(lhs.submeshes, rhs.submeshes, sizeof(GeomSubmesh) * lhs.submeshCount) == 0)
+		&& (lhs.indexCount == 0 || memcmp(lhs.indices, rhs.indices, sizeof(int32_t) * lhs.indexCount) == 0);
+}
+
+bool isTopologyConstant(const InputGeomCache& geomCache)
+{
+	const size_t frameCount = geomCache.getDataCount();
+	if (frameCount < 2)
+	{
+		return false;
+	}
+
+	float time = 0.0f;
+	GeomCacheData firstFrameData{};
+	geomCache.getData(0, time, &firstFrameData);
+
+	for (size_t iFrame = 1; iFrame < frameCount; ++iFrame)
+	{
+		GeomCacheData frameData{};
+		geomCache.getData(iFrame, time, &frameData);
+		if (!hasSameTopology(firstFrameData, frameData))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void writeTopology(Stream* pStream, const GeomCacheData& data, bool isIndexCoded)
+{
+	pStream->write<uint64_t>(data.meshCount);
+	pStream->write(data.meshes, sizeof(GeomMesh) * data.meshCount);
+
+	pStream->write<uint64_t>(data.submeshCount);
+	pStream->write(data.submeshes, sizeof(GeomSubmesh) * data.submeshCount);
+
+	if (isIndexCoded)
+	{
+		const bool isTriangleList = std::all_of(data.submeshes, data.submeshes + data.submeshCount
+			, [](const GeomSubmesh& submesh) { return submesh.topology == Topology::Triangles; });
+
+		std::vector<uint8_t> encoded;
+		encodeIndices(static_cast<const int32_t*>(data.indices), data.indices ? data.indexCount : 0, isTriangleList, encoded);
+		pStream->write<uint32_t>(static_cast<uint32_t>(encoded.size()));
+		pStream->write(encoded.data(), encoded.size());
+	}
+	else if (data.indices)
+	{
+		pStream->write(data.indices, sizeof(int32_t) * data.indexCount);
+	}
+}
+
+void* readTopology(Stream* pStream, FrameBufferPool& pool, size_t indexCount, bool isIndexCoded, GeomCacheData& data, size_t& blockSize)
+{
+	// The submesh count follows the meshes, peek at it so the topology fits in one block.
+	GeomCacheData topology{};
+	topology.indexCount = indexCount;
+	topology.meshCount = pStream->read<uint64_t>();
+	const size_t meshesOffset = pStream->getPosition();
+	pStream->seek(sizeof(GeomMesh) * topology.meshCount, Stream::SeekOrigin::Current);
+	topology.submeshCount = pStream->read<uint64_t>();
+	pStream->seek(meshesOffset, Stream::SeekOrigin::Begin);
+
+	void* block = pool.allocateFrame(topology, nullptr, blockSize);
+	if (block == nullptr)
+	{
+		pStream->seek(meshesOffset - sizeof(uint64_t), Stream::SeekOrigin::Begin);
+		skipTopology(pStream, indexCount, isIndexCoded);
+		return nullptr;
+	}
+
+	pStream->read(topology.meshes, sizeof(GeomMesh) * topology.meshCount);
+	pStream->seek(sizeof(uint64_t), Stream::SeekOrigin::Current);
+	pStream->read(topology.submeshes, sizeof(GeomSubmesh) * topology.submeshCount);
+	readIndices(pStream, indexCount, isIndexCoded, static_cast<int32_t*>(topology.indices));
+
+	data.indices = topology.indices;
+	data.indexCount = topology.indexCount;
+	data.meshes = topology.meshes;
+	data.meshCount = topology.meshCount;
+	data.submeshes = topology.submeshes;
+	data.submeshCount = topology.submeshCount;
+	return block;
+}
+
+void skipTopology(Stream* pStream, size_t indexCount, bool isIndexCoded)
+{
+	const uint64_t meshCount = pStream->read<uint64_t>();
+	pStream->seek(sizeof(GeomMesh) * meshCount, Stream::SeekOrigin::Current);
+
+	const uint64_t submeshCount = pStream->read<uint64_t>();
+	pStream->seek(sizeof(GeomSubmesh) * submeshCount, Stream::SeekOrigin::Current);
+
+	const size_t indicesSize = isIndexCoded ? pStream->read<uint32_t>() : sizeof(int32_t) * indexCount;
+	pStream->seek(indicesSize, Stream::SeekOrigin::Current);
+}
+
+void readIndices(Stream* pStream, size_t indexCount, bool isIndexCoded, int32_t* indices)
+{
+	if (!isIndexCoded)
+	{
+		if (indexCount > 0)
+		{
+			pStream->read(indices, sizeof(int32_t) * indexCount);
+		}
+		return;
+	}
+
+	std::vector<uint8_t> encoded(pStream->read<uint32_t>());
+	if (!encoded.empty())
+	{
+		pStream->read(encoded.data(), encoded.size());
+	}
+	if (indexCount > 0 && !decodeIndices(encoded.data(), encoded.size(), indices, indexCount))
+	{
+		memset(indices, 0, sizeof(int32_t) * indexCount);
+	}
+}
+
+void SharedTopologyTable::clear(FrameBufferPool& pool)
+{
+	for (auto& topology : m_Topologies)
+	{
+		pool.deallocate(topology.Block, topology.BlockSize);
+	}
+	m_Topologies.clear();
+}
+
+void SharedTopologyTable::set(size_t window, const GeomCacheData& data, void* block, size_t blockSize)
+{
+	assert(!isLoaded(window));
+
+	TopologyDataType& topology = m_Topologies[window];
+	topology.Data = data;
+	topology.Data.vertices = nullptr;
+	topology.Data.vertexCount = 0;
+	topology.Block = block;
+	topology.BlockSize = blockSize;
+	topology.RefCount = 1;
+}
+
+void SharedTopologyTable::acquire(size_t window)
+{
+	assert(isLoaded(window));
+	++m_Topologies[window].RefCount;
+}
+
+void SharedTopologyTable::release(size_t window, FrameBufferPool& pool)
+{
+	TopologyDataType& topology = m_Topologies[window];
+	assert(topology.RefCount > 0);
+
+	if (--topology.RefCount == 0)
+	{
+		pool.deallocate(topology.Block, topology.BlockSize);
+		topology = TopologyDataType{};
+	}
+}
+
+} // namespace nvc
@@ -0,0 +1,69 @@
+#pragma once
+
+//! Project Includes.
+#include "Plugin/GeomCacheData.h"
+
+class Stream;
+
+namespace nvc
+{
+
+class FrameBufferPool;
+class InputGeomCache;
+
+// Topology is the meshes, submeshes and indices of a frame (the index count comes from the frame header).
+// On disk: uint64 meshCount, GeomMesh[meshCount], uint64 submeshCount, GeomSubmesh[submeshCount], then the indices:
+// int32 indices[indexCount], or when the file codes its indices, uint32 size and the indices' coding (see IndexCoding.h).
+//
+// Compressors store it once for the whole file when it never changes (after the time table, preceded by
+// a uint64 index count), otherwise once per seek window (in the window's first frame) for the frames of
+// the window which share it. See FILE_FLAG_SHARED_TOPOLOGY and FRAME_FLAG_SHARED_TOPOLOGY.
+bool hasSameTopology(const GeomCacheData& lhs, const GeomCacheData& rhs);
+bool isTopologyConstant(const InputGeomCache& geomCache);
+void writeTopology(Stream* pStream, const GeomCacheData& data, bool isIndexCoded);
+
+// Reads a topology into a single pool block, only the topology members of data are written.
+void* readTopology(Stream* pStream, FrameBufferPool& pool, size_t indexCount, bool isIndexCoded, GeomCacheData& data, size_t& blockSize);
+void skipTopology(Stream* pStream, size_t indexCount, bool isIndexCoded);
+
+// Reads the indices ending a topology. Indices which don't decode are 0, so the triangles are degenerate.
+void readIndices(Stream* pStream, size_t indexCount, bool isIndexCoded, int32_t* indices);
+
+// Topologies shared by the frames of each seek window, reference counted by the frames using them.
+// A topology either owns a pool block or references memory owned by someone else (a stream mapping).
+class SharedTopologyTable final
+{
+private:
+	struct TopologyDataType
+	{
+		GeomCacheData Data;
+		void* Block;
+		size_t BlockSize;
+		uint32_t RefCount;
+	};
+
+	std::vector<TopologyDataType> m_Topologies;
+
+public:
+	SharedTopologyTable() = default;
+
+	void resize(size_t windowCount) { m_Topologies.resize(windowCount); }
+	void clear(FrameBufferPool& pool);
+
+	bool isLoaded(size_t window) const { return m_Topologies[window].RefCount > 0; }
+	const GeomCacheData& get(size_t window) const { return m_Topologies[window].Data; }
+
+	// Takes ownership of block (may be nullptr) with a reference held by the caller.
+	void set(size_t window, const GeomCacheData& data, void* block, size_t blockSize);
+
+	void acquire(size_t window);
+	void release(size_t window, FrameBufferPool& pool);
+
+	//...
+	SharedTopologyTable(const SharedTopologyTable&) = delete;
+	SharedTopologyTable(SharedTopologyTable&&) = delete;
+	SharedTopologyTable& operator=(const SharedTopologyTable&) = delete;
+	SharedTopologyTable& operator=(SharedTopologyTable&&) = delete;
+};
+
+} // namespace nvc
@@ -13,7 +13,8 @@ public:
 	ICompressor() = default;
 	virtual ~ICompressor() = default;
 
-	virtual void compress(const InputGeomCache& geomCache, Stream* pStream) = 0;
+	// False if pStream can't be written, nothing is written then, or if the compression fails.
+	virtual bool compress(const InputGeomCache& geomCache, Stream* pStream) = 0;
 
 	//...
 	ICompressor(const ICompressor&) = delete;
@@ -7,6 +7,9 @@ namespace nvc
 struct GeomCacheData;
 struct GeomCacheDesc;
 
+static constexpr size_t DefaultFrameCacheBudget = 512ull * 1024 * 1024;
+static constexpr size_t InvalidFrameIndex = ~size_t(0);
+
 class IDecompressor
 {
 public:
@@ -20,9 +23,24 @@ public:
 	virtual bool getData(size_t frameIndex, float& time, GeomCacheData& data) = 0;
 	virtual bool getData(float time, GeomCacheData& data) = 0;
 	virtual const GeomCacheDesc* getDescriptors() const = 0;
+
+	// Decode-on-assign: cached frames may keep attributes packed (in the descriptor format), this converts
+	// vertices [firstVertex, firstVertex + vertexCount) of attribute iAttribute of a frame returned by
+	// getData(frameIndex) into dst in one pass, as Float3 (points, velocities, normals), Float4 (tangents)
+	// or Float2 (uvs). Disjoint ranges of a frame may be decoded concurrently.
+	// Returns false if the attribute isn't packed, data.vertices[iAttribute] is then used as is.
+	virtual bool decodeAttribute(size_t frameIndex, const GeomCacheData& data, size_t iAttribute, size_t firstVertex, size_t vertexCount, void* dst) const = 0;
 	virtual size_t getConstantDataStringSize() const = 0;
 	virtual const char* getConstantDataString(size_t index) const = 0;
 
+	// Decoded frame cache.
+	// Least recently used frames are evicted once the decoded frames exceed the budget (0: unbounded).
+	// Frames in the pinned range (the playhead window) are never evicted, so the budget may be exceeded by it.
+	virtual void setCacheBudget(size_t bytes) = 0;
+	virtual size_t getCacheBudget() const = 0;
+	virtual size_t getCacheSize() const = 0;
+	virtual void setPinnedRange(size_t frameIndex, size_t range) = 0;
+
 	virtual float getFrameTime(size_t frameIndex) const = 0;
 	virtual size_t getFrameIndex(float time) const = 0;
 	virtual size_t getFrameCount() const = 0;
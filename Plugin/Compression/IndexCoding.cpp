@@ -0,0 +1,375 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "IndexCoding.h"
+
+namespace nvc
+{
+
+namespace
+{
+	static const uint32_t EdgeFifoSize = 16;
+	static const uint32_t VertexFifoSize = 2;
+
+	static const uint32_t NoSharedEdge = 3;
+	static const uint32_t VertexNext = 0;
+	static const uint32_t VertexExplicit = 3;
+
+	inline uint32_t zigzag(uint32_t delta)
+	{
+		return (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31);
+	}
+
+	inline uint32_t unzigzag(uint32_t value)
+	{
+		return (value >> 1) ^ (0u - (value & 1));
+	}
+
+	// Differences are taken modulo 2^32, any pair of indices round trips.
+	inline void appendDelta(std::vector<uint8_t>& encoded, int32_t value, int32_t reference)
+	{
+		uint32_t bits = zigzag(static_cast<uint32_t>(value) - static_cast<uint32_t>(reference));
+		while (bits >= 0x80)
+		{
+			encoded.push_back(static_cast<uint8_t>(bits | 0x80));
+			bits >>= 7;
+		}
+		encoded.push_back(static_cast<uint8_t>(bits));
+	}
+
+	inline bool consumeDelta(const uint8_t*& encoded, const uint8_t* encodedEnd, int32_t reference, int32_t& value)
+	{
+		uint32_t bits = 0;
+		for (uint32_t shift = 0; ; shift += 7)
+		{
+			if (encoded == encodedEnd || (shift == 28 && *encoded > 0x0F))
+			{
+				return false;
+			}
+			const uint8_t byte = *encoded++;
+			bits |= static_cast<uint32_t>(byte & 0x7F) << shift;
+			if (byte < 0x80)
+			{
+				break;
+			}
+		}
+		value = static_cast<int32_t>(static_cast<uint32_t>(reference) + unzigzag(bits));
+		return true;
+	}
+
+	// The FIFOs and the next vertex not referenced yet, updated the same way by the encoder and the decoder.
+	struct TriangleCodingState
+	{
+		int32_t Edges[EdgeFifoSize][2] = {};
+		uint32_t EdgeOffset = 0;
+		int32_t Vertices[VertexFifoSize] = {};
+		uint32_t VertexOffset = 0;
+		int64_t Next = 0;
+
+		// Entry 0 is the most recent.
+		const int32_t* getEdge(uint32_t entry) const { return Edges[(EdgeOffset - 1 - entry) % EdgeFifoSize]; }
+		int32_t getVertex(uint32_t entry) const { return Vertices[(VertexOffset - 1 - entry) % VertexFifoSize]; }
+
+		void pushEdge(int32_t a, int32_t b)
+		{
+			Edges[EdgeOffset % EdgeFifoSize][0] = a;
+			Edges[EdgeOffset % EdgeFifoSize][1] = b;
+			++EdgeOffset;
+		}
+
+		// Next and explicit vertices enter the vertex FIFO, FIFO vertices are already in it.
+		void pushVertex(int32_t v)
+		{
+			Vertices[VertexOffset % VertexFifoSize] = v;
+			++VertexOffset;
+			Next = std::max<int64_t>(Next, static_cast<int64_t>(v) + 1);
+		}
+
+		// The edges of triangle (a, b, c) reversed, as a neighbour with the same winding uses them.
+		void pushTriangleEdges(int32_t a, int32_t b, int32_t c)
+		{
+			pushEdge(b, a);
+			pushEdge(c, b);
+			pushEdge(a, c);
+		}
+	};
+
+	uint32_t getVertexCode(const TriangleCodingState& state, int32_t v)
+	{
+		if (v == state.Next)
+		{
+			return VertexNext;
+		}
+		for (uint32_t entry = 0; entry < VertexFifoSize; ++entry)
+		{
+			if (v == state.getVertex(entry))
+			{
+				return 1 + entry;
+			}
+		}
+		return VertexExplicit;
+	}
+
+	// Codes v and updates the state, appending its delta with reference if it's explicit.
+	uint32_t encodeVertex(TriangleCodingState& state, int32_t v, int32_t reference, std::vector<uint8_t>& deltas)
+	{
+		const uint32_t code = getVertexCode(state, v);
+		if (code == VertexExplicit)
+		{
+			appendDelta(deltas, v, reference);
+		}
+		if (code == VertexNext || code == VertexExplicit)
+		{
+			state.pushVertex(v);
+		}
+		return code;
+	}
+
+	inline bool decodeVertex(TriangleCodingState& state, uint32_t code, int32_t reference, const uint8_t*& encoded, const uint8_t* encodedEnd, int32_t& v)
+	{
+		if (code == VertexNext)
+		{
+			v = static_cast<int32_t>(state.Next);
+		}
+		else if (code == VertexExplicit)
+		{
+			if (!consumeDelta(encoded, encodedEnd, reference, v))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			v = state.getVertex(code - 1);
+			return true;
+		}
+		state.pushVertex(v);
+		return true;
+	}
+
+	void encodeTriangles(const int32_t* indices, size_t count, std::vector<uint8_t>& encoded)
+	{
+		TriangleCodingState state;
+		std::vector<uint8_t> deltas;
+		int32_t last = 0;
+
+		for (size_t i = 0; i < count; i += 3)
+		{
+			const int32_t a = indices[i];
+			const int32_t b = indices[i + 1];
+			const int32_t c = indices[i + 2];
+			deltas.clear();
+
+			// Rotation r puts the shared edge first: (a, b, c), (b, c, a) or (c, a, b).
+			uint32_t rotation = NoSharedEdge;
+			uint32_t edgeEntry = 0;
+			const int32_t rotated[5] = { a, b, c, a, b };
+			for (uint32_t r = 0; r < 3 && rotation == NoSharedEdge; ++r)
+			{
+				for (uint32_t entry = 0; entry < EdgeFifoSize; ++entry)
+				{
+					const int32_t* edge = state.getEdge(entry);
+					if (edge[0] == rotated[r] && edge[1] == rotated[r + 1])
+					{
+						rotation = r;
+						edgeEntry = entry;
+						break;
+					}
+				}
+			}
+
+			uint8_t code = 0;
+			if (rotation != NoSharedEdge)
+			{
+				const int32_t p = rotated[rotation];
+				const int32_t q = rotated[rotation + 1];
+				const int32_t r = rotated[rotation + 2];
+				const uint32_t vertexCode = encodeVertex(state, r, q, deltas);
+				code = static_cast<uint8_t>((rotation << 6) | (edgeEntry << 2) | vertexCode);
+
+				state.pushEdge(r, q);
+				state.pushEdge(p, r);
+			}
+			else
+			{
+				const uint32_t codeA = encodeVertex(state, a, last, deltas);
+				const uint32_t codeB = encodeVertex(state, b, a, deltas);
+				const uint32_t codeC = encodeVertex(state, c, b, deltas);
+				code = static_cast<uint8_t>((NoSharedEdge << 6) | (codeA << 4) | (codeB << 2) | codeC);
+
+				state.pushTriangleEdges(a, b, c);
+			}
+
+			encoded.push_back(code);
+			encoded.insert(encoded.end(), deltas.begin(), deltas.end());
+			last = c;
+		}
+	}
+
+	bool decodeTriangles(const uint8_t* encoded, const uint8_t* encodedEnd, int32_t* indices, size_t count)
+	{
+		TriangleCodingState state;
+		int32_t last = 0;
+
+		for (size_t i = 0; i < count; i += 3)
+		{
+			if (encoded == encodedEnd)
+			{
+				return false;
+			}
+			const uint32_t code = *encoded++;
+			const uint32_t rotation = code >> 6;
+
+			int32_t* triangle = indices + i;
+			if (rotation != NoSharedEdge)
+			{
+				const int32_t* edge = state.getEdge((code >> 2) & (EdgeFifoSize - 1));
+				const int32_t p = edge[0];
+				const int32_t q = edge[1];
+				int32_t r = 0;
+				if (!decodeVertex(state, code & 3, q, encoded, encodedEnd, r))
+				{
+					return false;
+				}
+
+				triangle[rotation] = p;
+				triangle[(rotation + 1) % 3] = q;
+				triangle[(rotation + 2) % 3] = r;
+
+				state.pushEdge(r, q);
+				state.pushEdge(p, r);
+			}
+			else
+			{
+				if (!decodeVertex(state, (code >> 4) & 3, last, encoded, encodedEnd, triangle[0])
+					|| !decodeVertex(state, (code >> 2) & 3, triangle[0], encoded, encodedEnd, triangle[1])
+					|| !decodeVertex(state, code & 3, triangle[1], encoded, encodedEnd, triangle[2]))
+				{
+					return false;
+				}
+
+				state.pushTriangleEdges(triangle[0], triangle[1], triangle[2]);
+			}
+			last = triangle[2];
+		}
+		return encoded == encodedEnd;
+	}
+}
+
+size_t encodeIndices(const int32_t* indices, size_t count, bool isTriangleList, std::vector<uint8_t>& encoded)
+{
+	IndexCodingMode mode = IndexCodingMode::Raw;
+	size_t size = sizeof(int32_t) * count;
+
+	const bool fitsUint16 = std::all_of(indices, indices + count, [](int32_t index) { return index >= 0 && index <= 0xFFFF; });
+	if (fitsUint16 && count > 0)
+	{
+		mode = IndexCodingMode::Uint16;
+		size = sizeof(uint16_t) * count;
+	}
+
+	std::vector<uint8_t> deltas;
+	int32_t previous = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		appendDelta(deltas, indices[i], previous);
+		previous = indices[i];
+	}
+	if (deltas.size() < size)
+	{
+		mode = IndexCodingMode::Deltas;
+		size = deltas.size();
+	}
+
+	std::vector<uint8_t> triangles;
+	if (isTriangleList && count % 3 == 0)
+	{
+		encodeTriangles(indices, count, triangles);
+		if (triangles.size() < size)
+		{
+			mode = IndexCodingMode::Triangles;
+			size = triangles.size();
+		}
+	}
+
+	const size_t start = encoded.size();
+	encoded.push_back(static_cast<uint8_t>(mode));
+	switch (mode)
+	{
+	case IndexCodingMode::Raw:
+		encoded.insert(encoded.end(), reinterpret_cast<const uint8_t*>(indices), reinterpret_cast<const uint8_t*>(indices + count));
+		break;
+	case IndexCodingMode::Uint16:
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint16_t index = static_cast<uint16_t>(indices[i]);
+			encoded.insert(encoded.end(), reinterpret_cast<const uint8_t*>(&index), reinterpret_cast<const uint8_t*>(&index + 1));
+		}
+		break;
+	case IndexCodingMode::Deltas:
+		encoded.insert(encoded.end(), deltas.begin(), deltas.end());
+		break;
+	case IndexCodingMode::Triangles:
+		encoded.insert(encoded.end(), triangles.begin(), triangles.end());
+		break;
+	}
+	return encoded.size() - start;
+}
+
+bool decodeIndices(const uint8_t* encoded, size_t encodedSize, int32_t* indices, size_t count)
+{
+	if (encodedSize == 0)
+	{
+		return false;
+	}
+	const uint8_t* encodedEnd = encoded + encodedSize;
+	const IndexCodingMode mode = static_cast<IndexCodingMode>(*encoded++);
+
+	switch (mode)
+	{
+	case IndexCodingMode::Raw:
+		if (static_cast<size_t>(encodedEnd - encoded) != sizeof(int32_t) * count)
+		{
+			return false;
+		}
+		if (count > 0)
+		{
+			memcpy(indices, encoded, sizeof(int32_t) * count);
+		}
+		return true;
+
+	case IndexCodingMode::Uint16:
+		if (static_cast<size_t>(encodedEnd - encoded) != sizeof(uint16_t) * count)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint16_t index = 0;
+			memcpy(&index, encoded + sizeof(uint16_t) * i, sizeof(index));
+			indices[i] = index;
+		}
+		return true;
+
+	case IndexCodingMode::Deltas:
+	{
+		int32_t previous = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!consumeDelta(encoded, encodedEnd, previous, indices[i]))
+			{
+				return false;
+			}
+			previous = indices[i];
+		}
+		return encoded == encodedEnd;
+	}
+
+	case IndexCodingMode::Triangles:
+		return count % 3 == 0 && decodeTriangles(encoded, encodedEnd, indices, count);
+	}
+	return false;
+}
+
+} // namespace nvc
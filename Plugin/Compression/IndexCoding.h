@@ -0,0 +1,37 @@
+#pragma once
+
+namespace nvc
+{
+
+// Lossless coding of index buffers, the indices decode in their original order. Stored as:
+//   uint8_t IndexCodingMode
+//   Raw:       int32_t indices[count]
+//   Uint16:    uint16_t indices[count], every index is in [0, 65536)
+//   Deltas:    each index as the zig-zag varint of its difference with the previous one
+//   Triangles: per triangle, a code byte followed by the zig-zag varints of its explicit vertices
+//
+// Triangles codes each triangle against a FIFO of the recent edges, in the direction a neighbour shares them,
+// and a FIFO of the recent vertices. The code byte is
+//   bits 7-6: rotation (0 to 2) of the triangle that puts the shared edge first, 3 if no edge is shared
+//   shared edge:    bits 5-2 its edge FIFO entry, bits 1-0 the third vertex's code
+//   no shared edge: bits 5-0 the codes of the 3 vertices, 2 bits each
+// A vertex code is 0 for the next vertex not referenced yet, 1 or 2 for the first or second vertex FIFO entry,
+// 3 for an explicit vertex. The explicit third vertex of a shared edge is relative to the edge's second vertex,
+// the others to the previous vertex.
+// On a mesh ordered for locality that's 1 to 2 bytes per triangle, against 12 for raw indices.
+enum class IndexCodingMode : uint8_t
+{
+	Raw,
+	Uint16,
+	Deltas,
+	Triangles,
+};
+
+// Appends the smallest coding of indices[count] to encoded and returns its size in bytes, which is never larger
+// than the raw indices plus the mode byte. Triangles is only tried for triangle lists.
+size_t encodeIndices(const int32_t* indices, size_t count, bool isTriangleList, std::vector<uint8_t>& encoded);
+
+// Returns false if encoded isn't the coding of count indices.
+bool decodeIndices(const uint8_t* encoded, size_t encodedSize, int32_t* indices, size_t count);
+
+} // namespace nvc
@@ -6,27 +6,42 @@
 
 //! Project Includes.
 #include "NullTypes.h"
+#include "FrameTopology.h"
 #include "Plugin/InputGeomCache.h"
 #include "Plugin/Stream/Stream.h"
 
 namespace nvc
 {
 
-void NullCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
+bool NullCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
 {
+	if (!pStream->canWrite())
+	{
+		return false;
+	}
+
 	GeomCacheDesc geomDesc[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
 	geomCache.getDesc(geomDesc);
 
 	InputGeomCacheConstantData geomConstantData {};
 	geomCache.getConstantData(geomConstantData);
 
+	// note: constant data is padded to 4 bytes, so the frames which follow stay aligned and
+	//       NullDecompressor can reference them in place. Readers stop at the last string anyway.
+	const size_t constantDataSize = geomConstantData.getSizeAsByteArray();
+	const size_t constantDataPadding = (sizeof(uint32_t) - (constantDataSize % sizeof(uint32_t))) % sizeof(uint32_t);
+
+	const bool isFileTopologyShared = isTopologyConstant(geomCache);
+
 	// Write header.
 	const null_compression::FileHeader header
 	{
 		static_cast<uint64_t>(geomCache.getDataCount()),
 		static_cast<uint32_t>(DefaultSeekWindow),
 		static_cast<uint32_t>(getAttributeCount(geomDesc)),
-		static_cast<uint32_t>(geomConstantData.getSizeAsByteArray())
+		static_cast<uint32_t>(constantDataSize + constantDataPadding),
+		null_compression::FILE_FLAG_FRAME_INDEX
+			| (isFileTopologyShared ? null_compression::FILE_FLAG_SHARED_TOPOLOGY : 0u)
 	};
 
 	pStream->write(header);
@@ -52,9 +67,18 @@ void NullCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
 		pStream->write(static_cast<uint64_t>(0));
 	}
 
+	// Same for the frame index.
+	const size_t frameIndexOffset = pStream->getPosition();
+	std::vector<null_compression::FrameIndexEntry> frameIndexValues(header.FrameCount, null_compression::FrameIndexEntry{});
+	pStream->write(frameIndexValues.data(), sizeof(null_compression::FrameIndexEntry) * frameIndexValues.size());
+
 	// Write constant data.
 	if(header.ConstantDataSize > 0) {
 		geomConstantData.storeDataTo(pStream);
+		for (size_t iPadding = 0; iPadding < constantDataPadding; ++iPadding)
+		{
+			pStream->write<uint8_t>(0);
+		}
 	}
 
 	// Write frames.
@@ -70,15 +94,31 @@ void NullCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
 		pStream->write(time);
 	}
 
+	// Write the topology shared by every frame. Indices stay raw, the decompressor maps them.
+	if (isFileTopologyShared)
+	{
+		float time = 0.0f;
+		GeomCacheData frameData{};
+		geomCache.getData(0, time, &frameData);
+
+		pStream->write<uint64_t>(frameData.indexCount);
+		writeTopology(pStream, frameData, false);
+	}
+
 	// Write frames.
 	const size_t attributeCount = getAttributeCount(geomDesc);
+	GeomCacheData windowTopology{};
+	bool hasWindowTopology = false;
 
 	for (uint64_t iFrame = 0; iFrame < header.FrameCount; ++iFrame)
 	{
-		if ((iFrame % header.FrameSeekWindowCount) == 0)
+		const bool isWindowStart = (iFrame % header.FrameSeekWindowCount) == 0;
+		if (isWindowStart)
 		{
 			frameSeekTableValues.push_back(pStream->getPosition());
+			hasWindowTopology = false;
 		}
+		frameIndexValues[iFrame].Offset = pStream->getPosition();
 
 		float time = 0.0f;
 		GeomCacheData frameData{};
@@ -88,25 +128,29 @@ void NullCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
 			continue; // Error?
 		}
 
+		// The first frame of a seek window always stores its topology, so the window stays decodable on its own.
+		const bool isTopologyShared = isFileTopologyShared
+			|| (hasWindowTopology && hasSameTopology(windowTopology, frameData));
+
 		const null_compression::FrameHeader frameHeader
 		{
 			static_cast<uint32_t>(frameData.indexCount),
 			static_cast<uint32_t>(frameData.vertexCount),
+			isTopologyShared ? null_compression::FRAME_FLAG_SHARED_TOPOLOGY : 0u
 		};
 
 		pStream->write(frameHeader);
 
-		// Write mesh and submesh data.
-		pStream->write<uint64_t>(frameData.meshCount);
-		pStream->write(frameData.meshes, sizeof(GeomMesh) * frameData.meshCount);
-
-        pStream->write<uint64_t>(frameData.submeshCount);
-        pStream->write(frameData.submeshes, sizeof(GeomSubmesh) * frameData.submeshCount);
+		// Write mesh, submesh and index data.
+		if (!isTopologyShared)
+		{
+			writeTopology(pStream, frameData, false);
+		}
 
-		// Write indices.
-		if (frameData.indices)
+		if (isWindowStart)
 		{
-			pStream->write(frameData.indices, sizeof(int) * frameData.indexCount);
+			windowTopology = frameData;
+			hasWindowTopology = true;
 		}
 
 		// Write vertices.
@@ -118,6 +162,8 @@ void NullCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
 				pStream->write(frameData.vertices[iAttribute], dataSize);
 			}
 		}
+
+		frameIndexValues[iFrame].Size = pStream->getPosition() - frameIndexValues[iFrame].Offset;
 	}
 
 	// Update the frame seek table with the real offsets.
@@ -126,6 +172,11 @@ void NullCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
 	{
 		pStream->write(frameSeekTableValues[iEntry]);
 	}
+
+	pStream->seek(frameIndexOffset, Stream::SeekOrigin::Begin);
+	pStream->write(frameIndexValues.data(), sizeof(null_compression::FrameIndexEntry) * frameIndexValues.size());
+
+	return true;
 }
 
 } //namespace nvc
@@ -15,7 +15,7 @@ public:
 	NullCompressor() = default;
 	~NullCompressor() = default;
 
-	void compress(const InputGeomCache& geomCache, Stream* pStream) override;
+	bool compress(const InputGeomCache& geomCache, Stream* pStream) override;
 
 	//...
 	NullCompressor(const NullCompressor&) = delete;
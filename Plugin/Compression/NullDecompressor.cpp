@@ -11,6 +11,36 @@
 namespace nvc
 {
 
+namespace
+{
+	template<typename TData>
+	bool readMapped(const Stream* pStream, size_t& offset, TData& d)
+	{
+		const void* p = pStream->view(offset, sizeof(TData));
+		if (p == nullptr)
+		{
+			return false;
+		}
+
+		memcpy(&d, p, sizeof(TData));
+		offset += sizeof(TData);
+		return true;
+	}
+
+	// Returns nullptr if the range is out of the stream or not aligned for direct access.
+	const void* viewMapped(const Stream* pStream, size_t& offset, size_t dataSize, size_t alignment)
+	{
+		const void* p = pStream->view(offset, dataSize);
+		offset += dataSize;
+
+		if (p != nullptr && (reinterpret_cast<uintptr_t>(p) % alignment) != 0)
+		{
+			return nullptr;
+		}
+		return p;
+	}
+}
+
 NullDecompressor::~NullDecompressor()
 {
 	close();
@@ -46,6 +76,13 @@ void NullDecompressor::open(Stream* pStream)
 		m_SeekTable.push_back(m_pStream->read<uint64_t>());
 	}
 
+	// Read the frame index.
+	if ((m_Header.Flags & null_compression::FILE_FLAG_FRAME_INDEX) != 0)
+	{
+		m_FrameIndex.resize(m_Header.FrameCount);
+		m_pStream->read(m_FrameIndex.data(), sizeof(null_compression::FrameIndexEntry) * m_FrameIndex.size());
+	}
+
 	// Read constant data
 	if(m_Header.ConstantDataSize > 0) {
 		m_ConstantData.resize(m_Header.ConstantDataSize);
@@ -58,43 +95,120 @@ void NullDecompressor::open(Stream* pStream)
 		m_FrameTimeTable.push_back(m_pStream->read<float>());
 	}
 
-	m_IsFrameLoaded.resize(m_Header.FrameCount, false);
+	m_LoadedFrames.resize(m_Header.FrameCount);
+
+	// Frame data of a read only stream with a view() can be referenced in place.
+	m_AttributeCount = getAttributeCount(m_Descriptor);
+	m_IsMapped = m_UseMappedFrames && !m_pStream->canWrite() && m_pStream->view(0, 0) != nullptr;
+	if (m_IsMapped)
+	{
+		m_MappedVertexPointers.resize(m_Header.FrameCount * m_AttributeCount, nullptr);
+	}
+
+	// Read the topology shared by every frame, or prepare for the per window ones.
+	if ((m_Header.Flags & null_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		const size_t indexCount = static_cast<size_t>(m_pStream->read<uint64_t>());
+		if (!m_IsMapped || !mapTopology(indexCount, m_FileTopology))
+		{
+			m_FileTopologyBlock = readTopology(m_pStream, m_FramePool, indexCount, false, m_FileTopology, m_FileTopologyBlockSize);
+			assert(m_FileTopologyBlock != nullptr);
+		}
+	}
+	else
+	{
+		m_WindowTopologies.resize(m_SeekTable.size());
+	}
 }
 
 void NullDecompressor::close()
 {
-	auto it = m_LoadedFrames.begin();
-	const auto itEnd = m_LoadedFrames.end();
-	while (it != itEnd)
+	for (size_t iFrame = 0; iFrame < m_LoadedFrames.getFrameCount(); ++iFrame)
 	{
-		freeFrame(*it);
-		++it;
+		if (m_LoadedFrames.isLoaded(iFrame))
+		{
+			freeFrame(m_LoadedFrames[iFrame]);
+		}
 	}
 
 	m_Header = {};
 	m_pStream = nullptr;
 	memset(m_Descriptor, 0, sizeof(m_Descriptor));
 	m_SeekTable.clear();
+	m_FrameIndex.clear();
 
 	m_LoadedFrames.clear();
-	m_IsFrameLoaded.clear();
 	m_FramesOffset = 0;
+
+	m_WindowTopologies.clear(m_FramePool);
+	m_FramePool.deallocate(m_FileTopologyBlock, m_FileTopologyBlockSize);
+	m_FileTopology = {};
+	m_FileTopologyBlock = nullptr;
+	m_FileTopologyBlockSize = 0;
+	m_WalkTopologyWindow = InvalidFrameIndex;
+
+	m_FramePool.clear();
+
+	m_IsMapped = false;
+	m_AttributeCount = 0;
+	m_MappedVertexPointers.clear();
 }
 
 void NullDecompressor::prefetch(size_t frameIndex, size_t range)
 {
-	const size_t frameSeekIndex = getSeekTableIndex(frameIndex);
-	const size_t startFrame = frameSeekIndex * m_Header.FrameSeekWindowCount;
-	const size_t frameToLoad = (frameIndex + range) - startFrame;
+	// The budget or pinned range may have changed since the last load.
+	evictFrames();
+
+	const size_t endFrame = std::min<size_t>(frameIndex + range, getFrameCount());
 
-	// Load the frames from the seek window until the end of the range specified.
-	m_pStream->seek(getSeekTableOffset(frameIndex), Stream::SeekOrigin::Begin);
-	for (size_t iFrame = startFrame; iFrame < startFrame + frameToLoad; ++iFrame)
+	// Start from the first frame which isn't resident yet.
+	size_t firstFrame = frameIndex;
+	while (firstFrame < endFrame && m_LoadedFrames.isLoaded(firstFrame))
 	{
-		loadFrame(iFrame);
+		++firstFrame;
+	}
 
-		//! TODO: Start an async job to preload after the current frame?...
+	if (firstFrame >= endFrame)
+	{
+		return;
 	}
+
+	if (!m_FrameIndex.empty())
+	{
+		// Every frame is addressable, only the missing ones are read.
+		for (size_t iFrame = firstFrame; iFrame < endFrame; ++iFrame)
+		{
+			if (!m_LoadedFrames.isLoaded(iFrame))
+			{
+				loadIndexedFrame(iFrame);
+			}
+		}
+	}
+	else
+	{
+		// Frames are only addressable at seek window starts, but they're stored back to back,
+		// so a range crossing window boundaries is loaded by reading on past the window end.
+		const size_t startFrame = getSeekTableIndex(firstFrame) * m_Header.FrameSeekWindowCount;
+		m_pStream->seek(getSeekTableOffset(firstFrame), Stream::SeekOrigin::Begin);
+		for (size_t iFrame = startFrame; iFrame < endFrame; ++iFrame)
+		{
+			null_compression::FrameHeader frameHeader{};
+			m_pStream->read(frameHeader);
+
+			const GeomCacheData* sharedTopology = loadSharedTopology(iFrame, frameHeader);
+			if (m_LoadedFrames.isLoaded(iFrame))
+			{
+				skipFrame(frameHeader, sharedTopology == nullptr
+					&& (frameHeader.Flags & null_compression::FRAME_FLAG_SHARED_TOPOLOGY) == 0);
+			}
+			else
+			{
+				loadFrame(iFrame, frameHeader, sharedTopology);
+			}
+		}
+	}
+
+	releaseWalkTopology();
 }
 
 bool NullDecompressor::getData(size_t frameIndex, float& time, GeomCacheData& data)
@@ -102,7 +216,17 @@ bool NullDecompressor::getData(size_t frameIndex, float& time, GeomCacheData& da
 	time = getFrameTime(frameIndex);
 	if (std::isfinite(time))
 	{
-		return getData(time, data);
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		if (!m_LoadedFrames.isLoaded(frameIndex))
+		{
+			return false;
+		}
+
+		// Move to the front of the LRU list.
+		m_LoadedFrames.touch(frameIndex);
+
+		data = m_LoadedFrames[frameIndex].Data;
+		return true;
 	}
 
 	return false;
@@ -110,22 +234,8 @@ bool NullDecompressor::getData(size_t frameIndex, float& time, GeomCacheData& da
 
 bool NullDecompressor::getData(float time, GeomCacheData& data)
 {
-	const auto it = std::lower_bound(
-		  m_LoadedFrames.begin()
-		, m_LoadedFrames.end()
-		, FrameDataType { time, GeomCacheData{} }
-		, [](const FrameDataType& lhs, const FrameDataType& rhs) -> bool {
-			return lhs.Time < rhs.Time;
-		}
-	);
-
-	if (it != m_LoadedFrames.end())
-	{
-		data = it->Data;
-		return true;
-	}
-
-	return false;
+	float frameTime = 0.0f;
+	return getData(getFrameIndex(time), frameTime, data);
 }
 
 size_t NullDecompressor::getConstantDataStringSize() const {
@@ -142,109 +252,404 @@ const char* NullDecompressor::getConstantDataString(size_t index) const {
 	return nullptr;
 }
 
-void NullDecompressor::loadFrame(size_t frameIndex)
+// Skips the rest of a frame, the stream is past its header (and its topology unless hasTopology).
+void NullDecompressor::skipFrame(const null_compression::FrameHeader& frameHeader, bool hasTopology)
+{
+	if (hasTopology)
+	{
+		skipTopology(m_pStream, frameHeader.IndexCount, false);
+	}
+
+	size_t dataSize = 0;
+	if (frameHeader.VertexCount > 0)
+	{
+		const size_t attributeCount = getAttributeCount(m_Descriptor);
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			dataSize += getSizeOfDataFormat(m_Descriptor[iAttribute].format) * frameHeader.VertexCount;
+		}
+	}
+
+	m_pStream->seek(dataSize, Stream::SeekOrigin::Current);
+}
+
+// Reads a single frame through the frame index. A frame sharing its window topology which isn't
+// resident reads it from the window's first frame beforehand.
+void NullDecompressor::loadIndexedFrame(size_t frameIndex)
 {
+	const null_compression::FrameIndexEntry& entry = m_FrameIndex[frameIndex];
+	if (entry.Size == 0)
+	{
+		return;
+	}
+
 	null_compression::FrameHeader frameHeader{};
+	m_pStream->seek(entry.Offset, Stream::SeekOrigin::Begin);
 	m_pStream->read(frameHeader);
 
+	const GeomCacheData* sharedTopology = loadSharedTopology(frameIndex, frameHeader);
+	if (sharedTopology == nullptr && (frameHeader.Flags & null_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		const size_t windowStart = getSeekTableIndex(frameIndex) * m_Header.FrameSeekWindowCount;
+
+		null_compression::FrameHeader windowHeader{};
+		m_pStream->seek(m_FrameIndex[windowStart].Offset, Stream::SeekOrigin::Begin);
+		m_pStream->read(windowHeader);
+		sharedTopology = loadSharedTopology(windowStart, windowHeader);
+
+		m_pStream->seek(entry.Offset + sizeof(frameHeader), Stream::SeekOrigin::Begin);
+	}
+
+	loadFrame(frameIndex, frameHeader, sharedTopology);
+}
+
+// The stream is past the frame header, and past the topology if sharedTopology comes from loadSharedTopology().
+void NullDecompressor::loadFrame(size_t frameIndex, const null_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology)
+{
+	const bool hasTopology = sharedTopology == nullptr;
+	if (hasTopology && (frameHeader.Flags & null_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		// The window topology couldn't be loaded.
+		skipFrame(frameHeader, false);
+		return;
+	}
+
+	if (m_IsMapped && loadMappedFrame(frameIndex, frameHeader, sharedTopology))
+	{
+		return;
+	}
+
+	const size_t frameOffset = m_pStream->getPosition();
 
 	FrameDataType frameData{};
 	frameData.Time = m_FrameTimeTable[frameIndex];
-	frameData.Data.indexCount = frameHeader.IndexCount;
 	frameData.Data.vertexCount = frameHeader.VertexCount;
 
-	frameData.Data.meshCount = m_pStream->read<uint64_t>();
-	frameData.Data.meshes = new GeomMesh[frameData.Data.meshCount];
-	for (size_t iMesh = 0; iMesh < frameData.Data.meshCount; ++iMesh)
+	if (hasTopology)
 	{
-		m_pStream->read(frameData.Data.meshes[iMesh]);
+		// The submesh count follows the meshes, peek at it so the whole frame fits in one block.
+		frameData.Data.indexCount = frameHeader.IndexCount;
+		frameData.Data.meshCount = m_pStream->read<uint64_t>();
+		const size_t meshesOffset = m_pStream->getPosition();
+		m_pStream->seek(sizeof(GeomMesh) * frameData.Data.meshCount, Stream::SeekOrigin::Current);
+		frameData.Data.submeshCount = m_pStream->read<uint64_t>();
+		m_pStream->seek(meshesOffset, Stream::SeekOrigin::Begin);
 	}
 
-    frameData.Data.submeshCount = m_pStream->read<uint64_t>();
-    frameData.Data.submeshes = new GeomSubmesh[frameData.Data.submeshCount];
-    for (size_t iSubmesh = 0; iSubmesh < frameData.Data.submeshCount; ++iSubmesh)
-    {
-        m_pStream->read(frameData.Data.submeshes[iSubmesh]);
-    }
+	frameData.Block = m_FramePool.allocateFrame(frameData.Data, m_Descriptor, frameData.BlockSize);
+	if (frameData.Block == nullptr)
+	{
+		m_pStream->seek(frameOffset, Stream::SeekOrigin::Begin);
+		skipFrame(frameHeader, hasTopology);
+		return;
+	}
 
-	if (frameHeader.IndexCount > 0)
+	if (hasTopology)
 	{
-		const size_t dataSize = sizeof(int) * frameHeader.IndexCount;
+		m_pStream->read(frameData.Data.meshes, sizeof(GeomMesh) * frameData.Data.meshCount);
+		m_pStream->seek(sizeof(uint64_t), Stream::SeekOrigin::Current);
+		m_pStream->read(frameData.Data.submeshes, sizeof(GeomSubmesh) * frameData.Data.submeshCount);
 
-		void *indices = malloc(dataSize);
-		if (indices != nullptr)
+		if (frameHeader.IndexCount > 0)
 		{
-			m_pStream->read(indices, dataSize);
+			m_pStream->read(frameData.Data.indices, sizeof(int) * frameHeader.IndexCount);
 		}
-		else
+	}
+	else
+	{
+		useSharedTopology(frameIndex, *sharedTopology, frameData);
+	}
+
+	if (frameHeader.VertexCount > 0)
+	{
+		const size_t attributeCount = getAttributeCount(m_Descriptor);
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
 		{
-			m_pStream->seek(dataSize, Stream::SeekOrigin::Current);
+			const size_t dataSize = getSizeOfDataFormat(m_Descriptor[iAttribute].format) * frameData.Data.vertexCount;
+			m_pStream->read(frameData.Data.vertices[iAttribute], dataSize);
 		}
+	}
+
+	if (!insertLoadedData(frameIndex, frameData))
+	{
+		freeFrame(frameData);
+	}
+}
+
+// The on-disk frame layout is exactly what GeomCacheData describes, so instead of allocating and
+// copying each array, point the frame at the stream mapping. Nothing is allocated here: the vertex
+// pointer table lives in m_MappedVertexPointers, and the OS page cache acts as the frame cache.
+// Returns false (without moving the stream) if the frame can't be referenced in place.
+bool NullDecompressor::loadMappedFrame(size_t frameIndex, const null_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology)
+{
+	const size_t frameOffset = m_pStream->getPosition();
 
-		frameData.Data.indices = indices;
+	GeomCacheData topology{};
+	if (sharedTopology == nullptr && !mapTopology(frameHeader.IndexCount, topology))
+	{
+		return false;
 	}
 
+	size_t offset = m_pStream->getPosition();
+
+	void** vertices = nullptr;
 	if (frameHeader.VertexCount > 0)
 	{
-		const size_t attributeCount = getAttributeCount(m_Descriptor);
-		frameData.Data.vertices = new void*[attributeCount];
+		vertices = &m_MappedVertexPointers[frameIndex * m_AttributeCount];
 
-		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		for (size_t iAttribute = 0; iAttribute < m_AttributeCount; ++iAttribute)
 		{
-			const size_t dataSize = getSizeOfDataFormat(m_Descriptor[iAttribute].format) * frameData.Data.vertexCount;
+			const size_t elementSize = getSizeOfDataFormat(m_Descriptor[iAttribute].format);
+			const size_t alignment = (elementSize % sizeof(float)) == 0 ? sizeof(float) : sizeof(uint16_t);
 
-			void *vertexData = malloc(dataSize);
-			if (vertexData != nullptr)
-			{
-				m_pStream->read(vertexData, dataSize);
-			}
-			else
+			const void* vertexData = viewMapped(m_pStream, offset, elementSize * frameHeader.VertexCount, alignment);
+			if (vertexData == nullptr)
 			{
-				m_pStream->seek(dataSize, Stream::SeekOrigin::Current);
+				m_pStream->seek(frameOffset, Stream::SeekOrigin::Begin);
+				return false;
 			}
 
-			frameData.Data.vertices[iAttribute] = vertexData;
+			// note: the mapping is read only, consumers of GeomCacheData never write through these pointers.
+			vertices[iAttribute] = const_cast<void*>(vertexData);
 		}
 	}
 
+	m_pStream->seek(offset, Stream::SeekOrigin::Begin);
+
+	if (m_LoadedFrames.isLoaded(frameIndex))
+	{
+		return true;
+	}
+
+	FrameDataType frameData{};
+	frameData.Time = m_FrameTimeTable[frameIndex];
+	frameData.IsMapped = true;
+	frameData.Data = topology;
+	frameData.Data.vertexCount = frameHeader.VertexCount;
+	frameData.Data.vertices = vertices;
+
+	if (sharedTopology != nullptr)
+	{
+		useSharedTopology(frameIndex, *sharedTopology, frameData);
+	}
+
 	if (!insertLoadedData(frameIndex, frameData))
 	{
 		freeFrame(frameData);
 	}
+	return true;
 }
 
-void NullDecompressor::freeFrame(FrameDataType& data) const
+void NullDecompressor::freeFrame(FrameDataType& data)
 {
-	freeGeomCacheData(data.Data, getAttributeCount(m_Descriptor));
+	if (!data.IsMapped)
+	{
+		m_FramePool.deallocate(data.Block, data.BlockSize);
+	}
+	if (data.TopologyWindow != InvalidFrameIndex)
+	{
+		m_WindowTopologies.release(data.TopologyWindow, m_FramePool);
+	}
 	data.Data = GeomCacheData{};
+	data.Block = nullptr;
+	data.BlockSize = 0;
+	data.TopologyWindow = InvalidFrameIndex;
 }
 
-bool NullDecompressor::insertLoadedData(size_t frameIndex, const FrameDataType& data)
+// Returns the shared topology of a frame, or nullptr if the frame stores its own and the stream is still at it.
+// A seek window's first frame stores the topology shared by the rest of the window: it's read into
+// m_WindowTopologies (or skipped if already there) and stays referenced while prefetch() walks the window.
+const GeomCacheData* NullDecompressor::loadSharedTopology(size_t frameIndex, const null_compression::FrameHeader& frameHeader)
 {
-	float time = m_FrameTimeTable[frameIndex];
+	const size_t window = getSeekTableIndex(frameIndex);
+
+	if ((frameHeader.Flags & null_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		if ((m_Header.Flags & null_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0)
+		{
+			return &m_FileTopology;
+		}
 
-	const auto it = std::find_if(m_LoadedFrames.begin(), m_LoadedFrames.end(),
-		[time](const FrameDataType& d)
+		if (window != m_WalkTopologyWindow && m_WindowTopologies.isLoaded(window))
+		{
+			// Still referenced by resident frames of the window, as when a frame is read through the frame index.
+			releaseWalkTopology();
+			m_WindowTopologies.acquire(window);
+			m_WalkTopologyWindow = window;
+		}
+
+		return window == m_WalkTopologyWindow ? &m_WindowTopologies.get(window) : nullptr;
+	}
+
+	if ((m_Header.Flags & null_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0
+		|| (frameIndex % m_Header.FrameSeekWindowCount) != 0)
 	{
-		return d.Time == time;
-	});
+		return nullptr;
+	}
+
+	releaseWalkTopology();
 
-	if (it == m_LoadedFrames.end())
+	if (m_WindowTopologies.isLoaded(window))
 	{
-		// Insert sorted.
-		const auto itInsert = std::lower_bound(m_LoadedFrames.begin(), m_LoadedFrames.end(), data,
-			[](const FrameDataType& lhs, const FrameDataType& rhs)
+		skipTopology(m_pStream, frameHeader.IndexCount, false);
+		m_WindowTopologies.acquire(window);
+	}
+	else
+	{
+		GeomCacheData topology{};
+		void* block = nullptr;
+		size_t blockSize = 0;
+
+		if (!m_IsMapped || !mapTopology(frameHeader.IndexCount, topology))
 		{
-			return lhs.Time < rhs.Time;
-		});
+			const size_t topologyOffset = m_pStream->getPosition();
+			block = readTopology(m_pStream, m_FramePool, frameHeader.IndexCount, false, topology, blockSize);
+			if (block == nullptr)
+			{
+				m_pStream->seek(topologyOffset, Stream::SeekOrigin::Begin);
+				return nullptr;
+			}
+		}
 
-		m_LoadedFrames.insert(itInsert, data);
-		m_IsFrameLoaded[frameIndex] = true;
+		m_WindowTopologies.set(window, topology, block, blockSize);
+	}
 
-		return true;
+	m_WalkTopologyWindow = window;
+	return &m_WindowTopologies.get(window);
+}
+
+void NullDecompressor::releaseWalkTopology()
+{
+	if (m_WalkTopologyWindow != InvalidFrameIndex)
+	{
+		m_WindowTopologies.release(m_WalkTopologyWindow, m_FramePool);
+		m_WalkTopologyWindow = InvalidFrameIndex;
+	}
+}
+
+// Points topology at the stream mapping. Returns false (without moving the stream) if it can't be referenced in place.
+bool NullDecompressor::mapTopology(size_t indexCount, GeomCacheData& topology)
+{
+	const size_t topologyOffset = m_pStream->getPosition();
+	size_t offset = topologyOffset;
+
+	uint64_t meshCount = 0;
+	uint64_t submeshCount = 0;
+
+	if (!readMapped(m_pStream, offset, meshCount))
+	{
+		return false;
 	}
+	const void* meshes = viewMapped(m_pStream, offset, sizeof(GeomMesh) * meshCount, alignof(GeomMesh));
 
-	return false;
+	if (!readMapped(m_pStream, offset, submeshCount))
+	{
+		return false;
+	}
+	const void* submeshes = viewMapped(m_pStream, offset, sizeof(GeomSubmesh) * submeshCount, alignof(GeomSubmesh));
+
+	if (meshes == nullptr || submeshes == nullptr)
+	{
+		return false;
+	}
+
+	const void* indices = nullptr;
+	if (indexCount > 0)
+	{
+		indices = viewMapped(m_pStream, offset, sizeof(int) * indexCount, alignof(int));
+		if (indices == nullptr)
+		{
+			return false;
+		}
+	}
+
+	m_pStream->seek(offset, Stream::SeekOrigin::Begin);
+
+	topology.indices = const_cast<void*>(indices);
+	topology.indexCount = indexCount;
+	topology.meshes = static_cast<GeomMesh*>(const_cast<void*>(meshes));
+	topology.meshCount = meshCount;
+	topology.submeshes = static_cast<GeomSubmesh*>(const_cast<void*>(submeshes));
+	topology.submeshCount = submeshCount;
+	return true;
+}
+
+// Points a frame at a shared topology, a window topology stays referenced until the frame is freed.
+void NullDecompressor::useSharedTopology(size_t frameIndex, const GeomCacheData& topology, FrameDataType& frameData)
+{
+	frameData.Data.indices = topology.indices;
+	frameData.Data.indexCount = topology.indexCount;
+	frameData.Data.meshes = topology.meshes;
+	frameData.Data.meshCount = topology.meshCount;
+	frameData.Data.submeshes = topology.submeshes;
+	frameData.Data.submeshCount = topology.submeshCount;
+
+	if (&topology != &m_FileTopology)
+	{
+		frameData.TopologyWindow = getSeekTableIndex(frameIndex);
+		m_WindowTopologies.acquire(frameData.TopologyWindow);
+	}
+}
+
+bool NullDecompressor::insertLoadedData(size_t frameIndex, FrameDataType& data)
+{
+	if (m_LoadedFrames.isLoaded(frameIndex))
+	{
+		return false;
+	}
+
+	data.Size = data.IsMapped ? 0 : data.BlockSize;
+
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+
+		m_LoadedFrames.insert(frameIndex, data);
+	}
+
+	evictFrames();
+	return true;
+}
+
+void NullDecompressor::setCacheBudget(size_t bytes)
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	m_LoadedFrames.setBudget(bytes);
+}
+
+size_t NullDecompressor::getCacheSize() const
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	return m_LoadedFrames.getSize();
+}
+
+size_t NullDecompressor::getHeapAllocationCount() const
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	return m_FramePool.getHeapAllocationCount() + m_LoadedFrames.getHeapAllocationCount();
+}
+
+void NullDecompressor::setPinnedRange(size_t frameIndex, size_t range)
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	m_LoadedFrames.setPinnedRange(frameIndex, range);
+}
+
+// Drops least recently used frames until the cache fits its budget. Only called from the prefetching
+// thread (prefetch()/loadFrame()), which is the only writer of m_LoadedFrames outside the lock.
+void NullDecompressor::evictFrames()
+{
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		m_LoadedFrames.evict();
+	}
+
+	// Free outside of the lock, getData() shouldn't wait on the allocator.
+	std::vector<FrameDataType>& evictedFrames = m_LoadedFrames.getEvictedFrames();
+	for (auto& frame : evictedFrames)
+	{
+		freeFrame(frame);
+	}
+	evictedFrames.clear();
 }
 
 } //namespace nvc
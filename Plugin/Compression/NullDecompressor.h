@@ -6,6 +6,10 @@
 
 //! Project Includes.
 #include "Plugin/GeomCacheData.h"
+#include "Plugin/Foundation/Concurrency.h"
+#include "FrameBufferPool.h"
+#include "FrameSlotCache.h"
+#include "FrameTopology.h"
 
 namespace nvc
 {
@@ -23,20 +27,50 @@ private:
 	char m_Semantics[GEOM_CACHE_MAX_DESCRIPTOR_COUNT][null_compression::SEMANTIC_STRING_LENGTH] = {};
 
 	std::vector<uint64_t> m_SeekTable;
+	std::vector<null_compression::FrameIndexEntry> m_FrameIndex; // Empty if the file predates FILE_FLAG_FRAME_INDEX.
 	std::vector<float> m_FrameTimeTable;
-	std::vector<bool> m_IsFrameLoaded;
 	std::vector<uint8_t> m_ConstantData;
 
 	struct FrameDataType 
 	{
 		float Time;
 		GeomCacheData Data;
+		void* Block; // Single m_FramePool block holding all the arrays of Data.
+		size_t BlockSize;
+		size_t Size; // Bytes owned by the frame, counted against the cache budget.
+
+		// LRU list links (frame indices), only frames with Size > 0 are linked.
+		size_t LruPrev;
+		size_t LruNext;
+		bool IsMapped; // Data arrays alias the stream mapping, nothing to free.
+		size_t TopologyWindow = InvalidFrameIndex; // m_WindowTopologies entry Data refers to.
 	};
 
-	std::vector<FrameDataType> m_LoadedFrames;
+	// One slot per frame, parallel to m_FrameTimeTable.
+	FrameSlotCache<FrameDataType> m_LoadedFrames;
+
+	// prefetch() may run on a worker thread while getData() is called, this guards m_LoadedFrames.
+	// note: prefetch() itself must not be called concurrently (it owns the stream cursor).
+	mutable spin_mutex m_LoadedFramesMutex;
+
+	FrameBufferPool m_FramePool;
 
 	size_t m_FramesOffset = 0;
 
+	// Shared topologies: the file's if FILE_FLAG_SHARED_TOPOLOGY is set, otherwise one per seek window.
+	// Only touched by the prefetching thread, like the stream.
+	GeomCacheData m_FileTopology = {};
+	void* m_FileTopologyBlock = nullptr;
+	size_t m_FileTopologyBlockSize = 0;
+	SharedTopologyTable m_WindowTopologies;
+	size_t m_WalkTopologyWindow = InvalidFrameIndex; // Window topology referenced by the running prefetch().
+
+	// Mapped mode: frame arrays point straight into the stream's view() (see loadMappedFrame()).
+	bool m_UseMappedFrames = true;
+	bool m_IsMapped = false;
+	size_t m_AttributeCount = 0;
+	std::vector<void*> m_MappedVertexPointers; // FrameCount * m_AttributeCount, GeomCacheData::vertices of mapped frames.
+
 public:
 	NullDecompressor() = default;
 	~NullDecompressor();
@@ -48,9 +82,23 @@ public:
 	bool getData(size_t frameIndex, float& time, GeomCacheData& data) override;
 	bool getData(float time, GeomCacheData& data) override;
 	const GeomCacheDesc* getDescriptors() const override { return &m_Descriptor[0]; }
+	bool decodeAttribute(size_t, const GeomCacheData&, size_t, size_t, size_t, void*) const override { return false; }
 	size_t getConstantDataStringSize() const override;
 	const char* getConstantDataString(size_t index) const override;
 
+	void setCacheBudget(size_t bytes) override;
+	size_t getCacheBudget() const override { return m_LoadedFrames.getBudget(); }
+	size_t getCacheSize() const override;
+	void setPinnedRange(size_t frameIndex, size_t range) override;
+
+	const FrameBufferPool& getFramePool() const { return m_FramePool; }
+	// Heap allocations of the frame cache: the pooled frames and the bookkeeping of the loaded ones.
+	size_t getHeapAllocationCount() const;
+
+	// Must be called before open(). Mapped mode is only used on read only streams which have a view().
+	void setMappedMode(bool enable) { m_UseMappedFrames = enable; }
+	bool isMappedMode() const { return m_IsMapped; }
+
 	//...
 	NullDecompressor(const NullDecompressor&) = delete;
 	NullDecompressor(NullDecompressor&&) = delete;
@@ -104,10 +152,19 @@ public:
 	}
 
 private:
-	void loadFrame(size_t frameIndex);
-	void freeFrame(FrameDataType& data) const;
-
-	bool insertLoadedData(size_t frameIndex, const FrameDataType& data);
+	void loadFrame(size_t frameIndex, const null_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology);
+	void skipFrame(const null_compression::FrameHeader& frameHeader, bool hasTopology);
+	void loadIndexedFrame(size_t frameIndex);
+	bool loadMappedFrame(size_t frameIndex, const null_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology);
+	void freeFrame(FrameDataType& data);
+
+	const GeomCacheData* loadSharedTopology(size_t frameIndex, const null_compression::FrameHeader& frameHeader);
+	void releaseWalkTopology();
+	bool mapTopology(size_t indexCount, GeomCacheData& topology);
+	void useSharedTopology(size_t frameIndex, const GeomCacheData& topology, FrameDataType& frameData);
+
+	bool insertLoadedData(size_t frameIndex, FrameDataType& data);
+	void evictFrames();
 };
 
 } // namespace nvc
@@ -11,15 +11,33 @@ namespace null_compression
 		uint32_t FrameSeekWindowCount;
 		uint32_t VertexAttributeCount;
 		uint32_t ConstantDataSize;
+		uint32_t Flags; // FILE_FLAG_*
 	};
 
 	struct FrameHeader
 	{
 		uint32_t IndexCount;
 		uint32_t VertexCount;
+		uint32_t Flags; // FRAME_FLAG_*
+	};
+
+	// Where a frame is stored, from its FrameHeader to the next frame.
+	struct FrameIndexEntry
+	{
+		uint64_t Offset;
+		uint64_t Size; // 0 if the frame wasn't written.
 	};
 
 	static const uint32_t SEMANTIC_STRING_LENGTH = 60;
+
+	// Every frame has the same topology, stored once after the time table.
+	static const uint32_t FILE_FLAG_SHARED_TOPOLOGY = 1u << 0;
+
+	// A FrameIndexEntry per frame follows the seek table, so any frame can be read on its own.
+	static const uint32_t FILE_FLAG_FRAME_INDEX = 1u << 1;
+
+	// The frame stores no topology, it uses the file topology or else the one of its seek window's first frame.
+	static const uint32_t FRAME_FLAG_SHARED_TOPOLOGY = 1u << 0;
 }
 
 } // namespace nvc
@@ -4,8 +4,451 @@
 //! Header Includes.
 #include "Plugin/Compression/PackedTransform.h"
 
+//! Project Includes.
+#include "Plugin/Foundation/Simd.h"
+
+//! System Includes.
+#include <atomic>
+
 namespace nvc
 {
 
+static_assert(sizeof(unorm16x2) == 2 * sizeof(uint16_t), "unorm16x2 must be tightly packed");
+static_assert(sizeof(unorm16x3) == 3 * sizeof(uint16_t), "unorm16x3 must be tightly packed");
+static_assert(sizeof(float3) == 3 * sizeof(float), "float3 must be tightly packed");
+static_assert(sizeof(float4) == 4 * sizeof(float), "float4 must be tightly packed");
+
+namespace
+{
+	static constexpr float Unorm16Scale = 1.0f / 65535.0f;
+	static constexpr float OctScale = 2.0f / 65535.0f; // unorm16 to [-1, 1].
+
+	//! Scalar.
+
+	void UnpackPointsScalar(const AABB& aabb, const unorm16x3* packed, float3* unpacked, size_t count)
+	{
+		const float scale[3] = { aabb.extents[0] * Unorm16Scale, aabb.extents[1] * Unorm16Scale, aabb.extents[2] * Unorm16Scale };
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			unpacked[i][0] = aabb.min[0] + static_cast<float>(packed[i][0].data) * scale[0];
+			unpacked[i][1] = aabb.min[1] + static_cast<float>(packed[i][1].data) * scale[1];
+			unpacked[i][2] = aabb.min[2] + static_cast<float>(packed[i][2].data) * scale[2];
+		}
+	}
+
+	inline void OctDecodeScalar(const unorm16x2& packed, float& x, float& y, float& z)
+	{
+		x = static_cast<float>(packed[0].data) * OctScale - 1.0f;
+		y = static_cast<float>(packed[1].data) * OctScale - 1.0f;
+		z = (1.0f - std::abs(x)) - std::abs(y);
+
+		const float t = std::max(std::min(-z, 1.0f), 0.0f);
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+
+		const float k = 1.0f / sqrtf((x * x + y * y) + z * z);
+		x *= k;
+		y *= k;
+		z *= k;
+	}
+
+	void OctDecodeArrayScalar(const unorm16x2* packed, float3* unpacked, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			OctDecodeScalar(packed[i], unpacked[i][0], unpacked[i][1], unpacked[i][2]);
+		}
+	}
+
+	void OctDecodeArrayScalar(const unorm16x2* packed, float4* unpacked, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			OctDecodeScalar(packed[i], unpacked[i][0], unpacked[i][1], unpacked[i][2]);
+			unpacked[i][3] = 1.0f;
+		}
+	}
+
+	void UnpackUnorm16ArrayScalar(const unorm16* packed, float* unpacked, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			unpacked[i] = static_cast<float>(packed[i].data) * Unorm16Scale;
+		}
+	}
+
+#if NVC_SIMD_X86
+
+	//! SSE4.1, 4 lanes.
+
+	// Structure of arrays to x, y, z triplets.
+	NVC_TARGET_SSE41 inline void StoreFloat3x4(float* dst, __m128 x, __m128 y, __m128 z)
+	{
+		const __m128 xyLo = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+		const __m128 xyHi = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+
+		const __m128 z0x1 = _mm_shuffle_ps(z, xyLo, _MM_SHUFFLE(3, 2, 0, 0));
+		const __m128 y1z1 = _mm_shuffle_ps(xyLo, z, _MM_SHUFFLE(1, 1, 3, 3));
+		const __m128 z2x3 = _mm_shuffle_ps(z, xyHi, _MM_SHUFFLE(2, 2, 2, 2));
+		const __m128 y3z3 = _mm_shuffle_ps(xyHi, z, _MM_SHUFFLE(3, 3, 3, 3));
+
+		_mm_storeu_ps(dst + 0, _mm_shuffle_ps(xyLo, z0x1, _MM_SHUFFLE(2, 0, 1, 0))); // x0 y0 z0 x1
+		_mm_storeu_ps(dst + 4, _mm_shuffle_ps(y1z1, xyHi, _MM_SHUFFLE(1, 0, 2, 0))); // y1 z1 x2 y2
+		_mm_storeu_ps(dst + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0))); // z2 x3 y3 z3
+	}
+
+	NVC_TARGET_SSE41 inline void StoreFloat4x4(float* dst, __m128 x, __m128 y, __m128 z, __m128 w)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(dst + 0, x);
+		_mm_storeu_ps(dst + 4, y);
+		_mm_storeu_ps(dst + 8, z);
+		_mm_storeu_ps(dst + 12, w);
+	}
+
+	NVC_TARGET_SSE41 inline __m128 Unorm16ToFloat(__m128i packed)
+	{
+		return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(packed));
+	}
+
+	// Same operations as OctDecodeScalar(), on the x and y halves of 4 packed normals.
+	NVC_TARGET_SSE41 inline void OctDecode4(__m128i packed, __m128& x, __m128& y, __m128& z)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 scale = _mm_set1_ps(OctScale);
+
+		x = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, _mm_set1_epi32(0xFFFF))), scale), one);
+		y = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(packed, 16)), scale), one);
+		z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), _mm_andnot_ps(signMask, y));
+
+		const __m128 t = _mm_max_ps(_mm_min_ps(_mm_xor_ps(z, signMask), one), zero);
+		const __m128 negT = _mm_xor_ps(t, signMask);
+		x = _mm_add_ps(x, _mm_blendv_ps(t, negT, _mm_cmpge_ps(x, zero)));
+		y = _mm_add_ps(y, _mm_blendv_ps(t, negT, _mm_cmpge_ps(y, zero)));
+
+		const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		const __m128 k = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+		x = _mm_mul_ps(x, k);
+		y = _mm_mul_ps(y, k);
+		z = _mm_mul_ps(z, k);
+	}
+
+	// The x, y, z pattern of the flattened points repeats every 3 registers.
+	NVC_TARGET_SSE41 void UnpackPointsSSE41(const AABB& aabb, const unorm16x3* packed, float3* unpacked, size_t count)
+	{
+		const float sx = aabb.extents[0] * Unorm16Scale;
+		const float sy = aabb.extents[1] * Unorm16Scale;
+		const float sz = aabb.extents[2] * Unorm16Scale;
+		const __m128 scale0 = _mm_setr_ps(sx, sy, sz, sx);
+		const __m128 scale1 = _mm_setr_ps(sy, sz, sx, sy);
+		const __m128 scale2 = _mm_setr_ps(sz, sx, sy, sz);
+		const __m128 offset0 = _mm_setr_ps(aabb.min[0], aabb.min[1], aabb.min[2], aabb.min[0]);
+		const __m128 offset1 = _mm_setr_ps(aabb.min[1], aabb.min[2], aabb.min[0], aabb.min[1]);
+		const __m128 offset2 = _mm_setr_ps(aabb.min[2], aabb.min[0], aabb.min[1], aabb.min[2]);
+
+		const uint16_t* src = reinterpret_cast<const uint16_t*>(packed);
+		float* dst = reinterpret_cast<float*>(unpacked);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8, src += 24, dst += 24)
+		{
+			const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0));
+			const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8));
+			const __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+
+			_mm_storeu_ps(dst + 0, _mm_add_ps(offset0, _mm_mul_ps(Unorm16ToFloat(p0), scale0)));
+			_mm_storeu_ps(dst + 4, _mm_add_ps(offset1, _mm_mul_ps(Unorm16ToFloat(_mm_srli_si128(p0, 8)), scale1)));
+			_mm_storeu_ps(dst + 8, _mm_add_ps(offset2, _mm_mul_ps(Unorm16ToFloat(p1), scale2)));
+			_mm_storeu_ps(dst + 12, _mm_add_ps(offset0, _mm_mul_ps(Unorm16ToFloat(_mm_srli_si128(p1, 8)), scale0)));
+			_mm_storeu_ps(dst + 16, _mm_add_ps(offset1, _mm_mul_ps(Unorm16ToFloat(p2), scale1)));
+			_mm_storeu_ps(dst + 20, _mm_add_ps(offset2, _mm_mul_ps(Unorm16ToFloat(_mm_srli_si128(p2, 8)), scale2)));
+		}
+
+		UnpackPointsScalar(aabb, packed + i, unpacked + i, count - i);
+	}
+
+	NVC_TARGET_SSE41 void OctDecodeArraySSE41(const unorm16x2* packed, float3* unpacked, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			OctDecode4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i)), x, y, z);
+			StoreFloat3x4(&unpacked[i][0], x, y, z);
+		}
+
+		OctDecodeArrayScalar(packed + i, unpacked + i, count - i);
+	}
+
+	NVC_TARGET_SSE41 void OctDecodeArraySSE41(const unorm16x2* packed, float4* unpacked, size_t count)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			OctDecode4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i)), x, y, z);
+			StoreFloat4x4(&unpacked[i][0], x, y, z, one);
+		}
+
+		OctDecodeArrayScalar(packed + i, unpacked + i, count - i);
+	}
+
+	NVC_TARGET_SSE41 void UnpackUnorm16ArraySSE41(const unorm16* packed, float* unpacked, size_t count)
+	{
+		const __m128 scale = _mm_set1_ps(Unorm16Scale);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i));
+			_mm_storeu_ps(unpacked + i + 0, _mm_mul_ps(Unorm16ToFloat(p), scale));
+			_mm_storeu_ps(unpacked + i + 4, _mm_mul_ps(Unorm16ToFloat(_mm_srli_si128(p, 8)), scale));
+		}
+
+		UnpackUnorm16ArrayScalar(packed + i, unpacked + i, count - i);
+	}
+
+	//! AVX2, 8 lanes.
+
+	NVC_TARGET_AVX2 inline __m256 Unorm16ToFloat8(__m128i packed)
+	{
+		return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(packed));
+	}
+
+	NVC_TARGET_AVX2 inline void OctDecode8(__m256i packed, __m256& x, __m256& y, __m256& z)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		const __m256 scale = _mm256_set1_ps(OctScale);
+
+		x = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(packed, _mm256_set1_epi32(0xFFFF))), scale), one);
+		y = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(packed, 16)), scale), one);
+		z = _mm256_sub_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, x)), _mm256_andnot_ps(signMask, y));
+
+		const __m256 t = _mm256_max_ps(_mm256_min_ps(_mm256_xor_ps(z, signMask), one), zero);
+		const __m256 negT = _mm256_xor_ps(t, signMask);
+		x = _mm256_add_ps(x, _mm256_blendv_ps(t, negT, _mm256_cmp_ps(x, zero, _CMP_GE_OQ)));
+		y = _mm256_add_ps(y, _mm256_blendv_ps(t, negT, _mm256_cmp_ps(y, zero, _CMP_GE_OQ)));
+
+		const __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+		const __m256 k = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared));
+		x = _mm256_mul_ps(x, k);
+		y = _mm256_mul_ps(y, k);
+		z = _mm256_mul_ps(z, k);
+	}
+
+	NVC_TARGET_AVX2 void UnpackPointsAVX2(const AABB& aabb, const unorm16x3* packed, float3* unpacked, size_t count)
+	{
+		const float sx = aabb.extents[0] * Unorm16Scale;
+		const float sy = aabb.extents[1] * Unorm16Scale;
+		const float sz = aabb.extents[2] * Unorm16Scale;
+		const __m256 scale0 = _mm256_setr_ps(sx, sy, sz, sx, sy, sz, sx, sy);
+		const __m256 scale1 = _mm256_setr_ps(sz, sx, sy, sz, sx, sy, sz, sx);
+		const __m256 scale2 = _mm256_setr_ps(sy, sz, sx, sy, sz, sx, sy, sz);
+		const float ox = aabb.min[0];
+		const float oy = aabb.min[1];
+		const float oz = aabb.min[2];
+		const __m256 offset0 = _mm256_setr_ps(ox, oy, oz, ox, oy, oz, ox, oy);
+		const __m256 offset1 = _mm256_setr_ps(oz, ox, oy, oz, ox, oy, oz, ox);
+		const __m256 offset2 = _mm256_setr_ps(oy, oz, ox, oy, oz, ox, oy, oz);
+
+		const uint16_t* src = reinterpret_cast<const uint16_t*>(packed);
+		float* dst = reinterpret_cast<float*>(unpacked);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8, src += 24, dst += 24)
+		{
+			const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0));
+			const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8));
+			const __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+
+			_mm256_storeu_ps(dst + 0, _mm256_add_ps(offset0, _mm256_mul_ps(Unorm16ToFloat8(p0), scale0)));
+			_mm256_storeu_ps(dst + 8, _mm256_add_ps(offset1, _mm256_mul_ps(Unorm16ToFloat8(p1), scale1)));
+			_mm256_storeu_ps(dst + 16, _mm256_add_ps(offset2, _mm256_mul_ps(Unorm16ToFloat8(p2), scale2)));
+		}
+
+		UnpackPointsScalar(aabb, packed + i, unpacked + i, count - i);
+	}
+
+	NVC_TARGET_AVX2 void OctDecodeArrayAVX2(const unorm16x2* packed, float3* unpacked, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x, y, z;
+			OctDecode8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed + i)), x, y, z);
+			StoreFloat3x4(&unpacked[i][0], _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+			StoreFloat3x4(&unpacked[i + 4][0], _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+		}
+
+		OctDecodeArraySSE41(packed + i, unpacked + i, count - i);
+	}
+
+	NVC_TARGET_AVX2 void OctDecodeArrayAVX2(const unorm16x2* packed, float4* unpacked, size_t count)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x, y, z;
+			OctDecode8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed + i)), x, y, z);
+			StoreFloat4x4(&unpacked[i][0], _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z), one);
+			StoreFloat4x4(&unpacked[i + 4][0], _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1), one);
+		}
+
+		OctDecodeArraySSE41(packed + i, unpacked + i, count - i);
+	}
+
+	NVC_TARGET_AVX2 void UnpackUnorm16ArrayAVX2(const unorm16* packed, float* unpacked, size_t count)
+	{
+		const __m256 scale = _mm256_set1_ps(Unorm16Scale);
+
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i + 0));
+			const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i + 8));
+			_mm256_storeu_ps(unpacked + i + 0, _mm256_mul_ps(Unorm16ToFloat8(p0), scale));
+			_mm256_storeu_ps(unpacked + i + 8, _mm256_mul_ps(Unorm16ToFloat8(p1), scale));
+		}
+
+		UnpackUnorm16ArraySSE41(packed + i, unpacked + i, count - i);
+	}
+
+#endif // NVC_SIMD_X86
+
+	//! Dispatch.
+
+	SimdLevel DetectSimdLevel()
+	{
+		const cpu_features& features = get_cpu_features();
+		if (features.avx2)
+		{
+			return SimdLevel::AVX2;
+		}
+		if (features.sse41)
+		{
+			return SimdLevel::SSE41;
+		}
+		return SimdLevel::Scalar;
+	}
+
+	std::atomic<SimdLevel>& getSelectedSimdLevel()
+	{
+		static std::atomic<SimdLevel> level { GetSupportedSimdLevel() };
+		return level;
+	}
+}
+
+SimdLevel GetSupportedSimdLevel()
+{
+	static const SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+SimdLevel GetSimdLevel()
+{
+	return getSelectedSimdLevel().load(std::memory_order_relaxed);
+}
+
+void SetSimdLevel(SimdLevel level)
+{
+	getSelectedSimdLevel().store(std::min(level, GetSupportedSimdLevel()), std::memory_order_relaxed);
+}
+
+void UnpackPoints(const AABB& aabb, const unorm16x3* packed, float3* unpacked, size_t count)
+{
+	switch (GetSimdLevel())
+	{
+#if NVC_SIMD_X86
+	case SimdLevel::AVX2:	UnpackPointsAVX2(aabb, packed, unpacked, count);	break;
+	case SimdLevel::SSE41:	UnpackPointsSSE41(aabb, packed, unpacked, count);	break;
+#endif
+	default:				UnpackPointsScalar(aabb, packed, unpacked, count);	break;
+	}
+}
+
+void OctDecodeArray(const unorm16x2* packed, float3* unpacked, size_t count)
+{
+	switch (GetSimdLevel())
+	{
+#if NVC_SIMD_X86
+	case SimdLevel::AVX2:	OctDecodeArrayAVX2(packed, unpacked, count);	break;
+	case SimdLevel::SSE41:	OctDecodeArraySSE41(packed, unpacked, count);	break;
+#endif
+	default:				OctDecodeArrayScalar(packed, unpacked, count);	break;
+	}
+}
+
+void OctDecodeArray(const unorm16x2* packed, float4* unpacked, size_t count)
+{
+	switch (GetSimdLevel())
+	{
+#if NVC_SIMD_X86
+	case SimdLevel::AVX2:	OctDecodeArrayAVX2(packed, unpacked, count);	break;
+	case SimdLevel::SSE41:	OctDecodeArraySSE41(packed, unpacked, count);	break;
+#endif
+	default:				OctDecodeArrayScalar(packed, unpacked, count);	break;
+	}
+}
+
+void UnpackUnorm16Array(const unorm16* packed, float* unpacked, size_t count)
+{
+	switch (GetSimdLevel())
+	{
+#if NVC_SIMD_X86
+	case SimdLevel::AVX2:	UnpackUnorm16ArrayAVX2(packed, unpacked, count);	break;
+	case SimdLevel::SSE41:	UnpackUnorm16ArraySSE41(packed, unpacked, count);	break;
+#endif
+	default:				UnpackUnorm16ArrayScalar(packed, unpacked, count);	break;
+	}
+}
+
+void PackBits(const uint16_t* values, size_t count, uint32_t bits, uint8_t* packed)
+{
+	uint64_t pending = 0;
+	uint32_t pendingBits = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		assert(values[i] < (1u << bits));
+		pending |= static_cast<uint64_t>(values[i]) << pendingBits;
+		pendingBits += bits;
+		while (pendingBits >= 8)
+		{
+			*packed++ = static_cast<uint8_t>(pending);
+			pending >>= 8;
+			pendingBits -= 8;
+		}
+	}
+	if (pendingBits > 0)
+	{
+		*packed = static_cast<uint8_t>(pending);
+	}
+}
+
+void UnpackBitsToUnorm16(const uint8_t* packed, size_t count, uint32_t bits, unorm16* unpacked)
+{
+	const uint64_t mask = (1u << bits) - 1;
+	uint64_t pending = 0;
+	uint32_t pendingBits = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		while (pendingBits < bits)
+		{
+			pending |= static_cast<uint64_t>(*packed++) << pendingBits;
+			pendingBits += 8;
+		}
+		unpacked[i].data = ExpandToUnorm16(static_cast<uint16_t>(pending & mask), bits);
+		pending >>= bits;
+		pendingBits -= bits;
+	}
+}
 
 } // namespace nvc
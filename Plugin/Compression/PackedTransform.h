@@ -220,13 +220,16 @@ inline float2 OctEncode(float3 n)
 	//n.xy = n.xy * 0.5 + 0.5;
 	//return n.xy;
 
-	const float k = 1.0f / (abs(n[0]) + abs(n[1]) + abs(n[2]));
+	const float k = 1.0f / (std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]));
 	n[0] = n[0] * k;
 	n[1] = n[1] * k;
 	n[2] = n[2] * k;
 
-	n[0] = n[2] >= 0.0f ? n[0] : (1.0f - abs(n[1])) * (n[0] >= 0.0 ? 1.0f : -1.0f);
-	n[1] = n[2] >= 0.0f ? n[1] : (1.0f - abs(n[0])) * (n[1] >= 0.0 ? 1.0f : -1.0f);
+	// Both wrapped components come from the unwrapped ones.
+	const float x = n[0];
+	const float y = n[1];
+	n[0] = n[2] >= 0.0f ? x : (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+	n[1] = n[2] >= 0.0f ? y : (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
 	
 	float2 oct;
 	oct[0] = n[0] * 0.5f + 0.5f;
@@ -251,7 +254,7 @@ inline float3 OctDecode(float2 f)
 	f[0] = f[0] * 2.0f - 1.0f;
 	f[1] = f[1] * 2.0f - 1.0f;
 
-	float3 n; n[0] = f[0]; n[1] = f[1]; n[2] = 1.0f - abs(f[0]) - abs(f[1]);
+	float3 n; n[0] = f[0]; n[1] = f[1]; n[2] = 1.0f - std::abs(f[0]) - std::abs(f[1]);
 	const float t = std::max(std::min(-n[2], 1.0f), 0.0f);
 	n[0] += n[0] >= 0.0f ? -t : t;
 	n[1] += n[1] >= 0.0f ? -t : t;
@@ -264,4 +267,59 @@ inline float3 OctDecode(float2 f)
 	return n;
 }
 
+// Batch decoding of whole arrays, the hot path of quantised playback.
+// Dispatched at runtime (cpuid) to AVX2, SSE4.1 or a portable scalar loop, which all give the same results.
+// note: unlike UnpackPoint()/OctDecode() these scale by the reciprocal of 65535 instead of dividing,
+//       so they may differ from the per element functions in the last bit.
+enum class SimdLevel
+{
+	Scalar,
+	SSE41,
+	AVX2,
+};
+
+SimdLevel GetSupportedSimdLevel();
+SimdLevel GetSimdLevel();
+void SetSimdLevel(SimdLevel level); // Clamped to the supported level, for tests and benchmarks.
+
+void UnpackPoints(const AABB& aabb, const unorm16x3* packed, float3* unpacked, size_t count);
+void OctDecodeArray(const unorm16x2* packed, float3* unpacked, size_t count);
+void OctDecodeArray(const unorm16x2* packed, float4* unpacked, size_t count); // w = 1, for tangents.
+void UnpackUnorm16Array(const unorm16* packed, float* unpacked, size_t count);
+
+// Elements per iteration of the widest kernel loop. The elements past the last whole batch go through the
+// scalar loop, which may round differently (FP contraction), so arrays decoded in several calls should be
+// split on multiples of it to decode like a single call.
+static constexpr size_t PackedArrayBatchSize = 16;
+
+// Quantisation to fewer than 16 bits per value, bit-packed in files and expanded back to unorm16 when loaded,
+// so the kernels above decode them unchanged.
+inline uint16_t QuantiseUnorm(float value, uint32_t bits)
+{
+	assert(bits >= 1 && bits < 16);
+	const float clamped = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f; // NaN to 0.
+	return static_cast<uint16_t>(clamped * ((1u << bits) - 1) + 0.5f);
+}
+
+// Replicates the bits down to 16, 0 and the largest value map to 0 and 65535.
+inline uint16_t ExpandToUnorm16(uint16_t value, uint32_t bits)
+{
+	assert(bits >= 1 && bits < 16);
+	uint32_t expanded = static_cast<uint32_t>(value) << (16 - bits);
+	for (uint32_t filled = bits; filled < 16; filled *= 2)
+	{
+		expanded |= expanded >> filled;
+	}
+	return static_cast<uint16_t>(expanded);
+}
+
+inline size_t GetBitPackedSize(size_t count, uint32_t bits)
+{
+	return (count * bits + 7) / 8;
+}
+
+// Values of bits each, least significant bit first, into GetBitPackedSize(count, bits) bytes.
+void PackBits(const uint16_t* values, size_t count, uint32_t bits, uint8_t* packed);
+void UnpackBitsToUnorm16(const uint8_t* packed, size_t count, uint32_t bits, unorm16* unpacked);
+
 } // namespace nvc
@@ -0,0 +1,543 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "PcaBasis.h"
+
+//! Project Includes.
+#include "PackedTransform.h"
+#include "Plugin/Foundation/Simd.h"
+#include "Plugin/Foundation/Concurrency.h"
+
+namespace nvc
+{
+
+namespace
+{
+	// Values per task when building, and per pass over the components when reconstructing (the destination
+	// stays in L1 while every component row streams through).
+	static const size_t BlockSize = 1024;
+
+	// The Gram matrix is summed from partial matrices over value ranges, at most this many bytes of them.
+	static const size_t MaxPartialGramSize = 64ull * 1024 * 1024;
+
+	// Independent partial sums, so the compiler can keep them in a vector register.
+	float dot(const float* lhs, const float* rhs, size_t count)
+	{
+		float sums[8] = {};
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			for (size_t k = 0; k < 8; ++k)
+			{
+				sums[k] += lhs[i + k] * rhs[i + k];
+			}
+		}
+		for (; i < count; ++i)
+		{
+			sums[0] += lhs[i] * rhs[i];
+		}
+		return ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+	}
+
+	// y += a * x, vectorised the same way.
+	void axpy(float a, const float* x, float* y, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			// Loaded before any store, x and y may alias as far as the compiler knows.
+			float values[8];
+			for (size_t k = 0; k < 8; ++k)
+			{
+				values[k] = y[i + k] + a * x[i + k];
+			}
+			for (size_t k = 0; k < 8; ++k)
+			{
+				y[i + k] = values[k];
+			}
+		}
+		for (; i < count; ++i)
+		{
+			y[i] += a * x[i];
+		}
+	}
+
+	// Gram matrix of the centered frames, gram[i * frameCount + j] = dot(frames[i] - mean, frames[j] - mean).
+	// Each task sums the products of a value range in float per block, and in double across blocks.
+	std::vector<double> buildGramMatrix(const float* const* frames, size_t frameCount, size_t valueCount, const std::vector<float>& mean)
+	{
+		const size_t gramSize = frameCount * frameCount;
+		const size_t blockCount = ceildiv(valueCount, BlockSize);
+		const size_t partialCount = std::max<size_t>(1, std::min(blockCount, MaxPartialGramSize / (gramSize * sizeof(double))));
+		std::vector<std::vector<double>> partials(partialCount);
+
+		parallel_for(size_t(0), partialCount, [&](size_t iPartial) {
+			std::vector<double>& partial = partials[iPartial];
+			partial.assign(gramSize, 0.0);
+			std::vector<float> centered(frameCount * BlockSize);
+
+			for (size_t iBlock = iPartial; iBlock < blockCount; iBlock += partialCount)
+			{
+				const size_t first = iBlock * BlockSize;
+				const size_t count = std::min(BlockSize, valueCount - first);
+				for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						centered[iFrame * BlockSize + i] = frames[iFrame][first + i] - mean[first + i];
+					}
+				}
+
+				for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+				{
+					const float* lhs = &centered[iFrame * BlockSize];
+					for (size_t jFrame = 0; jFrame <= iFrame; ++jFrame)
+					{
+						const float* rhs = &centered[jFrame * BlockSize];
+						partial[iFrame * frameCount + jFrame] += dot(lhs, rhs, count);
+					}
+				}
+			}
+		});
+
+		std::vector<double> gram(gramSize, 0.0);
+		for (const std::vector<double>& partial : partials)
+		{
+			for (size_t i = 0; i < gramSize; ++i)
+			{
+				gram[i] += partial[i];
+			}
+		}
+		for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+		{
+			for (size_t jFrame = 0; jFrame < iFrame; ++jFrame)
+			{
+				gram[jFrame * frameCount + iFrame] = gram[iFrame * frameCount + jFrame];
+			}
+		}
+		return gram;
+	}
+
+	// Cyclic Jacobi eigen decomposition of the symmetric matrix a[n * n], which is destroyed.
+	// eigenvectors[i * n + k] is component i of the eigenvector of eigenvalues[k].
+	void jacobiEigen(std::vector<double>& a, size_t n, std::vector<double>& eigenvalues, std::vector<double>& eigenvectors)
+	{
+		static const size_t MaxSweepCount = 64;
+
+		eigenvectors.assign(n * n, 0.0);
+		for (size_t i = 0; i < n; ++i)
+		{
+			eigenvectors[i * n + i] = 1.0;
+		}
+
+		for (size_t iSweep = 0; iSweep < MaxSweepCount; ++iSweep)
+		{
+			double diagonal = 0.0;
+			double offDiagonal = 0.0;
+			for (size_t p = 0; p < n; ++p)
+			{
+				diagonal += a[p * n + p] * a[p * n + p];
+				for (size_t q = p + 1; q < n; ++q)
+				{
+					offDiagonal += a[p * n + q] * a[p * n + q];
+				}
+			}
+			if (offDiagonal <= 1e-22 * diagonal)
+			{
+				break;
+			}
+
+			for (size_t p = 0; p < n; ++p)
+			{
+				for (size_t q = p + 1; q < n; ++q)
+				{
+					const double apq = a[p * n + q];
+					if (std::fabs(apq) <= 1e-300)
+					{
+						continue;
+					}
+
+					// Rotation zeroing a[p][q]: a = rotation^T * a * rotation.
+					const double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+					const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+					const double c = 1.0 / std::sqrt(t * t + 1.0);
+					const double s = t * c;
+
+					for (size_t k = 0; k < n; ++k)
+					{
+						const double akp = a[k * n + p];
+						const double akq = a[k * n + q];
+						a[k * n + p] = c * akp - s * akq;
+						a[k * n + q] = s * akp + c * akq;
+					}
+					for (size_t k = 0; k < n; ++k)
+					{
+						const double apk = a[p * n + k];
+						const double aqk = a[q * n + k];
+						a[p * n + k] = c * apk - s * aqk;
+						a[q * n + k] = s * apk + c * aqk;
+					}
+					for (size_t k = 0; k < n; ++k)
+					{
+						const double vkp = eigenvectors[k * n + p];
+						const double vkq = eigenvectors[k * n + q];
+						eigenvectors[k * n + p] = c * vkp - s * vkq;
+						eigenvectors[k * n + q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+
+		eigenvalues.resize(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			eigenvalues[i] = a[i * n + i];
+		}
+	}
+
+	//! Reconstruction kernels, dst[i] += sum of weights[k] * components[k][i] for i < count.
+	// components point at the first value, rows are valueCount apart.
+
+	void accumulateComponentsScalar(const int16_t* components, size_t valueCount, const float* weights, size_t componentCount, size_t count, float* dst)
+	{
+		for (size_t k = 0; k < componentCount; ++k)
+		{
+			const int16_t* row = components + k * valueCount;
+			const float weight = weights[k];
+			for (size_t i = 0; i < count; ++i)
+			{
+				dst[i] += weight * static_cast<float>(row[i]);
+			}
+		}
+	}
+
+#if NVC_SIMD_X86
+
+	//! SSE4.1, 4 values per register, 4 components per pass over dst.
+
+	NVC_TARGET_SSE41 inline __m128 loadComponent4(const int16_t* row)
+	{
+		return _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row))));
+	}
+
+	NVC_TARGET_SSE41 void accumulateComponentsSSE41(const int16_t* components, size_t valueCount, const float* weights, size_t componentCount, size_t count, float* dst)
+	{
+		const size_t vectorCount = count & ~size_t(3);
+
+		size_t k = 0;
+		for (; k + 4 <= componentCount; k += 4)
+		{
+			const int16_t* row0 = components + k * valueCount;
+			const int16_t* row1 = row0 + valueCount;
+			const int16_t* row2 = row1 + valueCount;
+			const int16_t* row3 = row2 + valueCount;
+			const __m128 w0 = _mm_set1_ps(weights[k]);
+			const __m128 w1 = _mm_set1_ps(weights[k + 1]);
+			const __m128 w2 = _mm_set1_ps(weights[k + 2]);
+			const __m128 w3 = _mm_set1_ps(weights[k + 3]);
+
+			for (size_t i = 0; i < vectorCount; i += 4)
+			{
+				__m128 sum = _mm_loadu_ps(dst + i);
+				sum = _mm_add_ps(sum, _mm_mul_ps(w0, loadComponent4(row0 + i)));
+				sum = _mm_add_ps(sum, _mm_mul_ps(w1, loadComponent4(row1 + i)));
+				sum = _mm_add_ps(sum, _mm_mul_ps(w2, loadComponent4(row2 + i)));
+				sum = _mm_add_ps(sum, _mm_mul_ps(w3, loadComponent4(row3 + i)));
+				_mm_storeu_ps(dst + i, sum);
+			}
+			accumulateComponentsScalar(row0 + vectorCount, valueCount, weights + k, 4, count - vectorCount, dst + vectorCount);
+		}
+
+		accumulateComponentsScalar(components + k * valueCount, valueCount, weights + k, componentCount - k, count, dst);
+	}
+
+	//! AVX2, 8 values per register, 4 components per pass over dst.
+
+	NVC_TARGET_AVX2 inline __m256 loadComponent8(const int16_t* row)
+	{
+		return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row))));
+	}
+
+	NVC_TARGET_AVX2 void accumulateComponentsAVX2(const int16_t* components, size_t valueCount, const float* weights, size_t componentCount, size_t count, float* dst)
+	{
+		const size_t vectorCount = count & ~size_t(7);
+
+		size_t k = 0;
+		for (; k + 4 <= componentCount; k += 4)
+		{
+			const int16_t* row0 = components + k * valueCount;
+			const int16_t* row1 = row0 + valueCount;
+			const int16_t* row2 = row1 + valueCount;
+			const int16_t* row3 = row2 + valueCount;
+			const __m256 w0 = _mm256_set1_ps(weights[k]);
+			const __m256 w1 = _mm256_set1_ps(weights[k + 1]);
+			const __m256 w2 = _mm256_set1_ps(weights[k + 2]);
+			const __m256 w3 = _mm256_set1_ps(weights[k + 3]);
+
+			for (size_t i = 0; i < vectorCount; i += 8)
+			{
+				// Two partial sums, so the adds of a pass don't all wait on each other.
+				const __m256 sum01 = _mm256_add_ps(_mm256_mul_ps(w0, loadComponent8(row0 + i)), _mm256_mul_ps(w1, loadComponent8(row1 + i)));
+				const __m256 sum23 = _mm256_add_ps(_mm256_mul_ps(w2, loadComponent8(row2 + i)), _mm256_mul_ps(w3, loadComponent8(row3 + i)));
+				_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_add_ps(sum01, sum23)));
+			}
+			accumulateComponentsScalar(row0 + vectorCount, valueCount, weights + k, 4, count - vectorCount, dst + vectorCount);
+		}
+
+		accumulateComponentsScalar(components + k * valueCount, valueCount, weights + k, componentCount - k, count, dst);
+	}
+
+#endif // NVC_SIMD_X86
+
+	void accumulateComponents(const int16_t* components, size_t valueCount, const float* weights, size_t componentCount, size_t count, float* dst)
+	{
+		switch (GetSimdLevel())
+		{
+#if NVC_SIMD_X86
+		case SimdLevel::AVX2:	accumulateComponentsAVX2(components, valueCount, weights, componentCount, count, dst);	break;
+		case SimdLevel::SSE41:	accumulateComponentsSSE41(components, valueCount, weights, componentCount, count, dst);	break;
+#endif
+		default:				accumulateComponentsScalar(components, valueCount, weights, componentCount, count, dst);	break;
+		}
+	}
+}
+
+PcaBasis buildPcaBasis(const float* const* frames, size_t frameCount, size_t valueCount, float maxRmsError, size_t maxComponentCount)
+{
+	PcaBasis basis;
+	basis.ValueCount = valueCount;
+	basis.Mean.assign(valueCount, 0.0f);
+	if (frameCount == 0 || valueCount == 0)
+	{
+		return basis;
+	}
+
+	// Mean of every value over the frames.
+	const size_t blockCount = ceildiv(valueCount, BlockSize);
+	parallel_for(size_t(0), blockCount, [&](size_t iBlock) {
+		const size_t first = iBlock * BlockSize;
+		const size_t count = std::min(BlockSize, valueCount - first);
+		std::vector<double> sums(count, 0.0);
+		for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				sums[i] += frames[iFrame][first + i];
+			}
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			basis.Mean[first + i] = static_cast<float>(sums[i] / frameCount);
+		}
+	});
+
+	// The eigenvectors of the Gram matrix give the principal components as combinations of the frames.
+	std::vector<double> gram = buildGramMatrix(frames, frameCount, valueCount, basis.Mean);
+	std::vector<double> eigenvalues;
+	std::vector<double> eigenvectors;
+	jacobiEigen(gram, frameCount, eigenvalues, eigenvectors);
+
+	std::vector<size_t> order(frameCount);
+	for (size_t i = 0; i < frameCount; ++i)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return eigenvalues[lhs] > eigenvalues[rhs]; });
+
+	// The squared error of dropping components is the sum of their eigenvalues.
+	const double maxSquaredError = static_cast<double>(maxRmsError) * maxRmsError * frameCount * valueCount;
+	double droppedEnergy = 0.0;
+	for (size_t i = 0; i < frameCount; ++i)
+	{
+		droppedEnergy += std::max(eigenvalues[i], 0.0);
+	}
+
+	size_t componentCount = 0;
+	while (componentCount < std::min(frameCount, maxComponentCount)
+		&& droppedEnergy > maxSquaredError
+		&& eigenvalues[order[componentCount]] > 0.0)
+	{
+		droppedEnergy -= eigenvalues[order[componentCount]];
+		++componentCount;
+	}
+
+	// component k = sum over frames i of eigenvector k[i] * (frames[i] - mean), normalised, then quantised
+	// with its largest magnitude at 32767.
+	std::vector<float> frameWeights(componentCount * frameCount);
+	for (size_t k = 0; k < componentCount; ++k)
+	{
+		for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+		{
+			frameWeights[k * frameCount + iFrame] = static_cast<float>(eigenvectors[iFrame * frameCount + order[k]] / std::sqrt(eigenvalues[order[k]]));
+		}
+	}
+
+	// Each block of a component is summed while it's in L1.
+	std::vector<float> components(componentCount * valueCount);
+	parallel_for(size_t(0), blockCount, [&](size_t iBlock) {
+		const size_t first = iBlock * BlockSize;
+		const size_t count = std::min(BlockSize, valueCount - first);
+		std::vector<float> centered(frameCount * BlockSize);
+		for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				centered[iFrame * BlockSize + i] = frames[iFrame][first + i] - basis.Mean[first + i];
+			}
+		}
+		for (size_t k = 0; k < componentCount; ++k)
+		{
+			for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+			{
+				axpy(frameWeights[k * frameCount + iFrame], &centered[iFrame * BlockSize], &components[k * valueCount + first], count);
+			}
+		}
+	});
+
+	basis.ComponentCount = componentCount;
+	basis.Components.resize(componentCount * valueCount);
+	parallel_for(size_t(0), componentCount, [&](size_t k) {
+		const float* component = &components[k * valueCount];
+		float maxMagnitude = 0.0f;
+		for (size_t i = 0; i < valueCount; ++i)
+		{
+			maxMagnitude = std::max(maxMagnitude, std::fabs(component[i]));
+		}
+
+		const float scale = maxMagnitude > 0.0f ? 32767.0f / maxMagnitude : 0.0f;
+		int16_t* quantised = &basis.Components[k * valueCount];
+		for (size_t i = 0; i < valueCount; ++i)
+		{
+			quantised[i] = static_cast<int16_t>(std::lround(component[i] * scale));
+		}
+	});
+
+	return basis;
+}
+
+void projectOnPcaBasis(const PcaBasis& basis, const float* const* frames, size_t frameCount, float* weights, size_t weightStride)
+{
+	const size_t componentCount = basis.ComponentCount;
+	if (componentCount == 0)
+	{
+		return;
+	}
+
+	// The normal equations: products of the components with each other and with every centered frame,
+	// summed like the Gram matrix.
+	const size_t productCount = componentCount * componentCount + frameCount * componentCount;
+	const size_t blockCount = ceildiv(basis.ValueCount, BlockSize);
+	const size_t partialCount = std::max<size_t>(1, std::min(blockCount, MaxPartialGramSize / (productCount * sizeof(double))));
+	std::vector<std::vector<double>> partials(partialCount);
+
+	parallel_for(size_t(0), partialCount, [&](size_t iPartial) {
+		std::vector<double>& partial = partials[iPartial];
+		partial.assign(productCount, 0.0);
+		double* componentProducts = partial.data();
+		double* frameProducts = partial.data() + componentCount * componentCount;
+		std::vector<float> components(componentCount * BlockSize);
+		std::vector<float> centered(BlockSize);
+
+		for (size_t iBlock = iPartial; iBlock < blockCount; iBlock += partialCount)
+		{
+			const size_t first = iBlock * BlockSize;
+			const size_t count = std::min(BlockSize, basis.ValueCount - first);
+			for (size_t k = 0; k < componentCount; ++k)
+			{
+				const int16_t* component = &basis.Components[k * basis.ValueCount + first];
+				for (size_t i = 0; i < count; ++i)
+				{
+					components[k * BlockSize + i] = static_cast<float>(component[i]);
+				}
+				for (size_t l = 0; l <= k; ++l)
+				{
+					componentProducts[k * componentCount + l] += dot(&components[k * BlockSize], &components[l * BlockSize], count);
+				}
+			}
+
+			for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					centered[i] = frames[iFrame][first + i] - basis.Mean[first + i];
+				}
+				for (size_t k = 0; k < componentCount; ++k)
+				{
+					frameProducts[iFrame * componentCount + k] += dot(&components[k * BlockSize], centered.data(), count);
+				}
+			}
+		}
+	});
+
+	std::vector<double> products(productCount, 0.0);
+	for (const std::vector<double>& partial : partials)
+	{
+		for (size_t i = 0; i < productCount; ++i)
+		{
+			products[i] += partial[i];
+		}
+	}
+
+	// Cholesky factorisation of the component products (lower triangle), the components are independent.
+	std::vector<double> factor(componentCount * componentCount, 0.0);
+	for (size_t k = 0; k < componentCount; ++k)
+	{
+		for (size_t l = 0; l <= k; ++l)
+		{
+			double sum = products[k * componentCount + l];
+			for (size_t m = 0; m < l; ++m)
+			{
+				sum -= factor[k * componentCount + m] * factor[l * componentCount + m];
+			}
+			factor[k * componentCount + l] = k == l ? std::sqrt(std::max(sum, 1e-300)) : sum / factor[l * componentCount + l];
+		}
+	}
+
+	const double* frameProducts = products.data() + componentCount * componentCount;
+	std::vector<double> solution(componentCount);
+	for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+	{
+		for (size_t k = 0; k < componentCount; ++k)
+		{
+			double sum = frameProducts[iFrame * componentCount + k];
+			for (size_t m = 0; m < k; ++m)
+			{
+				sum -= factor[k * componentCount + m] * solution[m];
+			}
+			solution[k] = sum / factor[k * componentCount + k];
+		}
+		for (size_t k = componentCount; k-- > 0;)
+		{
+			double sum = solution[k];
+			for (size_t m = k + 1; m < componentCount; ++m)
+			{
+				sum -= factor[m * componentCount + k] * solution[m];
+			}
+			solution[k] = sum / factor[k * componentCount + k];
+		}
+		for (size_t k = 0; k < componentCount; ++k)
+		{
+			weights[iFrame * weightStride + k] = static_cast<float>(solution[k]);
+		}
+	}
+}
+
+void reconstructFromPcaBasis(const PcaBasis& basis, const float* weights, size_t firstValue, size_t count, float* dst)
+{
+	assert(firstValue + count <= basis.ValueCount);
+
+	for (size_t blockStart = 0; blockStart < count; blockStart += BlockSize)
+	{
+		const size_t blockCount = std::min(BlockSize, count - blockStart);
+		const size_t first = firstValue + blockStart;
+
+		memcpy(dst + blockStart, &basis.Mean[first], sizeof(float) * blockCount);
+		if (basis.ComponentCount > 0)
+		{
+			accumulateComponents(&basis.Components[first], basis.ValueCount, weights, basis.ComponentCount, blockCount, dst + blockStart);
+		}
+	}
+}
+
+} // namespace nvc
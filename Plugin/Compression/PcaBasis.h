@@ -0,0 +1,32 @@
+#pragma once
+
+namespace nvc
+{
+
+// Principal component basis of an attribute over the frames of a sequence with a fixed vertex count.
+// A frame's values (vertex count * components per vertex floats) are approximated by
+//   Mean + sum over k of weight[k] * Components[k]
+// with a few weights per frame. The components are quantised to int16, each scaled to the full range, and the
+// weights are relative to the quantised components, so no scale is stored.
+struct PcaBasis
+{
+	size_t ValueCount = 0;
+	size_t ComponentCount = 0;
+	std::vector<float> Mean;			// [ValueCount]
+	std::vector<int16_t> Components;	// [ComponentCount][ValueCount], most significant first.
+};
+
+// Builds the basis of frames[frameCount] with the fewest components such that the RMS error of the truncation
+// over every value of every frame is at most maxRmsError, capped at maxComponentCount.
+// The components are the eigenvectors of the frames' Gram matrix (snapshot method), so the cost is
+// frameCount^2 * valueCount, not valueCount^2.
+PcaBasis buildPcaBasis(const float* const* frames, size_t frameCount, size_t valueCount, float maxRmsError, size_t maxComponentCount);
+
+// Writes the weights approximating each of frames[frameCount] (ValueCount floats) to weights[frame * weightStride + k].
+// They're the least squares fit on the quantised components, which are only nearly orthogonal.
+void projectOnPcaBasis(const PcaBasis& basis, const float* const* frames, size_t frameCount, float* weights, size_t weightStride);
+
+// Reconstructs values [firstValue, firstValue + count) of a frame from its weights.
+void reconstructFromPcaBasis(const PcaBasis& basis, const float* weights, size_t firstValue, size_t count, float* dst);
+
+} // namespace nvc
@@ -0,0 +1,338 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "PcaCompressor.h"
+
+//! Project Includes.
+#include "PcaTypes.h"
+#include "PcaBasis.h"
+#include "FrameTopology.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/Stream/Stream.h"
+
+namespace nvc
+{
+
+namespace
+{
+	struct StoredAttribute
+	{
+		size_t InputIndex;
+		DataFormat Format;
+		bool HasBasis;
+		PcaBasis Basis;
+		size_t FirstWeight; // Of the attribute's weights in the frame's weights.
+	};
+
+	// The format decodeAttribute() outputs for an attribute: only attributes in that format can have a basis,
+	// which reconstructs the input values.
+	DataFormat getDecodedFormat(const char* semantic)
+	{
+		if (_stricmp(semantic, nvcSEMANTIC_POINTS) == 0
+			|| _stricmp(semantic, nvcSEMANTIC_VELOCITIES) == 0
+			|| _stricmp(semantic, nvcSEMANTIC_NORMALS) == 0)
+		{
+			return DataFormat::Float3;
+		}
+		if (_stricmp(semantic, nvcSEMANTIC_TANGENTS) == 0)
+		{
+			return DataFormat::Float4;
+		}
+		if (_stricmp(semantic, nvcSEMANTIC_UV0) == 0
+			|| _stricmp(semantic, nvcSEMANTIC_UV1) == 0)
+		{
+			return DataFormat::Float2;
+		}
+		return DataFormat::Unknown;
+	}
+
+	// The vertex count of every frame, or 0 if it changes or a frame has no vertices.
+	size_t getFixedVertexCount(const InputGeomCache& geomCache)
+	{
+		size_t vertexCount = 0;
+		const size_t frameCount = geomCache.getDataCount();
+		for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+		{
+			float time = 0.0f;
+			GeomCacheData frameData{};
+			geomCache.getData(iFrame, time, &frameData);
+			if (frameData.vertices == nullptr || frameData.vertexCount == 0
+				|| (iFrame > 0 && frameData.vertexCount != vertexCount))
+			{
+				return 0;
+			}
+			vertexCount = frameData.vertexCount;
+		}
+		return vertexCount;
+	}
+
+	// The values of an attribute in every frame.
+	std::vector<const float*> getAttributeFrames(const InputGeomCache& geomCache, size_t iAttribute)
+	{
+		std::vector<const float*> frames(geomCache.getDataCount());
+		for (size_t iFrame = 0; iFrame < frames.size(); ++iFrame)
+		{
+			float time = 0.0f;
+			GeomCacheData frameData{};
+			geomCache.getData(iFrame, time, &frameData);
+			frames[iFrame] = static_cast<const float*>(frameData.vertices[iAttribute]);
+		}
+		return frames;
+	}
+
+	// Largest range of a component of the values over every frame.
+	float getExtent(const std::vector<const float*>& frames, size_t vertexCount, size_t componentCount)
+	{
+		float extent = 0.0f;
+		for (size_t iComponent = 0; iComponent < componentCount; ++iComponent)
+		{
+			float min = frames[0][iComponent];
+			float max = min;
+			for (const float* values : frames)
+			{
+				for (size_t iVertex = 0; iVertex < vertexCount; ++iVertex)
+				{
+					min = std::min(min, values[iVertex * componentCount + iComponent]);
+					max = std::max(max, values[iVertex * componentCount + iComponent]);
+				}
+			}
+			extent = std::max(extent, max - min);
+		}
+		return extent;
+	}
+}
+
+bool PcaCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
+{
+	if (!pStream->canWrite())
+	{
+		return false;
+	}
+
+	GeomCacheDesc geomDesc[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	geomCache.getDesc(geomDesc);
+
+	InputGeomCacheConstantData geomConstantData {};
+	geomCache.getConstantData(geomConstantData);
+
+	const size_t frameCount = geomCache.getDataCount();
+	const size_t basisVertexCount = getFixedVertexCount(geomCache);
+
+	// Find the stored attributes, ids aren't stored. With a fixed vertex count, build the bases.
+	std::vector<StoredAttribute> attributes;
+	size_t weightCount = 0;
+
+	const size_t attributeCount = getAttributeCount(geomDesc);
+	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	{
+		const char* semantic = geomDesc[iAttribute].semantic;
+		if (semantic == nullptr
+			|| _stricmp(semantic, nvcSEMANTIC_VERTEXID) == 0
+			|| _stricmp(semantic, nvcSEMANTIC_MESHID) == 0)
+		{
+			continue;
+		}
+
+		attributes.push_back(StoredAttribute{ iAttribute, geomDesc[iAttribute].format, false, PcaBasis{}, 0 });
+		StoredAttribute& attribute = attributes.back();
+		if (basisVertexCount == 0 || attribute.Format != getDecodedFormat(semantic))
+		{
+			continue;
+		}
+
+		const std::vector<const float*> frames = getAttributeFrames(geomCache, iAttribute);
+		const size_t componentsPerVertex = getSizeOfDataFormat(attribute.Format) / sizeof(float);
+		const size_t valueCount = basisVertexCount * componentsPerVertex;
+		const float maxRmsError = m_MaxRelativeError * getExtent(frames, basisVertexCount, componentsPerVertex);
+		attribute.Basis = buildPcaBasis(frames.data(), frameCount, valueCount, maxRmsError, m_MaxComponentCount);
+
+		// Keep the basis if it's smaller than the raw frames.
+		const size_t basisSize = sizeof(float) * valueCount
+			+ sizeof(int16_t) * attribute.Basis.ComponentCount * valueCount
+			+ sizeof(float) * attribute.Basis.ComponentCount * frameCount;
+		if (basisSize < sizeof(float) * valueCount * frameCount)
+		{
+			attribute.HasBasis = true;
+			attribute.FirstWeight = weightCount;
+			weightCount += attribute.Basis.ComponentCount;
+		}
+		else
+		{
+			attribute.Basis = PcaBasis{};
+		}
+	}
+
+	// Weights of every frame, [frame][weight].
+	std::vector<float> weights(frameCount * weightCount);
+	for (const StoredAttribute& attribute : attributes)
+	{
+		if (attribute.HasBasis)
+		{
+			const std::vector<const float*> frames = getAttributeFrames(geomCache, attribute.InputIndex);
+			projectOnPcaBasis(attribute.Basis, frames.data(), frameCount, &weights[attribute.FirstWeight], weightCount);
+		}
+	}
+
+	const bool isFileTopologyShared = isTopologyConstant(geomCache);
+
+	// Write header.
+	const pca_compression::FileHeader header
+	{
+		static_cast<uint64_t>(frameCount),
+		static_cast<uint32_t>(DefaultSeekWindow),
+		static_cast<uint32_t>(attributes.size()),
+		static_cast<uint32_t>(geomConstantData.getSizeAsByteArray()),
+		pca_compression::FILE_FLAG_FRAME_INDEX
+			| pca_compression::FILE_FLAG_INDEX_CODED
+			| (isFileTopologyShared ? pca_compression::FILE_FLAG_SHARED_TOPOLOGY : 0u),
+		static_cast<uint32_t>(basisVertexCount),
+		static_cast<uint32_t>(weightCount)
+	};
+
+	pStream->write(header);
+
+	// Write the descriptor.
+	char buffer[pca_compression::SEMANTIC_STRING_LENGTH] = {};
+	for (const StoredAttribute& attribute : attributes)
+	{
+		memset(buffer, 0, sizeof(buffer));
+		assert(strlen(geomDesc[attribute.InputIndex].semantic) < pca_compression::SEMANTIC_STRING_LENGTH);
+		sprintf(buffer, "%s", geomDesc[attribute.InputIndex].semantic);
+
+		pStream->write(buffer, sizeof(buffer));
+		pStream->write<uint32_t>(static_cast<uint32_t>(attribute.Format));
+		pStream->write<uint32_t>(attribute.HasBasis ? static_cast<uint32_t>(attribute.Basis.ComponentCount) : pca_compression::NO_BASIS);
+	}
+
+	// Calculate frame offsets and write a dummy entry in the stream to hold the value later.
+	const size_t frameSeekTableOffset = pStream->getPosition();
+	const size_t frameSeekTableSize = (header.FrameCount + header.FrameSeekWindowCount - 1) / header.FrameSeekWindowCount;
+	for (uint64_t iEntry = 0; iEntry < frameSeekTableSize; ++iEntry)
+	{
+		pStream->write(static_cast<uint64_t>(0));
+	}
+
+	// Same for the frame index.
+	const size_t frameIndexOffset = pStream->getPosition();
+	std::vector<pca_compression::FrameIndexEntry> frameIndexValues(header.FrameCount, pca_compression::FrameIndexEntry{});
+	pStream->write(frameIndexValues.data(), sizeof(pca_compression::FrameIndexEntry) * frameIndexValues.size());
+
+	// Write constant data.
+	if (header.ConstantDataSize > 0)
+	{
+		geomConstantData.storeDataTo(pStream);
+	}
+
+	// Write time array.
+	for (uint64_t iFrame = 0; iFrame < header.FrameCount; ++iFrame)
+	{
+		float time = 0.0f;
+		GeomCacheData frameData{};
+		geomCache.getData(iFrame, time, &frameData);
+
+		pStream->write(time);
+	}
+
+	// Write the topology shared by every frame.
+	if (isFileTopologyShared)
+	{
+		float time = 0.0f;
+		GeomCacheData frameData{};
+		geomCache.getData(0, time, &frameData);
+
+		pStream->write<uint64_t>(frameData.indexCount);
+		writeTopology(pStream, frameData, true);
+	}
+
+	// Write the bases, then the weights of every frame.
+	for (const StoredAttribute& attribute : attributes)
+	{
+		if (attribute.HasBasis)
+		{
+			pStream->write(attribute.Basis.Mean.data(), sizeof(float) * attribute.Basis.Mean.size());
+			if (attribute.Basis.ComponentCount > 0)
+			{
+				pStream->write(attribute.Basis.Components.data(), sizeof(int16_t) * attribute.Basis.Components.size());
+			}
+		}
+	}
+	if (!weights.empty())
+	{
+		pStream->write(weights.data(), sizeof(float) * weights.size());
+	}
+
+	// Write frames.
+	std::vector<uint64_t> frameSeekTableValues;
+	GeomCacheData windowTopology{};
+	bool hasWindowTopology = false;
+
+	for (uint64_t iFrame = 0; iFrame < header.FrameCount; ++iFrame)
+	{
+		const bool isWindowStart = (iFrame % header.FrameSeekWindowCount) == 0;
+		if (isWindowStart)
+		{
+			frameSeekTableValues.push_back(pStream->getPosition());
+			hasWindowTopology = false;
+		}
+		frameIndexValues[iFrame].Offset = pStream->getPosition();
+
+		float time = 0.0f;
+		GeomCacheData frameData{};
+		geomCache.getData(iFrame, time, &frameData);
+		if (frameData.vertices == nullptr)
+		{
+			continue; // Error?
+		}
+
+		// The first frame of a seek window always stores its topology, so the window stays decodable on its own.
+		const bool isTopologyShared = isFileTopologyShared
+			|| (hasWindowTopology && hasSameTopology(windowTopology, frameData));
+
+		const pca_compression::FrameHeader frameHeader
+		{
+			static_cast<uint32_t>(frameData.indexCount),
+			static_cast<uint32_t>(frameData.vertexCount),
+			isTopologyShared ? pca_compression::FRAME_FLAG_SHARED_TOPOLOGY : 0u
+		};
+
+		pStream->write(frameHeader);
+
+		// Write mesh, submesh and index data.
+		if (!isTopologyShared)
+		{
+			writeTopology(pStream, frameData, true);
+		}
+
+		if (isWindowStart)
+		{
+			windowTopology = frameData;
+			hasWindowTopology = true;
+		}
+
+		// Write the attributes without a basis.
+		for (const StoredAttribute& attribute : attributes)
+		{
+			if (!attribute.HasBasis)
+			{
+				pStream->write(frameData.vertices[attribute.InputIndex], getSizeOfDataFormat(attribute.Format) * frameData.vertexCount);
+			}
+		}
+
+		frameIndexValues[iFrame].Size = pStream->getPosition() - frameIndexValues[iFrame].Offset;
+	}
+
+	// Update the frame seek table with the real offsets.
+	pStream->seek(frameSeekTableOffset, Stream::SeekOrigin::Begin);
+	for (uint64_t iEntry = 0; iEntry < frameSeekTableValues.size(); ++iEntry)
+	{
+		pStream->write(frameSeekTableValues[iEntry]);
+	}
+
+	pStream->seek(frameIndexOffset, Stream::SeekOrigin::Begin);
+	pStream->write(frameIndexValues.data(), sizeof(pca_compression::FrameIndexEntry) * frameIndexValues.size());
+
+	return true;
+}
+
+} //namespace nvc
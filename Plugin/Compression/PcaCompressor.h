@@ -0,0 +1,39 @@
+#pragma once
+
+//! Local Includes.
+#include "ICompressor.h"
+
+namespace nvc
+{
+
+// Stores the float attributes of a sequence with a fixed vertex count as a principal component basis per
+// attribute for the whole file, and a few weights per frame (see PcaBasis.h). Each basis has the fewest
+// components keeping the RMS error within maxRelativeError of the attribute's extent, up to maxComponentCount.
+// Attributes whose basis wouldn't be smaller than their frames, and every attribute of a sequence whose vertex
+// count changes, are stored raw in each frame.
+class PcaCompressor final : public ICompressor
+{
+public:
+	static const size_t DefaultSeekWindow = 10;
+	static const size_t DefaultMaxComponentCount = 64;
+	static constexpr float DefaultMaxRelativeError = 1e-4f;
+
+public:
+	explicit PcaCompressor(float maxRelativeError = DefaultMaxRelativeError, size_t maxComponentCount = DefaultMaxComponentCount)
+		: m_MaxRelativeError(maxRelativeError), m_MaxComponentCount(maxComponentCount) {}
+	~PcaCompressor() = default;
+
+	bool compress(const InputGeomCache& geomCache, Stream* pStream) override;
+
+	//...
+	PcaCompressor(const PcaCompressor&) = delete;
+	PcaCompressor(PcaCompressor&&) = delete;
+	PcaCompressor& operator=(const PcaCompressor&) = delete;
+	PcaCompressor& operator=(PcaCompressor&&) = delete;
+
+private:
+	float m_MaxRelativeError = DefaultMaxRelativeError;
+	size_t m_MaxComponentCount = DefaultMaxComponentCount;
+};
+
+} // namespace nvc
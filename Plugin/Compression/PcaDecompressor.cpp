@@ -0,0 +1,505 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "PcaDecompressor.h"
+
+//! Project Includes.
+#include "Plugin/Stream/Stream.h"
+#include "Plugin/InputGeomCache.h"
+
+namespace nvc
+{
+
+PcaDecompressor::~PcaDecompressor()
+{
+	close();
+}
+
+void PcaDecompressor::open(Stream* pStream)
+{
+	close();
+
+	m_pStream = pStream;
+
+	// Read the file header.
+	m_pStream->read(m_Header);
+
+	// Read the descriptor.
+	for (uint32_t iElement = 0; iElement < m_Header.VertexAttributeCount; ++iElement)
+	{
+		m_pStream->read(m_Semantics[iElement], sizeof(char) * pca_compression::SEMANTIC_STRING_LENGTH);
+
+		uint32_t format = 0;
+		m_pStream->read(format);
+		const uint32_t basisComponentCount = m_pStream->read<uint32_t>();
+
+		m_Descriptor[iElement].semantic = m_Semantics[iElement];
+		m_Descriptor[iElement].format = static_cast<DataFormat>(format);
+
+		// Frames don't store the basis attributes.
+		m_FrameDescriptor[iElement].semantic = m_Semantics[iElement];
+		m_FrameDescriptor[iElement].format = basisComponentCount == pca_compression::NO_BASIS ? m_Descriptor[iElement].format : DataFormat::Unknown;
+
+		AttributeBasis attributeBasis{};
+		if (basisComponentCount != pca_compression::NO_BASIS)
+		{
+			attributeBasis.HasBasis = true;
+			attributeBasis.Basis.ComponentCount = basisComponentCount;
+			attributeBasis.Basis.ValueCount = m_Header.BasisVertexCount * getSizeOfDataFormat(m_Descriptor[iElement].format) / sizeof(float);
+		}
+		m_Bases.push_back(attributeBasis);
+	}
+
+	m_FramesOffset = m_pStream->getPosition();
+
+	// Read the seek table.
+	const size_t seekTableSize = (m_Header.FrameCount + m_Header.FrameSeekWindowCount - 1) / m_Header.FrameSeekWindowCount;
+	for (uint64_t iEntry = 0; iEntry < seekTableSize; ++iEntry)
+	{
+		m_SeekTable.push_back(m_pStream->read<uint64_t>());
+	}
+
+	// Read the frame index.
+	assert((m_Header.Flags & pca_compression::FILE_FLAG_FRAME_INDEX) != 0);
+	m_FrameIndex.resize(m_Header.FrameCount);
+	m_pStream->read(m_FrameIndex.data(), sizeof(pca_compression::FrameIndexEntry) * m_FrameIndex.size());
+
+	// Read constant data
+	if(m_Header.ConstantDataSize > 0)
+	{
+		m_ConstantData.resize(m_Header.ConstantDataSize);
+		m_pStream->read(m_ConstantData.data(), m_ConstantData.size());
+	}
+
+	// Read the time table.
+	for (size_t iFrame = 0; iFrame < m_Header.FrameCount; ++iFrame)
+	{
+		m_FrameTimeTable.push_back(m_pStream->read<float>());
+	}
+
+	m_LoadedFrames.resize(m_Header.FrameCount);
+
+	// Read the topology shared by every frame, or prepare for the per window ones.
+	if ((m_Header.Flags & pca_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		const size_t indexCount = static_cast<size_t>(m_pStream->read<uint64_t>());
+		m_FileTopologyBlock = readTopology(m_pStream, m_FramePool, indexCount, isIndexCoded(), m_FileTopology, m_FileTopologyBlockSize);
+		assert(m_FileTopologyBlock != nullptr);
+	}
+	else
+	{
+		m_WindowTopologies.resize(m_SeekTable.size());
+	}
+
+	// Read the bases, then the weights of every frame.
+	size_t weightCount = 0;
+	for (AttributeBasis& attributeBasis : m_Bases)
+	{
+		if (attributeBasis.HasBasis)
+		{
+			PcaBasis& basis = attributeBasis.Basis;
+			basis.Mean.resize(basis.ValueCount);
+			basis.Components.resize(basis.ComponentCount * basis.ValueCount);
+			m_pStream->read(basis.Mean.data(), sizeof(float) * basis.Mean.size());
+			if (basis.ComponentCount > 0)
+			{
+				m_pStream->read(basis.Components.data(), sizeof(int16_t) * basis.Components.size());
+			}
+
+			attributeBasis.FirstWeight = weightCount;
+			weightCount += basis.ComponentCount;
+		}
+	}
+	assert(weightCount == m_Header.WeightCount);
+
+	if (m_Header.WeightCount > 0)
+	{
+		m_Weights.resize(m_Header.FrameCount * m_Header.WeightCount);
+		m_pStream->read(m_Weights.data(), sizeof(float) * m_Weights.size());
+	}
+}
+
+void PcaDecompressor::close()
+{
+	for (size_t iFrame = 0; iFrame < m_LoadedFrames.getFrameCount(); ++iFrame)
+	{
+		if (m_LoadedFrames.isLoaded(iFrame))
+		{
+			freeFrame(m_LoadedFrames[iFrame]);
+		}
+	}
+
+	m_Header = {};
+	m_pStream = nullptr;
+	memset(m_Descriptor, 0, sizeof(m_Descriptor));
+	memset(m_FrameDescriptor, 0, sizeof(m_FrameDescriptor));
+	m_SeekTable.clear();
+	m_FrameIndex.clear();
+	m_FrameTimeTable.clear();
+	m_ConstantData.clear();
+	m_Bases.clear();
+	m_Weights.clear();
+
+	m_LoadedFrames.clear();
+	m_FramesOffset = 0;
+
+	m_WindowTopologies.clear(m_FramePool);
+	m_FramePool.deallocate(m_FileTopologyBlock, m_FileTopologyBlockSize);
+	m_FileTopology = {};
+	m_FileTopologyBlock = nullptr;
+	m_FileTopologyBlockSize = 0;
+	m_WalkTopologyWindow = InvalidFrameIndex;
+
+	m_FramePool.clear();
+}
+
+void PcaDecompressor::prefetch(size_t frameIndex, size_t range)
+{
+	// The budget or pinned range may have changed since the last load.
+	evictFrames();
+
+	const size_t endFrame = std::min<size_t>(frameIndex + range, getFrameCount());
+
+	// Start from the first frame which isn't resident yet.
+	size_t firstFrame = frameIndex;
+	while (firstFrame < endFrame && m_LoadedFrames.isLoaded(firstFrame))
+	{
+		++firstFrame;
+	}
+
+	if (firstFrame >= endFrame)
+	{
+		return;
+	}
+
+	// Frames are read through the frame index, each on its own.
+	for (size_t iFrame = firstFrame; iFrame < endFrame; ++iFrame)
+	{
+		if (!m_LoadedFrames.isLoaded(iFrame))
+		{
+			loadIndexedFrame(iFrame);
+		}
+	}
+
+	releaseWalkTopology();
+}
+
+bool PcaDecompressor::getData(size_t frameIndex, float& time, GeomCacheData& data)
+{
+	time = getFrameTime(frameIndex);
+	if (std::isfinite(time))
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		if (!m_LoadedFrames.isLoaded(frameIndex))
+		{
+			return false;
+		}
+
+		// Move to the front of the LRU list.
+		m_LoadedFrames.touch(frameIndex);
+
+		data = m_LoadedFrames[frameIndex].Data;
+		return true;
+	}
+
+	return false;
+}
+
+bool PcaDecompressor::getData(float time, GeomCacheData& data)
+{
+	float frameTime = 0.0f;
+	return getData(getFrameIndex(time), frameTime, data);
+}
+
+size_t PcaDecompressor::getConstantDataStringSize() const
+{
+	if (!m_ConstantData.empty())
+	{
+		return InputGeomCacheConstantData::getStringCountFromData(m_ConstantData.data(), m_ConstantData.size());
+	}
+	return 0;
+}
+
+const char* PcaDecompressor::getConstantDataString(size_t index) const
+{
+	if (!m_ConstantData.empty())
+	{
+		return InputGeomCacheConstantData::getStringFromData(m_ConstantData.data(), m_ConstantData.size(), index);
+	}
+	return nullptr;
+}
+
+bool PcaDecompressor::decodeAttribute(size_t /*frameIndex*/, const GeomCacheData& data, size_t iAttribute, size_t firstVertex, size_t vertexCount, void* dst) const
+{
+	if (data.vertices == nullptr || iAttribute >= m_Bases.size() || !m_Bases[iAttribute].HasBasis)
+	{
+		return false;
+	}
+	assert(firstVertex + vertexCount <= data.vertexCount);
+	assert(data.vertexCount == m_Header.BasisVertexCount);
+
+	// The frame's attribute points at its weights (see loadFrame()). Disjoint ranges reconstruct independently,
+	// which is how decodes of a frame run in parallel.
+	const size_t componentsPerVertex = getSizeOfDataFormat(m_Descriptor[iAttribute].format) / sizeof(float);
+	reconstructFromPcaBasis(m_Bases[iAttribute].Basis, static_cast<const float*>(data.vertices[iAttribute])
+		, firstVertex * componentsPerVertex, vertexCount * componentsPerVertex, static_cast<float*>(dst));
+	return true;
+}
+
+// Reads a single frame through the frame index. A frame sharing its window topology which isn't resident
+// reads it from the window's first frame beforehand.
+void PcaDecompressor::loadIndexedFrame(size_t frameIndex)
+{
+	const pca_compression::FrameIndexEntry& entry = m_FrameIndex[frameIndex];
+	if (entry.Size == 0)
+	{
+		return;
+	}
+
+	pca_compression::FrameHeader frameHeader{};
+	m_pStream->seek(entry.Offset, Stream::SeekOrigin::Begin);
+	m_pStream->read(frameHeader);
+
+	const GeomCacheData* sharedTopology = loadSharedTopology(frameIndex, frameHeader);
+	if (sharedTopology == nullptr && (frameHeader.Flags & pca_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		const size_t windowStart = getSeekTableIndex(frameIndex) * m_Header.FrameSeekWindowCount;
+
+		pca_compression::FrameHeader windowHeader{};
+		m_pStream->seek(m_FrameIndex[windowStart].Offset, Stream::SeekOrigin::Begin);
+		m_pStream->read(windowHeader);
+		sharedTopology = loadSharedTopology(windowStart, windowHeader);
+
+		m_pStream->seek(entry.Offset + sizeof(frameHeader), Stream::SeekOrigin::Begin);
+	}
+
+	loadFrame(frameIndex, frameHeader, sharedTopology);
+}
+
+// The stream is past the frame header, and past the topology if sharedTopology comes from loadSharedTopology().
+void PcaDecompressor::loadFrame(size_t frameIndex, const pca_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology)
+{
+	const bool hasTopology = sharedTopology == nullptr;
+	if (hasTopology && (frameHeader.Flags & pca_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		// The window topology couldn't be loaded.
+		return;
+	}
+
+	FrameDataType frameData{};
+	frameData.Time = m_FrameTimeTable[frameIndex];
+	frameData.Data.vertexCount = frameHeader.VertexCount;
+
+	if (hasTopology)
+	{
+		// The submesh count follows the meshes, peek at it so the whole frame fits in one block.
+		frameData.Data.indexCount = frameHeader.IndexCount;
+		frameData.Data.meshCount = m_pStream->read<uint64_t>();
+		const size_t meshesOffset = m_pStream->getPosition();
+		m_pStream->seek(sizeof(GeomMesh) * frameData.Data.meshCount, Stream::SeekOrigin::Current);
+		frameData.Data.submeshCount = m_pStream->read<uint64_t>();
+		m_pStream->seek(meshesOffset, Stream::SeekOrigin::Begin);
+	}
+
+	frameData.Block = m_FramePool.allocateFrame(frameData.Data, m_FrameDescriptor, frameData.BlockSize);
+	if (frameData.Block == nullptr)
+	{
+		return;
+	}
+
+	if (hasTopology)
+	{
+		m_pStream->read(frameData.Data.meshes, sizeof(GeomMesh) * frameData.Data.meshCount);
+		m_pStream->seek(sizeof(uint64_t), Stream::SeekOrigin::Current);
+		m_pStream->read(frameData.Data.submeshes, sizeof(GeomSubmesh) * frameData.Data.submeshCount);
+
+		readIndices(m_pStream, frameHeader.IndexCount, isIndexCoded(), static_cast<int32_t*>(frameData.Data.indices));
+	}
+	else
+	{
+		useSharedTopology(frameIndex, *sharedTopology, frameData);
+	}
+
+	// Raw attributes are read as is, basis attributes point at the frame's weights, they're reconstructed
+	// by decodeAttribute() when the frame is used.
+	if (frameHeader.VertexCount > 0)
+	{
+		const size_t attributeCount = getAttributeCount(m_Descriptor);
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			if (!m_Bases[iAttribute].HasBasis)
+			{
+				m_pStream->read(frameData.Data.vertices[iAttribute], getSizeOfDataFormat(m_Descriptor[iAttribute].format) * frameData.Data.vertexCount);
+			}
+			else if (frameHeader.VertexCount == m_Header.BasisVertexCount)
+			{
+				frameData.Data.vertices[iAttribute] = &m_Weights[frameIndex * m_Header.WeightCount + m_Bases[iAttribute].FirstWeight];
+			}
+			else
+			{
+				freeFrame(frameData);
+				return;
+			}
+		}
+	}
+
+	if (!insertLoadedData(frameIndex, frameData))
+	{
+		freeFrame(frameData);
+	}
+}
+
+void PcaDecompressor::freeFrame(FrameDataType& data)
+{
+	m_FramePool.deallocate(data.Block, data.BlockSize);
+	if (data.TopologyWindow != InvalidFrameIndex)
+	{
+		m_WindowTopologies.release(data.TopologyWindow, m_FramePool);
+	}
+	data.Data = GeomCacheData{};
+	data.Block = nullptr;
+	data.BlockSize = 0;
+	data.TopologyWindow = InvalidFrameIndex;
+}
+
+// Returns the shared topology of a frame, or nullptr if the frame stores its own and the stream is still at it.
+// A seek window's first frame stores the topology shared by the rest of the window: it's read into
+// m_WindowTopologies (or skipped if already there) and stays referenced while prefetch() walks the window.
+const GeomCacheData* PcaDecompressor::loadSharedTopology(size_t frameIndex, const pca_compression::FrameHeader& frameHeader)
+{
+	const size_t window = getSeekTableIndex(frameIndex);
+
+	if ((frameHeader.Flags & pca_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		if ((m_Header.Flags & pca_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0)
+		{
+			return &m_FileTopology;
+		}
+
+		if (window != m_WalkTopologyWindow && m_WindowTopologies.isLoaded(window))
+		{
+			// Still referenced by resident frames of the window, as when a frame is read through the frame index.
+			releaseWalkTopology();
+			m_WindowTopologies.acquire(window);
+			m_WalkTopologyWindow = window;
+		}
+
+		return window == m_WalkTopologyWindow ? &m_WindowTopologies.get(window) : nullptr;
+	}
+
+	if ((m_Header.Flags & pca_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0
+		|| (frameIndex % m_Header.FrameSeekWindowCount) != 0)
+	{
+		return nullptr;
+	}
+
+	releaseWalkTopology();
+
+	if (m_WindowTopologies.isLoaded(window))
+	{
+		skipTopology(m_pStream, frameHeader.IndexCount, isIndexCoded());
+		m_WindowTopologies.acquire(window);
+	}
+	else
+	{
+		const size_t topologyOffset = m_pStream->getPosition();
+
+		GeomCacheData topology{};
+		size_t blockSize = 0;
+		void* block = readTopology(m_pStream, m_FramePool, frameHeader.IndexCount, isIndexCoded(), topology, blockSize);
+		if (block == nullptr)
+		{
+			m_pStream->seek(topologyOffset, Stream::SeekOrigin::Begin);
+			return nullptr;
+		}
+
+		m_WindowTopologies.set(window, topology, block, blockSize);
+	}
+
+	m_WalkTopologyWindow = window;
+	return &m_WindowTopologies.get(window);
+}
+
+void PcaDecompressor::releaseWalkTopology()
+{
+	if (m_WalkTopologyWindow != InvalidFrameIndex)
+	{
+		m_WindowTopologies.release(m_WalkTopologyWindow, m_FramePool);
+		m_WalkTopologyWindow = InvalidFrameIndex;
+	}
+}
+
+// Points a frame at a shared topology, a window topology stays referenced until the frame is freed.
+void PcaDecompressor::useSharedTopology(size_t frameIndex, const GeomCacheData& topology, FrameDataType& frameData)
+{
+	frameData.Data.indices = topology.indices;
+	frameData.Data.indexCount = topology.indexCount;
+	frameData.Data.meshes = topology.meshes;
+	frameData.Data.meshCount = topology.meshCount;
+	frameData.Data.submeshes = topology.submeshes;
+	frameData.Data.submeshCount = topology.submeshCount;
+
+	if (&topology != &m_FileTopology)
+	{
+		frameData.TopologyWindow = getSeekTableIndex(frameIndex);
+		m_WindowTopologies.acquire(frameData.TopologyWindow);
+	}
+}
+
+bool PcaDecompressor::insertLoadedData(size_t frameIndex, FrameDataType& data)
+{
+	if (m_LoadedFrames.isLoaded(frameIndex))
+	{
+		return false;
+	}
+
+	data.Size = data.BlockSize;
+
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+
+		m_LoadedFrames.insert(frameIndex, data);
+	}
+
+	evictFrames();
+	return true;
+}
+
+void PcaDecompressor::setCacheBudget(size_t bytes)
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	m_LoadedFrames.setBudget(bytes);
+}
+
+size_t PcaDecompressor::getCacheSize() const
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	return m_LoadedFrames.getSize();
+}
+
+void PcaDecompressor::setPinnedRange(size_t frameIndex, size_t range)
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	m_LoadedFrames.setPinnedRange(frameIndex, range);
+}
+
+// Drops least recently used frames until the cache fits its budget. Only called from the prefetching
+// thread (prefetch()/loadFrame()), which is the only writer of m_LoadedFrames outside the lock.
+void PcaDecompressor::evictFrames()
+{
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		m_LoadedFrames.evict();
+	}
+
+	// Free outside of the lock, getData() shouldn't wait on the allocator.
+	std::vector<FrameDataType>& evictedFrames = m_LoadedFrames.getEvictedFrames();
+	for (auto& frame : evictedFrames)
+	{
+		freeFrame(frame);
+	}
+	evictedFrames.clear();
+}
+
+} //namespace nvc
@@ -0,0 +1,160 @@
+#pragma once
+
+//! Local Includes.
+#include "IDecompressor.h"
+#include "PcaTypes.h"
+#include "PcaBasis.h"
+
+//! Project Includes.
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/Foundation/Concurrency.h"
+#include "FrameBufferPool.h"
+#include "FrameSlotCache.h"
+#include "FrameTopology.h"
+
+namespace nvc
+{
+
+class PcaDecompressor final : public IDecompressor
+{
+private:
+	Stream* m_pStream = nullptr;
+
+	pca_compression::FileHeader m_Header = {};
+
+	GeomCacheDesc m_Descriptor[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	char m_Semantics[GEOM_CACHE_MAX_DESCRIPTOR_COUNT][pca_compression::SEMANTIC_STRING_LENGTH] = {};
+
+	std::vector<uint64_t> m_SeekTable;
+	std::vector<pca_compression::FrameIndexEntry> m_FrameIndex;
+	std::vector<float> m_FrameTimeTable;
+	std::vector<uint8_t> m_ConstantData;
+
+	struct FrameDataType 
+	{
+		float Time;
+		GeomCacheData Data;
+		void* Block; // Single m_FramePool block holding all the arrays of Data but the basis attributes.
+		size_t BlockSize;
+		size_t Size; // Bytes owned by the frame, counted against the cache budget.
+
+		// LRU list links (frame indices), only frames with Size > 0 are linked.
+		size_t LruPrev;
+		size_t LruNext;
+		size_t TopologyWindow = InvalidFrameIndex; // m_WindowTopologies entry Data refers to.
+	};
+
+	// One slot per frame, parallel to m_FrameTimeTable.
+	FrameSlotCache<FrameDataType> m_LoadedFrames;
+
+	// prefetch() may run on a worker thread while getData() is called, this guards m_LoadedFrames.
+	// note: prefetch() itself must not be called concurrently (it owns the stream cursor).
+	mutable spin_mutex m_LoadedFramesMutex;
+
+	FrameBufferPool m_FramePool;
+
+	size_t m_FramesOffset = 0;
+
+	// Shared topologies: the file's if FILE_FLAG_SHARED_TOPOLOGY is set, otherwise one per seek window.
+	// Only touched by the prefetching thread, like the stream.
+	GeomCacheData m_FileTopology = {};
+	void* m_FileTopologyBlock = nullptr;
+	size_t m_FileTopologyBlockSize = 0;
+	SharedTopologyTable m_WindowTopologies;
+	size_t m_WalkTopologyWindow = InvalidFrameIndex; // Window topology referenced by the running prefetch().
+
+	// Bases of the attributes, in descriptor order, and the weights of every frame: [frame][weight].
+	// Read by open() and constant afterwards, decodeAttribute() reads them without locking.
+	struct AttributeBasis
+	{
+		bool HasBasis = false;
+		size_t FirstWeight = 0;
+		PcaBasis Basis;
+	};
+	std::vector<AttributeBasis> m_Bases;
+	std::vector<float> m_Weights;
+
+	// m_Descriptor with the format of basis attributes Unknown: what the frames store.
+	GeomCacheDesc m_FrameDescriptor[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+
+public:
+	PcaDecompressor() = default;
+	~PcaDecompressor();
+
+	void open(Stream* pStream) override;
+	void close() override;
+	void prefetch(size_t frameIndex, size_t range) override;
+
+	bool getData(size_t frameIndex, float& time, GeomCacheData& data) override;
+	bool getData(float time, GeomCacheData& data) override;
+	const GeomCacheDesc* getDescriptors() const override { return &m_Descriptor[0]; }
+	bool decodeAttribute(size_t frameIndex, const GeomCacheData& data, size_t iAttribute, size_t firstVertex, size_t vertexCount, void* dst) const override;
+	size_t getConstantDataStringSize() const override;
+	const char* getConstantDataString(size_t index) const override;
+
+	void setCacheBudget(size_t bytes) override;
+	size_t getCacheBudget() const override { return m_LoadedFrames.getBudget(); }
+	size_t getCacheSize() const override;
+	void setPinnedRange(size_t frameIndex, size_t range) override;
+
+	const FrameBufferPool& getFramePool() const { return m_FramePool; }
+
+	//...
+	PcaDecompressor(const PcaDecompressor&) = delete;
+	PcaDecompressor(PcaDecompressor&&) = delete;
+	PcaDecompressor& operator=(const PcaDecompressor&) = delete;
+	PcaDecompressor& operator=(PcaDecompressor&&) = delete;
+
+private:
+	size_t getSeekTableIndex(size_t frameIndex) const
+	{
+		return frameIndex / m_Header.FrameSeekWindowCount;
+	}
+
+	bool isIndexCoded() const
+	{
+		return (m_Header.Flags & pca_compression::FILE_FLAG_INDEX_CODED) != 0;
+	}
+
+public:
+	float getFrameTime(size_t frameIndex) const override
+	{
+		if (frameIndex < getFrameCount())
+		{
+			return m_FrameTimeTable[frameIndex];
+		}
+
+		return HUGE_VALF;
+	}
+
+	size_t getFrameIndex(float time) const override
+	{
+		const auto it = std::lower_bound(m_FrameTimeTable.cbegin(), m_FrameTimeTable.cend(), time);
+
+		if (it != m_FrameTimeTable.end())
+		{
+			return (it - m_FrameTimeTable.begin());
+		}
+
+		return ~0u;
+	}
+
+	size_t getFrameCount() const override
+	{
+		return m_Header.FrameCount;
+	}
+
+private:
+	void loadFrame(size_t frameIndex, const pca_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology);
+	void loadIndexedFrame(size_t frameIndex);
+	void freeFrame(FrameDataType& data);
+
+	const GeomCacheData* loadSharedTopology(size_t frameIndex, const pca_compression::FrameHeader& frameHeader);
+	void releaseWalkTopology();
+	void useSharedTopology(size_t frameIndex, const GeomCacheData& topology, FrameDataType& frameData);
+
+	bool insertLoadedData(size_t frameIndex, FrameDataType& data);
+	void evictFrames();
+};
+
+} // namespace nvc
@@ -0,0 +1,54 @@
+#pragma once
+#include "Plugin/Foundation/Types.h"
+
+namespace nvc
+{
+
+namespace pca_compression
+{
+	struct FileHeader
+	{
+		uint64_t FrameCount;
+		uint32_t FrameSeekWindowCount;
+		uint32_t VertexAttributeCount;
+		uint32_t ConstantDataSize;
+		uint32_t Flags; // FILE_FLAG_*
+		uint32_t BasisVertexCount; // Vertex count of every frame if an attribute has a basis.
+		uint32_t WeightCount; // Basis weights per frame, those of each basis attribute in descriptor order.
+	};
+
+	struct FrameHeader
+	{
+		uint32_t IndexCount;
+		uint32_t VertexCount;
+		uint32_t Flags; // FRAME_FLAG_*
+	};
+
+	// Where a frame is stored, from its FrameHeader to the next frame.
+	struct FrameIndexEntry
+	{
+		uint64_t Offset;
+		uint64_t Size; // 0 if the frame wasn't written.
+	};
+
+	static const uint32_t SEMANTIC_STRING_LENGTH = 60;
+
+	// Follows the format of a descriptor entry: the attribute is stored raw in every frame.
+	// Otherwise it's the component count of the attribute's basis (see PcaBasis.h), stored after the
+	// shared topology as the mean then the components, and the frames don't store the attribute.
+	static const uint32_t NO_BASIS = ~0u;
+
+	// Every frame has the same topology, stored once after the time table.
+	static const uint32_t FILE_FLAG_SHARED_TOPOLOGY = 1u << 0;
+
+	// A FrameIndexEntry per frame follows the seek table, so any frame can be read on its own.
+	static const uint32_t FILE_FLAG_FRAME_INDEX = 1u << 1;
+
+	// Topology indices are stored as their coding (see FrameTopology.h).
+	static const uint32_t FILE_FLAG_INDEX_CODED = 1u << 2;
+
+	// The frame stores no topology, it uses the file topology or else the one of its seek window's first frame.
+	static const uint32_t FRAME_FLAG_SHARED_TOPOLOGY = 1u << 0;
+}
+
+} // namespace nvc
@@ -6,24 +6,425 @@
 
 //! Project Includes.
 #include "QuantisationTypes.h"
+#include "FrameTopology.h"
+#include "Plugin/Foundation/Concurrency.h"
 #include "Plugin/Foundation/Types.h"
-#include "Plugin/Foundation/RawVector.h"
 #include "Plugin/InputGeomCache.h"
+#include "Plugin/Stream/MemoryStream.h"
 #include "Plugin/Stream/Stream.h"
 #include "PackedTransform.h"
+#include "RansCoding.h"
+
+//! System Includes.
+#include <thread>
 
 namespace nvc
 {
 
-void QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
+namespace
 {
-	GeomCacheDesc geomDesc[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
-	geomCache.getDesc(geomDesc);
+	void writeAttribute(Stream* pStream, const void* data, size_t dataSize, size_t componentSize, bool isEntropyCoded, std::vector<uint8_t>& encoded)
+	{
+		if (isEntropyCoded)
+		{
+			encoded.clear();
+			const size_t encodedSize = ransEncode(static_cast<const uint8_t*>(data), dataSize, componentSize, encoded);
+			if (encodedSize < dataSize)
+			{
+				pStream->write(static_cast<uint32_t>(encodedSize));
+				pStream->write(encoded.data(), encodedSize);
+				return;
+			}
+			pStream->write(static_cast<uint32_t>(0));
+		}
 
-	InputGeomCacheConstantData geomConstantData {};
-	geomCache.getConstantData(geomConstantData);
+		pStream->write(data, dataSize);
+	}
+
+	// Running maximum and RMS of the distances between input values and their decoding.
+	struct ErrorStats
+	{
+		double SumOfSquares = 0.0;
+		float Max = 0.0f;
+		size_t Count = 0;
+
+		void add(float error)
+		{
+			SumOfSquares += static_cast<double>(error) * error;
+			Max = std::max(Max, error);
+			++Count;
+		}
+
+		void add(const ErrorStats& stats)
+		{
+			SumOfSquares += stats.SumOfSquares;
+			Max = std::max(Max, stats.Max);
+			Count += stats.Count;
+		}
+
+		QuantisationError get(uint32_t bits) const
+		{
+			QuantisationError error;
+			error.Bits = bits;
+			error.MaxError = Max;
+			error.RmsError = Count > 0 ? static_cast<float>(std::sqrt(SumOfSquares / Count)) : 0.0f;
+			return error;
+		}
+	};
+
+	struct QuantisationBuffers
+	{
+		std::vector<uint16_t> Values;
+		std::vector<uint8_t> Bytes; // An attribute stored as is.
+		std::vector<uint8_t> Packed;
+		std::vector<uint8_t> Encoded;
+	};
+
+	// A frame encoded on its own, written to the file once the frames before it are.
+	struct FrameEncoding
+	{
+		MemoryStream Data;
+		QuantisationBuffers Buffers;
+		std::vector<uint32_t> BoundsSplits;
+		std::vector<quantisation_compression::BoundsRange> BoundsRanges;
+		ErrorStats Stats[GEOM_CACHE_MAX_DESCRIPTOR_COUNT];
+	};
+
+	// A frame added to a compression, held until its batch is encoded.
+	struct FrameCopy
+	{
+		std::vector<int32_t> Indices;
+		std::vector<GeomMesh> Meshes;
+		std::vector<GeomSubmesh> Submeshes;
+		std::vector<uint8_t> Vertices[GEOM_CACHE_MAX_DESCRIPTOR_COUNT];
+		void* VertexPointers[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	};
+
+	// 16 bits keep the truncation of unorm16, which files had before bit packing.
+	inline uint16_t quantise(float value, uint32_t bits)
+	{
+		return bits < 16 ? QuantiseUnorm(value, bits) : unorm16(value).data;
+	}
+
+	// As QuantisationDecompressor gets it.
+	inline float dequantise(uint16_t value, uint32_t bits)
+	{
+		unorm16 decoded;
+		decoded.data = bits < 16 ? ExpandToUnorm16(value, bits) : value;
+		return decoded.to_float();
+	}
+
+	void writeQuantised(Stream* pStream, uint32_t bits, bool isEntropyCoded, QuantisationBuffers& buffers)
+	{
+		if (bits >= 16)
+		{
+			writeAttribute(pStream, buffers.Values.data(), sizeof(uint16_t) * buffers.Values.size(), sizeof(uint16_t), isEntropyCoded, buffers.Encoded);
+			return;
+		}
+
+		buffers.Packed.resize(GetBitPackedSize(buffers.Values.size(), bits));
+		PackBits(buffers.Values.data(), buffers.Values.size(), bits, buffers.Packed.data());
+		writeAttribute(pStream, buffers.Packed.data(), buffers.Packed.size(), 1, isEntropyCoded, buffers.Encoded);
+	}
+
+	// Splits the vertices of a frame per mesh, and per block of blockSize vertices of a mesh if blockSize > 0,
+	// and bounds the points and velocities (unless velocitiesAttributeIndex is ~0u) of each range.
+	void buildBoundsRanges(const GeomCacheData& frameData, size_t pointsAttributeIndex, size_t velocitiesAttributeIndex, size_t blockSize
+		, std::vector<uint32_t>& splits, std::vector<quantisation_compression::BoundsRange>& ranges)
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(frameData.vertexCount);
+		splits.assign(1, 0);
+		for (size_t iMesh = 0; iMesh < frameData.meshCount; ++iMesh)
+		{
+			const GeomMesh& mesh = frameData.meshes[iMesh];
+			splits.push_back(std::min(mesh.vertexOffset, vertexCount));
+			splits.push_back(std::min(mesh.vertexOffset + mesh.vertexCount, vertexCount));
+		}
+		splits.push_back(vertexCount);
+		std::sort(splits.begin(), splits.end());
+		splits.erase(std::unique(splits.begin(), splits.end()), splits.end());
+
+		const float3* points = static_cast<const float3*>(frameData.vertices[pointsAttributeIndex]);
+		const float3* velocities = velocitiesAttributeIndex != ~0u ? static_cast<const float3*>(frameData.vertices[velocitiesAttributeIndex]) : nullptr;
+
+		ranges.clear();
+		for (size_t iSplit = 0; iSplit + 1 < splits.size(); ++iSplit)
+		{
+			const uint32_t end = splits[iSplit + 1];
+			for (uint32_t first = splits[iSplit]; first < end; )
+			{
+				const uint32_t count = blockSize > 0 ? std::min<uint32_t>(static_cast<uint32_t>(blockSize), end - first) : end - first;
+
+				quantisation_compression::BoundsRange range{};
+				range.FirstVertex = first;
+				range.Points = AABB::Build(points + first, count);
+				if (velocities != nullptr)
+				{
+					range.Velocities = AABB::Build(velocities + first, count);
+				}
+				ranges.push_back(range);
+
+				first += count;
+			}
+		}
+	}
+
+	// Points or velocities, against the bounds of their range. Flat extents quantise to 0.
+	void quantisePoints(const std::vector<quantisation_compression::BoundsRange>& ranges, bool isVelocities, const float3* points, size_t count
+		, uint32_t bits, ErrorStats& stats, QuantisationBuffers& buffers)
+	{
+		buffers.Values.resize(3 * count);
+		for (size_t iRange = 0; iRange < ranges.size(); ++iRange)
+		{
+			const AABB& aabb = isVelocities ? ranges[iRange].Velocities : ranges[iRange].Points;
+			const size_t end = iRange + 1 < ranges.size() ? ranges[iRange + 1].FirstVertex : count;
+			for (size_t i = ranges[iRange].FirstVertex; i < end; ++i)
+			{
+				float squaredError = 0.0f;
+				for (size_t c = 0; c < 3; ++c)
+				{
+					const float offset = points[i][c] - aabb.min[c];
+					const uint16_t value = quantise(aabb.extents[c] > 0.0f ? offset / aabb.extents[c] : 0.0f, bits);
+					buffers.Values[3 * i + c] = value;
+
+					const float error = aabb.min[c] + dequantise(value, bits) * aabb.extents[c] - points[i][c];
+					squaredError += error * error;
+				}
+				stats.add(std::sqrt(squaredError));
+			}
+		}
+	}
+
+	// Octahedral coding of normals (stride 3) or of the xyz of tangents (stride 4).
+	void quantiseDirections(const float* directions, size_t stride, size_t count, uint32_t bits, ErrorStats& stats, QuantisationBuffers& buffers)
+	{
+		buffers.Values.resize(2 * count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			float3 direction;
+			direction[0] = directions[stride * i + 0];
+			direction[1] = directions[stride * i + 1];
+			direction[2] = directions[stride * i + 2];
+
+			const float2 oct = OctEncode(direction);
+			float2 decodedOct;
+			for (size_t c = 0; c < 2; ++c)
+			{
+				buffers.Values[2 * i + c] = quantise(oct[c], bits);
+				decodedOct[c] = dequantise(buffers.Values[2 * i + c], bits);
+			}
+
+			const float length = std::sqrt(Squared(direction[0]) + Squared(direction[1]) + Squared(direction[2]));
+			if (length > 0.0f)
+			{
+				const float3 decoded = OctDecode(decodedOct);
+				stats.add(std::sqrt(Squared(decoded[0] - direction[0] / length)
+					+ Squared(decoded[1] - direction[1] / length)
+					+ Squared(decoded[2] - direction[2] / length)));
+			}
+		}
+	}
+
+	void quantiseUVs(const float2* uvs, size_t count, uint32_t bits, ErrorStats& stats, QuantisationBuffers& buffers)
+	{
+		buffers.Values.resize(2 * count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			float squaredError = 0.0f;
+			for (size_t c = 0; c < 2; ++c)
+			{
+				const uint16_t value = quantise(uvs[i][c], bits);
+				buffers.Values[2 * i + c] = value;
+
+				const float error = dequantise(value, bits) - uvs[i][c];
+				squaredError += error * error;
+			}
+			stats.add(std::sqrt(squaredError));
+		}
+	}
+
+	// Keeps the values of the vertices inside (or outside of) the constant ranges, stride values per vertex.
+	template<class T>
+	void selectVertices(std::vector<T>& values, size_t stride, const std::vector<quantisation_compression::VertexRange>& constantRanges, bool isConstant)
+	{
+		size_t selectedCount = 0;
+		size_t first = 0;
+		const auto keep = [&](size_t begin, size_t end)
+		{
+			std::copy(values.begin() + stride * begin, values.begin() + stride * end, values.begin() + selectedCount);
+			selectedCount += stride * (end - begin);
+		};
+
+		const size_t vertexCount = values.size() / stride;
+		for (const auto& range : constantRanges)
+		{
+			if (isConstant)
+			{
+				keep(range.First, range.First + range.Count);
+			}
+			else
+			{
+				keep(first, range.First);
+			}
+			first = range.First + range.Count;
+		}
+		if (!isConstant)
+		{
+			keep(first, vertexCount);
+		}
+		values.resize(selectedCount);
+	}
+
+	size_t getVertexCount(const std::vector<quantisation_compression::VertexRange>& ranges)
+	{
+		size_t count = 0;
+		for (const auto& range : ranges)
+		{
+			count += range.Count;
+		}
+		return count;
+	}
+
+	// Vertex ranges of each attribute which are bit-identical in every frame, split per mesh: a static mesh
+	// has all its attributes constant, an attribute constant over every mesh (like the UVs of cloth) becomes a
+	// single range. None unless every frame with vertices has the same vertex count.
+	void findConstantRanges(const InputGeomCache& geomCache, const GeomCacheDesc* inputDesc, const bool* isStored
+		, std::vector<quantisation_compression::VertexRange>* constantRanges)
+	{
+		const size_t attributeCount = getAttributeCount(inputDesc);
+		std::vector<GeomCacheData> frames;
+		for (size_t iFrame = 0; iFrame < geomCache.getDataCount(); ++iFrame)
+		{
+			float time = 0.0f;
+			GeomCacheData frameData{};
+			geomCache.getData(iFrame, time, &frameData);
+			if (frameData.vertices != nullptr && frameData.vertexCount > 0)
+			{
+				if (!frames.empty() && frameData.vertexCount != frames[0].vertexCount)
+				{
+					return;
+				}
+				frames.push_back(frameData);
+			}
+		}
+		if (frames.size() < 2)
+		{
+			return;
+		}
+
+		// The meshes of the first frame, as buildBoundsRanges() splits them.
+		std::vector<uint32_t> splits;
+		std::vector<quantisation_compression::BoundsRange> boundsRanges;
+		buildBoundsRanges(frames[0], 0, ~0u, 0, splits, boundsRanges);
+
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			if (!isStored[iAttribute])
+			{
+				continue;
+			}
+
+			const size_t vertexSize = getSizeOfDataFormat(inputDesc[iAttribute].format);
+			const uint8_t* first = static_cast<const uint8_t*>(frames[0].vertices[iAttribute]);
+			for (size_t iSplit = 0; iSplit + 1 < splits.size(); ++iSplit)
+			{
+				const size_t offset = vertexSize * splits[iSplit];
+				const size_t size = vertexSize * (splits[iSplit + 1] - splits[iSplit]);
+				const bool isConstant = std::all_of(frames.begin() + 1, frames.end(), [&](const GeomCacheData& frame)
+				{
+					return memcmp(static_cast<const uint8_t*>(frame.vertices[iAttribute]) + offset, first + offset, size) == 0;
+				});
+				if (!isConstant)
+				{
+					continue;
+				}
+
+				auto& ranges = constantRanges[iAttribute];
+				if (!ranges.empty() && ranges.back().First + ranges.back().Count == splits[iSplit])
+				{
+					ranges.back().Count += splits[iSplit + 1] - splits[iSplit];
+				}
+				else
+				{
+					ranges.push_back({ splits[iSplit], splits[iSplit + 1] - splits[iSplit] });
+				}
+			}
+		}
+	}
+
+	// Fewest bits keeping the points of every frame within tolerance, 16 if none does.
+	uint32_t getPointBitsForTolerance(const InputGeomCache& geomCache, size_t pointsAttributeIndex, size_t blockSize, float tolerance)
+	{
+		std::vector<uint32_t> splits;
+		std::vector<quantisation_compression::BoundsRange> ranges;
+		float maxDiagonal = 0.0f;
+		for (size_t iFrame = 0; iFrame < geomCache.getDataCount(); ++iFrame)
+		{
+			float time = 0.0f;
+			GeomCacheData frameData{};
+			geomCache.getData(iFrame, time, &frameData);
+			if (frameData.vertices == nullptr || frameData.vertexCount == 0)
+			{
+				continue;
+			}
+
+			buildBoundsRanges(frameData, pointsAttributeIndex, ~0u, blockSize, splits, ranges);
+			for (const auto& range : ranges)
+			{
+				const AABB& aabb = range.Points;
+				maxDiagonal = std::max(maxDiagonal, std::sqrt(Squared(aabb.extents[0]) + Squared(aabb.extents[1]) + Squared(aabb.extents[2])));
+			}
+		}
+
+		// Rounding is off by half a step on each axis at most, and the expansion to unorm16 by one 16 bit step.
+		for (uint32_t bits = 1; bits < 16; ++bits)
+		{
+			if (maxDiagonal * (0.5f / ((1u << bits) - 1) + 1.0f / 65535.0f) <= tolerance)
+			{
+				return bits;
+			}
+		}
+		return 16;
+	}
+
+	inline uint32_t clampBits(uint32_t bits)
+	{
+		return std::min<uint32_t>(std::max<uint32_t>(bits, 1), 16);
+	}
+}
+
+// A compression between the start of the file and finish(): the attributes and layout decided at the start,
+// the tables written at the end and the batch of frames waiting to be encoded.
+struct QuantisationCompressor::Encoder
+{
+	explicit Encoder(size_t frameBatchSize)
+		: batchSize(frameBatchSize), encodings(frameBatchSize) {}
+
+	void setAttributes(const GeomCacheDesc* desc, const QuantisationSettings& settings);
+	void writeFileStart(uint64_t frameCount, const InputGeomCacheConstantData& constantData
+		, const GeomCacheData* sharedTopology, const GeomCacheData* constantFrame);
+	bool addFrame(float time, const GeomCacheData& frameData, bool isCopied);
+	bool finish(QuantisationReport& report);
+
+	void writeVertices(Stream* pFrameStream, FrameEncoding& encoding, const GeomCacheData& frameData, size_t iAttribute, bool isConstant, ErrorStats& stats) const;
+	void encodeFrame(const GeomCacheData& frameData, const GeomCacheData* windowTopology, FrameEncoding& encoding) const;
+	void encodeBatch();
+	GeomCacheData copyFrame(const GeomCacheData& frameData, FrameCopy& copy) const;
+
+	// Velocities get bounds ranges unless they aren't stored.
+	size_t getBoundedVelocitiesIndex() const
+	{
+		return velocitiesAttributeIndex != ~0u && isStored[velocitiesAttributeIndex] ? velocitiesAttributeIndex : ~0u;
+	}
+
+	Stream* pStream = nullptr;
+	bool isEntropyCoded = false;
+	size_t boundsBlockSize = 0;
+
+	GeomCacheDesc inputDesc[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	GeomCacheDesc geomDesc[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {}; // With the formats written.
+	size_t attributeCount = 0;
 
-	// Find vertex attributes and update the formats.
 	size_t pointsAttributeIndex = ~0u;
 	size_t velocitiesAttributeIndex = ~0u;
 	size_t normalsAttributeIndex = ~0u;
@@ -33,7 +434,38 @@ void QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* p
 	size_t vertexIdAttributeIndex = ~0u;
 	size_t meshIdAttributeIndex = ~0u;
 
-	const size_t attributeCount = getAttributeCount(geomDesc);
+	// Bits of the quantised attributes, 0 for the ones stored as is.
+	uint32_t attributeBits[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	bool isStored[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	std::vector<quantisation_compression::VertexRange> constantRanges[GEOM_CACHE_MAX_DESCRIPTOR_COUNT];
+	ErrorStats errorStats[GEOM_CACHE_MAX_DESCRIPTOR_COUNT];
+
+	quantisation_compression::FileHeader header{};
+	size_t frameSeekTableOffset = 0;
+	size_t frameIndexOffset = 0;
+	size_t timeTableOffset = 0;
+	std::vector<uint64_t> frameSeekTableValues;
+	std::vector<quantisation_compression::FrameIndexEntry> frameIndexValues;
+	std::vector<float> frameTimes;
+	size_t addedFrameCount = 0; // With the frames past header.FrameCount, which aren't written.
+
+	// Whole seek windows of frames, encoded in parallel once the batch is full. Frames added with addFrame()
+	// are copied, the ones of compress() stay in the InputGeomCache.
+	size_t batchSize = 0;
+	uint64_t batchFirstFrame = 0;
+	std::vector<GeomCacheData> batchFrames;
+	std::vector<FrameCopy> batchCopies;
+	std::vector<FrameEncoding> encodings;
+};
+
+// Finds the attributes and the formats they're written in. Every attribute but the ids is stored, with the
+// bits of the settings.
+void QuantisationCompressor::Encoder::setAttributes(const GeomCacheDesc* desc, const QuantisationSettings& settings)
+{
+	attributeCount = getAttributeCount(desc);
+	std::copy(desc, desc + attributeCount, inputDesc);
+	std::copy(desc, desc + attributeCount, geomDesc);
+
 	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
 	{
 		if (geomDesc[iAttribute].semantic != nullptr)
@@ -42,31 +474,37 @@ void QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* p
 			{
 				pointsAttributeIndex = iAttribute;
 				geomDesc[iAttribute].format = DataFormat::UNorm16x3;
+				attributeBits[iAttribute] = clampBits(settings.PointBits);
 			}
 			else if (_stricmp(geomDesc[iAttribute].semantic, nvcSEMANTIC_VELOCITIES) == 0)
 			{
 				velocitiesAttributeIndex = iAttribute;
 				geomDesc[iAttribute].format = DataFormat::UNorm16x3;
+				attributeBits[iAttribute] = clampBits(settings.VelocityBits);
 			}
 			else if (_stricmp(geomDesc[iAttribute].semantic, nvcSEMANTIC_NORMALS) == 0)
 			{
 				normalsAttributeIndex = iAttribute;
 				geomDesc[iAttribute].format = DataFormat::UNorm16x2;
+				attributeBits[iAttribute] = clampBits(settings.NormalBits);
 			}
 			else if (_stricmp(geomDesc[iAttribute].semantic, nvcSEMANTIC_TANGENTS) == 0)
 			{
 				tangentsAttributeIndex = iAttribute;
 				geomDesc[iAttribute].format = DataFormat::UNorm16x2;
+				attributeBits[iAttribute] = clampBits(settings.TangentBits);
 			}
 			else if (_stricmp(geomDesc[iAttribute].semantic, nvcSEMANTIC_UV0) == 0)
 			{
 				uv0AttributeIndex = iAttribute;
 				geomDesc[iAttribute].format = DataFormat::UNorm16x2;
+				attributeBits[iAttribute] = clampBits(settings.UVBits);
 			}
 			else if (_stricmp(geomDesc[iAttribute].semantic, nvcSEMANTIC_UV1) == 0)
 			{
 				uv1AttributeIndex = iAttribute;
 				geomDesc[iAttribute].format = DataFormat::UNorm16x2;
+				attributeBits[iAttribute] = clampBits(settings.UVBits);
 			}
 			else if (_stricmp(geomDesc[iAttribute].semantic, nvcSEMANTIC_VERTEXID) == 0)
 			{
@@ -77,13 +515,399 @@ void QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* p
 				meshIdAttributeIndex = iAttribute;
 			}
 		}
+
+		isStored[iAttribute] = iAttribute != vertexIdAttributeIndex && iAttribute != meshIdAttributeIndex;
+	}
+}
+
+// Writes everything before the frames. The seek table, frame index and time table are left to finish().
+void QuantisationCompressor::Encoder::writeFileStart(uint64_t frameCount, const InputGeomCacheConstantData& constantData
+	, const GeomCacheData* sharedTopology, const GeomCacheData* constantFrame)
+{
+	// Files without bit-packed attributes keep the layout they had before it.
+	const bool isBitPacked = std::any_of(attributeBits, attributeBits + attributeCount, [](uint32_t bits) { return bits > 0 && bits < 16; });
+
+	// Files without constant vertices keep the layout they had before them.
+	const bool hasConstantVertices = std::any_of(constantRanges, constantRanges + attributeCount
+		, [](const std::vector<quantisation_compression::VertexRange>& ranges) { return !ranges.empty(); });
+
+	// Write header.
+	header =
+	{
+		frameCount,
+		static_cast<uint32_t>(DefaultSeekWindow),
+		static_cast<uint32_t>(std::count(isStored, isStored + attributeCount, true)),
+		static_cast<uint32_t>(constantData.getSizeAsByteArray()),
+		quantisation_compression::FILE_FLAG_FRAME_INDEX
+			| quantisation_compression::FILE_FLAG_INDEX_CODED
+			| (isEntropyCoded ? quantisation_compression::FILE_FLAG_ENTROPY_CODED : 0u)
+			| (isBitPacked ? quantisation_compression::FILE_FLAG_BIT_PACKED : 0u)
+			| quantisation_compression::FILE_FLAG_BOUNDS_RANGES
+			| (sharedTopology != nullptr ? quantisation_compression::FILE_FLAG_SHARED_TOPOLOGY : 0u)
+			| (hasConstantVertices ? quantisation_compression::FILE_FLAG_CONSTANT_VERTICES : 0u)
+	};
+
+	pStream->write(header);
+
+	// Write the descriptor.
+	char buffer[quantisation_compression::SEMANTIC_STRING_LENGTH] = {};
+	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	{
+		if (!isStored[iAttribute])
+		{
+			// Skip.
+		}
+		else
+		{
+			memset(buffer, 0, sizeof(buffer));
+			assert(geomDesc[iAttribute].semantic != nullptr
+				&& strlen(geomDesc[iAttribute].semantic) < quantisation_compression::SEMANTIC_STRING_LENGTH);
+			sprintf(buffer, "%s", geomDesc[iAttribute].semantic);
+
+			pStream->write(buffer, sizeof(buffer));
+			pStream->write<uint32_t>(static_cast<uint32_t>(geomDesc[iAttribute].format));
+			if (isBitPacked)
+			{
+				pStream->write<uint32_t>(attributeBits[iAttribute] < 16 ? attributeBits[iAttribute] : 0u);
+			}
+		}
+	}
+
+	// Calculate frame offsets and write a dummy entry in the stream to hold the value later.
+	frameSeekTableOffset = pStream->getPosition();
+	const size_t frameSeekTableSize = (header.FrameCount + header.FrameSeekWindowCount - 1) / header.FrameSeekWindowCount;
+	for (uint64_t iEntry = 0; iEntry < frameSeekTableSize; ++iEntry)
+	{
+		pStream->write(static_cast<uint64_t>(0));
+	}
+
+	// Same for the frame index.
+	frameIndexOffset = pStream->getPosition();
+	frameIndexValues.assign(header.FrameCount, quantisation_compression::FrameIndexEntry{});
+	pStream->write(frameIndexValues.data(), sizeof(quantisation_compression::FrameIndexEntry) * frameIndexValues.size());
+
+	// Write constant data.
+	if(header.ConstantDataSize > 0)
+	{
+		constantData.storeDataTo(pStream);
+	}
+
+	// And the time array.
+	timeTableOffset = pStream->getPosition();
+	for (uint64_t iFrame = 0; iFrame < header.FrameCount; ++iFrame)
+	{
+		pStream->write(0.0f);
+	}
+	frameTimes.reserve(header.FrameCount);
+
+	// Write the topology shared by every frame.
+	if (sharedTopology != nullptr)
+	{
+		pStream->write<uint64_t>(sharedTopology->indexCount);
+		writeTopology(pStream, *sharedTopology, true);
+	}
+
+	// Write the vertices which are the same in every frame, from the first frame with vertices.
+	if (hasConstantVertices)
+	{
+		FrameEncoding encoding;
+		buildBoundsRanges(*constantFrame, pointsAttributeIndex, getBoundedVelocitiesIndex(), boundsBlockSize
+			, encoding.BoundsSplits, encoding.BoundsRanges);
+
+		pStream->write(static_cast<uint32_t>(constantFrame->vertexCount));
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			if (isStored[iAttribute])
+			{
+				const auto& ranges = constantRanges[iAttribute];
+				pStream->write(static_cast<uint32_t>(ranges.size()));
+				pStream->write(ranges.data(), sizeof(quantisation_compression::VertexRange) * ranges.size());
+				if (!ranges.empty())
+				{
+					// Errors of attributes constant in full are the ones of every frame, the others get theirs from the frames.
+					ErrorStats discardedStats;
+					writeVertices(pStream, encoding, *constantFrame, iAttribute, true, getVertexCount(ranges) == constantFrame->vertexCount ? errorStats[iAttribute] : discardedStats);
+				}
+			}
+		}
+	}
+}
+
+// Quantises an attribute of a frame, the bounds ranges are the frame's in the encoding, and writes the
+// vertices inside (or outside of) its constant ranges.
+void QuantisationCompressor::Encoder::writeVertices(Stream* pFrameStream, FrameEncoding& encoding, const GeomCacheData& frameData, size_t iAttribute, bool isConstant, ErrorStats& stats) const
+{
+	QuantisationBuffers& buffers = encoding.Buffers;
+	const void* vertices = frameData.vertices[iAttribute];
+	size_t stride = 2;
+	if (iAttribute == pointsAttributeIndex
+		|| iAttribute == velocitiesAttributeIndex)
+	{
+		quantisePoints(encoding.BoundsRanges, iAttribute == velocitiesAttributeIndex, static_cast<const float3*>(vertices), frameData.vertexCount
+			, attributeBits[iAttribute], stats, buffers);
+		stride = 3;
+	}
+	else if (iAttribute == normalsAttributeIndex)
+	{
+		quantiseDirections(static_cast<const float*>(vertices), 3, frameData.vertexCount, attributeBits[iAttribute], stats, buffers);
+	}
+	else if (iAttribute == tangentsAttributeIndex)
+	{
+		quantiseDirections(static_cast<const float*>(vertices), 4, frameData.vertexCount, attributeBits[iAttribute], stats, buffers);
+	}
+	else if (iAttribute == uv0AttributeIndex
+		|| iAttribute == uv1AttributeIndex)
+	{
+		quantiseUVs(static_cast<const float2*>(vertices), frameData.vertexCount, attributeBits[iAttribute], stats, buffers);
+	}
+	else
+	{
+		const size_t vertexSize = getSizeOfDataFormat(geomDesc[iAttribute].format);
+		buffers.Bytes.assign(static_cast<const uint8_t*>(vertices), static_cast<const uint8_t*>(vertices) + vertexSize * frameData.vertexCount);
+		if (isConstant || !constantRanges[iAttribute].empty())
+		{
+			selectVertices(buffers.Bytes, vertexSize, constantRanges[iAttribute], isConstant);
+		}
+		writeAttribute(pFrameStream, buffers.Bytes.data(), buffers.Bytes.size(), getSizeOfDataFormatComponent(geomDesc[iAttribute].format), isEntropyCoded, buffers.Encoded);
+		return;
+	}
+
+	if (isConstant || !constantRanges[iAttribute].empty())
+	{
+		selectVertices(buffers.Values, stride, constantRanges[iAttribute], isConstant);
+	}
+	writeQuantised(pFrameStream, attributeBits[iAttribute], isEntropyCoded, buffers);
+}
+
+// Encodes a frame into its buffer. A frame depends on nothing but the input, and the first frame of its
+// seek window for the topology (nullptr for that frame itself), so frames can be encoded in any order.
+void QuantisationCompressor::Encoder::encodeFrame(const GeomCacheData& frameData, const GeomCacheData* windowTopology, FrameEncoding& encoding) const
+{
+	Stream* pFrameStream = &encoding.Data;
+	pFrameStream->seek(0, Stream::SeekOrigin::Begin);
+	pFrameStream->setLength(0);
+	std::fill(encoding.Stats, encoding.Stats + attributeCount, ErrorStats{});
+
+	if (frameData.vertices == nullptr)
+	{
+		return; // Error?
+	}
+
+	// The first frame of a seek window always stores its topology, so the window stays decodable on its own.
+	const bool isTopologyShared = (header.Flags & quantisation_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0
+		|| (windowTopology != nullptr && windowTopology->vertices != nullptr && hasSameTopology(*windowTopology, frameData));
+
+	const quantisation_compression::FrameHeader frameHeader
+	{
+		static_cast<uint32_t>(frameData.indexCount),
+		static_cast<uint32_t>(frameData.vertexCount),
+		isTopologyShared ? quantisation_compression::FRAME_FLAG_SHARED_TOPOLOGY : 0u
+	};
+
+	pFrameStream->write(frameHeader);
+
+	// Write mesh, submesh and index data.
+	if (!isTopologyShared)
+	{
+		writeTopology(pFrameStream, frameData, true);
+	}
+
+	// Write vertices, the decompressor reads none from a frame without any.
+	if (frameData.vertexCount > 0)
+	{
+		buildBoundsRanges(frameData, pointsAttributeIndex, getBoundedVelocitiesIndex(), boundsBlockSize
+			, encoding.BoundsSplits, encoding.BoundsRanges);
+
+		pFrameStream->write(static_cast<uint32_t>(encoding.BoundsRanges.size()));
+		pFrameStream->write(encoding.BoundsRanges.data(), sizeof(quantisation_compression::BoundsRange) * encoding.BoundsRanges.size());
+
+		// Attributes constant in full aren't in the frames at all.
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			if (isStored[iAttribute] && getVertexCount(constantRanges[iAttribute]) < frameData.vertexCount)
+			{
+				writeVertices(pFrameStream, encoding, frameData, iAttribute, false, encoding.Stats[iAttribute]);
+			}
+		}
+	}
+}
+
+// Encodes the frames of the batch in parallel and writes them in order. The errors are summed per frame
+// in order too, so the file and the report don't depend on the number of threads.
+void QuantisationCompressor::Encoder::encodeBatch()
+{
+	assert(batchFirstFrame % header.FrameSeekWindowCount == 0);
+	parallel_for(static_cast<size_t>(0), batchFrames.size(), [&](size_t iEncoding)
+	{
+		const size_t iWindowStart = iEncoding - iEncoding % header.FrameSeekWindowCount;
+		encodeFrame(batchFrames[iEncoding], iWindowStart != iEncoding ? &batchFrames[iWindowStart] : nullptr, encodings[iEncoding]);
+	});
+
+	for (size_t iEncoding = 0; iEncoding < batchFrames.size(); ++iEncoding)
+	{
+		const uint64_t iFrame = batchFirstFrame + iEncoding;
+		if ((iFrame % header.FrameSeekWindowCount) == 0)
+		{
+			frameSeekTableValues.push_back(pStream->getPosition());
+		}
+
+		const MemoryStream& frameStream = encodings[iEncoding].Data;
+		frameIndexValues[iFrame].Offset = pStream->getPosition();
+		frameIndexValues[iFrame].Size = frameStream.getLength();
+		if (frameStream.getLength() > 0)
+		{
+			pStream->write(frameStream.getBuffer(), frameStream.getLength());
+		}
+
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			errorStats[iAttribute].add(encodings[iEncoding].Stats[iAttribute]);
+		}
+	}
+
+	batchFirstFrame += batchFrames.size();
+	batchFrames.clear();
+}
+
+// The frame with its topology and stored attributes copied, the ones which aren't stored are nullptr.
+GeomCacheData QuantisationCompressor::Encoder::copyFrame(const GeomCacheData& frameData, FrameCopy& copy) const
+{
+	GeomCacheData frame = frameData;
+
+	const int32_t* indices = static_cast<const int32_t*>(frameData.indices);
+	copy.Indices.assign(indices, indices != nullptr ? indices + frameData.indexCount : indices);
+	frame.indices = indices != nullptr ? copy.Indices.data() : nullptr;
+
+	copy.Meshes.assign(frameData.meshes, frameData.meshes != nullptr ? frameData.meshes + frameData.meshCount : frameData.meshes);
+	frame.meshes = frameData.meshes != nullptr ? copy.Meshes.data() : nullptr;
+
+	copy.Submeshes.assign(frameData.submeshes, frameData.submeshes != nullptr ? frameData.submeshes + frameData.submeshCount : frameData.submeshes);
+	frame.submeshes = frameData.submeshes != nullptr ? copy.Submeshes.data() : nullptr;
+
+	if (frameData.vertices != nullptr)
+	{
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			copy.VertexPointers[iAttribute] = nullptr;
+			if (isStored[iAttribute])
+			{
+				const uint8_t* vertices = static_cast<const uint8_t*>(frameData.vertices[iAttribute]);
+				copy.Vertices[iAttribute].assign(vertices, vertices + getSizeOfDataFormat(inputDesc[iAttribute].format) * frameData.vertexCount);
+				copy.VertexPointers[iAttribute] = copy.Vertices[iAttribute].data();
+			}
+		}
+		frame.vertices = copy.VertexPointers;
+	}
+	return frame;
+}
+
+bool QuantisationCompressor::Encoder::addFrame(float time, const GeomCacheData& frameData, bool isCopied)
+{
+	++addedFrameCount;
+	if (frameTimes.size() == header.FrameCount)
+	{
+		return false; // Past the frame count of the file.
+	}
+	frameTimes.push_back(time);
+
+	if (isCopied)
+	{
+		batchCopies.resize(batchSize);
+		batchFrames.push_back(copyFrame(frameData, batchCopies[batchFrames.size()]));
+	}
+	else
+	{
+		batchFrames.push_back(frameData);
+	}
+
+	if (batchFrames.size() == batchSize)
+	{
+		encodeBatch();
+	}
+	return true;
+}
+
+// The tables before the frames were sized for header.FrameCount frames, a file with any other count of
+// frames can't be decoded and is left without its tables.
+bool QuantisationCompressor::Encoder::finish(QuantisationReport& report)
+{
+	if (addedFrameCount != header.FrameCount)
+	{
+		return false;
+	}
+
+	if (!batchFrames.empty())
+	{
+		encodeBatch();
+	}
+
+	// Report the errors of the attributes written.
+	const auto getError = [&](size_t iAttribute)
+	{
+		return iAttribute != ~0u && isStored[iAttribute] ? errorStats[iAttribute].get(attributeBits[iAttribute]) : QuantisationError{};
+	};
+	report.Points = getError(pointsAttributeIndex);
+	report.Velocities = getError(velocitiesAttributeIndex);
+	report.Normals = getError(normalsAttributeIndex);
+	report.Tangents = getError(tangentsAttributeIndex);
+	report.UV0 = getError(uv0AttributeIndex);
+	report.UV1 = getError(uv1AttributeIndex);
+
+	// Update the frame seek table with the real offsets.
+	pStream->seek(frameSeekTableOffset, Stream::SeekOrigin::Begin);
+	for (uint64_t iEntry = 0; iEntry < frameSeekTableValues.size(); ++iEntry)
+	{
+		pStream->write(frameSeekTableValues[iEntry]);
+	}
+
+	pStream->seek(frameIndexOffset, Stream::SeekOrigin::Begin);
+	pStream->write(frameIndexValues.data(), sizeof(quantisation_compression::FrameIndexEntry) * frameIndexValues.size());
+
+	pStream->seek(timeTableOffset, Stream::SeekOrigin::Begin);
+	pStream->write(frameTimes.data(), sizeof(float) * frameTimes.size());
+	return true;
+}
+
+QuantisationCompressor::QuantisationCompressor(bool isEntropyCoded, const QuantisationSettings& settings)
+	: m_IsEntropyCoded(isEntropyCoded), m_Settings(settings)
+{
+}
+
+QuantisationCompressor::~QuantisationCompressor() = default;
+
+bool QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
+{
+	if (!pStream->canWrite())
+	{
+		return false;
 	}
 
+	m_Report = {};
+
+	// Frames are encoded in parallel, twice as many as there are threads rounded up to whole seek windows.
+	const size_t batchWindowCount = ceildiv<size_t>(2 * std::max(std::thread::hardware_concurrency(), 1u), DefaultSeekWindow);
+	m_Encoder.reset(new Encoder(batchWindowCount * DefaultSeekWindow));
+	Encoder& encoder = *m_Encoder;
+	encoder.pStream = pStream;
+	encoder.isEntropyCoded = m_IsEntropyCoded;
+	encoder.boundsBlockSize = m_Settings.BoundsBlockSize;
+
+	GeomCacheDesc geomDesc[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	geomCache.getDesc(geomDesc);
+	encoder.setAttributes(geomDesc, m_Settings);
+
+	InputGeomCacheConstantData geomConstantData {};
+	geomCache.getConstantData(geomConstantData);
+
 	// Check if we need UV0, UV1 or velocities.
 	bool areUV0Null = true;
 	bool areUV1Null = true;
 	bool areVelocitiesNull = true;
 
+	const size_t uv0AttributeIndex = encoder.uv0AttributeIndex;
+	const size_t uv1AttributeIndex = encoder.uv1AttributeIndex;
+	const size_t velocitiesAttributeIndex = encoder.velocitiesAttributeIndex;
+
 	size_t frameCount = geomCache.getDataCount();
 	for (uint64_t iFrame = 0; iFrame < frameCount; ++iFrame)
 	{
@@ -98,7 +922,7 @@ void QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* p
 		// Write vertices.
 		if (frameData.vertices)
 		{
-			if (uv0AttributeIndex == ~0u)
+			if (uv0AttributeIndex != ~0u)
 			{
 				const float2* uv0 = static_cast<const float2*>(frameData.vertices[uv0AttributeIndex]);
 				for (size_t iVertex = 0; areUV0Null && (iVertex < frameData.vertexCount); ++iVertex)
@@ -107,7 +931,7 @@ void QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* p
 				}
 			}
 
-			if (uv1AttributeIndex == ~0u)
+			if (uv1AttributeIndex != ~0u)
 			{
 				const float2* uv1 = static_cast<const float2*>(frameData.vertices[uv1AttributeIndex]);
 				for (size_t iVertex = 0; areUV1Null && (iVertex < frameData.vertexCount); ++iVertex)
@@ -116,7 +940,7 @@ void QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* p
 				}
 			}
 
-			if (velocitiesAttributeIndex == ~0u)
+			if (velocitiesAttributeIndex != ~0u)
 			{
 				const float3* velocities = static_cast<const float3*>(frameData.vertices[velocitiesAttributeIndex]);
 				for (size_t iVertex = 0; areVelocitiesNull && (iVertex < frameData.vertexCount); ++iVertex)
@@ -130,233 +954,86 @@ void QuantisationCompressor::compress(const InputGeomCache& geomCache, Stream* p
 		}
 	}
 
-	uint32_t attributeToRemove = 0;
 	if (uv0AttributeIndex != ~0u && areUV0Null)
 	{
-		++attributeToRemove;
+		encoder.isStored[uv0AttributeIndex] = false;
 	}
 
 	if (uv1AttributeIndex != ~0u && areUV1Null)
 	{
-		++attributeToRemove;
+		encoder.isStored[uv1AttributeIndex] = false;
 	}
 
 	if (velocitiesAttributeIndex != ~0u && areVelocitiesNull)
 	{
-		++attributeToRemove;
+		encoder.isStored[velocitiesAttributeIndex] = false;
 	}
 
-	if (vertexIdAttributeIndex != ~0u)
+	if (encoder.pointsAttributeIndex != ~0u && m_Settings.PointTolerance > 0.0f)
 	{
-		++attributeToRemove;
+		encoder.attributeBits[encoder.pointsAttributeIndex] = getPointBitsForTolerance(geomCache, encoder.pointsAttributeIndex, m_Settings.BoundsBlockSize, m_Settings.PointTolerance);
 	}
-	if (meshIdAttributeIndex != ~0u)
-	{
-		++attributeToRemove;
-	}
-
-	// Write header.
-	const quantisation_compression::FileHeader header
-	{
-		static_cast<uint64_t>(geomCache.getDataCount()),
-		static_cast<uint32_t>(DefaultSeekWindow),
-		static_cast<uint32_t>(getAttributeCount(geomDesc)) - attributeToRemove,
-		static_cast<uint32_t>(geomConstantData.getSizeAsByteArray())
-	};
-
-	pStream->write(header);
 
-	// Write the descriptor.
-	char buffer[quantisation_compression::SEMANTIC_STRING_LENGTH] = {};
-	for (uint32_t iAttribute = 0; iAttribute < header.VertexAttributeCount; ++iAttribute)
+	if (m_Settings.ConstantVertices)
 	{
-		if (iAttribute == vertexIdAttributeIndex
-			|| iAttribute == meshIdAttributeIndex
-			|| (iAttribute == velocitiesAttributeIndex && areVelocitiesNull)
-			|| (iAttribute == uv0AttributeIndex && areUV0Null)
-			|| (iAttribute == uv1AttributeIndex && areUV1Null))
-		{
-			// Skip.
-		}
-		else
-		{
-			memset(buffer, 0, sizeof(buffer));
-			assert(geomDesc[iAttribute].semantic != nullptr
-				&& strlen(geomDesc[iAttribute].semantic) < quantisation_compression::SEMANTIC_STRING_LENGTH);
-			sprintf(buffer, "%s", geomDesc[iAttribute].semantic);
-
-			pStream->write(buffer, sizeof(buffer));
-			pStream->write<uint32_t>(static_cast<uint32_t>(geomDesc[iAttribute].format));
-		}
+		findConstantRanges(geomCache, encoder.inputDesc, encoder.isStored, encoder.constantRanges);
 	}
 
-	// Calculate frame offsets and write a dummy entry in the stream to hold the value later.
-	const size_t frameSeekTableOffset = pStream->getPosition();
-	const size_t frameSeekTableSize = (header.FrameCount + header.FrameSeekWindowCount - 1) / header.FrameSeekWindowCount;
-	for (uint64_t iEntry = 0; iEntry < frameSeekTableSize; ++iEntry)
+	// The topology shared by every frame, and the first frame with vertices for the constant ones.
+	float time = 0.0f;
+	GeomCacheData sharedTopology{};
+	const bool isFileTopologyShared = isTopologyConstant(geomCache);
+	if (isFileTopologyShared)
 	{
-		pStream->write(static_cast<uint64_t>(0));
+		geomCache.getData(0, time, &sharedTopology);
 	}
 
-	// Write constant data.
-	if(header.ConstantDataSize > 0)
+	GeomCacheData constantFrame{};
+	for (uint64_t iFrame = 0; iFrame < frameCount && (constantFrame.vertices == nullptr || constantFrame.vertexCount == 0); ++iFrame)
 	{
-		geomConstantData.storeDataTo(pStream);
+		geomCache.getData(iFrame, time, &constantFrame);
 	}
 
-	// Write frames.
-	std::vector<uint64_t> frameSeekTableValues;
-
-	// Write time array.
-	for (uint64_t iFrame = 0; iFrame < header.FrameCount; ++iFrame)
-	{
-		float time = 0.0f;
-		GeomCacheData frameData{};
-		geomCache.getData(iFrame, time, &frameData);
-
-		pStream->write(time);
-	}
+	encoder.writeFileStart(frameCount, geomConstantData, isFileTopologyShared ? &sharedTopology : nullptr, &constantFrame);
 
 	// Write frames.
-	for (uint64_t iFrame = 0; iFrame < header.FrameCount; ++iFrame)
+	for (uint64_t iFrame = 0; iFrame < frameCount; ++iFrame)
 	{
-		if ((iFrame % header.FrameSeekWindowCount) == 0)
-		{
-			frameSeekTableValues.push_back(pStream->getPosition());
-		}
-
-		float time = 0.0f;
 		GeomCacheData frameData{};
 		geomCache.getData(iFrame, time, &frameData);
-		if (frameData.vertices == nullptr)
-		{
-			continue; // Error?
-		}
-
-		const quantisation_compression::FrameHeader frameHeader
-		{
-			static_cast<uint32_t>(frameData.indexCount),
-			static_cast<uint32_t>(frameData.vertexCount),
-		};
-
-		pStream->write(frameHeader);
-
-		// Write mesh and submesh data.
-		pStream->write<uint64_t>(frameData.meshCount);
-		pStream->write(frameData.meshes, sizeof(GeomMesh) * frameData.meshCount);
-
-        pStream->write<uint64_t>(frameData.submeshCount);
-        pStream->write(frameData.submeshes, sizeof(GeomSubmesh) * frameData.submeshCount);
-
-		// Write indices.
-		if (frameData.indices)
-		{
-			pStream->write(frameData.indices, sizeof(int) * frameData.indexCount);
-		}
-
-		// Write vertices.
-		if (frameData.vertices)
-		{
-			float3* points = static_cast<float3*>(frameData.vertices[pointsAttributeIndex]);
-			const AABB verticesAABB = AABB::Build(points, frameData.vertexCount);
-
-			pStream->write(verticesAABB);
-
-			for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
-			{
-				if (iAttribute == vertexIdAttributeIndex
-					|| iAttribute == meshIdAttributeIndex
-					|| (iAttribute == velocitiesAttributeIndex && areVelocitiesNull)
-					|| (iAttribute == uv0AttributeIndex && areUV0Null)
-					|| (iAttribute == uv1AttributeIndex && areUV1Null))
-				{
-					// Skip.
-				}
-				else if (iAttribute == pointsAttributeIndex)
-				{
-					RawVector<unorm16x3> packedVertices(frameData.vertexCount);
-					for (size_t iVertex = 0; iVertex < frameData.vertexCount; ++iVertex)
-					{
-						packedVertices[iVertex] = PackPoint(verticesAABB, points[iVertex]);
-					}
-
-					const size_t dataSize = getSizeOfDataFormat(DataFormat::UNorm16x3) * frameData.vertexCount;
-					pStream->write(packedVertices.data(), dataSize);
-				}
-				else if (iAttribute == velocitiesAttributeIndex)
-				{
-					float3* velocities = static_cast<float3*>(frameData.vertices[iAttribute]);
-                    RawVector<unorm16x3> packedVelocities(frameData.vertexCount);
-					for (size_t iVelocities = 0; iVelocities < frameData.vertexCount; ++iVelocities)
-					{
-						packedVelocities[iVelocities] = PackPoint(verticesAABB, velocities[iVelocities]);
-					}
-
-					const size_t dataSize = getSizeOfDataFormat(DataFormat::UNorm16x3) * frameData.vertexCount;
-					pStream->write(packedVelocities.data(), dataSize);
-				}
-				else if (iAttribute == normalsAttributeIndex)
-				{
-					float3* normals = static_cast<float3*>(frameData.vertices[iAttribute]);
-
-					RawVector<unorm16x2> packedNormals(frameData.vertexCount);
-					for (size_t iVertex = 0; iVertex < frameData.vertexCount; ++iVertex)
-					{
-						float2 n = OctEncode(normals[iVertex]);
-						packedNormals[iVertex][0] = n[0];
-						packedNormals[iVertex][1] = n[1];
-					}
-
-					const size_t dataSize = getSizeOfDataFormat(DataFormat::UNorm16x2) * frameData.vertexCount;
-					pStream->write(packedNormals.data(), dataSize);
-				}
-				else if (iAttribute == tangentsAttributeIndex)
-				{
-					float4* tangents = static_cast<float4*>(frameData.vertices[iAttribute]);
-
-					unorm16x2* packedTangents = new unorm16x2[frameData.vertexCount];
-					for (size_t iVertex = 0; iVertex < frameData.vertexCount; ++iVertex)
-					{
-						float2 t = OctEncode(tangents[iVertex]);
-						packedTangents[iVertex][0] = t[0];
-						packedTangents[iVertex][1] = t[1];
-					}
+		encoder.addFrame(time, frameData, false);
+	}
 
-					const size_t dataSize = getSizeOfDataFormat(DataFormat::UNorm16x2) * frameData.vertexCount;
-					pStream->write(packedTangents, dataSize);
+	const bool isFinished = encoder.finish(m_Report);
+	m_Encoder.reset();
+	return isFinished;
+}
 
-					delete[] packedTangents;
-				}
-				else if (iAttribute == uv0AttributeIndex
-					|| iAttribute == uv1AttributeIndex)
-				{
-					float2* uvs = static_cast<float2*>(frameData.vertices[iAttribute]);
+void QuantisationCompressor::begin(const GeomCacheDesc* desc, const InputGeomCacheConstantData& constantData, size_t frameCount, Stream* pStream)
+{
+	m_Report = {};
 
-					RawVector<unorm16x2> packedUVs(frameData.vertexCount);
-					for (size_t iVertex = 0; iVertex < frameData.vertexCount; ++iVertex)
-					{
-						packedUVs[iVertex][0] = uvs[iVertex][0];
-						packedUVs[iVertex][1] = uvs[iVertex][1];
-					}
+	// A seek window of copied frames at a time.
+	m_Encoder.reset(new Encoder(DefaultSeekWindow));
+	m_Encoder->pStream = pStream;
+	m_Encoder->isEntropyCoded = m_IsEntropyCoded;
+	m_Encoder->boundsBlockSize = m_Settings.BoundsBlockSize;
+	m_Encoder->setAttributes(desc, m_Settings);
+	m_Encoder->writeFileStart(frameCount, constantData, nullptr, nullptr);
+}
 
-					const size_t dataSize = getSizeOfDataFormat(DataFormat::UNorm16x2) * frameData.vertexCount;
-					pStream->write(packedUVs.data(), dataSize);
-				}
-				else
-				{
-					const size_t dataSize = getSizeOfDataFormat(geomDesc[iAttribute].format) * frameData.vertexCount;
-					pStream->write(frameData.vertices[iAttribute], dataSize);
-				}
-			}
-		}
-	}
+bool QuantisationCompressor::addFrame(float time, const GeomCacheData& data)
+{
+	assert(m_Encoder != nullptr);
+	return m_Encoder->addFrame(time, data, true);
+}
 
-	// Update the frame seek table with the real offsets.
-	pStream->seek(frameSeekTableOffset, Stream::SeekOrigin::Begin);
-	for (uint64_t iEntry = 0; iEntry < frameSeekTableValues.size(); ++iEntry)
-	{
-		pStream->write(frameSeekTableValues[iEntry]);
-	}
+bool QuantisationCompressor::finish()
+{
+	assert(m_Encoder != nullptr);
+	const bool isComplete = m_Encoder->finish(m_Report);
+	m_Encoder.reset();
+	return isComplete;
 }
 
 } //namespace nvc
@@ -3,19 +3,83 @@
 //! Local Includes.
 #include "ICompressor.h"
 
+//! Project Includes.
+#include "Plugin/GeomCacheData.h"
+
 namespace nvc
 {
 
+struct InputGeomCacheConstantData;
+
+// Bits per component of the quantised attributes, 1 to 16. Attributes with fewer than 16 bits are bit-packed.
+struct QuantisationSettings
+{
+	static const uint32_t DefaultBits = 16;
+
+	uint32_t PointBits = DefaultBits;
+	uint32_t VelocityBits = DefaultBits;
+	uint32_t NormalBits = DefaultBits; // Per octahedral coordinate.
+	uint32_t TangentBits = DefaultBits; // Per octahedral coordinate.
+	uint32_t UVBits = DefaultBits;
+
+	// Error bounded mode: if > 0, points get the fewest bits keeping their error within this world space
+	// distance in every frame, and PointBits is ignored.
+	float PointTolerance = 0.0f;
+
+	// Points and velocities are quantised against bounds per mesh, or per block of this many consecutive
+	// vertices of a mesh if > 0. Smaller blocks follow the local extent at 52 bytes each per frame.
+	uint32_t BoundsBlockSize = 0;
+
+	// Vertices of an attribute which are bit-identical in every frame (static meshes, UVs or colors that don't
+	// change) are stored once instead of per frame. Detected per mesh of the first frame.
+	bool ConstantVertices = true;
+};
+
+// Error of an attribute's decoded values over every frame, as the distance to the input values: in world units
+// for points and velocities, between unit vectors for normals and tangents (about the angle in radians), and
+// in texture space for UVs.
+struct QuantisationError
+{
+	uint32_t Bits = 0; // 0 if the attribute isn't stored.
+	float MaxError = 0.0f;
+	float RmsError = 0.0f;
+};
+
+struct QuantisationReport
+{
+	QuantisationError Points;
+	QuantisationError Velocities;
+	QuantisationError Normals;
+	QuantisationError Tangents;
+	QuantisationError UV0;
+	QuantisationError UV1;
+};
+
 class QuantisationCompressor final : public ICompressor
 {
 public:
 	static const size_t DefaultSeekWindow = 10;
 
 public:
-	QuantisationCompressor() = default;
-	~QuantisationCompressor() = default;
+	// With entropy coding, each attribute of a frame is rANS coded unless that doesn't make it smaller.
+	explicit QuantisationCompressor(bool isEntropyCoded = false, const QuantisationSettings& settings = QuantisationSettings{});
+	~QuantisationCompressor();
 
-	void compress(const InputGeomCache& geomCache, Stream* pStream) override;
+	bool compress(const InputGeomCache& geomCache, Stream* pStream) override;
+
+	// Incremental compression of sequences too long to hold in an InputGeomCache: begin(), addFrame() for each
+	// of the frameCount frames in order, then finish(). Only a seek window of frames is held at a time.
+	// Without the whole sequence to look at, every attribute of desc is stored (but the ids), PointTolerance is
+	// ignored for PointBits, and neither the topology nor vertices are shared by the whole file.
+	void begin(const GeomCacheDesc* desc, const InputGeomCacheConstantData& constantData, size_t frameCount, Stream* pStream);
+	// The data is copied, it only needs to be valid during the call. False past the frameCount frames.
+	bool addFrame(float time, const GeomCacheData& data);
+	// Writes the seek, frame index and time tables. False, and the file is left incomplete, unless exactly
+	// frameCount frames were added.
+	bool finish();
+
+	// Bits and errors of the last compress() or finish().
+	const QuantisationReport& getReport() const { return m_Report; }
 
 	//...
 	QuantisationCompressor(const QuantisationCompressor&) = delete;
@@ -24,7 +88,14 @@ public:
 	QuantisationCompressor& operator=(QuantisationCompressor&&) = delete;
 
 private:
+	struct Encoder;
+
 	void BuildAABB();
+
+	bool m_IsEntropyCoded = false;
+	QuantisationSettings m_Settings;
+	QuantisationReport m_Report;
+	std::unique_ptr<Encoder> m_Encoder;
 };
 
 } // namespace nvc
@@ -8,10 +8,30 @@
 #include "Plugin/Stream/Stream.h"
 #include "Plugin/InputGeomCache.h"
 #include "PackedTransform.h"
+#include "RansCoding.h"
 
 namespace nvc
 {
 
+namespace
+{
+	// Fills the vertexCount vertices of dst from the stored vertices and, in their ranges, the constant ones.
+	void mergeConstantVertices(const std::vector<quantisation_compression::VertexRange>& constantRanges, const uint8_t* constantVertices
+		, const uint8_t* storedVertices, size_t vertexSize, size_t vertexCount, uint8_t* dst)
+	{
+		size_t first = 0;
+		for (const auto& range : constantRanges)
+		{
+			memcpy(dst + vertexSize * first, storedVertices, vertexSize * (range.First - first));
+			storedVertices += vertexSize * (range.First - first);
+			memcpy(dst + vertexSize * range.First, constantVertices, vertexSize * range.Count);
+			constantVertices += vertexSize * range.Count;
+			first = range.First + range.Count;
+		}
+		memcpy(dst + vertexSize * first, storedVertices, vertexSize * (vertexCount - first));
+	}
+}
+
 QuantisationDecompressor::~QuantisationDecompressor()
 {
 	close();
@@ -34,29 +54,13 @@ void QuantisationDecompressor::open(Stream* pStream)
 		uint32_t format = 0;
 		m_pStream->read(format);
 
+		// note: frames are cached packed, so the formats stay the stored ones (see decodeAttribute()).
 		m_Descriptor[iElement].semantic = m_Semantics[iElement];
 		m_Descriptor[iElement].format = static_cast<DataFormat>(format);
 
-		if (_stricmp(m_Descriptor[iElement].semantic, nvcSEMANTIC_POINTS) == 0)
-		{
-			m_Descriptor[iElement].format = DataFormat::Float3;
-		}
-		else if (_stricmp(m_Descriptor[iElement].semantic, nvcSEMANTIC_VELOCITIES) == 0)
+		if ((m_Header.Flags & quantisation_compression::FILE_FLAG_BIT_PACKED) != 0)
 		{
-			m_Descriptor[iElement].format = DataFormat::Float3;
-		}
-		else if (_stricmp(m_Descriptor[iElement].semantic, nvcSEMANTIC_NORMALS) == 0)
-		{
-			m_Descriptor[iElement].format = DataFormat::Float3;
-		}
-		else if (_stricmp(m_Descriptor[iElement].semantic, nvcSEMANTIC_TANGENTS) == 0)
-		{
-			m_Descriptor[iElement].format = DataFormat::Float4;
-		}
-		else if (_stricmp(m_Descriptor[iElement].semantic, nvcSEMANTIC_UV0) == 0
-			|| _stricmp(m_Descriptor[iElement].semantic, nvcSEMANTIC_UV1) == 0)
-		{
-			m_Descriptor[iElement].format = DataFormat::Float2;
+			m_pStream->read(m_AttributeBits[iElement]);
 		}
 	}
 
@@ -69,6 +73,13 @@ void QuantisationDecompressor::open(Stream* pStream)
 		m_SeekTable.push_back(m_pStream->read<uint64_t>());
 	}
 
+	// Read the frame index.
+	if ((m_Header.Flags & quantisation_compression::FILE_FLAG_FRAME_INDEX) != 0)
+	{
+		m_FrameIndex.resize(m_Header.FrameCount);
+		m_pStream->read(m_FrameIndex.data(), sizeof(quantisation_compression::FrameIndexEntry) * m_FrameIndex.size());
+	}
+
 	// Read constant data
 	if(m_Header.ConstantDataSize > 0)
 	{
@@ -82,43 +93,120 @@ void QuantisationDecompressor::open(Stream* pStream)
 		m_FrameTimeTable.push_back(m_pStream->read<float>());
 	}
 
-	m_IsFrameLoaded.resize(m_Header.FrameCount, false);
+	m_LoadedFrames.resize(m_Header.FrameCount);
+
+	// Read the topology shared by every frame, or prepare for the per window ones.
+	if ((m_Header.Flags & quantisation_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		const size_t indexCount = static_cast<size_t>(m_pStream->read<uint64_t>());
+		m_FileTopologyBlock = readTopology(m_pStream, m_FramePool, indexCount, isIndexCoded(), m_FileTopology, m_FileTopologyBlockSize);
+		assert(m_FileTopologyBlock != nullptr);
+	}
+	else
+	{
+		m_WindowTopologies.resize(m_SeekTable.size());
+	}
+
+	memcpy(m_FrameDescriptor, m_Descriptor, sizeof(m_Descriptor));
+	if ((m_Header.Flags & quantisation_compression::FILE_FLAG_CONSTANT_VERTICES) != 0)
+	{
+		readConstantVertices();
+	}
 }
 
 void QuantisationDecompressor::close()
 {
-	auto it = m_LoadedFrames.begin();
-	const auto itEnd = m_LoadedFrames.end();
-	while (it != itEnd)
+	for (size_t iFrame = 0; iFrame < m_LoadedFrames.getFrameCount(); ++iFrame)
 	{
-		freeFrame(*it);
-		++it;
+		if (m_LoadedFrames.isLoaded(iFrame))
+		{
+			freeFrame(m_LoadedFrames[iFrame]);
+		}
 	}
 
 	m_Header = {};
 	m_pStream = nullptr;
 	memset(m_Descriptor, 0, sizeof(m_Descriptor));
+	memset(m_AttributeBits, 0, sizeof(m_AttributeBits));
+	memset(m_FrameDescriptor, 0, sizeof(m_FrameDescriptor));
+	m_ConstantVertexCount = 0;
+	for (size_t iAttribute = 0; iAttribute < GEOM_CACHE_MAX_DESCRIPTOR_COUNT; ++iAttribute)
+	{
+		m_ConstantRanges[iAttribute].clear();
+		m_ConstantRangeVertexCounts[iAttribute] = 0;
+		m_ConstantVertices[iAttribute].clear();
+	}
 	m_SeekTable.clear();
+	m_FrameIndex.clear();
 
 	m_LoadedFrames.clear();
-	m_IsFrameLoaded.clear();
 	m_FramesOffset = 0;
+
+	m_WindowTopologies.clear(m_FramePool);
+	m_FramePool.deallocate(m_FileTopologyBlock, m_FileTopologyBlockSize);
+	m_FileTopology = {};
+	m_FileTopologyBlock = nullptr;
+	m_FileTopologyBlockSize = 0;
+	m_WalkTopologyWindow = InvalidFrameIndex;
+
+	m_FramePool.clear();
 }
 
 void QuantisationDecompressor::prefetch(size_t frameIndex, size_t range)
 {
-	const size_t frameSeekIndex = getSeekTableIndex(frameIndex);
-	const size_t startFrame = frameSeekIndex * m_Header.FrameSeekWindowCount;
-	const size_t frameToLoad = (frameIndex + range) - startFrame;
+	// The budget or pinned range may have changed since the last load.
+	evictFrames();
+
+	const size_t endFrame = std::min<size_t>(frameIndex + range, getFrameCount());
+
+	// Start from the first frame which isn't resident yet.
+	size_t firstFrame = frameIndex;
+	while (firstFrame < endFrame && m_LoadedFrames.isLoaded(firstFrame))
+	{
+		++firstFrame;
+	}
 
-	// Load the frames from the seek window until the end of the range specified.
-	m_pStream->seek(getSeekTableOffset(frameIndex), Stream::SeekOrigin::Begin);
-	for (size_t iFrame = startFrame; iFrame < startFrame + frameToLoad; ++iFrame)
+	if (firstFrame >= endFrame)
 	{
-		loadFrame(iFrame);
+		return;
+	}
 
-		//! TODO: Start an async job to preload after the current frame?...
+	if (!m_FrameIndex.empty())
+	{
+		// Every frame is addressable, only the missing ones are read.
+		for (size_t iFrame = firstFrame; iFrame < endFrame; ++iFrame)
+		{
+			if (!m_LoadedFrames.isLoaded(iFrame))
+			{
+				loadIndexedFrame(iFrame);
+			}
+		}
+	}
+	else
+	{
+		// Frames are only addressable at seek window starts, but they're stored back to back,
+		// so a range crossing window boundaries is loaded by reading on past the window end.
+		const size_t startFrame = getSeekTableIndex(firstFrame) * m_Header.FrameSeekWindowCount;
+		m_pStream->seek(getSeekTableOffset(firstFrame), Stream::SeekOrigin::Begin);
+		for (size_t iFrame = startFrame; iFrame < endFrame; ++iFrame)
+		{
+			quantisation_compression::FrameHeader frameHeader{};
+			m_pStream->read(frameHeader);
+
+			const GeomCacheData* sharedTopology = loadSharedTopology(iFrame, frameHeader);
+			if (m_LoadedFrames.isLoaded(iFrame))
+			{
+				skipFrame(frameHeader, sharedTopology == nullptr
+					&& (frameHeader.Flags & quantisation_compression::FRAME_FLAG_SHARED_TOPOLOGY) == 0);
+			}
+			else
+			{
+				loadFrame(iFrame, frameHeader, sharedTopology);
+			}
+		}
 	}
+
+	releaseWalkTopology();
 }
 
 bool QuantisationDecompressor::getData(size_t frameIndex, float& time, GeomCacheData& data)
@@ -126,7 +214,17 @@ bool QuantisationDecompressor::getData(size_t frameIndex, float& time, GeomCache
 	time = getFrameTime(frameIndex);
 	if (std::isfinite(time))
 	{
-		return getData(time, data);
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		if (!m_LoadedFrames.isLoaded(frameIndex))
+		{
+			return false;
+		}
+
+		// Move to the front of the LRU list.
+		m_LoadedFrames.touch(frameIndex);
+
+		data = m_LoadedFrames[frameIndex].Data;
+		return true;
 	}
 
 	return false;
@@ -134,22 +232,8 @@ bool QuantisationDecompressor::getData(size_t frameIndex, float& time, GeomCache
 
 bool QuantisationDecompressor::getData(float time, GeomCacheData& data)
 {
-	const auto it = std::lower_bound(
-		  m_LoadedFrames.begin()
-		, m_LoadedFrames.end()
-		, FrameDataType { time, GeomCacheData{} }
-		, [](const FrameDataType& lhs, const FrameDataType& rhs) -> bool {
-			return lhs.Time < rhs.Time;
-		}
-	);
-
-	if (it != m_LoadedFrames.end())
-	{
-		data = it->Data;
-		return true;
-	}
-
-	return false;
+	float frameTime = 0.0f;
+	return getData(getFrameIndex(time), frameTime, data);
 }
 
 size_t QuantisationDecompressor::getConstantDataStringSize() const
@@ -170,209 +254,508 @@ const char* QuantisationDecompressor::getConstantDataString(size_t index) const
 	return nullptr;
 }
 
-void QuantisationDecompressor::loadFrame(size_t frameIndex)
+bool QuantisationDecompressor::decodeAttribute(size_t frameIndex, const GeomCacheData& data, size_t iAttribute, size_t firstVertex, size_t vertexCount, void* dst) const
+{
+	if (data.vertices == nullptr || iAttribute >= getAttributeCount(m_Descriptor))
+	{
+		return false;
+	}
+	assert(firstVertex + vertexCount <= data.vertexCount);
+
+	// The ranges live as long as the frame's packed data.
+	const quantisation_compression::BoundsRange* boundsRanges = nullptr;
+	size_t boundsRangeCount = 0;
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		if (frameIndex >= m_LoadedFrames.getFrameCount() || !m_LoadedFrames.isLoaded(frameIndex))
+		{
+			return false;
+		}
+		boundsRanges = m_LoadedFrames[frameIndex].BoundsRanges;
+		boundsRangeCount = m_LoadedFrames[frameIndex].BoundsRangeCount;
+	}
+
+	const char* semantic = m_Descriptor[iAttribute].semantic;
+	const void* packedData = data.vertices[iAttribute];
+
+	const bool isVelocities = _stricmp(semantic, nvcSEMANTIC_VELOCITIES) == 0;
+	if (isVelocities || _stricmp(semantic, nvcSEMANTIC_POINTS) == 0)
+	{
+		// Each range of vertices in [firstVertex, firstVertex + vertexCount) against its bounds.
+		const size_t endVertex = firstVertex + vertexCount;
+		const auto* range = std::upper_bound(boundsRanges, boundsRanges + boundsRangeCount, firstVertex
+			, [](size_t vertex, const quantisation_compression::BoundsRange& r) { return vertex < r.FirstVertex; }) - 1;
+		for (size_t first = firstVertex; first < endVertex; ++range)
+		{
+			const size_t rangeEnd = range + 1 < boundsRanges + boundsRangeCount ? std::min<size_t>(range[1].FirstVertex, endVertex) : endVertex;
+			UnpackPoints(isVelocities ? range->Velocities : range->Points, static_cast<const unorm16x3*>(packedData) + first
+				, static_cast<float3*>(dst) + (first - firstVertex), rangeEnd - first);
+			first = rangeEnd;
+		}
+	}
+	else if (_stricmp(semantic, nvcSEMANTIC_NORMALS) == 0)
+	{
+		OctDecodeArray(static_cast<const unorm16x2*>(packedData) + firstVertex, static_cast<float3*>(dst), vertexCount);
+	}
+	else if (_stricmp(semantic, nvcSEMANTIC_TANGENTS) == 0)
+	{
+		OctDecodeArray(static_cast<const unorm16x2*>(packedData) + firstVertex, static_cast<float4*>(dst), vertexCount);
+	}
+	else if (_stricmp(semantic, nvcSEMANTIC_UV0) == 0
+		|| _stricmp(semantic, nvcSEMANTIC_UV1) == 0)
+	{
+		// Both components are plain unorm16, unpack them as one array.
+		UnpackUnorm16Array(reinterpret_cast<const unorm16*>(static_cast<const unorm16x2*>(packedData) + firstVertex), static_cast<float*>(dst), vertexCount * 2);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// Skips the rest of a frame, the stream is past its header (and its topology unless hasTopology).
+void QuantisationDecompressor::skipFrame(const quantisation_compression::FrameHeader& frameHeader, bool hasTopology)
+{
+	if (hasTopology)
+	{
+		skipTopology(m_pStream, frameHeader.IndexCount, isIndexCoded());
+	}
+
+	if (frameHeader.VertexCount == 0)
+	{
+		return;
+	}
+
+	skipBounds();
+
+	const size_t attributeCount = getAttributeCount(m_Descriptor);
+	if ((m_Header.Flags & quantisation_compression::FILE_FLAG_ENTROPY_CODED) != 0)
+	{
+		// Attribute sizes vary, hop from one to the next.
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			skipAttribute(iAttribute, getFrameVertexCount(iAttribute, frameHeader.VertexCount));
+		}
+		return;
+	}
+
+	size_t dataSize = 0;
+	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	{
+		dataSize += getStoredAttributeSize(iAttribute, getFrameVertexCount(iAttribute, frameHeader.VertexCount));
+	}
+
+	m_pStream->seek(dataSize, Stream::SeekOrigin::Current);
+}
+
+// Reads a single frame through the frame index. A frame sharing its window topology which isn't
+// resident reads it from the window's first frame beforehand.
+void QuantisationDecompressor::loadIndexedFrame(size_t frameIndex)
 {
+	const quantisation_compression::FrameIndexEntry& entry = m_FrameIndex[frameIndex];
+	if (entry.Size == 0)
+	{
+		return;
+	}
+
 	quantisation_compression::FrameHeader frameHeader{};
+	m_pStream->seek(entry.Offset, Stream::SeekOrigin::Begin);
 	m_pStream->read(frameHeader);
 
+	const GeomCacheData* sharedTopology = loadSharedTopology(frameIndex, frameHeader);
+	if (sharedTopology == nullptr && (frameHeader.Flags & quantisation_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		const size_t windowStart = getSeekTableIndex(frameIndex) * m_Header.FrameSeekWindowCount;
+
+		quantisation_compression::FrameHeader windowHeader{};
+		m_pStream->seek(m_FrameIndex[windowStart].Offset, Stream::SeekOrigin::Begin);
+		m_pStream->read(windowHeader);
+		sharedTopology = loadSharedTopology(windowStart, windowHeader);
+
+		m_pStream->seek(entry.Offset + sizeof(frameHeader), Stream::SeekOrigin::Begin);
+	}
+
+	loadFrame(frameIndex, frameHeader, sharedTopology);
+}
+
+// The stream is past the frame header, and past the topology if sharedTopology comes from loadSharedTopology().
+void QuantisationDecompressor::loadFrame(size_t frameIndex, const quantisation_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology)
+{
+	const bool hasTopology = sharedTopology == nullptr;
+	if (hasTopology && (frameHeader.Flags & quantisation_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		// The window topology couldn't be loaded.
+		skipFrame(frameHeader, false);
+		return;
+	}
+
+	if (m_ConstantVertexCount > 0 && frameHeader.VertexCount > 0 && frameHeader.VertexCount != m_ConstantVertexCount)
+	{
+		// Corrupted, the constant vertices don't fit.
+		skipFrame(frameHeader, hasTopology);
+		return;
+	}
+
+	const size_t frameOffset = m_pStream->getPosition();
+
 	FrameDataType frameData{};
 	frameData.Time = m_FrameTimeTable[frameIndex];
-	frameData.Data.indexCount = frameHeader.IndexCount;
 	frameData.Data.vertexCount = frameHeader.VertexCount;
 
-	frameData.Data.meshCount = m_pStream->read<uint64_t>();
-	frameData.Data.meshes = new GeomMesh[frameData.Data.meshCount];
-	for (size_t iMesh = 0; iMesh < frameData.Data.meshCount; ++iMesh)
+	if (hasTopology)
 	{
-		m_pStream->read(frameData.Data.meshes[iMesh]);
+		// The submesh count follows the meshes, peek at it so the whole frame fits in one block.
+		frameData.Data.indexCount = frameHeader.IndexCount;
+		frameData.Data.meshCount = m_pStream->read<uint64_t>();
+		const size_t meshesOffset = m_pStream->getPosition();
+		m_pStream->seek(sizeof(GeomMesh) * frameData.Data.meshCount, Stream::SeekOrigin::Current);
+		frameData.Data.submeshCount = m_pStream->read<uint64_t>();
+		m_pStream->seek(meshesOffset, Stream::SeekOrigin::Begin);
 	}
 
-    frameData.Data.submeshCount = m_pStream->read<uint64_t>();
-    frameData.Data.submeshes = new GeomSubmesh[frameData.Data.submeshCount];
-    for (size_t iSubmesh = 0; iSubmesh < frameData.Data.submeshCount; ++iSubmesh)
-    {
-        m_pStream->read(frameData.Data.submeshes[iSubmesh]);
-    }
-
-	if (frameHeader.IndexCount > 0)
+	frameData.Block = m_FramePool.allocateFrame(frameData.Data, m_FrameDescriptor, frameData.BlockSize);
+	if (frameData.Block == nullptr)
 	{
-		const size_t dataSize = sizeof(int) * frameHeader.IndexCount;
+		m_pStream->seek(frameOffset, Stream::SeekOrigin::Begin);
+		skipFrame(frameHeader, hasTopology);
+		return;
+	}
 
-		void *indices = malloc(dataSize);
-		if (indices != nullptr)
-		{
-			m_pStream->read(indices, dataSize);
-		}
-		else
-		{
-			m_pStream->seek(dataSize, Stream::SeekOrigin::Current);
-		}
+	if (hasTopology)
+	{
+		m_pStream->read(frameData.Data.meshes, sizeof(GeomMesh) * frameData.Data.meshCount);
+		m_pStream->seek(sizeof(uint64_t), Stream::SeekOrigin::Current);
+		m_pStream->read(frameData.Data.submeshes, sizeof(GeomSubmesh) * frameData.Data.submeshCount);
 
-		frameData.Data.indices = indices;
+		readIndices(m_pStream, frameHeader.IndexCount, isIndexCoded(), static_cast<int32_t*>(frameData.Data.indices));
+	}
+	else
+	{
+		useSharedTopology(frameIndex, *sharedTopology, frameData);
 	}
 
+	// Attributes stay packed, they're dequantised by decodeAttribute() when the frame is used.
 	if (frameHeader.VertexCount > 0)
 	{
-		const size_t attributeCount = getAttributeCount(m_Descriptor);
-		frameData.Data.vertices = new void*[attributeCount];
-
-		AABB verticesAABB{};
-		m_pStream->read(verticesAABB);
+		readBounds(frameData);
 
+		const size_t attributeCount = getAttributeCount(m_Descriptor);
 		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
 		{
-			size_t dataSize = getSizeOfDataFormat(m_Descriptor[iAttribute].format) * frameData.Data.vertexCount;
-			if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_POINTS) == 0)
-			{
-				dataSize = getSizeOfDataFormat(DataFormat::UNorm16x3) * frameData.Data.vertexCount;
-			}
-			else if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_VELOCITIES) == 0)
-			{
-				dataSize = getSizeOfDataFormat(DataFormat::UNorm16x3) * frameData.Data.vertexCount;
-			}
-			else if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_NORMALS) == 0)
-			{
-				dataSize = getSizeOfDataFormat(DataFormat::UNorm16x2) * frameData.Data.vertexCount;
-			}
-			else if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_TANGENTS) == 0)
+			const size_t vertexCount = getFrameVertexCount(iAttribute, frameData.Data.vertexCount);
+			if (vertexCount == 0)
 			{
-				dataSize = getSizeOfDataFormat(DataFormat::UNorm16x2) * frameData.Data.vertexCount;
-			}
-			else if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_UV0) == 0
-				|| _stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_UV1) == 0)
-			{
-				dataSize = getSizeOfDataFormat(DataFormat::UNorm16x2) * frameData.Data.vertexCount;
+				// Constant over every vertex, the frame refers to the file's values.
+				frameData.Data.vertices[iAttribute] = m_ConstantVertices[iAttribute].data();
+				continue;
 			}
 
-			void *vertexData = malloc(dataSize);
-			if (vertexData != nullptr)
-			{
-				m_pStream->read(vertexData, dataSize);
-			}
-			else
+			// The stored vertices of attributes with constant ones are read aside, then merged with them.
+			const bool hasConstantVertices = vertexCount < frameData.Data.vertexCount;
+			const size_t vertexSize = getSizeOfDataFormat(m_Descriptor[iAttribute].format);
+			if (hasConstantVertices)
 			{
-				m_pStream->seek(dataSize, Stream::SeekOrigin::Current);
+				m_VaryingBuffer.resize(vertexSize * vertexCount);
 			}
+			uint8_t* vertices = static_cast<uint8_t*>(frameData.Data.vertices[iAttribute]);
 
-			if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_POINTS) == 0)
+			if (!readAttribute(iAttribute, vertexCount, hasConstantVertices ? m_VaryingBuffer.data() : vertices))
 			{
-				unorm16x3* packedVertices = static_cast<unorm16x3*>(vertexData);
-				float3 *unpackedVertices = static_cast<float3*>(malloc(getSizeOfDataFormat(DataFormat::Float3) * frameData.Data.vertexCount));
-
-				for (size_t iVertex = 0; iVertex < frameData.Data.vertexCount; ++iVertex)
+				// Corrupted, the frame isn't loaded. The stream is past it.
+				for (++iAttribute; iAttribute < attributeCount; ++iAttribute)
 				{
-					unpackedVertices[iVertex] = UnpackPoint(verticesAABB, packedVertices[iVertex]);
+					skipAttribute(iAttribute, getFrameVertexCount(iAttribute, frameData.Data.vertexCount));
 				}
-
-				free(vertexData);
-				vertexData = unpackedVertices;
+				freeFrame(frameData);
+				return;
 			}
-			else if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_VELOCITIES) == 0)
+
+			if (hasConstantVertices)
 			{
-				unorm16x3* packedVelocities = static_cast<unorm16x3*>(vertexData);
-				float3 *unpackedVelocities = static_cast<float3*>(malloc(getSizeOfDataFormat(DataFormat::Float3) * frameData.Data.vertexCount));
+				mergeConstantVertices(m_ConstantRanges[iAttribute], m_ConstantVertices[iAttribute].data(), m_VaryingBuffer.data()
+					, vertexSize, frameData.Data.vertexCount, vertices);
+			}
+		}
+	}
 
-				for (size_t iVertex = 0; iVertex < frameData.Data.vertexCount; ++iVertex)
-				{
-					unpackedVelocities[iVertex] = UnpackPoint(verticesAABB, packedVelocities[iVertex]);
-				}
+	if (!insertLoadedData(frameIndex, frameData))
+	{
+		freeFrame(frameData);
+	}
+}
 
-				free(vertexData);
-				vertexData = unpackedVelocities;
-			}
-			else if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_NORMALS) == 0)
-			{
-				unorm16x2* packedNormals = static_cast<unorm16x2*>(vertexData);
-				float3 *unpackedNormals = static_cast<float3*>(malloc(getSizeOfDataFormat(DataFormat::Float3) * frameData.Data.vertexCount));
+// Reads vertexCount vertices of an attribute into dst, in its format. Bit-packed attributes are read aside, then
+// expanded. False if the entropy coding is corrupted, the stream is past the attribute anyway.
+bool QuantisationDecompressor::readAttribute(size_t iAttribute, size_t vertexCount, uint8_t* dst)
+{
+	const DataFormat format = m_Descriptor[iAttribute].format;
+	const uint32_t bits = m_AttributeBits[iAttribute];
+	const size_t dataSize = getStoredAttributeSize(iAttribute, vertexCount);
+	if (bits != 0)
+	{
+		m_PackedBuffer.resize(dataSize);
+	}
+	uint8_t* data = bits != 0 ? m_PackedBuffer.data() : dst;
 
-				for (size_t iVertex = 0; iVertex < frameData.Data.vertexCount; ++iVertex)
-				{
-					float2 n; n[0] = packedNormals[iVertex][0].to_float(); n[1] = packedNormals[iVertex][1].to_float();
-					unpackedNormals[iVertex] = OctDecode(n);
-				}
+	const bool isEntropyCoded = (m_Header.Flags & quantisation_compression::FILE_FLAG_ENTROPY_CODED) != 0;
+	const uint32_t encodedSize = isEntropyCoded ? m_pStream->read<uint32_t>() : 0;
+	if (encodedSize == 0)
+	{
+		m_pStream->read(data, dataSize);
+	}
+	else
+	{
+		m_EncodedBuffer.resize(encodedSize);
+		m_pStream->read(m_EncodedBuffer.data(), encodedSize);
+		if (!ransDecode(m_EncodedBuffer.data(), encodedSize, bits != 0 ? 1 : getSizeOfDataFormatComponent(format), data, dataSize))
+		{
+			return false;
+		}
+	}
 
-				free(vertexData);
-				vertexData = unpackedNormals;
-			}
-			else if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_TANGENTS) == 0)
-			{
-				unorm16x2* packedTangents = static_cast<unorm16x2*>(vertexData);
-				float4 *unpackedTangents = static_cast<float4*>(malloc(getSizeOfDataFormat(DataFormat::Float4) * frameData.Data.vertexCount));
+	if (bits != 0)
+	{
+		const size_t valueCount = getSizeOfDataFormat(format) / getSizeOfDataFormatComponent(format) * vertexCount;
+		UnpackBitsToUnorm16(m_PackedBuffer.data(), valueCount, bits, reinterpret_cast<unorm16*>(dst));
+	}
+	return true;
+}
 
-				for (size_t iVertex = 0; iVertex < frameData.Data.vertexCount; ++iVertex)
-				{
-					float2 packed;
-					packed[0] = packedTangents[iVertex][0].to_float();
-					packed[1] = packedTangents[iVertex][1].to_float();
-
-					float3 t = OctDecode(packed);
-					unpackedTangents[iVertex][0] = t[0];
-					unpackedTangents[iVertex][1] = t[1];
-					unpackedTangents[iVertex][2] = t[2];
-					unpackedTangents[iVertex][3] = 1.0f;
-				}
+// Frames store nothing for an attribute without vertices of their own.
+void QuantisationDecompressor::skipAttribute(size_t iAttribute, size_t vertexCount)
+{
+	if (vertexCount == 0)
+	{
+		return;
+	}
 
-				free(vertexData);
-				vertexData = unpackedTangents;
-			}
-			else if (_stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_UV0) == 0
-				|| _stricmp(m_Descriptor[iAttribute].semantic, nvcSEMANTIC_UV1) == 0)
-			{
-				unorm16x2* packedUVs = static_cast<unorm16x2*>(vertexData);
-				float2 *unpackedUVs = static_cast<float2*>(malloc(getSizeOfDataFormat(DataFormat::Float2) * frameData.Data.vertexCount));
+	const bool isEntropyCoded = (m_Header.Flags & quantisation_compression::FILE_FLAG_ENTROPY_CODED) != 0;
+	const uint32_t encodedSize = isEntropyCoded ? m_pStream->read<uint32_t>() : 0;
+	m_pStream->seek(encodedSize != 0 ? encodedSize : getStoredAttributeSize(iAttribute, vertexCount), Stream::SeekOrigin::Current);
+}
 
-				for (size_t iVertex = 0; iVertex < frameData.Data.vertexCount; ++iVertex)
-				{
-					unpackedUVs[iVertex][0] = packedUVs[iVertex][0].to_float();
-					unpackedUVs[iVertex][1] = packedUVs[iVertex][1].to_float();
-				}
+// Attributes constant over every vertex are left out of the frame blocks, frames point at their values.
+void QuantisationDecompressor::readConstantVertices()
+{
+	m_ConstantVertexCount = m_pStream->read<uint32_t>();
 
-				free(vertexData);
-				vertexData = unpackedUVs;
-			}
+	const size_t attributeCount = getAttributeCount(m_Descriptor);
+	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	{
+		auto& ranges = m_ConstantRanges[iAttribute];
+		ranges.resize(m_pStream->read<uint32_t>());
+		m_pStream->read(ranges.data(), sizeof(quantisation_compression::VertexRange) * ranges.size());
 
-			frameData.Data.vertices[iAttribute] = vertexData;
+		size_t vertexCount = 0;
+		size_t end = 0;
+		for (const auto& range : ranges)
+		{
+			assert(range.First >= end && range.First + range.Count <= m_ConstantVertexCount);
+			vertexCount += range.Count;
+			end = range.First + range.Count;
 		}
+		if (vertexCount == 0)
+		{
+			continue;
+		}
+
+		m_ConstantRangeVertexCounts[iAttribute] = vertexCount;
+		m_ConstantVertices[iAttribute].resize(getSizeOfDataFormat(m_Descriptor[iAttribute].format) * vertexCount);
+		if (!readAttribute(iAttribute, vertexCount, m_ConstantVertices[iAttribute].data()))
+		{
+			// Corrupted, the vertices decode as 0.
+			std::fill(m_ConstantVertices[iAttribute].begin(), m_ConstantVertices[iAttribute].end(), uint8_t(0));
+		}
+
+		if (vertexCount == m_ConstantVertexCount)
+		{
+			m_FrameDescriptor[iAttribute].format = DataFormat::Unknown;
+		}
+	}
+}
+
+void QuantisationDecompressor::freeFrame(FrameDataType& data)
+{
+	m_FramePool.deallocate(data.Block, data.BlockSize);
+	m_FramePool.deallocate(data.BoundsRanges, data.BoundsBlockSize);
+	if (data.TopologyWindow != InvalidFrameIndex)
+	{
+		m_WindowTopologies.release(data.TopologyWindow, m_FramePool);
 	}
+	data.Data = GeomCacheData{};
+	data.Block = nullptr;
+	data.BlockSize = 0;
+	data.BoundsRanges = nullptr;
+	data.BoundsRangeCount = 0;
+	data.BoundsBlockSize = 0;
+	data.TopologyWindow = InvalidFrameIndex;
+}
 
-	if (!insertLoadedData(frameIndex, frameData))
+// Files without FILE_FLAG_BOUNDS_RANGES have one AABB per frame, read as a single range for points and velocities.
+void QuantisationDecompressor::readBounds(FrameDataType& frameData)
+{
+	const size_t rangeCount = hasBoundsRanges() ? m_pStream->read<uint32_t>() : 1;
+
+	frameData.BoundsBlockSize = sizeof(quantisation_compression::BoundsRange) * rangeCount;
+	frameData.BoundsRanges = static_cast<quantisation_compression::BoundsRange*>(m_FramePool.allocate(frameData.BoundsBlockSize));
+	frameData.BoundsRangeCount = rangeCount;
+
+	if (hasBoundsRanges())
 	{
-		freeFrame(frameData);
+		m_pStream->read(frameData.BoundsRanges, frameData.BoundsBlockSize);
+	}
+	else
+	{
+		const AABB bounds = m_pStream->read<AABB>();
+		frameData.BoundsRanges[0] = { 0, bounds, bounds };
 	}
 }
 
-void QuantisationDecompressor::freeFrame(FrameDataType& data) const
+void QuantisationDecompressor::skipBounds()
 {
-	freeGeomCacheData(data.Data, getAttributeCount(m_Descriptor));
-	data.Data = GeomCacheData{};
+	const size_t boundsSize = hasBoundsRanges() ? sizeof(quantisation_compression::BoundsRange) * m_pStream->read<uint32_t>() : sizeof(AABB);
+	m_pStream->seek(boundsSize, Stream::SeekOrigin::Current);
 }
 
-bool QuantisationDecompressor::insertLoadedData(size_t frameIndex, const FrameDataType& data)
+// Returns the shared topology of a frame, or nullptr if the frame stores its own and the stream is still at it.
+// A seek window's first frame stores the topology shared by the rest of the window: it's read into
+// m_WindowTopologies (or skipped if already there) and stays referenced while prefetch() walks the window.
+const GeomCacheData* QuantisationDecompressor::loadSharedTopology(size_t frameIndex, const quantisation_compression::FrameHeader& frameHeader)
 {
-	float time = m_FrameTimeTable[frameIndex];
+	const size_t window = getSeekTableIndex(frameIndex);
+
+	if ((frameHeader.Flags & quantisation_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		if ((m_Header.Flags & quantisation_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0)
+		{
+			return &m_FileTopology;
+		}
 
-	const auto it = std::find_if(m_LoadedFrames.begin(), m_LoadedFrames.end(),
-		[time](const FrameDataType& d)
+		if (window != m_WalkTopologyWindow && m_WindowTopologies.isLoaded(window))
+		{
+			// Still referenced by resident frames of the window, as when a frame is read through the frame index.
+			releaseWalkTopology();
+			m_WindowTopologies.acquire(window);
+			m_WalkTopologyWindow = window;
+		}
+
+		return window == m_WalkTopologyWindow ? &m_WindowTopologies.get(window) : nullptr;
+	}
+
+	if ((m_Header.Flags & quantisation_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0
+		|| (frameIndex % m_Header.FrameSeekWindowCount) != 0)
 	{
-		return d.Time == time;
-	});
+		return nullptr;
+	}
 
-	if (it == m_LoadedFrames.end())
+	releaseWalkTopology();
+
+	if (m_WindowTopologies.isLoaded(window))
 	{
-		// Insert sorted.
-		const auto itInsert = std::lower_bound(m_LoadedFrames.begin(), m_LoadedFrames.end(), data,
-			[](const FrameDataType& lhs, const FrameDataType& rhs)
+		skipTopology(m_pStream, frameHeader.IndexCount, isIndexCoded());
+		m_WindowTopologies.acquire(window);
+	}
+	else
+	{
+		const size_t topologyOffset = m_pStream->getPosition();
+
+		GeomCacheData topology{};
+		size_t blockSize = 0;
+		void* block = readTopology(m_pStream, m_FramePool, frameHeader.IndexCount, isIndexCoded(), topology, blockSize);
+		if (block == nullptr)
 		{
-			return lhs.Time < rhs.Time;
-		});
+			m_pStream->seek(topologyOffset, Stream::SeekOrigin::Begin);
+			return nullptr;
+		}
+
+		m_WindowTopologies.set(window, topology, block, blockSize);
+	}
 
-		m_LoadedFrames.insert(itInsert, data);
-		m_IsFrameLoaded[frameIndex] = true;
+	m_WalkTopologyWindow = window;
+	return &m_WindowTopologies.get(window);
+}
 
-		return true;
+void QuantisationDecompressor::releaseWalkTopology()
+{
+	if (m_WalkTopologyWindow != InvalidFrameIndex)
+	{
+		m_WindowTopologies.release(m_WalkTopologyWindow, m_FramePool);
+		m_WalkTopologyWindow = InvalidFrameIndex;
 	}
+}
 
-	return false;
+// Points a frame at a shared topology, a window topology stays referenced until the frame is freed.
+void QuantisationDecompressor::useSharedTopology(size_t frameIndex, const GeomCacheData& topology, FrameDataType& frameData)
+{
+	frameData.Data.indices = topology.indices;
+	frameData.Data.indexCount = topology.indexCount;
+	frameData.Data.meshes = topology.meshes;
+	frameData.Data.meshCount = topology.meshCount;
+	frameData.Data.submeshes = topology.submeshes;
+	frameData.Data.submeshCount = topology.submeshCount;
+
+	if (&topology != &m_FileTopology)
+	{
+		frameData.TopologyWindow = getSeekTableIndex(frameIndex);
+		m_WindowTopologies.acquire(frameData.TopologyWindow);
+	}
+}
+
+bool QuantisationDecompressor::insertLoadedData(size_t frameIndex, FrameDataType& data)
+{
+	if (m_LoadedFrames.isLoaded(frameIndex))
+	{
+		return false;
+	}
+
+	data.Size = data.BlockSize + data.BoundsBlockSize;
+
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+
+		m_LoadedFrames.insert(frameIndex, data);
+	}
+
+	evictFrames();
+	return true;
+}
+
+void QuantisationDecompressor::setCacheBudget(size_t bytes)
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	m_LoadedFrames.setBudget(bytes);
+}
+
+size_t QuantisationDecompressor::getCacheSize() const
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	return m_LoadedFrames.getSize();
+}
+
+void QuantisationDecompressor::setPinnedRange(size_t frameIndex, size_t range)
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	m_LoadedFrames.setPinnedRange(frameIndex, range);
+}
+
+// Drops least recently used frames until the cache fits its budget. Only called from the prefetching
+// thread (prefetch()/loadFrame()), which is the only writer of m_LoadedFrames outside the lock.
+void QuantisationDecompressor::evictFrames()
+{
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		m_LoadedFrames.evict();
+	}
+
+	// Free outside of the lock, getData() shouldn't wait on the allocator.
+	std::vector<FrameDataType>& evictedFrames = m_LoadedFrames.getEvictedFrames();
+	for (auto& frame : evictedFrames)
+	{
+		freeFrame(frame);
+	}
+	evictedFrames.clear();
 }
 
 } //namespace nvc
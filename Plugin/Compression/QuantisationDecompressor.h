@@ -6,6 +6,11 @@
 
 //! Project Includes.
 #include "Plugin/GeomCacheData.h"
+#include "Plugin/Foundation/Concurrency.h"
+#include "FrameBufferPool.h"
+#include "FrameSlotCache.h"
+#include "FrameTopology.h"
+#include "PackedTransform.h"
 
 namespace nvc
 {
@@ -21,22 +26,60 @@ private:
 
 	GeomCacheDesc m_Descriptor[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
 	char m_Semantics[GEOM_CACHE_MAX_DESCRIPTOR_COUNT][quantisation_compression::SEMANTIC_STRING_LENGTH] = {};
+	uint32_t m_AttributeBits[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {}; // Bits of bit-packed attributes, 0 for the others.
 
 	std::vector<uint64_t> m_SeekTable;
+	std::vector<quantisation_compression::FrameIndexEntry> m_FrameIndex; // Empty if the file predates FILE_FLAG_FRAME_INDEX.
 	std::vector<float> m_FrameTimeTable;
-	std::vector<bool> m_IsFrameLoaded;
 	std::vector<uint8_t> m_ConstantData;
+	std::vector<uint8_t> m_EncodedBuffer; // An entropy coded attribute being read.
+	std::vector<uint8_t> m_PackedBuffer; // A bit-packed attribute being read.
+	std::vector<uint8_t> m_VaryingBuffer; // The vertices of an attribute a frame stores, when it has constant ones.
+
+	// Vertices the same in every frame (FILE_FLAG_CONSTANT_VERTICES): per attribute their ranges and their values,
+	// in the stored format. Frames point at the values of attributes constant over all their vertices.
+	size_t m_ConstantVertexCount = 0;
+	std::vector<quantisation_compression::VertexRange> m_ConstantRanges[GEOM_CACHE_MAX_DESCRIPTOR_COUNT];
+	size_t m_ConstantRangeVertexCounts[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	std::vector<uint8_t> m_ConstantVertices[GEOM_CACHE_MAX_DESCRIPTOR_COUNT];
+	GeomCacheDesc m_FrameDescriptor[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {}; // Frame block layout, without the arrays of these attributes.
 
 	struct FrameDataType 
 	{
 		float Time;
 		GeomCacheData Data;
+		void* Block; // Single m_FramePool block holding all the arrays of Data, attributes stay packed.
+		size_t BlockSize;
+		size_t Size; // Bytes owned by the frame, counted against the cache budget.
+
+		// LRU list links (frame indices), only frames with Size > 0 are linked.
+		size_t LruPrev;
+		size_t LruNext;
+		quantisation_compression::BoundsRange* BoundsRanges; // m_FramePool block, quantisation bounds of the packed points and velocities.
+		size_t BoundsRangeCount;
+		size_t BoundsBlockSize;
+		size_t TopologyWindow = InvalidFrameIndex; // m_WindowTopologies entry Data refers to.
 	};
 
-	std::vector<FrameDataType> m_LoadedFrames;
+	// One slot per frame, parallel to m_FrameTimeTable.
+	FrameSlotCache<FrameDataType> m_LoadedFrames;
+
+	// prefetch() may run on a worker thread while getData() is called, this guards m_LoadedFrames.
+	// note: prefetch() itself must not be called concurrently (it owns the stream cursor).
+	mutable spin_mutex m_LoadedFramesMutex;
+
+	FrameBufferPool m_FramePool;
 
 	size_t m_FramesOffset = 0;
 
+	// Shared topologies: the file's if FILE_FLAG_SHARED_TOPOLOGY is set, otherwise one per seek window.
+	// Only touched by the prefetching thread, like the stream.
+	GeomCacheData m_FileTopology = {};
+	void* m_FileTopologyBlock = nullptr;
+	size_t m_FileTopologyBlockSize = 0;
+	SharedTopologyTable m_WindowTopologies;
+	size_t m_WalkTopologyWindow = InvalidFrameIndex; // Window topology referenced by the running prefetch().
+
 public:
 	QuantisationDecompressor() = default;
 	~QuantisationDecompressor();
@@ -48,9 +91,17 @@ public:
 	bool getData(size_t frameIndex, float& time, GeomCacheData& data) override;
 	bool getData(float time, GeomCacheData& data) override;
 	const GeomCacheDesc* getDescriptors() const override { return &m_Descriptor[0]; }
+	bool decodeAttribute(size_t frameIndex, const GeomCacheData& data, size_t iAttribute, size_t firstVertex, size_t vertexCount, void* dst) const override;
 	size_t getConstantDataStringSize() const override;
 	const char* getConstantDataString(size_t index) const override;
 
+	void setCacheBudget(size_t bytes) override;
+	size_t getCacheBudget() const override { return m_LoadedFrames.getBudget(); }
+	size_t getCacheSize() const override;
+	void setPinnedRange(size_t frameIndex, size_t range) override;
+
+	const FrameBufferPool& getFramePool() const { return m_FramePool; }
+
 	//...
 	QuantisationDecompressor(const QuantisationDecompressor&) = delete;
 	QuantisationDecompressor(QuantisationDecompressor&&) = delete;
@@ -63,6 +114,33 @@ private:
 		return frameIndex / m_Header.FrameSeekWindowCount;
 	}
 
+	bool isIndexCoded() const
+	{
+		return (m_Header.Flags & quantisation_compression::FILE_FLAG_INDEX_CODED) != 0;
+	}
+
+	bool hasBoundsRanges() const
+	{
+		return (m_Header.Flags & quantisation_compression::FILE_FLAG_BOUNDS_RANGES) != 0;
+	}
+
+	// Vertices of an attribute a frame of vertexCount vertices stores, the others are constant.
+	size_t getFrameVertexCount(size_t iAttribute, size_t vertexCount) const
+	{
+		return vertexCount - std::min(m_ConstantRangeVertexCounts[iAttribute], vertexCount);
+	}
+
+	// Bytes of an attribute of a frame in the file, before entropy coding.
+	size_t getStoredAttributeSize(size_t iAttribute, size_t vertexCount) const
+	{
+		const DataFormat format = m_Descriptor[iAttribute].format;
+		if (m_AttributeBits[iAttribute] == 0)
+		{
+			return getSizeOfDataFormat(format) * vertexCount;
+		}
+		return GetBitPackedSize(getSizeOfDataFormat(format) / getSizeOfDataFormatComponent(format) * vertexCount, m_AttributeBits[iAttribute]);
+	}
+
 	size_t getSeekTableOffset(size_t frameIndex) const
 	{
 		const size_t seekTableIndex = getSeekTableIndex(frameIndex);
@@ -104,10 +182,22 @@ public:
 	}
 
 private:
-	void loadFrame(size_t frameIndex);
-	void freeFrame(FrameDataType& data) const;
-
-	bool insertLoadedData(size_t frameIndex, const FrameDataType& data);
+	void loadFrame(size_t frameIndex, const quantisation_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology);
+	void skipFrame(const quantisation_compression::FrameHeader& frameHeader, bool hasTopology);
+	void loadIndexedFrame(size_t frameIndex);
+	bool readAttribute(size_t iAttribute, size_t vertexCount, uint8_t* dst);
+	void skipAttribute(size_t iAttribute, size_t vertexCount);
+	void readConstantVertices();
+	void readBounds(FrameDataType& frameData);
+	void skipBounds();
+	void freeFrame(FrameDataType& data);
+
+	const GeomCacheData* loadSharedTopology(size_t frameIndex, const quantisation_compression::FrameHeader& frameHeader);
+	void releaseWalkTopology();
+	void useSharedTopology(size_t frameIndex, const GeomCacheData& topology, FrameDataType& frameData);
+
+	bool insertLoadedData(size_t frameIndex, FrameDataType& data);
+	void evictFrames();
 };
 
 } // namespace nvc
@@ -1,5 +1,6 @@
 #pragma once
 #include "Plugin/Foundation/Types.h"
+#include "PackedTransform.h"
 
 namespace nvc
 {
@@ -12,15 +13,69 @@ namespace quantisation_compression
 		uint32_t FrameSeekWindowCount;
 		uint32_t VertexAttributeCount;
 		uint32_t ConstantDataSize;
+		uint32_t Flags; // FILE_FLAG_*
 	};
 
 	struct FrameHeader
 	{
 		uint32_t IndexCount;
 		uint32_t VertexCount;
+		uint32_t Flags; // FRAME_FLAG_*
+	};
+
+	// Where a frame is stored, from its FrameHeader to the next frame.
+	struct FrameIndexEntry
+	{
+		uint64_t Offset;
+		uint64_t Size; // 0 if the frame wasn't written.
+	};
+
+	// Quantisation bounds of the points and velocities of a frame's vertices, from FirstVertex up to the next range.
+	struct BoundsRange
+	{
+		uint32_t FirstVertex;
+		AABB Points;
+		AABB Velocities; // Empty if the file has no velocities.
+	};
+
+	// Vertices [First, First + Count) of an attribute, the same in every frame.
+	struct VertexRange
+	{
+		uint32_t First;
+		uint32_t Count;
 	};
 
 	static const uint32_t SEMANTIC_STRING_LENGTH = 60;
+
+	// Every frame has the same topology, stored once after the time table.
+	static const uint32_t FILE_FLAG_SHARED_TOPOLOGY = 1u << 0;
+
+	// A FrameIndexEntry per frame follows the seek table, so any frame can be read on its own.
+	static const uint32_t FILE_FLAG_FRAME_INDEX = 1u << 1;
+
+	// Each attribute of a frame is preceded by a uint32_t, the size of its rANS coding (see RansCoding.h) that
+	// follows, or 0 if it's stored as is.
+	static const uint32_t FILE_FLAG_ENTROPY_CODED = 1u << 2;
+
+	// Topology indices are stored as their coding (see FrameTopology.h).
+	static const uint32_t FILE_FLAG_INDEX_CODED = 1u << 3;
+
+	// Each descriptor entry is followed by a uint32_t, the bits per component (1 to 15) the attribute is stored with,
+	// or 0 if it's stored in its format. Such values are bit-packed (see PackBits()), and rANS coded bytewise.
+	static const uint32_t FILE_FLAG_BIT_PACKED = 1u << 4;
+
+	// Frames store a uint32_t count then that many BoundsRanges, one per mesh or per block of a mesh's vertices,
+	// instead of a single AABB the points and velocities of every mesh are quantised against.
+	static const uint32_t FILE_FLAG_BOUNDS_RANGES = 1u << 5;
+
+	// The vertices which are bit-identical in every frame are stored once, after the time table and the shared
+	// topology: a uint32_t vertex count, the one of every frame with vertices, then per attribute a uint32_t count
+	// and that many sorted VertexRanges, followed by the attribute over these vertices if there are any. Frames only
+	// store each attribute over its other vertices, and nothing for an attribute constant over all of them.
+	static const uint32_t FILE_FLAG_CONSTANT_VERTICES = 1u << 6;
+
+	// The frame stores no topology, it uses the file topology or else the one of its seek window's first frame.
+	static const uint32_t FRAME_FLAG_SHARED_TOPOLOGY = 1u << 0;
 }
 
 } // namespace nvc
@@ -0,0 +1,428 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "RansCoding.h"
+
+//! Project Includes.
+#include "PackedTransform.h"
+#include "Plugin/Foundation/Simd.h"
+
+namespace nvc
+{
+
+namespace
+{
+	static const uint32_t ScaleSize = 1u << RansScaleBits;
+	static const uint32_t ScaleMask = ScaleSize - 1;
+	static const uint32_t LowerBound = 1u << 16; // States stay in [LowerBound, 2^32) between symbols.
+	static const size_t SymbolCount = 256;
+
+	// A decoding slot packs the frequency and the offset in its symbol's range (12 bits each) with the symbol.
+	// A Rans plane has at least 2 symbols, so the frequencies fit in 12 bits.
+	inline uint32_t makeSlot(uint32_t frequency, uint32_t offset, uint32_t symbol)
+	{
+		return frequency | (offset << RansScaleBits) | (symbol << 24);
+	}
+
+	template<class T>
+	void append(std::vector<uint8_t>& encoded, const T& value)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		encoded.insert(encoded.end(), bytes, bytes + sizeof(T));
+	}
+
+	template<class T>
+	bool consume(const uint8_t*& encoded, const uint8_t* encodedEnd, T& value)
+	{
+		if (static_cast<size_t>(encodedEnd - encoded) < sizeof(T))
+		{
+			return false;
+		}
+		memcpy(&value, encoded, sizeof(T));
+		encoded += sizeof(T);
+		return true;
+	}
+
+	// Scales the counts of the present symbols to frequencies summing to ScaleSize, each at least 1.
+	void normaliseFrequencies(const uint64_t* counts, uint64_t total, uint32_t* frequencies)
+	{
+		uint32_t sum = 0;
+		for (size_t iSymbol = 0; iSymbol < SymbolCount; ++iSymbol)
+		{
+			frequencies[iSymbol] = counts[iSymbol] == 0 ? 0
+				: std::max<uint32_t>(1, static_cast<uint32_t>((counts[iSymbol] * ScaleSize) / total));
+			sum += frequencies[iSymbol];
+		}
+
+		// Rounding is settled on the most frequent symbols, where it costs the least.
+		while (sum != ScaleSize)
+		{
+			size_t iLargest = 0;
+			for (size_t iSymbol = 1; iSymbol < SymbolCount; ++iSymbol)
+			{
+				if (frequencies[iSymbol] > frequencies[iLargest])
+				{
+					iLargest = iSymbol;
+				}
+			}
+
+			const uint32_t step = sum > ScaleSize
+				? std::min(sum - ScaleSize, frequencies[iLargest] - frequencies[iLargest] / 2)
+				: ScaleSize - sum;
+			if (sum > ScaleSize)
+			{
+				frequencies[iLargest] -= step;
+				sum -= step;
+			}
+			else
+			{
+				frequencies[iLargest] += step;
+				sum += step;
+			}
+		}
+	}
+
+	void encodePlane(const uint8_t* data, size_t count, size_t stride, std::vector<uint8_t>& encoded)
+	{
+		uint64_t counts[SymbolCount] = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			++counts[data[i * stride]];
+		}
+
+		const size_t presentCount = std::count_if(std::begin(counts), std::end(counts), [](uint64_t c) { return c != 0; });
+		if (presentCount <= 1)
+		{
+			append(encoded, RansPlaneMode::Constant);
+			append(encoded, count == 0 ? uint8_t(0) : data[0]);
+			return;
+		}
+
+		uint32_t frequencies[SymbolCount] = {};
+		uint32_t starts[SymbolCount] = {};
+		normaliseFrequencies(counts, count, frequencies);
+		for (size_t iSymbol = 1; iSymbol < SymbolCount; ++iSymbol)
+		{
+			starts[iSymbol] = starts[iSymbol - 1] + frequencies[iSymbol - 1];
+		}
+
+		// Encoding runs backwards, so the decoder reads the words and the bytes forwards.
+		uint32_t states[RansLaneCount];
+		std::fill(std::begin(states), std::end(states), LowerBound);
+		std::vector<uint16_t> words;
+		words.reserve(count / 2);
+
+		for (size_t i = count; i-- > 0;)
+		{
+			const uint8_t symbol = data[i * stride];
+			const uint32_t frequency = frequencies[symbol];
+			uint32_t& state = states[i % RansLaneCount];
+
+			if (state >= ((LowerBound >> RansScaleBits) << 16) * frequency)
+			{
+				words.push_back(static_cast<uint16_t>(state));
+				state >>= 16;
+			}
+			state = ((state / frequency) << RansScaleBits) + (state % frequency) + starts[symbol];
+		}
+		std::reverse(words.begin(), words.end());
+
+		append(encoded, RansPlaneMode::Rans);
+		uint8_t bitmap[SymbolCount / 8] = {};
+		for (size_t iSymbol = 0; iSymbol < SymbolCount; ++iSymbol)
+		{
+			if (frequencies[iSymbol] != 0)
+			{
+				bitmap[iSymbol / 8] |= static_cast<uint8_t>(1u << (iSymbol % 8));
+			}
+		}
+		encoded.insert(encoded.end(), std::begin(bitmap), std::end(bitmap));
+		for (size_t iSymbol = 0; iSymbol < SymbolCount; ++iSymbol)
+		{
+			if (frequencies[iSymbol] != 0)
+			{
+				append(encoded, static_cast<uint16_t>(frequencies[iSymbol]));
+			}
+		}
+		append(encoded, states);
+		const uint8_t* wordBytes = reinterpret_cast<const uint8_t*>(words.data());
+		encoded.insert(encoded.end(), wordBytes, wordBytes + sizeof(uint16_t) * words.size());
+	}
+
+	inline uint32_t readWord(const uint8_t* words)
+	{
+		uint16_t word;
+		memcpy(&word, words, sizeof(word));
+		return word;
+	}
+
+	// Every lane takes at most a word per group of RansLaneCount bytes.
+	static const ptrdiff_t GroupWordsSize = sizeof(uint16_t) * RansLaneCount;
+
+	//! Scalar.
+
+	// Decodes bytes [begin, count) of the plane, begin being a multiple of RansLaneCount.
+	bool decodeSymbolsScalar(const uint32_t* slots, uint32_t* states, const uint8_t*& words, const uint8_t* wordsEnd, uint8_t* data, size_t stride, size_t begin, size_t count)
+	{
+		uint32_t laneStates[RansLaneCount];
+		std::copy(states, states + RansLaneCount, laneStates);
+		const uint8_t* nextWord = words;
+
+		// Whole groups don't check the word stream end, and renormalise without branching.
+		size_t i = begin;
+		for (; i + RansLaneCount <= count && wordsEnd - nextWord >= GroupWordsSize; i += RansLaneCount)
+		{
+			for (size_t iLane = 0; iLane < RansLaneCount; ++iLane)
+			{
+				uint32_t state = laneStates[iLane];
+				const uint32_t slot = slots[state & ScaleMask];
+				data[(i + iLane) * stride] = static_cast<uint8_t>(slot >> 24);
+				state = (slot & ScaleMask) * (state >> RansScaleBits) + ((slot >> RansScaleBits) & ScaleMask);
+
+				// Whether a word is taken is random, a branch on it would mispredict.
+				const uint32_t needsWord = state < LowerBound ? 1u : 0u;
+				laneStates[iLane] = (state << (needsWord * 16)) | (readWord(nextWord) & (0u - needsWord));
+				nextWord += needsWord * sizeof(uint16_t);
+			}
+		}
+
+		for (; i < count; ++i)
+		{
+			uint32_t& state = laneStates[i % RansLaneCount];
+			const uint32_t slot = slots[state & ScaleMask];
+			data[i * stride] = static_cast<uint8_t>(slot >> 24);
+			state = (slot & ScaleMask) * (state >> RansScaleBits) + ((slot >> RansScaleBits) & ScaleMask);
+
+			if (state < LowerBound)
+			{
+				if (wordsEnd - nextWord < static_cast<ptrdiff_t>(sizeof(uint16_t)))
+				{
+					return false;
+				}
+				state = (state << 16) | readWord(nextWord);
+				nextWord += sizeof(uint16_t);
+			}
+		}
+
+		std::copy(laneStates, laneStates + RansLaneCount, states);
+		words = nextWord;
+		return true;
+	}
+
+#if NVC_SIMD_X86
+
+	//! AVX2, 8 coders per register.
+
+	static const size_t RegisterCount = RansLaneCount / 8;
+	static_assert(RansLaneCount % 8 == 0, "the AVX2 decoder has 8 coders per register");
+
+	// Lanes needing a word take the next ones in lane order: for each mask of such lanes in a register,
+	// the index of the word each lane takes among the next 8, and how many are taken.
+	struct WordPermutations
+	{
+		uint32_t Indices[256][8];
+		uint32_t Counts[256];
+
+		WordPermutations()
+		{
+			for (uint32_t mask = 0; mask < 256; ++mask)
+			{
+				uint32_t taken = 0;
+				for (uint32_t iLane = 0; iLane < 8; ++iLane)
+				{
+					Indices[mask][iLane] = taken;
+					taken += (mask >> iLane) & 1u;
+				}
+				Counts[mask] = taken;
+			}
+		}
+	};
+
+	static const WordPermutations s_WordPermutations;
+
+	// Decodes the byte of each of 8 coders and renormalises them, the 8 bytes are returned in the low half.
+	NVC_TARGET_AVX2 inline __m128i decodeSymbols8(const uint32_t* slots, __m256i& state, const uint8_t*& words)
+	{
+		const __m256i scaleMask = _mm256_set1_epi32(ScaleMask);
+		const __m256i lastBelowBound = _mm256_set1_epi32(LowerBound - 1);
+		const __m256i symbolBytes = _mm256_setr_epi8(
+			3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+		const __m256i slot = _mm256_i32gather_epi32(reinterpret_cast<const int*>(slots), _mm256_and_si256(state, scaleMask), 4);
+
+		const __m256i frequency = _mm256_and_si256(slot, scaleMask);
+		const __m256i offset = _mm256_and_si256(_mm256_srli_epi32(slot, RansScaleBits), scaleMask);
+		state = _mm256_add_epi32(_mm256_mullo_epi32(frequency, _mm256_srli_epi32(state, RansScaleBits)), offset);
+
+		const __m256i needsWord = _mm256_cmpeq_epi32(_mm256_min_epu32(state, lastBelowBound), state);
+		const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(needsWord));
+		const __m256i nextWords = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words)));
+		const __m256i laneWords = _mm256_permutevar8x32_epi32(nextWords
+			, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s_WordPermutations.Indices[mask])));
+
+		state = _mm256_blendv_epi8(state, _mm256_or_si256(_mm256_slli_epi32(state, 16), laneWords), needsWord);
+		words += sizeof(uint16_t) * s_WordPermutations.Counts[mask];
+
+		const __m256i symbols = _mm256_shuffle_epi8(slot, symbolBytes);
+		return _mm_unpacklo_epi32(_mm256_castsi256_si128(symbols), _mm256_extracti128_si256(symbols, 1));
+	}
+
+	// Decodes whole groups of RansLaneCount bytes while their words can be loaded, and returns the bytes decoded.
+	NVC_TARGET_AVX2 size_t decodeSymbolsAVX2(const uint32_t* slots, uint32_t* states, const uint8_t*& words, const uint8_t* wordsEnd, uint8_t* data, size_t stride, size_t count)
+	{
+		__m256i state[RegisterCount];
+		for (size_t iRegister = 0; iRegister < RegisterCount; ++iRegister)
+		{
+			state[iRegister] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states + 8 * iRegister));
+		}
+
+		size_t i = 0;
+		for (; i + RansLaneCount <= count && wordsEnd - words >= GroupWordsSize; i += RansLaneCount)
+		{
+			// The registers are independent until the words are taken, in register order, so their gathers overlap.
+			alignas(16) uint8_t bytes[RansLaneCount];
+			for (size_t iRegister = 0; iRegister < RegisterCount; ++iRegister)
+			{
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(bytes + 8 * iRegister), decodeSymbols8(slots, state[iRegister], words));
+			}
+
+			if (stride == 1)
+			{
+				memcpy(data + i, bytes, RansLaneCount);
+			}
+			else
+			{
+				for (size_t iLane = 0; iLane < RansLaneCount; ++iLane)
+				{
+					data[(i + iLane) * stride] = bytes[iLane];
+				}
+			}
+		}
+
+		for (size_t iRegister = 0; iRegister < RegisterCount; ++iRegister)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(states + 8 * iRegister), state[iRegister]);
+		}
+		return i;
+	}
+
+#endif // NVC_SIMD_X86
+
+	bool decodePlane(const uint8_t* encoded, const uint8_t* encodedEnd, size_t stride, uint8_t* data, size_t count)
+	{
+		RansPlaneMode mode{};
+		if (!consume(encoded, encodedEnd, mode))
+		{
+			return false;
+		}
+
+		if (mode == RansPlaneMode::Constant)
+		{
+			uint8_t symbol = 0;
+			if (!consume(encoded, encodedEnd, symbol) || encoded != encodedEnd)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				data[i * stride] = symbol;
+			}
+			return true;
+		}
+
+		if (mode != RansPlaneMode::Rans)
+		{
+			return false;
+		}
+
+		uint8_t bitmap[SymbolCount / 8];
+		if (!consume(encoded, encodedEnd, bitmap))
+		{
+			return false;
+		}
+
+		uint32_t slots[ScaleSize];
+		uint32_t start = 0;
+		for (uint32_t iSymbol = 0; iSymbol < SymbolCount; ++iSymbol)
+		{
+			if ((bitmap[iSymbol / 8] & (1u << (iSymbol % 8))) == 0)
+			{
+				continue;
+			}
+
+			uint16_t frequency = 0;
+			if (!consume(encoded, encodedEnd, frequency) || frequency == 0 || frequency >= ScaleSize || frequency > ScaleSize - start)
+			{
+				return false;
+			}
+			for (uint32_t offset = 0; offset < frequency; ++offset)
+			{
+				slots[start + offset] = makeSlot(frequency, offset, iSymbol);
+			}
+			start += frequency;
+		}
+
+		uint32_t states[RansLaneCount];
+		if (start != ScaleSize || !consume(encoded, encodedEnd, states))
+		{
+			return false;
+		}
+
+		size_t decoded = 0;
+#if NVC_SIMD_X86
+		if (GetSimdLevel() == SimdLevel::AVX2)
+		{
+			decoded = decodeSymbolsAVX2(slots, states, encoded, encodedEnd, data, stride, count);
+		}
+#endif
+		if (!decodeSymbolsScalar(slots, states, encoded, encodedEnd, data, stride, decoded, count))
+		{
+			return false;
+		}
+
+		// Decoding ends where encoding started.
+		return encoded == encodedEnd
+			&& std::all_of(std::begin(states), std::end(states), [](uint32_t state) { return state == LowerBound; });
+	}
+}
+
+size_t ransEncode(const uint8_t* data, size_t size, size_t stride, std::vector<uint8_t>& encoded)
+{
+	assert(stride > 0 && size % stride == 0);
+
+	const size_t encodedOffset = encoded.size();
+	for (size_t iPlane = 0; iPlane < stride; ++iPlane)
+	{
+		const size_t sizeOffset = encoded.size();
+		append(encoded, uint32_t(0));
+		encodePlane(data + iPlane, size / stride, stride, encoded);
+
+		const uint32_t planeSize = static_cast<uint32_t>(encoded.size() - sizeOffset - sizeof(uint32_t));
+		memcpy(encoded.data() + sizeOffset, &planeSize, sizeof(planeSize));
+	}
+
+	return encoded.size() - encodedOffset;
+}
+
+bool ransDecode(const uint8_t* encoded, size_t encodedSize, size_t stride, uint8_t* data, size_t size)
+{
+	assert(stride > 0 && size % stride == 0);
+
+	const uint8_t* const encodedEnd = encoded + encodedSize;
+	for (size_t iPlane = 0; iPlane < stride; ++iPlane)
+	{
+		uint32_t planeSize = 0;
+		if (!consume(encoded, encodedEnd, planeSize) || static_cast<size_t>(encodedEnd - encoded) < planeSize
+			|| !decodePlane(encoded, encoded + planeSize, stride, data + iPlane, size / stride))
+		{
+			return false;
+		}
+		encoded += planeSize;
+	}
+
+	return encoded == encodedEnd;
+}
+
+} // namespace nvc
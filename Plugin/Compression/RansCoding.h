@@ -0,0 +1,33 @@
+#pragma once
+
+namespace nvc
+{
+
+// Order 0 entropy coding of byte streams with interleaved rANS: RansLaneCount coders take the bytes in turn,
+// so consecutive bytes decode independently and the decoder runs the lanes side by side (AVX2 when available).
+// Frequencies are normalised to 2^RansScaleBits, the coder states are 32 bits and renormalise 16 bits at a time.
+//
+// With a stride, byte k of every stride bytes is a plane coded with its own frequencies, e.g. the low and high
+// bytes of uint16 values, which have very different statistics. Each plane is stored as:
+//   uint32_t size of the rest of the plane
+//   uint8_t  RansPlaneMode
+//   Constant: uint8_t symbol
+//   Rans:     uint8_t bitmap of the symbols present[32], uint16_t frequency of each present symbol,
+//             uint32_t states[RansLaneCount], then the 16 bit renormalisation words in decoding order.
+static const size_t RansLaneCount = 32;
+static const uint32_t RansScaleBits = 12;
+
+enum class RansPlaneMode : uint8_t
+{
+	Constant,	// Every byte of the plane is the same, or the plane is empty.
+	Rans,
+};
+
+// Appends the coding of data to encoded and returns its size in bytes, which can be larger than size
+// for data that doesn't compress. size must be a multiple of stride.
+size_t ransEncode(const uint8_t* data, size_t size, size_t stride, std::vector<uint8_t>& encoded);
+
+// Returns false if encoded isn't the coding of size bytes with this stride.
+bool ransDecode(const uint8_t* encoded, size_t encodedSize, size_t stride, uint8_t* data, size_t size);
+
+} // namespace nvc
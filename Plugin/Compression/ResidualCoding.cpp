@@ -0,0 +1,141 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "ResidualCoding.h"
+
+namespace nvc
+{
+
+namespace
+{
+	uint16_t predict(const uint16_t* previous, const uint16_t* previous2, size_t i, Prediction prediction)
+	{
+		return prediction == Prediction::Linear
+			? static_cast<uint16_t>(2 * previous[i] - previous2[i])
+			: previous[i];
+	}
+
+	// Small residuals of either sign map to small values: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+	uint16_t zigzagEncode(uint16_t residual)
+	{
+		return static_cast<uint16_t>((residual << 1) ^ (0u - (residual >> 15)));
+	}
+
+	uint16_t zigzagDecode(uint16_t value)
+	{
+		return static_cast<uint16_t>((value >> 1) ^ (0u - (value & 1u)));
+	}
+
+	uint32_t getBitWidth(uint16_t value)
+	{
+		uint32_t width = 0;
+		while (value != 0)
+		{
+			++width;
+			value >>= 1;
+		}
+		return width;
+	}
+}
+
+size_t encodeResiduals(const uint16_t* values, const uint16_t* previous, const uint16_t* previous2, size_t count, Prediction prediction, std::vector<uint8_t>& encoded)
+{
+	assert(prediction != Prediction::None);
+
+	const size_t encodedOffset = encoded.size();
+	uint16_t block[ResidualBlockSize];
+
+	for (size_t blockStart = 0; blockStart < count; blockStart += ResidualBlockSize)
+	{
+		const size_t blockCount = std::min(ResidualBlockSize, count - blockStart);
+
+		uint16_t maxValue = 0;
+		for (size_t i = 0; i < blockCount; ++i)
+		{
+			const size_t iValue = blockStart + i;
+			block[i] = zigzagEncode(static_cast<uint16_t>(values[iValue] - predict(previous, previous2, iValue, prediction)));
+			maxValue = std::max(maxValue, block[i]);
+		}
+
+		const uint32_t width = getBitWidth(maxValue);
+		encoded.push_back(static_cast<uint8_t>(width));
+
+		uint64_t bits = 0;
+		uint32_t bitCount = 0;
+		for (size_t i = 0; i < blockCount; ++i)
+		{
+			bits |= static_cast<uint64_t>(block[i]) << bitCount;
+			bitCount += width;
+			while (bitCount >= 8)
+			{
+				encoded.push_back(static_cast<uint8_t>(bits));
+				bits >>= 8;
+				bitCount -= 8;
+			}
+		}
+		if (bitCount > 0)
+		{
+			encoded.push_back(static_cast<uint8_t>(bits));
+		}
+	}
+
+	return encoded.size() - encodedOffset;
+}
+
+namespace
+{
+	template<Prediction prediction>
+	bool decodeResidualsImpl(const uint8_t* encoded, size_t encodedSize, const uint16_t* previous, const uint16_t* previous2, size_t count, uint16_t* values)
+	{
+		const uint8_t* const encodedEnd = encoded + encodedSize;
+
+		for (size_t blockStart = 0; blockStart < count; blockStart += ResidualBlockSize)
+		{
+			const size_t blockCount = std::min(ResidualBlockSize, count - blockStart);
+			if (encoded == encodedEnd)
+			{
+				return false;
+			}
+
+			const uint32_t width = *encoded++;
+			const size_t blockSize = (blockCount * width + 7) / 8;
+			if (width > 16 || static_cast<size_t>(encodedEnd - encoded) < blockSize)
+			{
+				return false;
+			}
+
+			const uint32_t mask = (1u << width) - 1;
+			uint64_t bits = 0;
+			uint32_t bitCount = 0;
+			for (size_t iValue = blockStart; iValue < blockStart + blockCount; ++iValue)
+			{
+				while (bitCount < width)
+				{
+					bits |= static_cast<uint64_t>(*encoded++) << bitCount;
+					bitCount += 8;
+				}
+
+				const uint16_t residual = zigzagDecode(static_cast<uint16_t>(bits & mask));
+				values[iValue] = static_cast<uint16_t>(predict(previous, previous2, iValue, prediction) + residual);
+
+				bits >>= width;
+				bitCount -= width;
+			}
+		}
+
+		return true;
+	}
+}
+
+bool decodeResiduals(const uint8_t* encoded, size_t encodedSize, const uint16_t* previous, const uint16_t* previous2, size_t count, Prediction prediction, uint16_t* values)
+{
+	assert(prediction != Prediction::None);
+
+	// The prediction is a template argument, so the per value loop doesn't branch on it.
+	return prediction == Prediction::Linear
+		? decodeResidualsImpl<Prediction::Linear>(encoded, encodedSize, previous, previous2, count, values)
+		: decodeResidualsImpl<Prediction::Previous>(encoded, encodedSize, previous, previous2, count, values);
+}
+
+} // namespace nvc
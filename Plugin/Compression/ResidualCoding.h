@@ -0,0 +1,25 @@
+#pragma once
+
+namespace nvc
+{
+
+// Delta coding of packed attributes (arrays of uint16 values) against a prediction from the previous frames.
+// Residuals are taken modulo 2^16, so decoding is exact whatever the values, then zigzag mapped and bit packed
+// in blocks of ResidualBlockSize values, each block preceded by a byte holding its bit width (0 to 16).
+static const size_t ResidualBlockSize = 32;
+
+enum class Prediction : uint32_t
+{
+	None,		// Stored as is.
+	Previous,	// The previous frame's values.
+	Linear,		// Extrapolated from the two previous frames' values: 2 * previous - beforePrevious.
+};
+
+// Appends the residuals of values to encoded and returns their size in bytes.
+// previous2 is only read with Prediction::Linear.
+size_t encodeResiduals(const uint16_t* values, const uint16_t* previous, const uint16_t* previous2, size_t count, Prediction prediction, std::vector<uint8_t>& encoded);
+
+// Returns false if encoded is shorter than the residuals of count values.
+bool decodeResiduals(const uint8_t* encoded, size_t encodedSize, const uint16_t* previous, const uint16_t* previous2, size_t count, Prediction prediction, uint16_t* values);
+
+} // namespace nvc
@@ -0,0 +1,439 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "TemporalCompressor.h"
+
+//! Project Includes.
+#include "TemporalTypes.h"
+#include "FrameTopology.h"
+#include "ResidualCoding.h"
+#include "RansCoding.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/Stream/Stream.h"
+#include "PackedTransform.h"
+
+namespace nvc
+{
+
+namespace
+{
+	// How an input attribute is stored. All but Raw are packed as unorm16 values, which can be predicted.
+	enum class PackedKind
+	{
+		Points,
+		Velocities,
+		Normals,
+		Tangents,
+		UVs,
+		Raw,
+	};
+
+	struct PackedAttribute
+	{
+		size_t InputIndex;
+		PackedKind Kind;
+		DataFormat Format; // Stored format.
+	};
+
+	// True if every component of the attribute is 0 in every frame.
+	bool isAttributeNull(const InputGeomCache& geomCache, size_t iAttribute, size_t componentCount)
+	{
+		const size_t frameCount = geomCache.getDataCount();
+		for (size_t iFrame = 0; iFrame < frameCount; ++iFrame)
+		{
+			float time = 0.0f;
+			GeomCacheData frameData{};
+			geomCache.getData(iFrame, time, &frameData);
+			if (frameData.vertices == nullptr)
+			{
+				continue;
+			}
+
+			const float* values = static_cast<const float*>(frameData.vertices[iAttribute]);
+			for (size_t iValue = 0; iValue < frameData.vertexCount * componentCount; ++iValue)
+			{
+				if (values[iValue] != 0.0f)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Bounds of the points of frames [firstFrame, endFrame). Flat extents are widened so PackPoint() doesn't divide by 0.
+	AABB buildWindowBounds(const InputGeomCache& geomCache, size_t pointsIndex, size_t firstFrame, size_t endFrame)
+	{
+		bool isEmpty = true;
+		float3 min{};
+		float3 max{};
+		for (size_t iFrame = firstFrame; iFrame < endFrame; ++iFrame)
+		{
+			float time = 0.0f;
+			GeomCacheData frameData{};
+			geomCache.getData(iFrame, time, &frameData);
+			if (frameData.vertices == nullptr || frameData.vertexCount == 0)
+			{
+				continue;
+			}
+
+			const AABB frameBounds = AABB::Build(static_cast<const float3*>(frameData.vertices[pointsIndex]), frameData.vertexCount);
+			for (int k = 0; k < 3; ++k)
+			{
+				const float frameMax = frameBounds.min[k] + frameBounds.extents[k];
+				min[k] = isEmpty ? frameBounds.min[k] : std::min(min[k], frameBounds.min[k]);
+				max[k] = isEmpty ? frameMax : std::max(max[k], frameMax);
+			}
+			isEmpty = false;
+		}
+
+		float3 extents{};
+		for (int k = 0; k < 3; ++k)
+		{
+			extents[k] = max[k] > min[k] ? max[k] - min[k] : 1.0f;
+		}
+		return AABB(min, extents);
+	}
+
+	// Writes the attribute of frameData in its stored format to packed.
+	void packAttribute(const PackedAttribute& attribute, const AABB& bounds, const GeomCacheData& frameData, uint8_t* packed)
+	{
+		const void* values = frameData.vertices[attribute.InputIndex];
+		const size_t vertexCount = frameData.vertexCount;
+
+		switch (attribute.Kind)
+		{
+		case PackedKind::Points:
+		case PackedKind::Velocities:
+			for (size_t iVertex = 0; iVertex < vertexCount; ++iVertex)
+			{
+				reinterpret_cast<unorm16x3*>(packed)[iVertex] = PackPoint(bounds, static_cast<const float3*>(values)[iVertex]);
+			}
+			break;
+
+		case PackedKind::Normals:
+		case PackedKind::Tangents:
+			for (size_t iVertex = 0; iVertex < vertexCount; ++iVertex)
+			{
+				const float2 n = attribute.Kind == PackedKind::Normals
+					? OctEncode(static_cast<const float3*>(values)[iVertex])
+					: OctEncode(static_cast<const float4*>(values)[iVertex]);
+				reinterpret_cast<unorm16x2*>(packed)[iVertex][0] = n[0];
+				reinterpret_cast<unorm16x2*>(packed)[iVertex][1] = n[1];
+			}
+			break;
+
+		case PackedKind::UVs:
+			for (size_t iVertex = 0; iVertex < vertexCount; ++iVertex)
+			{
+				reinterpret_cast<unorm16x2*>(packed)[iVertex][0] = static_cast<const float2*>(values)[iVertex][0];
+				reinterpret_cast<unorm16x2*>(packed)[iVertex][1] = static_cast<const float2*>(values)[iVertex][1];
+			}
+			break;
+
+		case PackedKind::Raw:
+			memcpy(packed, values, getSizeOfDataFormat(attribute.Format) * vertexCount);
+			break;
+		}
+	}
+}
+
+bool TemporalCompressor::compress(const InputGeomCache& geomCache, Stream* pStream)
+{
+	if (!pStream->canWrite())
+	{
+		return false;
+	}
+
+	GeomCacheDesc geomDesc[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	geomCache.getDesc(geomDesc);
+
+	InputGeomCacheConstantData geomConstantData {};
+	geomCache.getConstantData(geomConstantData);
+
+	// Find the stored attributes and their formats. Ids aren't stored, nor are uvs or velocities which are always 0.
+	size_t pointsAttributeIndex = ~0u;
+	std::vector<PackedAttribute> attributes;
+
+	const size_t attributeCount = getAttributeCount(geomDesc);
+	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	{
+		const char* semantic = geomDesc[iAttribute].semantic;
+		if (semantic == nullptr
+			|| _stricmp(semantic, nvcSEMANTIC_VERTEXID) == 0
+			|| _stricmp(semantic, nvcSEMANTIC_MESHID) == 0)
+		{
+			continue;
+		}
+
+		PackedAttribute attribute{ iAttribute, PackedKind::Raw, geomDesc[iAttribute].format };
+		if (_stricmp(semantic, nvcSEMANTIC_POINTS) == 0)
+		{
+			pointsAttributeIndex = iAttribute;
+			attribute.Kind = PackedKind::Points;
+			attribute.Format = DataFormat::UNorm16x3;
+		}
+		else if (_stricmp(semantic, nvcSEMANTIC_VELOCITIES) == 0)
+		{
+			if (isAttributeNull(geomCache, iAttribute, 3))
+			{
+				continue;
+			}
+			attribute.Kind = PackedKind::Velocities;
+			attribute.Format = DataFormat::UNorm16x3;
+		}
+		else if (_stricmp(semantic, nvcSEMANTIC_NORMALS) == 0)
+		{
+			attribute.Kind = PackedKind::Normals;
+			attribute.Format = DataFormat::UNorm16x2;
+		}
+		else if (_stricmp(semantic, nvcSEMANTIC_TANGENTS) == 0)
+		{
+			attribute.Kind = PackedKind::Tangents;
+			attribute.Format = DataFormat::UNorm16x2;
+		}
+		else if (_stricmp(semantic, nvcSEMANTIC_UV0) == 0
+			|| _stricmp(semantic, nvcSEMANTIC_UV1) == 0)
+		{
+			if (isAttributeNull(geomCache, iAttribute, 2))
+			{
+				continue;
+			}
+			attribute.Kind = PackedKind::UVs;
+			attribute.Format = DataFormat::UNorm16x2;
+		}
+
+		attributes.push_back(attribute);
+	}
+	assert(pointsAttributeIndex != ~0u);
+
+	const bool isFileTopologyShared = isTopologyConstant(geomCache);
+
+	// Write header.
+	const temporal_compression::FileHeader header
+	{
+		static_cast<uint64_t>(geomCache.getDataCount()),
+		static_cast<uint32_t>(DefaultSeekWindow),
+		static_cast<uint32_t>(attributes.size()),
+		static_cast<uint32_t>(geomConstantData.getSizeAsByteArray()),
+		temporal_compression::FILE_FLAG_FRAME_INDEX
+			| temporal_compression::FILE_FLAG_INDEX_CODED
+			| (isFileTopologyShared ? temporal_compression::FILE_FLAG_SHARED_TOPOLOGY : 0u)
+	};
+
+	pStream->write(header);
+
+	// Write the descriptor.
+	char buffer[temporal_compression::SEMANTIC_STRING_LENGTH] = {};
+	for (const PackedAttribute& attribute : attributes)
+	{
+		memset(buffer, 0, sizeof(buffer));
+		assert(strlen(geomDesc[attribute.InputIndex].semantic) < temporal_compression::SEMANTIC_STRING_LENGTH);
+		sprintf(buffer, "%s", geomDesc[attribute.InputIndex].semantic);
+
+		pStream->write(buffer, sizeof(buffer));
+		pStream->write<uint32_t>(static_cast<uint32_t>(attribute.Format));
+	}
+
+	// Calculate frame offsets and write a dummy entry in the stream to hold the value later.
+	const size_t frameSeekTableOffset = pStream->getPosition();
+	const size_t frameSeekTableSize = (header.FrameCount + header.FrameSeekWindowCount - 1) / header.FrameSeekWindowCount;
+	for (uint64_t iEntry = 0; iEntry < frameSeekTableSize; ++iEntry)
+	{
+		pStream->write(static_cast<uint64_t>(0));
+	}
+
+	// Same for the frame index.
+	const size_t frameIndexOffset = pStream->getPosition();
+	std::vector<temporal_compression::FrameIndexEntry> frameIndexValues(header.FrameCount, temporal_compression::FrameIndexEntry{});
+	pStream->write(frameIndexValues.data(), sizeof(temporal_compression::FrameIndexEntry) * frameIndexValues.size());
+
+	// Write constant data.
+	if (header.ConstantDataSize > 0)
+	{
+		geomConstantData.storeDataTo(pStream);
+	}
+
+	// Write time array.
+	for (uint64_t iFrame = 0; iFrame < header.FrameCount; ++iFrame)
+	{
+		float time = 0.0f;
+		GeomCacheData frameData{};
+		geomCache.getData(iFrame, time, &frameData);
+
+		pStream->write(time);
+	}
+
+	// Write the topology shared by every frame.
+	if (isFileTopologyShared)
+	{
+		float time = 0.0f;
+		GeomCacheData frameData{};
+		geomCache.getData(0, time, &frameData);
+
+		pStream->write<uint64_t>(frameData.indexCount);
+		writeTopology(pStream, frameData, true);
+	}
+
+	// Write frames.
+	std::vector<uint64_t> frameSeekTableValues;
+	GeomCacheData windowTopology{};
+	bool hasWindowTopology = false;
+	AABB windowBounds{};
+
+	// Packed attributes of the frame and of the two previous ones, back to back.
+	std::vector<uint8_t> packedFrames[3];
+	size_t chainLength = 0; // Frames since the last keyframe, including it.
+	size_t previousVertexCount = 0;
+	std::vector<uint8_t> residuals[2];
+	std::vector<uint8_t> entropyCoded;
+
+	for (uint64_t iFrame = 0; iFrame < header.FrameCount; ++iFrame)
+	{
+		const bool isWindowStart = (iFrame % header.FrameSeekWindowCount) == 0;
+		if (isWindowStart)
+		{
+			frameSeekTableValues.push_back(pStream->getPosition());
+			hasWindowTopology = false;
+
+			const size_t windowEnd = std::min<size_t>(iFrame + header.FrameSeekWindowCount, header.FrameCount);
+			windowBounds = buildWindowBounds(geomCache, pointsAttributeIndex, iFrame, windowEnd);
+		}
+		frameIndexValues[iFrame].Offset = pStream->getPosition();
+
+		float time = 0.0f;
+		GeomCacheData frameData{};
+		geomCache.getData(iFrame, time, &frameData);
+		if (frameData.vertices == nullptr)
+		{
+			chainLength = 0;
+			continue; // Error?
+		}
+
+		// Predictions need the previous frames' values for the same vertices.
+		const bool isKeyframe = isWindowStart || chainLength == 0 || frameData.vertexCount != previousVertexCount;
+		chainLength = isKeyframe ? 1 : chainLength + 1;
+		previousVertexCount = frameData.vertexCount;
+
+		// The first frame of a seek window always stores its topology, so the window stays decodable on its own.
+		const bool isTopologyShared = isFileTopologyShared
+			|| (hasWindowTopology && hasSameTopology(windowTopology, frameData));
+
+		const temporal_compression::FrameHeader frameHeader
+		{
+			static_cast<uint32_t>(frameData.indexCount),
+			static_cast<uint32_t>(frameData.vertexCount),
+			(isTopologyShared ? temporal_compression::FRAME_FLAG_SHARED_TOPOLOGY : 0u)
+				| (isKeyframe ? temporal_compression::FRAME_FLAG_KEYFRAME : 0u)
+		};
+
+		pStream->write(frameHeader);
+
+		// Write mesh, submesh and index data.
+		if (!isTopologyShared)
+		{
+			writeTopology(pStream, frameData, true);
+		}
+
+		if (isWindowStart)
+		{
+			windowTopology = frameData;
+			hasWindowTopology = true;
+		}
+
+		// Write vertices.
+		if (frameData.vertexCount > 0)
+		{
+			pStream->write(windowBounds);
+
+			std::rotate(std::begin(packedFrames), std::begin(packedFrames) + 2, std::end(packedFrames));
+			std::vector<uint8_t>& packedFrame = packedFrames[0];
+			const std::vector<uint8_t>& previousFrame = packedFrames[1];
+			const std::vector<uint8_t>& previousFrame2 = packedFrames[2];
+
+			size_t frameSize = 0;
+			for (const PackedAttribute& attribute : attributes)
+			{
+				frameSize += getSizeOfDataFormat(attribute.Format) * frameData.vertexCount;
+			}
+			packedFrame.resize(frameSize);
+
+			size_t attributeOffset = 0;
+			for (const PackedAttribute& attribute : attributes)
+			{
+				const size_t dataSize = getSizeOfDataFormat(attribute.Format) * frameData.vertexCount;
+				packAttribute(attribute, windowBounds, frameData, packedFrame.data() + attributeOffset);
+
+				temporal_compression::AttributeHeader attributeHeader{ static_cast<uint32_t>(Prediction::None), static_cast<uint32_t>(dataSize), 0 };
+				const uint8_t* encoded = packedFrame.data() + attributeOffset;
+
+				if (!isKeyframe && attribute.Kind != PackedKind::Raw)
+				{
+					const uint16_t* values = reinterpret_cast<const uint16_t*>(packedFrame.data() + attributeOffset);
+					const uint16_t* previous = reinterpret_cast<const uint16_t*>(previousFrame.data() + attributeOffset);
+					const uint16_t* previous2 = reinterpret_cast<const uint16_t*>(previousFrame2.data() + attributeOffset);
+					const size_t valueCount = dataSize / sizeof(uint16_t);
+
+					// Keep whichever of the stored values and the residuals of each prediction is the smallest.
+					for (Prediction prediction : { Prediction::Previous, Prediction::Linear })
+					{
+						if (prediction == Prediction::Linear && chainLength < 3)
+						{
+							continue;
+						}
+
+						std::vector<uint8_t>& residual = residuals[prediction == Prediction::Linear ? 1 : 0];
+						residual.clear();
+						const size_t residualSize = encodeResiduals(values, previous, previous2, valueCount, prediction, residual);
+						if (residualSize < attributeHeader.EncodedSize)
+						{
+							attributeHeader.Prediction = static_cast<uint32_t>(prediction);
+							attributeHeader.EncodedSize = static_cast<uint32_t>(residualSize);
+							encoded = residual.data();
+						}
+					}
+				}
+
+				// Packed values are coded a byte plane per uint16 byte, bit packed residuals as plain bytes.
+				entropyCoded.clear();
+				const size_t stride = attributeHeader.Prediction == static_cast<uint32_t>(Prediction::None)
+					? getSizeOfDataFormatComponent(attribute.Format) : 1;
+				const size_t entropyCodedSize = ransEncode(encoded, attributeHeader.EncodedSize, stride, entropyCoded);
+				if (entropyCodedSize < attributeHeader.EncodedSize)
+				{
+					attributeHeader.EntropyCodedSize = static_cast<uint32_t>(entropyCodedSize);
+				}
+
+				pStream->write(attributeHeader);
+				if (attributeHeader.EntropyCodedSize != 0)
+				{
+					pStream->write(entropyCoded.data(), attributeHeader.EntropyCodedSize);
+				}
+				else
+				{
+					pStream->write(encoded, attributeHeader.EncodedSize);
+				}
+
+				attributeOffset += dataSize;
+			}
+		}
+
+		frameIndexValues[iFrame].Size = pStream->getPosition() - frameIndexValues[iFrame].Offset;
+	}
+
+	// Update the frame seek table with the real offsets.
+	pStream->seek(frameSeekTableOffset, Stream::SeekOrigin::Begin);
+	for (uint64_t iEntry = 0; iEntry < frameSeekTableValues.size(); ++iEntry)
+	{
+		pStream->write(frameSeekTableValues[iEntry]);
+	}
+
+	pStream->seek(frameIndexOffset, Stream::SeekOrigin::Begin);
+	pStream->write(frameIndexValues.data(), sizeof(temporal_compression::FrameIndexEntry) * frameIndexValues.size());
+
+	return true;
+}
+
+} //namespace nvc
@@ -0,0 +1,31 @@
+#pragma once
+
+//! Local Includes.
+#include "ICompressor.h"
+
+namespace nvc
+{
+
+// Quantises attributes like QuantisationCompressor, but against bounds shared by a seek window, and stores
+// only the first frame of each window (or of each run of frames with the same vertex count) as is.
+// The other frames store the residuals of their packed values from the previous frame, or from the
+// linear extrapolation of the two previous frames, whichever is smaller.
+class TemporalCompressor final : public ICompressor
+{
+public:
+	static const size_t DefaultSeekWindow = 10;
+
+public:
+	TemporalCompressor() = default;
+	~TemporalCompressor() = default;
+
+	bool compress(const InputGeomCache& geomCache, Stream* pStream) override;
+
+	//...
+	TemporalCompressor(const TemporalCompressor&) = delete;
+	TemporalCompressor(TemporalCompressor&&) = delete;
+	TemporalCompressor& operator=(const TemporalCompressor&) = delete;
+	TemporalCompressor& operator=(TemporalCompressor&&) = delete;
+};
+
+} // namespace nvc
@@ -0,0 +1,647 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "TemporalDecompressor.h"
+
+//! Project Includes.
+#include "Plugin/Stream/Stream.h"
+#include "Plugin/InputGeomCache.h"
+#include "PackedTransform.h"
+#include "ResidualCoding.h"
+#include "RansCoding.h"
+
+namespace nvc
+{
+
+TemporalDecompressor::~TemporalDecompressor()
+{
+	close();
+}
+
+void TemporalDecompressor::open(Stream* pStream)
+{
+	close();
+
+	m_pStream = pStream;
+
+	// Read the file header.
+	m_pStream->read(m_Header);
+
+	// Read the descriptor.
+	for (uint32_t iElement = 0; iElement < m_Header.VertexAttributeCount; ++iElement)
+	{
+		m_pStream->read(m_Semantics[iElement], sizeof(char) * temporal_compression::SEMANTIC_STRING_LENGTH);
+
+		uint32_t format = 0;
+		m_pStream->read(format);
+
+		// note: frames are cached packed, so the formats stay the stored ones (see decodeAttribute()).
+		m_Descriptor[iElement].semantic = m_Semantics[iElement];
+		m_Descriptor[iElement].format = static_cast<DataFormat>(format);
+	}
+
+	m_FramesOffset = m_pStream->getPosition();
+
+	// Read the seek table.
+	const size_t seekTableSize = (m_Header.FrameCount + m_Header.FrameSeekWindowCount - 1) / m_Header.FrameSeekWindowCount;
+	for (uint64_t iEntry = 0; iEntry < seekTableSize; ++iEntry)
+	{
+		m_SeekTable.push_back(m_pStream->read<uint64_t>());
+	}
+
+	// Read the frame index.
+	assert((m_Header.Flags & temporal_compression::FILE_FLAG_FRAME_INDEX) != 0);
+	m_FrameIndex.resize(m_Header.FrameCount);
+	m_pStream->read(m_FrameIndex.data(), sizeof(temporal_compression::FrameIndexEntry) * m_FrameIndex.size());
+
+	// Read constant data
+	if(m_Header.ConstantDataSize > 0)
+	{
+		m_ConstantData.resize(m_Header.ConstantDataSize);
+		m_pStream->read(m_ConstantData.data(), m_ConstantData.size());
+	}
+
+	// Read the time table.
+	for (size_t iFrame = 0; iFrame < m_Header.FrameCount; ++iFrame)
+	{
+		m_FrameTimeTable.push_back(m_pStream->read<float>());
+	}
+
+	m_LoadedFrames.resize(m_Header.FrameCount);
+
+	// Read the topology shared by every frame, or prepare for the per window ones.
+	if ((m_Header.Flags & temporal_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		const size_t indexCount = static_cast<size_t>(m_pStream->read<uint64_t>());
+		m_FileTopologyBlock = readTopology(m_pStream, m_FramePool, indexCount, isIndexCoded(), m_FileTopology, m_FileTopologyBlockSize);
+		assert(m_FileTopologyBlock != nullptr);
+	}
+	else
+	{
+		m_WindowTopologies.resize(m_SeekTable.size());
+	}
+}
+
+void TemporalDecompressor::close()
+{
+	for (size_t iFrame = 0; iFrame < m_LoadedFrames.getFrameCount(); ++iFrame)
+	{
+		if (m_LoadedFrames.isLoaded(iFrame))
+		{
+			freeFrame(m_LoadedFrames[iFrame]);
+		}
+	}
+
+	m_Header = {};
+	m_pStream = nullptr;
+	memset(m_Descriptor, 0, sizeof(m_Descriptor));
+	m_SeekTable.clear();
+	m_FrameIndex.clear();
+
+	m_LoadedFrames.clear();
+	m_FramesOffset = 0;
+
+	m_WindowTopologies.clear(m_FramePool);
+	m_FramePool.deallocate(m_FileTopologyBlock, m_FileTopologyBlockSize);
+	m_FileTopology = {};
+	m_FileTopologyBlock = nullptr;
+	m_FileTopologyBlockSize = 0;
+	m_WalkTopologyWindow = InvalidFrameIndex;
+
+	m_FramePool.clear();
+
+	for (HistoryFrame& historyFrame : m_History)
+	{
+		historyFrame.FrameIndex = InvalidFrameIndex;
+	}
+}
+
+void TemporalDecompressor::prefetch(size_t frameIndex, size_t range)
+{
+	// The budget or pinned range may have changed since the last load.
+	evictFrames();
+
+	const size_t endFrame = std::min<size_t>(frameIndex + range, getFrameCount());
+
+	// Start from the first frame which isn't resident yet.
+	size_t firstFrame = frameIndex;
+	while (firstFrame < endFrame && m_LoadedFrames.isLoaded(firstFrame))
+	{
+		++firstFrame;
+	}
+
+	if (firstFrame >= endFrame)
+	{
+		return;
+	}
+
+	// Frames are read through the frame index, predicted frames decode from the history of the previous ones.
+	for (size_t iFrame = firstFrame; iFrame < endFrame; ++iFrame)
+	{
+		if (!m_LoadedFrames.isLoaded(iFrame))
+		{
+			loadIndexedFrame(iFrame);
+		}
+	}
+
+	releaseWalkTopology();
+}
+
+bool TemporalDecompressor::getData(size_t frameIndex, float& time, GeomCacheData& data)
+{
+	time = getFrameTime(frameIndex);
+	if (std::isfinite(time))
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		if (!m_LoadedFrames.isLoaded(frameIndex))
+		{
+			return false;
+		}
+
+		// Move to the front of the LRU list.
+		m_LoadedFrames.touch(frameIndex);
+
+		data = m_LoadedFrames[frameIndex].Data;
+		return true;
+	}
+
+	return false;
+}
+
+bool TemporalDecompressor::getData(float time, GeomCacheData& data)
+{
+	float frameTime = 0.0f;
+	return getData(getFrameIndex(time), frameTime, data);
+}
+
+size_t TemporalDecompressor::getConstantDataStringSize() const
+{
+	if (!m_ConstantData.empty())
+	{
+		return InputGeomCacheConstantData::getStringCountFromData(m_ConstantData.data(), m_ConstantData.size());
+	}
+	return 0;
+}
+
+const char* TemporalDecompressor::getConstantDataString(size_t index) const
+{
+	if (!m_ConstantData.empty())
+	{
+		return InputGeomCacheConstantData::getStringFromData(m_ConstantData.data(), m_ConstantData.size(), index);
+	}
+	return nullptr;
+}
+
+bool TemporalDecompressor::decodeAttribute(size_t frameIndex, const GeomCacheData& data, size_t iAttribute, size_t firstVertex, size_t vertexCount, void* dst) const
+{
+	if (data.vertices == nullptr || iAttribute >= getAttributeCount(m_Descriptor))
+	{
+		return false;
+	}
+	assert(firstVertex + vertexCount <= data.vertexCount);
+
+	AABB verticesAABB{};
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		if (frameIndex >= m_LoadedFrames.getFrameCount() || !m_LoadedFrames.isLoaded(frameIndex))
+		{
+			return false;
+		}
+		verticesAABB = m_LoadedFrames[frameIndex].Bounds;
+	}
+
+	const char* semantic = m_Descriptor[iAttribute].semantic;
+	const void* packedData = data.vertices[iAttribute];
+
+	if (_stricmp(semantic, nvcSEMANTIC_POINTS) == 0
+		|| _stricmp(semantic, nvcSEMANTIC_VELOCITIES) == 0)
+	{
+		UnpackPoints(verticesAABB, static_cast<const unorm16x3*>(packedData) + firstVertex, static_cast<float3*>(dst), vertexCount);
+	}
+	else if (_stricmp(semantic, nvcSEMANTIC_NORMALS) == 0)
+	{
+		OctDecodeArray(static_cast<const unorm16x2*>(packedData) + firstVertex, static_cast<float3*>(dst), vertexCount);
+	}
+	else if (_stricmp(semantic, nvcSEMANTIC_TANGENTS) == 0)
+	{
+		OctDecodeArray(static_cast<const unorm16x2*>(packedData) + firstVertex, static_cast<float4*>(dst), vertexCount);
+	}
+	else if (_stricmp(semantic, nvcSEMANTIC_UV0) == 0
+		|| _stricmp(semantic, nvcSEMANTIC_UV1) == 0)
+	{
+		// Both components are plain unorm16, unpack them as one array.
+		UnpackUnorm16Array(reinterpret_cast<const unorm16*>(static_cast<const unorm16x2*>(packedData) + firstVertex), static_cast<float*>(dst), vertexCount * 2);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// Reads a single frame through the frame index. A predicted frame needs the previous frames in the history,
+// they're decoded first if they aren't. A frame sharing its window topology which isn't resident reads it
+// from the window's first frame beforehand.
+void TemporalDecompressor::loadIndexedFrame(size_t frameIndex)
+{
+	const temporal_compression::FrameIndexEntry& entry = m_FrameIndex[frameIndex];
+	if (entry.Size == 0)
+	{
+		return;
+	}
+
+	temporal_compression::FrameHeader frameHeader{};
+	m_pStream->seek(entry.Offset, Stream::SeekOrigin::Begin);
+	m_pStream->read(frameHeader);
+
+	if ((frameHeader.Flags & temporal_compression::FRAME_FLAG_KEYFRAME) == 0
+		&& m_History[0].FrameIndex != frameIndex - 1)
+	{
+		replayHistory(frameIndex);
+		m_pStream->seek(entry.Offset + sizeof(frameHeader), Stream::SeekOrigin::Begin);
+	}
+
+	const GeomCacheData* sharedTopology = loadSharedTopology(frameIndex, frameHeader);
+	if (sharedTopology == nullptr && (frameHeader.Flags & temporal_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		const size_t windowStart = getSeekTableIndex(frameIndex) * m_Header.FrameSeekWindowCount;
+
+		temporal_compression::FrameHeader windowHeader{};
+		m_pStream->seek(m_FrameIndex[windowStart].Offset, Stream::SeekOrigin::Begin);
+		m_pStream->read(windowHeader);
+		sharedTopology = loadSharedTopology(windowStart, windowHeader);
+
+		m_pStream->seek(entry.Offset + sizeof(frameHeader), Stream::SeekOrigin::Begin);
+	}
+
+	loadFrame(frameIndex, frameHeader, sharedTopology);
+}
+
+// Decodes the frames before frameIndex into the history, without caching them. Keyframes start every
+// seek window, so this goes back at most to the window start, or resumes from the history if it's in the window.
+void TemporalDecompressor::replayHistory(size_t frameIndex)
+{
+	const size_t windowStart = getSeekTableIndex(frameIndex) * m_Header.FrameSeekWindowCount;
+
+	size_t firstFrame = windowStart;
+	if (m_History[0].FrameIndex != InvalidFrameIndex
+		&& m_History[0].FrameIndex >= windowStart
+		&& m_History[0].FrameIndex < frameIndex)
+	{
+		firstFrame = m_History[0].FrameIndex + 1;
+	}
+
+	for (size_t iFrame = firstFrame; iFrame < frameIndex; ++iFrame)
+	{
+		if (m_FrameIndex[iFrame].Size == 0)
+		{
+			continue;
+		}
+
+		temporal_compression::FrameHeader frameHeader{};
+		m_pStream->seek(m_FrameIndex[iFrame].Offset, Stream::SeekOrigin::Begin);
+		m_pStream->read(frameHeader);
+
+		if ((frameHeader.Flags & temporal_compression::FRAME_FLAG_SHARED_TOPOLOGY) == 0)
+		{
+			skipTopology(m_pStream, frameHeader.IndexCount, isIndexCoded());
+		}
+
+		decodeVertices(iFrame, frameHeader);
+	}
+}
+
+// Reads the attributes of a frame into m_History[0], predicted ones from the previous history frames.
+// The stream is at the frame's AABB. Returns false if the frame can't be decoded.
+bool TemporalDecompressor::decodeVertices(size_t frameIndex, const temporal_compression::FrameHeader& frameHeader)
+{
+	if (frameHeader.VertexCount == 0)
+	{
+		return true;
+	}
+
+	std::rotate(std::begin(m_History), std::begin(m_History) + 2, std::end(m_History));
+	HistoryFrame& historyFrame = m_History[0];
+	const HistoryFrame& previousFrame = m_History[1];
+	const HistoryFrame& previousFrame2 = m_History[2];
+
+	const size_t attributeCount = getAttributeCount(m_Descriptor);
+	size_t frameSize = 0;
+	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	{
+		frameSize += getSizeOfDataFormat(m_Descriptor[iAttribute].format) * frameHeader.VertexCount;
+	}
+
+	historyFrame.FrameIndex = InvalidFrameIndex;
+	historyFrame.VertexCount = frameHeader.VertexCount;
+	historyFrame.Attributes.resize(frameSize);
+	m_pStream->read(historyFrame.Bounds);
+
+	size_t attributeOffset = 0;
+	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	{
+		const size_t dataSize = getSizeOfDataFormat(m_Descriptor[iAttribute].format) * frameHeader.VertexCount;
+		uint8_t* values = historyFrame.Attributes.data() + attributeOffset;
+
+		temporal_compression::AttributeHeader attributeHeader{};
+		m_pStream->read(attributeHeader);
+
+		const Prediction prediction = static_cast<Prediction>(attributeHeader.Prediction);
+		if (prediction == Prediction::None && attributeHeader.EncodedSize != dataSize)
+		{
+			return false;
+		}
+
+		const bool isEntropyCoded = attributeHeader.EntropyCodedSize != 0;
+		if (isEntropyCoded)
+		{
+			m_EntropyCodedBuffer.resize(attributeHeader.EntropyCodedSize);
+			m_pStream->read(m_EntropyCodedBuffer.data(), m_EntropyCodedBuffer.size());
+		}
+
+		if (prediction == Prediction::None)
+		{
+			if (!isEntropyCoded)
+			{
+				m_pStream->read(values, dataSize);
+			}
+			else if (!ransDecode(m_EntropyCodedBuffer.data(), m_EntropyCodedBuffer.size()
+				, getSizeOfDataFormatComponent(m_Descriptor[iAttribute].format), values, dataSize))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			const bool hasPrediction = frameIndex > 0
+				&& previousFrame.FrameIndex == frameIndex - 1
+				&& previousFrame.VertexCount == frameHeader.VertexCount
+				&& (prediction != Prediction::Linear
+					|| (frameIndex > 1 && previousFrame2.FrameIndex == frameIndex - 2 && previousFrame2.VertexCount == frameHeader.VertexCount));
+			if (!hasPrediction)
+			{
+				return false;
+			}
+
+			m_EncodedBuffer.resize(attributeHeader.EncodedSize);
+			if (!isEntropyCoded)
+			{
+				m_pStream->read(m_EncodedBuffer.data(), m_EncodedBuffer.size());
+			}
+			else if (!ransDecode(m_EntropyCodedBuffer.data(), m_EntropyCodedBuffer.size(), 1, m_EncodedBuffer.data(), m_EncodedBuffer.size()))
+			{
+				return false;
+			}
+
+			if (!decodeResiduals(m_EncodedBuffer.data(), m_EncodedBuffer.size()
+				, reinterpret_cast<const uint16_t*>(previousFrame.Attributes.data() + attributeOffset)
+				, reinterpret_cast<const uint16_t*>(previousFrame2.Attributes.data() + attributeOffset)
+				, dataSize / sizeof(uint16_t), prediction, reinterpret_cast<uint16_t*>(values)))
+			{
+				return false;
+			}
+		}
+
+		attributeOffset += dataSize;
+	}
+
+	historyFrame.FrameIndex = frameIndex;
+	return true;
+}
+
+// The stream is past the frame header, and past the topology if sharedTopology comes from loadSharedTopology().
+void TemporalDecompressor::loadFrame(size_t frameIndex, const temporal_compression::FrameHeader& frameHeader, const GeomCacheData* sharedTopology)
+{
+	const bool hasTopology = sharedTopology == nullptr;
+	if (hasTopology && (frameHeader.Flags & temporal_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		// The window topology couldn't be loaded, the attributes are still decoded for the next frames.
+		decodeVertices(frameIndex, frameHeader);
+		return;
+	}
+
+	const size_t frameOffset = m_pStream->getPosition();
+
+	FrameDataType frameData{};
+	frameData.Time = m_FrameTimeTable[frameIndex];
+	frameData.Data.vertexCount = frameHeader.VertexCount;
+
+	if (hasTopology)
+	{
+		// The submesh count follows the meshes, peek at it so the whole frame fits in one block.
+		frameData.Data.indexCount = frameHeader.IndexCount;
+		frameData.Data.meshCount = m_pStream->read<uint64_t>();
+		const size_t meshesOffset = m_pStream->getPosition();
+		m_pStream->seek(sizeof(GeomMesh) * frameData.Data.meshCount, Stream::SeekOrigin::Current);
+		frameData.Data.submeshCount = m_pStream->read<uint64_t>();
+		m_pStream->seek(meshesOffset, Stream::SeekOrigin::Begin);
+	}
+
+	frameData.Block = m_FramePool.allocateFrame(frameData.Data, m_Descriptor, frameData.BlockSize);
+	if (frameData.Block == nullptr)
+	{
+		m_pStream->seek(frameOffset, Stream::SeekOrigin::Begin);
+		if (hasTopology)
+		{
+			skipTopology(m_pStream, frameHeader.IndexCount, isIndexCoded());
+		}
+		decodeVertices(frameIndex, frameHeader);
+		return;
+	}
+
+	if (hasTopology)
+	{
+		m_pStream->read(frameData.Data.meshes, sizeof(GeomMesh) * frameData.Data.meshCount);
+		m_pStream->seek(sizeof(uint64_t), Stream::SeekOrigin::Current);
+		m_pStream->read(frameData.Data.submeshes, sizeof(GeomSubmesh) * frameData.Data.submeshCount);
+
+		readIndices(m_pStream, frameHeader.IndexCount, isIndexCoded(), static_cast<int32_t*>(frameData.Data.indices));
+	}
+	else
+	{
+		useSharedTopology(frameIndex, *sharedTopology, frameData);
+	}
+
+	// Attributes stay packed, they're dequantised by decodeAttribute() when the frame is used.
+	if (frameHeader.VertexCount > 0)
+	{
+		if (!decodeVertices(frameIndex, frameHeader))
+		{
+			freeFrame(frameData);
+			return;
+		}
+
+		const HistoryFrame& historyFrame = m_History[0];
+		frameData.Bounds = historyFrame.Bounds;
+
+		size_t attributeOffset = 0;
+		const size_t attributeCount = getAttributeCount(m_Descriptor);
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			const size_t dataSize = getSizeOfDataFormat(m_Descriptor[iAttribute].format) * frameData.Data.vertexCount;
+			memcpy(frameData.Data.vertices[iAttribute], historyFrame.Attributes.data() + attributeOffset, dataSize);
+			attributeOffset += dataSize;
+		}
+	}
+
+	if (!insertLoadedData(frameIndex, frameData))
+	{
+		freeFrame(frameData);
+	}
+}
+
+void TemporalDecompressor::freeFrame(FrameDataType& data)
+{
+	m_FramePool.deallocate(data.Block, data.BlockSize);
+	if (data.TopologyWindow != InvalidFrameIndex)
+	{
+		m_WindowTopologies.release(data.TopologyWindow, m_FramePool);
+	}
+	data.Data = GeomCacheData{};
+	data.Block = nullptr;
+	data.BlockSize = 0;
+	data.TopologyWindow = InvalidFrameIndex;
+}
+
+// Returns the shared topology of a frame, or nullptr if the frame stores its own and the stream is still at it.
+// A seek window's first frame stores the topology shared by the rest of the window: it's read into
+// m_WindowTopologies (or skipped if already there) and stays referenced while prefetch() walks the window.
+const GeomCacheData* TemporalDecompressor::loadSharedTopology(size_t frameIndex, const temporal_compression::FrameHeader& frameHeader)
+{
+	const size_t window = getSeekTableIndex(frameIndex);
+
+	if ((frameHeader.Flags & temporal_compression::FRAME_FLAG_SHARED_TOPOLOGY) != 0)
+	{
+		if ((m_Header.Flags & temporal_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0)
+		{
+			return &m_FileTopology;
+		}
+
+		if (window != m_WalkTopologyWindow && m_WindowTopologies.isLoaded(window))
+		{
+			// Still referenced by resident frames of the window, as when a frame is read through the frame index.
+			releaseWalkTopology();
+			m_WindowTopologies.acquire(window);
+			m_WalkTopologyWindow = window;
+		}
+
+		return window == m_WalkTopologyWindow ? &m_WindowTopologies.get(window) : nullptr;
+	}
+
+	if ((m_Header.Flags & temporal_compression::FILE_FLAG_SHARED_TOPOLOGY) != 0
+		|| (frameIndex % m_Header.FrameSeekWindowCount) != 0)
+	{
+		return nullptr;
+	}
+
+	releaseWalkTopology();
+
+	if (m_WindowTopologies.isLoaded(window))
+	{
+		skipTopology(m_pStream, frameHeader.IndexCount, isIndexCoded());
+		m_WindowTopologies.acquire(window);
+	}
+	else
+	{
+		const size_t topologyOffset = m_pStream->getPosition();
+
+		GeomCacheData topology{};
+		size_t blockSize = 0;
+		void* block = readTopology(m_pStream, m_FramePool, frameHeader.IndexCount, isIndexCoded(), topology, blockSize);
+		if (block == nullptr)
+		{
+			m_pStream->seek(topologyOffset, Stream::SeekOrigin::Begin);
+			return nullptr;
+		}
+
+		m_WindowTopologies.set(window, topology, block, blockSize);
+	}
+
+	m_WalkTopologyWindow = window;
+	return &m_WindowTopologies.get(window);
+}
+
+void TemporalDecompressor::releaseWalkTopology()
+{
+	if (m_WalkTopologyWindow != InvalidFrameIndex)
+	{
+		m_WindowTopologies.release(m_WalkTopologyWindow, m_FramePool);
+		m_WalkTopologyWindow = InvalidFrameIndex;
+	}
+}
+
+// Points a frame at a shared topology, a window topology stays referenced until the frame is freed.
+void TemporalDecompressor::useSharedTopology(size_t frameIndex, const GeomCacheData& topology, FrameDataType& frameData)
+{
+	frameData.Data.indices = topology.indices;
+	frameData.Data.indexCount = topology.indexCount;
+	frameData.Data.meshes = topology.meshes;
+	frameData.Data.meshCount = topology.meshCount;
+	frameData.Data.submeshes = topology.submeshes;
+	frameData.Data.submeshCount = topology.submeshCount;
+
+	if (&topology != &m_FileTopology)
+	{
+		frameData.TopologyWindow = getSeekTableIndex(frameIndex);
+		m_WindowTopologies.acquire(frameData.TopologyWindow);
+	}
+}
+
+bool TemporalDecompressor::insertLoadedData(size_t frameIndex, FrameDataType& data)
+{
+	if (m_LoadedFrames.isLoaded(frameIndex))
+	{
+		return false;
+	}
+
+	data.Size = data.BlockSize;
+
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+
+		m_LoadedFrames.insert(frameIndex, data);
+	}
+
+	evictFrames();
+	return true;
+}
+
+void TemporalDecompressor::setCacheBudget(size_t bytes)
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	m_LoadedFrames.setBudget(bytes);
+}
+
+size_t TemporalDecompressor::getCacheSize() const
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	return m_LoadedFrames.getSize();
+}
+
+void TemporalDecompressor::setPinnedRange(size_t frameIndex, size_t range)
+{
+	spin_mutex::lock_t lock(m_LoadedFramesMutex);
+	m_LoadedFrames.setPinnedRange(frameIndex, range);
+}
+
+// Drops least recently used frames until the cache fits its budget. Only called from the prefetching
+// thread (prefetch()/loadFrame()), which is the only writer of m_LoadedFrames outside the lock.
+void TemporalDecompressor::evictFrames()
+{
+	{
+		spin_mutex::lock_t lock(m_LoadedFramesMutex);
+		m_LoadedFrames.evict();
+	}
+
+	// Free outside of the lock, getData() shouldn't wait on the allocator.
+	std::vector<FrameDataType>& evictedFrames = m_LoadedFrames.getEvictedFrames();
+	for (auto& frame : evictedFrames)
+	{
+		freeFrame(frame);
+	}
+	evictedFrames.clear();
+}
+
+} //namespace nvc
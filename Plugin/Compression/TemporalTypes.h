@@ -0,0 +1,59 @@
+#pragma once
+#include "Plugin/Foundation/Types.h"
+
+namespace nvc
+{
+
+namespace temporal_compression
+{
+	struct FileHeader
+	{
+		uint64_t FrameCount;
+		uint32_t FrameSeekWindowCount;
+		uint32_t VertexAttributeCount;
+		uint32_t ConstantDataSize;
+		uint32_t Flags; // FILE_FLAG_*
+	};
+
+	struct FrameHeader
+	{
+		uint32_t IndexCount;
+		uint32_t VertexCount;
+		uint32_t Flags; // FRAME_FLAG_*
+	};
+
+	// Where a frame is stored, from its FrameHeader to the next frame.
+	struct FrameIndexEntry
+	{
+		uint64_t Offset;
+		uint64_t Size; // 0 if the frame wasn't written.
+	};
+
+	// Precedes each attribute of a frame, after the frame's AABB.
+	struct AttributeHeader
+	{
+		uint32_t Prediction; // nvc::Prediction, None: the packed values follow, otherwise their residuals (see ResidualCoding.h).
+		uint32_t EncodedSize;
+		uint32_t EntropyCodedSize; // 0, or the size of the rANS coding of the EncodedSize bytes (see RansCoding.h), stored instead.
+	};
+
+	static const uint32_t SEMANTIC_STRING_LENGTH = 60;
+
+	// Every frame has the same topology, stored once after the time table.
+	static const uint32_t FILE_FLAG_SHARED_TOPOLOGY = 1u << 0;
+
+	// A FrameIndexEntry per frame follows the seek table, so any frame can be read on its own.
+	static const uint32_t FILE_FLAG_FRAME_INDEX = 1u << 1;
+
+	// Topology indices are stored as their coding (see FrameTopology.h).
+	static const uint32_t FILE_FLAG_INDEX_CODED = 1u << 2;
+
+	// The frame stores no topology, it uses the file topology or else the one of its seek window's first frame.
+	static const uint32_t FRAME_FLAG_SHARED_TOPOLOGY = 1u << 0;
+
+	// Every attribute of the frame is stored as is. Other frames are predicted from the frames since
+	// the last keyframe, which is at most the first frame of their seek window.
+	static const uint32_t FRAME_FLAG_KEYFRAME = 1u << 1;
+}
+
+} // namespace nvc
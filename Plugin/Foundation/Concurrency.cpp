@@ -0,0 +1,225 @@
+#include "Plugin/PrecompiledHeader.h"
+#include "Concurrency.h"
+
+#if defined(NVC_ENABLE_THREAD_POOL)
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace nvc {
+namespace thread_pool {
+
+namespace {
+
+struct job_queue
+{
+    std::mutex mutex;
+    std::deque<job*> jobs;
+};
+
+class pool
+{
+public:
+    static pool& instance()
+    {
+        static pool s_pool;
+        return s_pool;
+    }
+
+    ~pool() { stop(); }
+
+    void start(size_t worker_count);
+    void stop();
+    size_t get_worker_count() const { return m_workers.size(); }
+
+    void run(job& job);
+
+private:
+    pool() { start(std::max(std::thread::hardware_concurrency(), 1u) - 1); }
+
+    void worker_func(size_t queue_index);
+    job_queue& get_local_queue();
+    job* find_job(size_t queue_index);
+    void work_on(job& job);
+
+    // Queue 0 takes the jobs of threads outside the pool, queue 1 + i belongs to worker i.
+    std::unique_ptr<job_queue[]> m_queues;
+    size_t m_queue_count = 0;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    std::atomic<size_t> m_open_jobs { 0 }; // jobs with unclaimed iterations.
+    bool m_stop = false;
+};
+
+thread_local size_t t_queue_index = 0;
+
+void pool::start(size_t worker_count)
+{
+    m_queue_count = worker_count + 1;
+    m_queues.reset(new job_queue[m_queue_count]);
+    m_stop = false;
+    for (size_t i = 0; i < worker_count; ++i) {
+        m_workers.emplace_back([this, i]() { worker_func(i + 1); });
+    }
+}
+
+void pool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+job_queue& pool::get_local_queue()
+{
+    // A thread of another pool instance (after a restart) falls back to the shared queue.
+    return m_queues[t_queue_index < m_queue_count ? t_queue_index : 0];
+}
+
+// Own jobs first (newest, its data is hot), then the oldest of the others.
+job* pool::find_job(size_t queue_index)
+{
+    for (size_t i = 0; i < m_queue_count; ++i) {
+        job_queue& queue = m_queues[(queue_index + i) % m_queue_count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        const auto take = [](job* j) {
+            if (j->next.load(std::memory_order_relaxed) >= j->count) {
+                return false;
+            }
+            j->users.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        };
+        if (i == 0) {
+            for (auto it = queue.jobs.rbegin(); it != queue.jobs.rend(); ++it) {
+                if (take(*it)) {
+                    return *it;
+                }
+            }
+        }
+        else {
+            for (job* j : queue.jobs) {
+                if (take(j)) {
+                    return j;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+void pool::work_on(job& job)
+{
+    for (;;) {
+        const size_t begin = job.next.fetch_add(job.grain, std::memory_order_relaxed);
+        if (begin >= job.count) {
+            break;
+        }
+        const size_t end = std::min(begin + job.grain, job.count);
+        if (end == job.count) {
+            m_open_jobs.fetch_sub(1, std::memory_order_relaxed);
+        }
+        job.invoke(job.body, begin, end);
+        job.done.fetch_add(end - begin, std::memory_order_release);
+    }
+}
+
+void pool::worker_func(size_t queue_index)
+{
+    t_queue_index = queue_index;
+
+    for (;;) {
+        if (job* j = find_job(queue_index)) {
+            work_on(*j);
+            j->users.fetch_sub(1, std::memory_order_release);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wake_mutex);
+        m_wake.wait(lock, [this]() { return m_stop || m_open_jobs.load(std::memory_order_relaxed) > 0; });
+        if (m_stop) {
+            break;
+        }
+    }
+}
+
+void pool::run(job& job)
+{
+    if (job.grain == 0) {
+        // A few chunks per thread to balance uneven iterations.
+        job.grain = std::max<size_t>(job.count / (m_queue_count * 4), 1);
+    }
+    if (m_workers.empty() || job.count <= job.grain) {
+        job.invoke(job.body, 0, job.count);
+        return;
+    }
+
+    job_queue& queue = get_local_queue();
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(&job);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_open_jobs.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_wake.notify_all();
+
+    work_on(job);
+
+    // Help with other jobs until the chunks claimed by other threads are done.
+    while (job.done.load(std::memory_order_acquire) < job.count) {
+        if (nvc::thread_pool::job* other = find_job(t_queue_index < m_queue_count ? t_queue_index : 0)) {
+            work_on(*other);
+            other->users.fetch_sub(1, std::memory_order_release);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.erase(std::find(queue.jobs.begin(), queue.jobs.end(), &job));
+    }
+    // The job lives on the stack, wait for the threads which may still touch it.
+    while (job.users.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+void run(job& job)
+{
+    pool::instance().run(job);
+}
+
+void set_worker_count(size_t count)
+{
+    pool& p = pool::instance();
+    if (p.get_worker_count() != count) {
+        p.stop();
+        p.start(count);
+    }
+}
+
+size_t get_worker_count()
+{
+    return pool::instance().get_worker_count();
+}
+
+} // namespace thread_pool
+} // namespace nvc
+
+#endif // NVC_ENABLE_THREAD_POOL
@@ -3,8 +3,13 @@
 #ifdef _WIN32
     #define NVC_ENABLE_PPL
 #endif
+#if !defined(NVC_ENABLE_PPL) && !defined(NVC_ENABLE_TBB)
+    #define NVC_ENABLE_THREAD_POOL
+#endif
 
 #include <atomic>
+#include <functional>
+#include <iterator>
 #if defined(NVC_ENABLE_PPL)
     #include <ppl.h>
 #elif defined(NVC_ENABLE_TBB)
@@ -13,6 +18,57 @@
 
 namespace nvc {
 
+template<class T>
+inline T ceildiv(T v, T d) { return (v + d - 1) / d; }
+
+#if defined(NVC_ENABLE_THREAD_POOL)
+
+// Built-in backend when neither PPL nor TBB is available: a fixed set of std::thread workers with one job
+// deque each. A job is pushed on the deque of the thread submitting it and idle workers steal it, its
+// iterations are claimed in chunks. The submitting thread works on its own job and, while waiting for
+// the chunks run by others, on any other job, so nested parallel loops can't deadlock.
+namespace thread_pool {
+
+struct job
+{
+    void (*invoke)(const void* body, size_t begin, size_t end);
+    const void* body;
+    size_t count;
+    size_t grain;                 // iterations per chunk, 0 picks it from the worker count.
+    std::atomic<size_t> next;     // first unclaimed iteration.
+    std::atomic<size_t> done;     // number of iterations completed.
+    std::atomic<uint32_t> users;  // threads which found the job in a deque and may still claim from it.
+};
+
+// Runs job.invoke() over [0, job.count) and returns once all iterations are done.
+void run(job& job);
+
+// Worker threads besides the calling ones, hardware threads - 1 by default. 0 runs every loop serially.
+// The workers are restarted, it must not be called while parallel work is running.
+void set_worker_count(size_t count);
+size_t get_worker_count();
+
+} // namespace thread_pool
+
+template<class Body>
+inline void parallel_for_blocked_impl(size_t count, size_t grain, const Body& body)
+{
+    if (count == 0) {
+        return;
+    }
+    thread_pool::job job;
+    job.invoke = [](const void* b, size_t begin, size_t end) { (*static_cast<const Body*>(b))(begin, end); };
+    job.body = &body;
+    job.count = count;
+    job.grain = grain;
+    job.next = 0;
+    job.done = 0;
+    job.users = 0;
+    thread_pool::run(job);
+}
+
+#endif // NVC_ENABLE_THREAD_POOL
+
 template<class Index, class Body>
 inline void parallel_for(Index begin, Index end, const Body& body)
 {
@@ -21,7 +77,12 @@ inline void parallel_for(Index begin, Index end, const Body& body)
 #elif defined(NVC_ENABLE_TBB)
     tbb::parallel_for(begin, end, body);
 #else
-    for (; begin != end; ++begin) { body(begin); }
+    if (end <= begin) {
+        return;
+    }
+    parallel_for_blocked_impl(static_cast<size_t>(end - begin), 0, [&](size_t first, size_t last) {
+        for (; first != last; ++first) { body(static_cast<Index>(begin + first)); }
+    });
 #endif
 }
 
@@ -52,14 +113,37 @@ inline void parallel_for_blocked(int begin, int end, int granularity, const Body
 }
 #else
 template<class Body>
-inline void parallel_for(int begin, int end, int /*granularity*/, const Body& body)
+inline void parallel_for(int begin, int end, int granularity, const Body& body)
 {
-    for (; begin != end; ++begin) { body(begin); }
+    if (end <= begin) {
+        return;
+    }
+    parallel_for_blocked_impl(static_cast<size_t>(end - begin), static_cast<size_t>(std::max(granularity, 0)), [&](size_t first, size_t last) {
+        for (; first != last; ++first) { body(begin + static_cast<int>(first)); }
+    });
 }
 template<class Body>
-inline void parallel_for_blocked(int begin, int end, int /*granularity*/, const Body& body)
+inline void parallel_for_blocked(int begin, int end, int granularity, const Body& body)
+{
+    if (end <= begin) {
+        return;
+    }
+    parallel_for_blocked_impl(static_cast<size_t>(end - begin), static_cast<size_t>(std::max(granularity, 0)), [&](size_t first, size_t last) {
+        body(begin + static_cast<int>(first), begin + static_cast<int>(last));
+    });
+}
+#endif
+
+#if defined(NVC_ENABLE_THREAD_POOL)
+template<class Iter, class Body>
+inline void parallel_for_each(Iter begin, Iter end, const Body& body, std::random_access_iterator_tag)
 {
-    for (; begin != end; ++begin) { body(begin); }
+    parallel_for(static_cast<size_t>(0), static_cast<size_t>(end - begin), [&](size_t i) { body(begin[i]); });
+}
+template<class Iter, class Body, class Category>
+inline void parallel_for_each(Iter begin, Iter end, const Body& body, Category)
+{
+    for (; begin != end; ++begin) { body(*begin); }
 }
 #endif
 
@@ -71,7 +155,7 @@ inline void parallel_for_each(Iter begin, Iter end, const Body& body)
 #elif defined(NVC_ENABLE_TBB)
     tbb::parallel_for_each(begin, end, body);
 #else
-    for (; begin != end; ++begin) { body(*begin); }
+    parallel_for_each(begin, end, body, typename std::iterator_traits<Iter>::iterator_category());
 #endif
 }
 
@@ -88,13 +172,11 @@ inline void parallel_invoke(Bodies... bodies) { tbb::parallel_invoke(bodies...);
 
 #else
 
-template <class Body>
-inline void parallel_invoke(const Body& body) { body(); }
-
-template<typename Body, typename... Args>
-void parallel_invoke(const Body& first, Args... args) {
-    first();
-    parallel_invoke(args...);
+template <class... Bodies>
+inline void parallel_invoke(const Bodies&... bodies)
+{
+    const std::function<void()> functions[] = { bodies... };
+    parallel_for(static_cast<size_t>(0), sizeof...(bodies), [&](size_t i) { functions[i](); });
 }
 
 #endif
@@ -0,0 +1,76 @@
+#include "Plugin/PrecompiledHeader.h"
+#include "Simd.h"
+
+#if NVC_SIMD_X86
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+namespace nvc {
+
+#if NVC_SIMD_X86
+
+static void cpuid(int leaf, uint32_t (&info)[4])
+{
+#if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int*>(info), leaf, 0);
+#else
+    __cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+static uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+static cpu_features detect_cpu_features()
+{
+    cpu_features features {};
+
+    uint32_t info[4] = {};
+    cpuid(0, info);
+    const uint32_t max_leaf = info[0];
+
+    cpuid(1, info);
+    const bool osxsave = (info[2] & (1u << 27)) != 0;
+    const bool avx = (info[2] & (1u << 28)) != 0;
+    features.sse41 = (info[2] & (1u << 19)) != 0;
+
+    // The VEX encoded sets also need the OS to save the ymm registers.
+    const bool avx_enabled = osxsave && avx && (xgetbv0() & 0x6) == 0x6;
+    features.f16c = avx_enabled && (info[2] & (1u << 29)) != 0;
+
+    if (avx_enabled && max_leaf >= 7) {
+        cpuid(7, info);
+        features.avx2 = (info[1] & (1u << 5)) != 0;
+    }
+
+    return features;
+}
+
+#else
+
+static cpu_features detect_cpu_features()
+{
+    return cpu_features {};
+}
+
+#endif // NVC_SIMD_X86
+
+const cpu_features& get_cpu_features()
+{
+    static const cpu_features features = detect_cpu_features();
+    return features;
+}
+
+} // namespace nvc
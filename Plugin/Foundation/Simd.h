@@ -0,0 +1,34 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define NVC_SIMD_X86 1
+    #include <immintrin.h>
+#else
+    #define NVC_SIMD_X86 0
+#endif
+
+// Kernels for instruction sets above the build baseline are marked with these and only called after checking
+// get_cpu_features(). MSVC accepts any intrinsic anywhere, GCC and Clang need the set enabled per function.
+#if NVC_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+    #define NVC_TARGET_SSE41 __attribute__((target("sse4.1")))
+    #define NVC_TARGET_AVX2  __attribute__((target("avx2")))
+    #define NVC_TARGET_F16C  __attribute__((target("avx,f16c")))
+#else
+    #define NVC_TARGET_SSE41
+    #define NVC_TARGET_AVX2
+    #define NVC_TARGET_F16C
+#endif
+
+namespace nvc {
+
+// What the CPU and the OS support, detected once.
+struct cpu_features
+{
+    bool sse41;
+    bool avx2;
+    bool f16c;
+};
+
+const cpu_features& get_cpu_features();
+
+} // namespace nvc
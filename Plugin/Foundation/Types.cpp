@@ -1,5 +1,6 @@
 #include "Plugin/PrecompiledHeader.h"
 #include "Types.h"
+#include "Simd.h"
 
 namespace nvc {
 
@@ -20,4 +21,118 @@ float2 to_float(unorm16x2 v) { return { v[0].to_float(), v[1].to_float() }; }
 float3 to_float(unorm16x3 v) { return { v[0].to_float(), v[1].to_float(), v[2].to_float() }; }
 float4 to_float(unorm16x4 v) { return { v[0].to_float(), v[1].to_float(), v[2].to_float(), v[3].to_float() }; }
 
+
+static_assert(sizeof(half4) == 4 * sizeof(half), "half vectors must be tightly packed");
+
+// Half to float without branches, from "Fast Half Float Conversions" (Jeroen van der Meulen):
+// float bits = mantissa[offset[exponent] + mantissa bits] + exponent[exponent], indexed by the half's sign and exponent.
+struct half_to_float_tables
+{
+    uint32_t mantissa[2048];
+    uint32_t exponent[64];
+    uint16_t offset[64];
+
+    half_to_float_tables()
+    {
+        mantissa[0] = 0;
+        for (uint32_t i = 1; i < 1024; ++i) {
+            // Denormals, normalise them.
+            uint32_t m = i << 13;
+            uint32_t e = 0;
+            while ((m & 0x00800000u) == 0) {
+                e -= 0x00800000u;
+                m <<= 1;
+            }
+            m &= ~0x00800000u;
+            e += 0x38800000u;
+            mantissa[i] = m | e;
+        }
+        for (uint32_t i = 1024; i < 2048; ++i) {
+            mantissa[i] = 0x38000000u + ((i - 1024) << 13);
+        }
+
+        exponent[0] = 0;
+        exponent[32] = 0x80000000u;
+        for (uint32_t i = 1; i < 31; ++i) {
+            exponent[i] = i << 23;
+            exponent[i + 32] = 0x80000000u + (i << 23);
+        }
+        exponent[31] = 0x47800000u; // Inf and NaN.
+        exponent[63] = 0xC7800000u;
+
+        for (uint32_t i = 0; i < 64; ++i) {
+            offset[i] = (i == 0 || i == 32) ? 0 : 1024;
+        }
+    }
+};
+
+static const half_to_float_tables& get_half_to_float_tables()
+{
+    static const half_to_float_tables tables;
+    return tables;
+}
+
+static void half_to_float_array_table(float* dst, const half* src, size_t count)
+{
+    const half_to_float_tables& tables = get_half_to_float_tables();
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t h = src[i].data;
+        const uint32_t bits = tables.mantissa[tables.offset[h >> 10] + (h & 0x3ff)] + tables.exponent[h >> 10];
+        memcpy(&dst[i], &bits, sizeof(float));
+    }
+}
+
+static void float_to_half_array_scalar(half* dst, const float* src, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = half(src[i]);
+    }
+}
+
+#if NVC_SIMD_X86
+
+NVC_TARGET_F16C static void half_to_float_array_f16c(float* dst, const half* src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    half_to_float_array_table(dst + i, src + i, count - i);
+}
+
+NVC_TARGET_F16C static void float_to_half_array_f16c(half* dst, const float* src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    float_to_half_array_scalar(dst + i, src + i, count - i);
+}
+
+#endif // NVC_SIMD_X86
+
+void half_to_float_array(float* dst, const half* src, size_t count)
+{
+#if NVC_SIMD_X86
+    if (get_cpu_features().f16c) {
+        half_to_float_array_f16c(dst, src, count);
+        return;
+    }
+#endif
+    half_to_float_array_table(dst, src, count);
+}
+
+void float_to_half_array(half* dst, const float* src, size_t count)
+{
+#if NVC_SIMD_X86
+    if (get_cpu_features().f16c) {
+        float_to_half_array_f16c(dst, src, count);
+        return;
+    }
+#endif
+    float_to_half_array_scalar(dst, src, count);
+}
+
 } // namespace nvc
@@ -1,12 +1,14 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
 
 namespace nvc {
 
 using time_t = float;
 
 
-// note: this half doesn't care about Inf nor NaN. simply round down minor bits of exponent and mantissa.
+// IEEE 754 binary16. conversions round to nearest even and keep denormals, Inf and NaN.
 struct half
 {
     uint16_t data;
@@ -16,12 +18,36 @@ struct half
 
     half(float v)
     {
-        uint32_t n = (uint32_t&)v;
-        uint16_t sign_bit = (n >> 16) & 0x8000;
-        uint16_t exponent = (((n >> 23) - 127 + 15) & 0x1f) << 10;
-        uint16_t mantissa = (n >> (23 - 10)) & 0x3ff;
-
-        data = sign_bit | exponent | mantissa;
+        const uint32_t f32_infinity = 255u << 23;
+        const uint32_t f16_overflow = (127u + 16u) << 23; // 65520 and above round to Inf.
+        const uint32_t f16_min_normal = 113u << 23;       // 2^-14
+        const uint32_t denormal_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+        uint32_t n;
+        memcpy(&n, &v, sizeof(n));
+        const uint32_t sign = n & 0x80000000u;
+        n ^= sign;
+
+        uint16_t h;
+        if (n >= f16_overflow) {
+            h = n > f32_infinity ? 0x7e00 : 0x7c00; // quiet NaN or Inf.
+        }
+        else if (n < f16_min_normal) {
+            // The magic number shifts the mantissa down to the denormal bits, the FPU rounds it to nearest even.
+            float f, magic;
+            memcpy(&f, &n, sizeof(f));
+            memcpy(&magic, &denormal_magic, sizeof(magic));
+            f += magic;
+            memcpy(&n, &f, sizeof(n));
+            h = static_cast<uint16_t>(n - denormal_magic);
+        }
+        else {
+            const uint32_t mantissa_odd = (n >> 13) & 1;
+            n += ((15u - 127u) << 23) + 0xfff; // rebias and round up from half way...
+            n += mantissa_odd;                 // ...unless it makes the mantissa odd.
+            h = static_cast<uint16_t>(n >> 13);
+        }
+        data = static_cast<uint16_t>(h | (sign >> 16));
     }
 
     half& operator=(float v)
@@ -32,12 +58,29 @@ struct half
 
     float to_float() const
     {
-        uint32_t sign_bit = (data & 0x8000) << 16;
-        uint32_t exponent = ((((data >> 10) & 0x1f) - 15 + 127) & 0xff) << 23;
-        uint32_t mantissa = (data & 0x3ff) << (23 - 10);
-
-        uint32_t r = sign_bit | exponent | mantissa;
-        return (float&)r;
+        const uint32_t shifted_exponent = 0x7c00u << 13;
+        const uint32_t denormal_magic = 113u << 23;
+
+        uint32_t n = (data & 0x7fffu) << 13;
+        const uint32_t exponent = n & shifted_exponent;
+        n += (127u - 15u) << 23;
+
+        if (exponent == shifted_exponent) {
+            n += (128u - 16u) << 23; // Inf or NaN.
+        }
+        else if (exponent == 0) {
+            n += 1u << 23; // denormal, renormalise with the FPU.
+            float f, magic;
+            memcpy(&f, &n, sizeof(f));
+            memcpy(&magic, &denormal_magic, sizeof(magic));
+            f -= magic;
+            memcpy(&n, &f, sizeof(n));
+        }
+        n |= (data & 0x8000u) << 16;
+
+        float f;
+        memcpy(&f, &n, sizeof(f));
+        return f;
     }
 };
 
@@ -151,5 +194,10 @@ float2 to_float(unorm16x2 v);
 float3 to_float(unorm16x3 v);
 float4 to_float(unorm16x4 v);
 
+// Bulk half conversions, F16C when the CPU has it, tables otherwise.
+// Same results as the per element conversions, except for NaN payloads.
+void half_to_float_array(float* dst, const half* src, size_t count);
+void float_to_half_array(half* dst, const float* src, size_t count);
+
 } // namespace nvc
 
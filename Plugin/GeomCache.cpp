@@ -5,12 +5,34 @@
 #include "GeomCache.h"
 #include "Plugin/Compression/NullDecompressor.h"
 #include "Plugin/Compression/QuantisationDecompressor.h"
+#include "Plugin/Compression/TemporalDecompressor.h"
+#include "Plugin/Compression/PcaDecompressor.h"
+#include "Plugin/Compression/PackedTransform.h"
+#include "Plugin/Foundation/Concurrency.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 namespace nvc {
 
+namespace {
+
+// Runs body(begin, end) over ranges of grainSize items, in parallel unless there's only one.
+template<class Body>
+void forEachRange(size_t count, size_t grainSize, const Body& body) {
+	if(grainSize == 0 || count <= grainSize) {
+		body(size_t(0), count);
+		return;
+	}
+
+	parallel_for(0, static_cast<int>(ceildiv(count, grainSize)), 1, [&](int iRange) {
+		const size_t begin = grainSize * iRange;
+		body(begin, __min(begin + grainSize, count));
+	});
+}
+
+} // namespace
+
 template<typename T>
 void convertDataArrayToFloat2(float2* dst, const T* src, size_t numberOfElements) {
 	for(size_t i = 0; i < numberOfElements; ++i) {
@@ -32,6 +54,19 @@ void convertDataArrayToFloat4(float4* dst, const T* src, size_t numberOfElements
 	}
 }
 
+// half vectors are tightly packed, convert them as one array of halves.
+void convertDataArrayToFloat2(float2* dst, const half2* src, size_t numberOfElements) {
+	half_to_float_array(reinterpret_cast<float*>(dst), reinterpret_cast<const half*>(src), numberOfElements * 2);
+}
+
+void convertDataArrayToFloat3(float3* dst, const half3* src, size_t numberOfElements) {
+	half_to_float_array(reinterpret_cast<float*>(dst), reinterpret_cast<const half*>(src), numberOfElements * 3);
+}
+
+void convertDataArrayToFloat4(float4* dst, const half4* src, size_t numberOfElements) {
+	half_to_float_array(reinterpret_cast<float*>(dst), reinterpret_cast<const half*>(src), numberOfElements * 4);
+}
+
 void convertDataArrayToFloat2(float2* dst, const void* src, size_t numberOfElements, DataFormat dataFormat) {
 	switch(dataFormat) {
 	default:		assert(false && "DataFormat must have 2 components");		break;
@@ -72,6 +107,7 @@ GeomCache::GeomCache()
 
 GeomCache::~GeomCache()
 {
+	close();
 }
 
 bool GeomCache::open(const char* nvcFilename) {
@@ -91,6 +127,14 @@ bool GeomCache::open(const char* nvcFilename) {
 		m_Decompressor = std::unique_ptr<QuantisationDecompressor>(
 			new QuantisationDecompressor()
 		);
+	} else if(strstr(nvcFilename, "temporal") != nullptr) {
+		m_Decompressor = std::unique_ptr<TemporalDecompressor>(
+			new TemporalDecompressor()
+		);
+	} else if(strstr(nvcFilename, "pca") != nullptr) {
+		m_Decompressor = std::unique_ptr<PcaDecompressor>(
+			new PcaDecompressor()
+		);
 	} else {
 		m_Decompressor = std::unique_ptr<NullDecompressor>(
 			new NullDecompressor()
@@ -98,6 +142,7 @@ bool GeomCache::open(const char* nvcFilename) {
 	}
 	assert(m_Decompressor);
 
+	m_Decompressor->setCacheBudget(m_CacheBudget);
 	m_Decompressor->open(m_InputFileStream.get());
 
 	{
@@ -117,13 +162,19 @@ bool GeomCache::open(const char* nvcFilename) {
 //	printf("m_DescIndex_uv0                  =%d\n", m_DescIndex_uv0      );
 //	printf("m_DescIndex_colors               =%d\n", m_DescIndex_colors   );
 
-	prefetch(0, 1);
+	prefetchNow(0, 1);
+	if(m_AsyncPrefetch) {
+		startPrefetchThread();
+	}
 	return good();
 }
 
 bool GeomCache::close() {
-	m_Decompressor.release();
-	m_InputFileStream.release();
+	stopPrefetchThread();
+
+	m_Decompressor.reset();
+	m_InputFileStream.reset();
+	m_VertexTriangles.clear();
 	m_DescIndex_points   = -1;
 	m_DescIndex_normals  = -1;
 	m_DescIndex_tangents = -1;
@@ -140,7 +191,124 @@ bool GeomCache::good() const {
 }
 
 void GeomCache::prefetch(size_t currentFrame, size_t range) {
-	m_Decompressor->prefetch(currentFrame, range);
+	if(m_PrefetchThread.joinable()) {
+		requestPrefetch(currentFrame, range);
+	} else {
+		prefetchNow(currentFrame, range);
+	}
+}
+
+void GeomCache::setAsyncPrefetch(bool enable) {
+	m_AsyncPrefetch = enable;
+	if(! good()) {
+		return;
+	}
+
+	if(enable) {
+		startPrefetchThread();
+	} else {
+		stopPrefetchThread();
+	}
+}
+
+void GeomCache::setCacheBudget(size_t bytes) {
+	m_CacheBudget = bytes;
+	if(good()) {
+		m_Decompressor->setCacheBudget(bytes);
+	}
+}
+
+void GeomCache::setPrefetchLookAhead(size_t frames, float seconds) {
+	m_LookAheadFrames = frames;
+	m_LookAheadSeconds = seconds;
+}
+
+void GeomCache::prefetchNow(size_t frameIndex, size_t range) {
+	std::lock_guard<std::mutex> lock(m_DecodeMutex);
+	m_Decompressor->prefetch(frameIndex, range);
+}
+
+void GeomCache::requestPrefetch(size_t frameIndex, size_t range) {
+	{
+		std::lock_guard<std::mutex> lock(m_PrefetchMutex);
+		if(frameIndex == m_PrefetchFrame && range == m_PrefetchRange) {
+			return;
+		}
+		m_PrefetchFrame = frameIndex;
+		m_PrefetchRange = range;
+		++m_PrefetchGeneration;
+	}
+	m_PrefetchCondition.notify_one();
+}
+
+size_t GeomCache::getLookAheadRange(size_t frameIndex) const {
+	size_t range = __max(m_LookAheadFrames, size_t(1));
+
+	if(m_LookAheadSeconds > 0.0f) {
+		size_t endFrame = getFrameIndexByTime(getTimeByFrameIndex(frameIndex) + m_LookAheadSeconds);
+		if(endFrame == ~0u) {
+			endFrame = getFrameCount();
+		}
+		if(endFrame >= frameIndex) {
+			range = __max(range, endFrame - frameIndex + 1);
+		}
+	}
+
+	return range;
+}
+
+void GeomCache::startPrefetchThread() {
+	if(m_PrefetchThread.joinable()) {
+		return;
+	}
+
+	m_PrefetchStop = false;
+	m_PrefetchFrame = 0;
+	m_PrefetchRange = 0;
+	m_PrefetchThread = std::thread([this]() { prefetchThreadFunc(); });
+}
+
+void GeomCache::stopPrefetchThread() {
+	if(! m_PrefetchThread.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_PrefetchMutex);
+		m_PrefetchStop = true;
+	}
+	m_PrefetchCondition.notify_one();
+	m_PrefetchThread.join();
+}
+
+void GeomCache::prefetchThreadFunc() {
+	uint32_t generation = m_PrefetchGeneration;
+
+	std::unique_lock<std::mutex> lock(m_PrefetchMutex);
+	for(;;) {
+		m_PrefetchCondition.wait(lock, [&]() {
+			return m_PrefetchStop || generation != m_PrefetchGeneration;
+		});
+		if(m_PrefetchStop) {
+			break;
+		}
+
+		generation = m_PrefetchGeneration;
+		const size_t firstFrame = m_PrefetchFrame;
+		const size_t lastFrame = __min(firstFrame + m_PrefetchRange, getFrameCount());
+		lock.unlock();
+
+		// One frame at a time, so in place decodes on the main thread only ever wait for a single frame
+		// and a seek or close is picked up quickly. Resident frames are skipped by the decompressor.
+		for(size_t iFrame = firstFrame; iFrame < lastFrame; ++iFrame) {
+			if(m_PrefetchStop || generation != m_PrefetchGeneration) {
+				break;
+			}
+			prefetchNow(iFrame, 1);
+		}
+
+		lock.lock();
+	}
 }
 
 // Playback.
@@ -154,6 +322,80 @@ void GeomCache::setCurrentFrameIndex(size_t currentFrameIndex) {
 	m_CurrentTime = getTimeByFrameIndex(currentFrameIndex);
 }
 
+void GeomCache::addConvertTasks(int descIndex, void* dst, size_t componentCount, size_t count) {
+	// Tasks start on kernel batches, so every vertex is converted by the same code path whatever the grain.
+	const size_t grainSize = m_ConvertGrainSize > 0
+		? ceildiv(m_ConvertGrainSize, PackedArrayBatchSize) * PackedArrayBatchSize
+		: count;
+	for(size_t begin = 0; begin < count; begin += grainSize) {
+		ConvertTask task;
+		task.descIndex = descIndex;
+		task.dst = dst;
+		task.componentCount = componentCount;
+		task.begin = begin;
+		task.end = __min(begin + grainSize, count);
+		m_ConvertTasks.push_back(task);
+	}
+}
+
+void GeomCache::runConvertTask(const ConvertTask& task, size_t frameIndex, const GeomCacheData& geomCacheData) const {
+	const size_t count = task.end - task.begin;
+
+	if(task.descIndex < 0) {
+		const auto* src = static_cast<const int32_t*>(geomCacheData.indices) + task.begin;
+		memcpy(static_cast<int32_t*>(task.dst) + task.begin, src, count * sizeof(int32_t));
+		return;
+	}
+
+	void* dst = static_cast<float*>(task.dst) + task.componentCount * task.begin;
+	if(m_Decompressor->decodeAttribute(frameIndex, geomCacheData, task.descIndex, task.begin, count, dst)) {
+		return;
+	}
+
+	const DataFormat format = m_GeomCacheDescs[task.descIndex].format;
+	const void* src = static_cast<const char*>(geomCacheData.vertices[task.descIndex]) + getSizeOfDataFormat(format) * task.begin;
+	switch(task.componentCount) {
+	case 2:		convertDataArrayToFloat2(static_cast<float2*>(dst), src, count, format);	break;
+	case 3:		convertDataArrayToFloat3(static_cast<float3*>(dst), src, count, format);	break;
+	case 4:		convertDataArrayToFloat4(static_cast<float4*>(dst), src, count, format);	break;
+	default:	assert(false && "Output attributes have 2 to 4 components");				break;
+	}
+}
+
+// Face normals and tangents over triangle ranges, then the vertices over vertex ranges.
+// The points, the uv0 and the normals when they aren't reconstructed are already in the output.
+void GeomCache::reconstructTangentSpace(OutputGeomCache& outputGeomCache, bool isNormalsReconstructed, bool isTangentsReconstructed) {
+	const size_t triangleCount = m_VertexTriangles.getTriangleCount();
+	const float3* points = outputGeomCache.points.data();
+	const float2* uvs = outputGeomCache.uv0.data();
+
+	if(isNormalsReconstructed) {
+		m_FaceNormals.resize(triangleCount);
+	}
+	if(isTangentsReconstructed) {
+		m_FaceTangents.resize(triangleCount);
+		m_FaceBitangents.resize(triangleCount);
+	}
+	forEachRange(triangleCount, m_ConvertGrainSize, [&](size_t begin, size_t end) {
+		if(isNormalsReconstructed) {
+			computeFaceNormals(m_VertexTriangles, points, begin, end - begin, m_FaceNormals.data());
+		}
+		if(isTangentsReconstructed) {
+			computeFaceTangents(m_VertexTriangles, points, uvs, begin, end - begin, m_FaceTangents.data(), m_FaceBitangents.data());
+		}
+	});
+
+	forEachRange(m_VertexTriangles.getVertexCount(), m_ConvertGrainSize, [&](size_t begin, size_t end) {
+		if(isNormalsReconstructed) {
+			computeVertexNormals(m_VertexTriangles, m_FaceNormals.data(), begin, end - begin, outputGeomCache.normals.data());
+		}
+		if(isTangentsReconstructed) {
+			computeVertexTangents(m_VertexTriangles, points, outputGeomCache.normals.data(), m_FaceTangents.data(), m_FaceBitangents.data()
+				, begin, end - begin, outputGeomCache.tangents.data());
+		}
+	});
+}
+
 // + function to get geometry data to render.
 bool GeomCache::assignCurrentDataToMesh(OutputGeomCache& outputGecomCache) {
 	if(! good()) {
@@ -166,91 +408,111 @@ bool GeomCache::assignCurrentDataToMesh(OutputGeomCache& outputGecomCache) {
 	if(frameIndex == ~0u) {
 		return false;
 	}
-	prefetch(frameIndex, 1);
 
-	if(! m_Decompressor->getData(m_CurrentTime, geomCacheData)) {
-		return false;
+	// Keep the playhead window resident, the frame read below must not be evicted while it's converted.
+	const size_t lookAheadRange = getLookAheadRange(frameIndex);
+	m_Decompressor->setPinnedRange(frameIndex, lookAheadRange);
+
+	if(m_PrefetchThread.joinable()) {
+		requestPrefetch(frameIndex, lookAheadRange);
+	}
+
+	float frameTime = 0.0f;
+	if(! m_Decompressor->getData(frameIndex, frameTime, geomCacheData)) {
+		// Not decoded yet (first frame, seek or the worker is behind), decode it in place.
+		prefetchNow(frameIndex, 1);
+		if(! m_Decompressor->getData(frameIndex, frameTime, geomCacheData)) {
+			return false;
+		}
 	}
     if (geomCacheData.meshCount == 0 || geomCacheData.submeshCount == 0) {
         return false;
     }
 
+	// The frame is owned by the decompressor.
 	if(geomCacheData.vertices == nullptr) {
-		freeGeomCacheData(geomCacheData, geomCacheData.vertexCount);
 		return false;
 	}
 
     outputGecomCache.meshes.assign(geomCacheData.meshes, geomCacheData.meshes + geomCacheData.meshCount);
     outputGecomCache.submeshes.assign(geomCacheData.submeshes, geomCacheData.submeshes + geomCacheData.submeshCount);
 
+	// Size the outputs, then fill them with tasks over index and vertex ranges.
+	m_ConvertTasks.clear();
+
 	// indices
-	{
-		outputGecomCache.indices.resize(geomCacheData.indexCount);
-		const auto* p = static_cast<const int32_t*>(geomCacheData.indices);
-		if(p) {
-			memcpy(outputGecomCache.indices.data(), p, outputGecomCache.indices.size() * sizeof(outputGecomCache.indices[0]));
-		}
+	outputGecomCache.indices.resize(geomCacheData.indexCount);
+	if(geomCacheData.indices) {
+		addConvertTasks(-1, outputGecomCache.indices.data(), 1, geomCacheData.indexCount);
 	}
 
+	// Vertex attributes, packed ones are dequantised by the decompressor straight into the output arrays.
+
 	// points
 //	printf("m_DescIndex_points=%d, geomCacheData.vertexCount=%zd\n", m_DescIndex_points, geomCacheData.vertexCount);
 	if(m_DescIndex_points >= 0) {
 		outputGecomCache.points.resize(geomCacheData.vertexCount);
-		const auto* p = geomCacheData.vertices[m_DescIndex_points];
-		convertDataArrayToFloat3(
-			  outputGecomCache.points.data()
-			, p
-			, outputGecomCache.points.size()
-			, m_GeomCacheDescs[m_DescIndex_points].format
-		);
+		addConvertTasks(m_DescIndex_points, outputGecomCache.points.data(), 3, geomCacheData.vertexCount);
 	}
 
 	// normals
 	if(m_DescIndex_normals >= 0) {
 		outputGecomCache.normals.resize(geomCacheData.vertexCount);
-		const auto* p = geomCacheData.vertices[m_DescIndex_normals];
-		convertDataArrayToFloat3(
-			  outputGecomCache.normals.data()
-			, p
-			, outputGecomCache.normals.size()
-			, m_GeomCacheDescs[m_DescIndex_normals].format
-		);
+		addConvertTasks(m_DescIndex_normals, outputGecomCache.normals.data(), 3, geomCacheData.vertexCount);
 	}
 
 	// tangents
 	if(m_DescIndex_tangents >= 0) {
 		outputGecomCache.tangents.resize(geomCacheData.vertexCount);
-		const auto* p = geomCacheData.vertices[m_DescIndex_tangents];
-		convertDataArrayToFloat4(
-			  outputGecomCache.tangents.data()
-			, p
-			, outputGecomCache.tangents.size()
-			, m_GeomCacheDescs[m_DescIndex_tangents].format
-		);
+		addConvertTasks(m_DescIndex_tangents, outputGecomCache.tangents.data(), 4, geomCacheData.vertexCount);
 	}
 
 	// uv0
 	if(m_DescIndex_uv0 >= 0) {
 		outputGecomCache.uv0.resize(geomCacheData.vertexCount);
-		const auto* p = geomCacheData.vertices[m_DescIndex_uv0];
-		convertDataArrayToFloat2(
-			  outputGecomCache.uv0.data()
-			, p
-			, outputGecomCache.uv0.size()
-			, m_GeomCacheDescs[m_DescIndex_uv0].format
-		);
+		addConvertTasks(m_DescIndex_uv0, outputGecomCache.uv0.data(), 2, geomCacheData.vertexCount);
 	}
 
 	// colors
 	if(m_DescIndex_colors >= 0) {
 		outputGecomCache.colors.resize(geomCacheData.vertexCount);
-		const auto* p = geomCacheData.vertices[m_DescIndex_colors];
-		convertDataArrayToFloat4(
-			  outputGecomCache.colors.data()
-			, p
-			, outputGecomCache.colors.size()
-			, m_GeomCacheDescs[m_DescIndex_colors].format
-		);
+		addConvertTasks(m_DescIndex_colors, outputGecomCache.colors.data(), 4, geomCacheData.vertexCount);
+	}
+
+	if(m_ConvertGrainSize == 0 || geomCacheData.vertexCount < m_ConvertGrainSize) {
+		for(const ConvertTask& task : m_ConvertTasks) {
+			runConvertTask(task, frameIndex, geomCacheData);
+		}
+	}
+	else {
+		parallel_for(0, static_cast<int>(m_ConvertTasks.size()), 1, [&](int iTask) {
+			runConvertTask(m_ConvertTasks[iTask], frameIndex, geomCacheData);
+		});
+	}
+
+	// Normals and tangents left out of the file, from the converted points and uv0.
+	const bool isNormalsReconstructed = m_DescIndex_normals < 0 && m_ReconstructNormals && m_DescIndex_points >= 0;
+	const bool isTangentsReconstructed = m_DescIndex_tangents < 0 && m_ReconstructTangents && m_DescIndex_points >= 0
+		&& m_DescIndex_uv0 >= 0 && (m_DescIndex_normals >= 0 || isNormalsReconstructed);
+	if(isNormalsReconstructed || isTangentsReconstructed) {
+		if(m_VertexTriangles.update(geomCacheData)) {
+			if(isNormalsReconstructed) {
+				outputGecomCache.normals.resize(geomCacheData.vertexCount);
+			}
+			if(isTangentsReconstructed) {
+				outputGecomCache.tangents.resize(geomCacheData.vertexCount);
+			}
+			reconstructTangentSpace(outputGecomCache, isNormalsReconstructed, isTangentsReconstructed);
+		}
+		else {
+			// Points, lines or quads only.
+			if(isNormalsReconstructed) {
+				outputGecomCache.normals.clear();
+			}
+			if(isTangentsReconstructed) {
+				outputGecomCache.tangents.clear();
+			}
+		}
 	}
 
 //	freeGeomCacheData(geomCacheData, m_AttributeCount);
@@ -2,12 +2,20 @@
 
 #include "Plugin/OutputGeomCache.h"
 #include "Plugin/GeomCacheData.h"
+#include "Plugin/VertexNormals.h"
 #include "Plugin/Compression/IDecompressor.h"
 #include "Plugin/Compression/NulLDecompressor.h"
 #include "Plugin/Stream/FileStream.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace nvc {
 
+// Vertices per conversion task in GeomCache::assignCurrentDataToMesh().
+static constexpr size_t DefaultConvertGrainSize = 64 * 1024;
+
 class GeomCache final
 {
 
@@ -29,6 +37,38 @@ public:
 	//              |-------------------|  <= skip
 	void prefetch(size_t currentTime, size_t range);
 
+	// Asynchronous prefetch.
+	// When enabled, a worker thread decodes frames ahead of the playhead and
+	// assignCurrentDataToMesh() only decodes in place when the current frame isn't ready yet (first frame, seek).
+	// The look-ahead covers whichever is larger of frames and seconds past the current frame.
+	void setAsyncPrefetch(bool enable);
+	bool isAsyncPrefetch() const { return m_AsyncPrefetch; }
+
+	// Decoded frame cache budget in bytes (0: unbounded), see IDecompressor::setCacheBudget().
+	void setCacheBudget(size_t bytes);
+	size_t getCacheBudget() const { return m_CacheBudget; }
+	size_t getCacheSize() const { return m_Decompressor->getCacheSize(); }
+
+	void setPrefetchLookAhead(size_t frames, float seconds);
+	size_t getPrefetchLookAheadFrames() const { return m_LookAheadFrames; }
+	float getPrefetchLookAheadSeconds() const { return m_LookAheadSeconds; }
+
+	// assignCurrentDataToMesh() splits the index copy and the attribute conversions in tasks of this many
+	// vertices (indices for the copy) and runs them on the Concurrency.h workers.
+	// Frames with fewer vertices are converted serially, 0 always converts serially.
+	void setConvertGrainSize(size_t vertexCount) { m_ConvertGrainSize = vertexCount; }
+	size_t getConvertGrainSize() const { return m_ConvertGrainSize; }
+
+	// Normals missing from the file are reconstructed from the points and triangles of each frame, and tangents
+	// missing from it from the normals and uv0 too (see VertexNormals.h), in tasks of the convert grain size.
+	// Off by default, players opt in per asset for files exported without them: on one core a 300x300 grid takes
+	// about 3 ms/frame with the normals reconstructed and 35 ms/frame with the tangents too, against 1 ms/frame
+	// with both stored (see TestNormalReconstruction.cpp).
+	void setReconstructNormals(bool enable) { m_ReconstructNormals = enable; }
+	bool isReconstructNormals() const { return m_ReconstructNormals; }
+	void setReconstructTangents(bool enable) { m_ReconstructTangents = enable; }
+	bool isReconstructTangents() const { return m_ReconstructTangents; }
+
 	// Playback.
 	void setCurrentFrame(float currentTime);
 	void setCurrentFrameIndex(size_t currentFrameIndex);
@@ -67,6 +107,28 @@ public:
 	GeomCache& operator=(GeomCache&&) = delete;
 
 protected:
+	// Output array of an attribute (nullptr for the indices) and the range of it converted by a task.
+	struct ConvertTask
+	{
+		int descIndex;
+		void* dst;
+		size_t componentCount;
+		size_t begin;
+		size_t end;
+	};
+
+	void addConvertTasks(int descIndex, void* dst, size_t componentCount, size_t count);
+	void runConvertTask(const ConvertTask& task, size_t frameIndex, const GeomCacheData& geomCacheData) const;
+	void reconstructTangentSpace(OutputGeomCache& outputGeomCache, bool isNormalsReconstructed, bool isTangentsReconstructed);
+
+	void prefetchNow(size_t frameIndex, size_t range);
+	void requestPrefetch(size_t frameIndex, size_t range);
+	size_t getLookAheadRange(size_t frameIndex) const;
+
+	void startPrefetchThread();
+	void stopPrefetchThread();
+	void prefetchThreadFunc();
+
 	std::unique_ptr<IDecompressor> m_Decompressor {};
 //	std::unique_ptr<NullDecompressor> m_Decompressor {};
 	std::unique_ptr<FileStream> m_InputFileStream {};
@@ -83,6 +145,33 @@ protected:
 
 	float m_CurrentTime = 0.0f;
 	size_t m_CurrentFrame = 0;
+
+	size_t m_CacheBudget = DefaultFrameCacheBudget;
+	size_t m_ConvertGrainSize = DefaultConvertGrainSize;
+	std::vector<ConvertTask> m_ConvertTasks;
+
+	bool m_ReconstructNormals = false;
+	bool m_ReconstructTangents = false;
+	VertexTriangles m_VertexTriangles;
+	std::vector<float3> m_FaceNormals;
+	std::vector<float3> m_FaceTangents;
+	std::vector<float3> m_FaceBitangents;
+
+	bool m_AsyncPrefetch = true;
+	size_t m_LookAheadFrames = 10;
+	float m_LookAheadSeconds = 0.0f;
+
+	// IDecompressor::prefetch() isn't reentrant, both the worker and in place decodes go through this.
+	std::mutex m_DecodeMutex;
+
+	// Pending request, guarded by m_PrefetchMutex. Bumping the generation makes the worker drop its current range.
+	std::thread m_PrefetchThread;
+	std::mutex m_PrefetchMutex;
+	std::condition_variable m_PrefetchCondition;
+	size_t m_PrefetchFrame = 0;
+	size_t m_PrefetchRange = 0;
+	std::atomic<uint32_t> m_PrefetchGeneration {0};
+	std::atomic<bool> m_PrefetchStop {false};
 };
 
 } // namespace nvc
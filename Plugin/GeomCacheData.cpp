@@ -15,10 +15,13 @@ void freeGeomCacheData(GeomCacheData& cacheData, size_t attributeCount)
 	void *data = const_cast<void*>(cacheData.indices);
 	free(data);
 
-	for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+	if (cacheData.vertices != nullptr)
 	{
-		void *vertexData = const_cast<void*>(cacheData.vertices[iAttribute]);
-		free(vertexData);
+		for (size_t iAttribute = 0; iAttribute < attributeCount; ++iAttribute)
+		{
+			void *vertexData = const_cast<void*>(cacheData.vertices[iAttribute]);
+			free(vertexData);
+		}
 	}
 
 	delete[] cacheData.vertices;
@@ -56,6 +59,35 @@ size_t getSizeOfDataFormat(DataFormat dataFormat)
 	}
 }
 
+size_t getSizeOfDataFormatComponent(DataFormat dataFormat)
+{
+	switch (dataFormat)
+	{
+	default:
+	case DataFormat::Unknown:	return 0;
+	case DataFormat::Int:
+	case DataFormat::Int2:
+	case DataFormat::Int3:
+	case DataFormat::Int4:		return sizeof(int32_t);
+	case DataFormat::Float:
+	case DataFormat::Float2:
+	case DataFormat::Float3:
+	case DataFormat::Float4:	return sizeof(float);
+	case DataFormat::Half:
+	case DataFormat::Half2:
+	case DataFormat::Half3:
+	case DataFormat::Half4:		return sizeof(half);
+	case DataFormat::SNorm16:
+	case DataFormat::SNorm16x2:
+	case DataFormat::SNorm16x3:
+	case DataFormat::SNorm16x4:	return sizeof(snorm16);
+	case DataFormat::UNorm16:
+	case DataFormat::UNorm16x2:
+	case DataFormat::UNorm16x3:
+	case DataFormat::UNorm16x4:	return sizeof(unorm16);
+	}
+}
+
 size_t getAttributeCount(const GeomCacheDesc* desc)
 {
 	size_t count = 0;
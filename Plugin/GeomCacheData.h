@@ -43,6 +43,8 @@ enum class CompressionType : uint32_t
 {
     Null,
     Quantize,
+    Temporal,
+    Pca,
 };
 
 enum class Topology : uint32_t
@@ -91,6 +93,7 @@ struct GeomCacheData
 void freeGeomCacheData(GeomCacheData& cacheData, size_t attributeCount);
 
 size_t getSizeOfDataFormat(DataFormat dataFormat);
+size_t getSizeOfDataFormatComponent(DataFormat dataFormat);
 size_t getAttributeCount(const GeomCacheDesc* desc);
 
 int getAttributeIndex(const GeomCacheDesc *desc, const char *semantic);
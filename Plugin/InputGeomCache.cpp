@@ -5,9 +5,85 @@
 #include "InputGeomCache.h"
 #include "Stream/Stream.h"
 #include "Stream/MemoryStream.h"
+#include "Compression/FrameTopology.h"
 
 namespace nvc {
 
+namespace
+{
+	bool isMeshValid(const GeomCacheData& data, const GeomMesh& mesh)
+	{
+		if (static_cast<size_t>(mesh.vertexOffset) + mesh.vertexCount > data.vertexCount
+			|| static_cast<size_t>(mesh.submeshOffset) + mesh.submeshCount > data.submeshCount)
+		{
+			return false;
+		}
+
+		const int32_t* indices = static_cast<const int32_t*>(data.indices);
+		for (uint32_t iSubmesh = mesh.submeshOffset; iSubmesh < mesh.submeshOffset + mesh.submeshCount; ++iSubmesh)
+		{
+			const GeomSubmesh& submesh = data.submeshes[iSubmesh];
+			if (static_cast<size_t>(submesh.indexOffset) + submesh.indexCount > data.indexCount
+				|| !std::all_of(indices + submesh.indexOffset, indices + submesh.indexOffset + submesh.indexCount
+					, [&mesh](int32_t index) { return index >= 0 && static_cast<uint32_t>(index) < mesh.vertexCount; }))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The reordered indices of a frame, and remap[vertex] the new position of each vertex.
+	void buildVertexOrder(const GeomCacheData& data, size_t cacheSize, std::vector<int32_t>& indices, std::vector<uint32_t>& remap)
+	{
+		const int32_t* srcIndices = static_cast<const int32_t*>(data.indices);
+		indices.assign(srcIndices, srcIndices + data.indexCount);
+		remap.resize(data.vertexCount);
+		for (size_t v = 0; v < data.vertexCount; ++v)
+		{
+			remap[v] = static_cast<uint32_t>(v);
+		}
+
+		std::vector<int32_t> meshIndices;
+		std::vector<uint32_t> meshRemap;
+		for (size_t iMesh = 0; iMesh < data.meshCount; ++iMesh)
+		{
+			const GeomMesh& mesh = data.meshes[iMesh];
+			if (!isMeshValid(data, mesh))
+			{
+				continue;
+			}
+
+			// Submeshes keep their index ranges, only their triangles move.
+			meshIndices.clear();
+			for (uint32_t iSubmesh = mesh.submeshOffset; iSubmesh < mesh.submeshOffset + mesh.submeshCount; ++iSubmesh)
+			{
+				const GeomSubmesh& submesh = data.submeshes[iSubmesh];
+				if (submesh.topology == Topology::Triangles)
+				{
+					optimizeTriangleOrder(srcIndices + submesh.indexOffset, submesh.indexCount, mesh.vertexCount, cacheSize, &indices[submesh.indexOffset]);
+				}
+				meshIndices.insert(meshIndices.end(), indices.begin() + submesh.indexOffset, indices.begin() + submesh.indexOffset + submesh.indexCount);
+			}
+
+			meshRemap.resize(mesh.vertexCount);
+			buildVertexFetchRemap(meshIndices.data(), meshIndices.size(), mesh.vertexCount, meshRemap.data());
+			for (uint32_t iSubmesh = mesh.submeshOffset; iSubmesh < mesh.submeshOffset + mesh.submeshCount; ++iSubmesh)
+			{
+				const GeomSubmesh& submesh = data.submeshes[iSubmesh];
+				for (uint32_t i = submesh.indexOffset; i < submesh.indexOffset + submesh.indexCount; ++i)
+				{
+					indices[i] = static_cast<int32_t>(meshRemap[indices[i]]);
+				}
+			}
+			for (uint32_t v = 0; v < mesh.vertexCount; ++v)
+			{
+				remap[mesh.vertexOffset + v] = mesh.vertexOffset + meshRemap[v];
+			}
+		}
+	}
+}
+
 InputGeomCache::InputGeomCache(const GeomCacheDesc *desc, const InputGeomCacheConstantData *constantData)
 {
 	memcpy(m_Descriptor, desc, sizeof(GeomCacheDesc) * getAttributeCount(desc));
@@ -105,6 +181,75 @@ void InputGeomCache::clearData()
     m_Data.clear();
 }
 
+void InputGeomCache::optimizeVertexOrder(size_t cacheSize)
+{
+	// Which frames repeat the previous topology, before any of them changes.
+	std::vector<uint8_t> isTopologyRepeated(m_Data.size(), 0);
+	for (size_t iFrame = 1; iFrame < m_Data.size(); ++iFrame)
+	{
+		isTopologyRepeated[iFrame] = hasSameTopology(m_Data[iFrame - 1].second, m_Data[iFrame].second);
+	}
+
+	const size_t attributeCount = getAttributeCount(m_Descriptor);
+	std::vector<int32_t> indices;
+	std::vector<uint32_t> remap;
+	std::vector<uint8_t> attribute;
+	for (size_t iFrame = 0; iFrame < m_Data.size(); ++iFrame)
+	{
+		GeomCacheData& data = m_Data[iFrame].second;
+		if (data.indices == nullptr || data.meshes == nullptr || data.submeshes == nullptr)
+		{
+			continue;
+		}
+		if (!isTopologyRepeated[iFrame] || remap.size() != data.vertexCount)
+		{
+			buildVertexOrder(data, cacheSize, indices, remap);
+		}
+
+		memcpy(data.indices, indices.data(), sizeof(int32_t) * indices.size());
+		for (size_t iAttribute = 0; data.vertices != nullptr && iAttribute < attributeCount; ++iAttribute)
+		{
+			const size_t vertexSize = getSizeOfDataFormat(m_Descriptor[iAttribute].format);
+			uint8_t* vertices = static_cast<uint8_t*>(data.vertices[iAttribute]);
+			if (vertices == nullptr || vertexSize == 0)
+			{
+				continue;
+			}
+
+			attribute.assign(vertices, vertices + vertexSize * data.vertexCount);
+			for (size_t v = 0; v < data.vertexCount; ++v)
+			{
+				memcpy(vertices + vertexSize * remap[v], &attribute[vertexSize * v], vertexSize);
+			}
+		}
+	}
+}
+
+bool InputGeomCache::removeAttribute(const char* semantic)
+{
+	const int removedIndex = getAttributeIndex(m_Descriptor, semantic);
+	if (removedIndex < 0)
+	{
+		return false;
+	}
+
+	// The following attributes move down one slot, the last one is left as the terminator.
+	const size_t attributeCount = getAttributeCount(m_Descriptor);
+	for (auto& frame : m_Data)
+	{
+		void** vertices = frame.second.vertices;
+		if (vertices != nullptr)
+		{
+			free(vertices[removedIndex]);
+			std::copy(vertices + removedIndex + 1, vertices + attributeCount, vertices + removedIndex);
+			vertices[attributeCount - 1] = nullptr;
+		}
+	}
+	std::copy(m_Descriptor + removedIndex + 1, m_Descriptor + attributeCount, m_Descriptor + removedIndex);
+	m_Descriptor[attributeCount - 1] = GEOM_CACHE_DESCRIPTOR_END;
+	return true;
+}
+
 void InputGeomCache::getDesc(GeomCacheDesc* desc) const
 {
 	memcpy(desc, m_Descriptor, sizeof(GeomCacheDesc) * getAttributeCount(m_Descriptor));
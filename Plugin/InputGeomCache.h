@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GeomCacheData.h"
+#include "VertexOrder.h"
 
 class Stream;
 
@@ -49,6 +50,15 @@ public:
 	void addData(float time, const GeomCacheData *data);
     void clearData();
 
+	// Reorders the triangles of every frame for the post-transform vertex cache, then the vertices of each mesh
+	// in order of first use (see VertexOrder.h). Frames with the same topology are reordered the same way.
+	// Meshes with indices outside of their vertices are left as they are.
+	void optimizeVertexOrder(size_t cacheSize = DefaultVertexCacheSize);
+
+	// Drops an attribute from the descriptor and every frame, e.g. normals the decoder reconstructs.
+	// Returns false if there's no attribute with this semantic.
+	bool removeAttribute(const char* semantic);
+
 	void getDesc(GeomCacheDesc *desc) const;
 	void getConstantData(InputGeomCacheConstantData& constantData) const;
 	// GeomCacheData::data can be nullptr. in that case, only count will be filled.
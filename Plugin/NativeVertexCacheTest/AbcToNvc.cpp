@@ -5,6 +5,8 @@
 #include "Plugin/Stream/FileStream.h"
 #include "Plugin/Compression/NullCompressor.h"
 #include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/TemporalCompressor.h"
+#include "Plugin/Compression/PcaCompressor.h"
 #include "Plugin/InputGeomCache.h"
 #include "Plugin/GeomCache.h"
 #include "Plugin/GeomCacheData.h"
@@ -33,6 +35,7 @@ int AbcToNvc(const char* srcAbcFilename, const char* outNvcFilename, nvc::AbcToN
     RemoveFile(outNvcFilename);
 	FileStream fs { outNvcFilename, FileStream::OpenModes::Random_ReadWrite };
 
+	const auto startTime = GetHighResolutionClock();
 	switch(compressionMethod) {
 	default:
 	case AbcToNvcCompressionMethod::Null:
@@ -47,7 +50,22 @@ int AbcToNvc(const char* srcAbcFilename, const char* outNvcFilename, nvc::AbcToN
 			qc.compress(*abcIgc, &fs);
 		}
 		break;
+	case AbcToNvcCompressionMethod::Temporal:
+		{
+			TemporalCompressor tc {};
+			tc.compress(*abcIgc, &fs);
+		}
+		break;
+	case AbcToNvcCompressionMethod::Pca:
+		{
+			PcaCompressor pc {};
+			pc.compress(*abcIgc, &fs);
+		}
+		break;
 	}
+	const double seconds = GetSeconds(startTime, GetHighResolutionClock());
+	printf("compressed %zd frames in %.3f seconds (%.1f frames/s)\n", abcIgc->getDataCount(), seconds, abcIgc->getDataCount() / seconds);
+
     nvcIGCRelease(abcIgc);
     return 0;
 }
@@ -4,6 +4,8 @@ namespace nvc {
 		Unknown,
 		Null,
 		Quantisation,
+		Temporal,
+		Pca,
 	};
 
 	int AbcToNvc(const char* srcAbcFilename, const char* outNvcFilename, nvc::AbcToNvcCompressionMethod compressionMethod);
@@ -1,14 +1,17 @@
 #include "Plugin/PrecompiledHeader.h"
 #include "Plugin/Foundation/Types.h"
 #include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Foundation/Concurrency.h"
 #include "Plugin/AlembicToGeomCache/AlembicToGeomCache.h"
 #include "Plugin/Stream/FileStream.h"
+#include "Plugin/Stream/MemoryStream.h"
 #include "Plugin/Compression/NullCompressor.h"
 #include "Plugin/Compression/QuantisationCompressor.h"
 #include "Plugin/InputGeomCache.h"
 #include "Plugin/GeomCache.h"
 #include "Plugin/GeomCacheData.h"
 #include "Plugin/NativeVertexCacheTest/TestUtil.h"
+#include <thread>
 
 namespace {
 using namespace nvc;
@@ -39,6 +42,19 @@ void convertDataArrayToFloat4(float4* dst, const T* src, size_t numberOfElements
 	}
 }
 
+// half vectors are tightly packed, convert them as one array of halves.
+void convertDataArrayToFloat2(float2* dst, const half2* src, size_t numberOfElements) {
+	half_to_float_array(reinterpret_cast<float*>(dst), reinterpret_cast<const half*>(src), numberOfElements * 2);
+}
+
+void convertDataArrayToFloat3(float3* dst, const half3* src, size_t numberOfElements) {
+	half_to_float_array(reinterpret_cast<float*>(dst), reinterpret_cast<const half*>(src), numberOfElements * 3);
+}
+
+void convertDataArrayToFloat4(float4* dst, const half4* src, size_t numberOfElements) {
+	half_to_float_array(reinterpret_cast<float*>(dst), reinterpret_cast<const half*>(src), numberOfElements * 4);
+}
+
 void convertDataArrayToFloat2(float2* dst, const void* src, size_t numberOfElements, DataFormat dataFormat) {
 	switch(dataFormat) {
 	default:		assert(false && "DataFormat must have 2 components");		break;
@@ -406,10 +422,314 @@ static void test3() {
 	}
 }
 
+// Asynchronous prefetch: playback must match the synchronous path frame by frame.
+static void test4() {
+    using namespace nvc;
+    using namespace nvcabc;
+
+    const char* abcFilename = "../../../Data/Cloth-300frames.abc";
+#if USE_QUANTISATION_COMPRESSOR
+	const char* nvcFilename = "../../../Data/TestOutput/Cloth-300frames.quantisation.nvc";
+#else
+	const char* nvcFilename = "../../../Data/TestOutput/Cloth-300frames.nvc";
+#endif
+    assert(IsFileExist(abcFilename));
+    RemoveFile(nvcFilename);
+
+	// Import -> output .nvc
+	{
+	    ImportOptions opt;
+
+	    const auto abcIgc = nvcabcAlembicToInputGeomCache(abcFilename, opt);
+	    assert(abcIgc);
+
+	    FileStream fs { nvcFilename, FileStream::OpenModes::Random_ReadWrite };
+	    Compressor nc {};
+	    nc.compress(*abcIgc, &fs);
+
+        nvcIGCRelease(abcIgc);
+    }
+
+	// read .nvc
+	{
+		GeomCache syncCache;
+		syncCache.setAsyncPrefetch(false);
+		const auto r0 = syncCache.open(nvcFilename);
+		assert(r0);
+
+		GeomCache asyncCache;
+		asyncCache.setPrefetchLookAhead(15, 0.5f);	// crosses seek windows
+		const auto r1 = asyncCache.open(nvcFilename);
+		assert(r1);
+		assert(asyncCache.isAsyncPrefetch());
+
+		const auto nFrame = syncCache.getFrameCount();
+		assert(nFrame == asyncCache.getFrameCount());
+
+		// Forward playback, then a jump back to the middle.
+		std::vector<size_t> frames;
+		for(size_t iFrame = 0; iFrame < nFrame; ++iFrame) {
+			frames.push_back(iFrame);
+		}
+		for(size_t iFrame = nFrame / 2; iFrame < nFrame; iFrame += 3) {
+			frames.push_back(iFrame);
+		}
+
+		double maxMs = 0.0;
+		double totalMs = 0.0;
+		for(const size_t iFrame : frames) {
+			syncCache.setCurrentFrameIndex(iFrame);
+			asyncCache.setCurrentFrameIndex(iFrame);
+
+			OutputGeomCache expected;
+			const auto r2 = syncCache.assignCurrentDataToMesh(expected);
+			assert(r2);
+
+			OutputGeomCache actual;
+			const auto t0 = std::chrono::high_resolution_clock::now();
+			const auto r3 = asyncCache.assignCurrentDataToMesh(actual);
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			assert(r3);
+
+			const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+			maxMs = __max(maxMs, ms);
+			totalMs += ms;
+
+			assert(expected.indices.size() == actual.indices.size());
+			assert(expected.points.size() == actual.points.size());
+			assert(memcmp(expected.indices.data(), actual.indices.data(), expected.indices.size() * sizeof(expected.indices[0])) == 0);
+			assert(memcmp(expected.points.data(), actual.points.data(), expected.points.size() * sizeof(expected.points[0])) == 0);
+			assert(memcmp(expected.normals.data(), actual.normals.data(), expected.normals.size() * sizeof(expected.normals[0])) == 0);
+		}
+
+		printf("async prefetch: %zd frames, assign avg %.3fms, max %.3fms\n", frames.size(), totalMs / frames.size(), maxMs);
+	}
+}
+
+// Bounded frame cache: scrubbing with a tiny budget keeps only the playhead window resident.
+static void test5() {
+    using namespace nvc;
+    using namespace nvcabc;
+
+    const char* abcFilename = "../../../Data/Cloth-300frames.abc";
+#if USE_QUANTISATION_COMPRESSOR
+	const char* nvcFilename = "../../../Data/TestOutput/Cloth-300frames.quantisation.nvc";
+#else
+	const char* nvcFilename = "../../../Data/TestOutput/Cloth-300frames.nvc";
+#endif
+    assert(IsFileExist(abcFilename));
+    RemoveFile(nvcFilename);
+
+	// Import -> output .nvc
+	{
+	    ImportOptions opt;
+
+	    const auto abcIgc = nvcabcAlembicToInputGeomCache(abcFilename, opt);
+	    assert(abcIgc);
+
+	    FileStream fs { nvcFilename, FileStream::OpenModes::Random_ReadWrite };
+	    Compressor nc {};
+	    nc.compress(*abcIgc, &fs);
+
+        nvcIGCRelease(abcIgc);
+    }
+
+	// read .nvc
+	{
+		GeomCache unboundedCache;
+		unboundedCache.setAsyncPrefetch(false);
+		unboundedCache.setCacheBudget(0);
+		const auto r0 = unboundedCache.open(nvcFilename);
+		assert(r0);
+
+		const size_t lookAheadFrames = 4;
+		GeomCache boundedCache;
+		boundedCache.setCacheBudget(1);
+		boundedCache.setPrefetchLookAhead(lookAheadFrames, 0.0f);
+		const auto r1 = boundedCache.open(nvcFilename);
+		assert(r1);
+
+		const auto nFrame = unboundedCache.getFrameCount();
+		Pcg pcg(123, 456);
+		size_t maxCacheSize = 0;
+		for(size_t iTest = 0, nTest = 512; iTest < nTest; ++iTest) {
+			const size_t iFrame = pcg.getUint32() % nFrame;
+			unboundedCache.setCurrentFrameIndex(iFrame);
+			boundedCache.setCurrentFrameIndex(iFrame);
+
+			OutputGeomCache expected;
+			const auto r2 = unboundedCache.assignCurrentDataToMesh(expected);
+			assert(r2);
+
+			OutputGeomCache actual;
+			const auto r3 = boundedCache.assignCurrentDataToMesh(actual);
+			assert(r3);
+
+			assert(expected.points.size() == actual.points.size());
+			assert(memcmp(expected.points.data(), actual.points.data(), expected.points.size() * sizeof(expected.points[0])) == 0);
+
+			maxCacheSize = __max(maxCacheSize, boundedCache.getCacheSize());
+		}
+
+		printf("frame cache: unbounded %zd bytes, bounded max %zd bytes\n", unboundedCache.getCacheSize(), maxCacheSize);
+		assert(maxCacheSize <= unboundedCache.getCacheSize());
+	}
+}
+
+// Decode-on-assign: quantised frames stay packed in the cache and are dequantised straight into the output.
+static void test6() {
+    using namespace nvc;
+    using namespace nvcabc;
+
+    const char* abcFilename = "../../../Data/Cloth-300frames.abc";
+	const char* nullFilename = "../../../Data/TestOutput/Cloth-300frames.nvc";
+	const char* quantisationFilename = "../../../Data/TestOutput/Cloth-300frames.quantisation.nvc";
+    assert(IsFileExist(abcFilename));
+    RemoveFile(nullFilename);
+    RemoveFile(quantisationFilename);
+
+	// Import -> output .nvc
+	{
+	    ImportOptions opt;
+
+	    const auto abcIgc = nvcabcAlembicToInputGeomCache(abcFilename, opt);
+	    assert(abcIgc);
+
+		{
+		    FileStream fs { nullFilename, FileStream::OpenModes::Random_ReadWrite };
+		    NullCompressor nc {};
+		    nc.compress(*abcIgc, &fs);
+		}
+		{
+		    FileStream fs { quantisationFilename, FileStream::OpenModes::Random_ReadWrite };
+		    QuantisationCompressor qc {};
+		    qc.compress(*abcIgc, &fs);
+		}
+
+        nvcIGCRelease(abcIgc);
+    }
+
+	// read .nvc
+	{
+		GeomCache nullCache;
+		nullCache.setAsyncPrefetch(false);
+		nullCache.setCacheBudget(0);
+		const auto r0 = nullCache.open(nullFilename);
+		assert(r0);
+
+		GeomCache quantisationCache;
+		quantisationCache.setAsyncPrefetch(false);
+		quantisationCache.setCacheBudget(0);
+		const auto r1 = quantisationCache.open(quantisationFilename);
+		assert(r1);
+
+		const auto nFrame = nullCache.getFrameCount();
+		assert(nFrame == quantisationCache.getFrameCount());
+
+		double assignMs = 0.0;
+		size_t decodedSize = 0;
+		for(size_t iFrame = 0; iFrame < nFrame; ++iFrame) {
+			nullCache.setCurrentFrameIndex(iFrame);
+			quantisationCache.setCurrentFrameIndex(iFrame);
+
+			OutputGeomCache expected;
+			const auto r2 = nullCache.assignCurrentDataToMesh(expected);
+			assert(r2);
+
+			OutputGeomCache actual;
+			const auto t0 = std::chrono::high_resolution_clock::now();
+			const auto r3 = quantisationCache.assignCurrentDataToMesh(actual);
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			assert(r3);
+			assignMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+			decodedSize += actual.points.size() * sizeof(actual.points[0])
+				+ actual.normals.size() * sizeof(actual.normals[0])
+				+ actual.tangents.size() * sizeof(actual.tangents[0])
+				+ actual.uv0.size() * sizeof(actual.uv0[0])
+				+ actual.indices.size() * sizeof(actual.indices[0]);
+
+			// Points are quantised to 16 bits over the frame bounds.
+			assert(expected.points.size() == actual.points.size());
+			float3 boundsMin = expected.points[0];
+			float3 boundsMax = expected.points[0];
+			for(const auto& p : expected.points) {
+				for(int i = 0; i < 3; ++i) {
+					boundsMin[i] = __min(boundsMin[i], p[i]);
+					boundsMax[i] = __max(boundsMax[i], p[i]);
+				}
+			}
+			for(size_t iPoint = 0; iPoint < expected.points.size(); ++iPoint) {
+				for(int i = 0; i < 3; ++i) {
+					const float tolerance = (boundsMax[i] - boundsMin[i]) / 65535.0f
+						+ 1e-5f * (fabsf(boundsMin[i]) + fabsf(boundsMax[i]) + 1.0f);
+					assert(fabsf(expected.points[iPoint][i] - actual.points[iPoint][i]) <= tolerance);
+				}
+			}
+		}
+
+		printf("decode-on-assign: %zd frames, resident %zd bytes (decoded %zd bytes), assign avg %.3fms\n"
+			, nFrame, quantisationCache.getCacheSize(), decodedSize, assignMs / nFrame);
+		assert(quantisationCache.getCacheSize() < decodedSize);
+	}
+}
+
+// Compression throughput: frames encoded in parallel must give the bytes of the serial encoding.
+static void test7() {
+    using namespace nvc;
+    using namespace nvcabc;
+
+    const char* abcFilename = "../../../Data/Clothx4-300frames.abc";
+    assert(IsFileExist(abcFilename));
+
+    ImportOptions opt;
+    const auto abcIgc = nvcabcAlembicToInputGeomCache(abcFilename, opt);
+    assert(abcIgc);
+	const size_t nFrame = abcIgc->getDataCount();
+
+	for(int quantise = 0; quantise < 2; ++quantise) {
+		std::vector<uint8_t> bytes[2];
+		double framesPerSecond[2] = {};
+		for(int parallel = 0; parallel < 2; ++parallel) {
+#if defined(NVC_ENABLE_THREAD_POOL)
+			thread_pool::set_worker_count(parallel ? std::max(std::thread::hardware_concurrency(), 1u) - 1 : 0);
+#endif
+			MemoryStream ms;
+			const auto t0 = std::chrono::high_resolution_clock::now();
+			if(quantise) {
+				QuantisationCompressor qc {};
+				qc.compress(*abcIgc, &ms);
+			}
+			else {
+				NullCompressor nc {};
+				nc.compress(*abcIgc, &ms);
+			}
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			framesPerSecond[parallel] = nFrame / std::chrono::duration<double>(t1 - t0).count();
+
+			const uint8_t* begin = static_cast<const uint8_t*>(ms.getBuffer());
+			bytes[parallel].assign(begin, begin + ms.getLength());
+		}
+
+		printf("compress %s: %zd frames, serial %.1f frames/s, parallel %.1f frames/s (%u hardware threads)\n"
+			, quantise ? "quantisation" : "null", nFrame, framesPerSecond[0], framesPerSecond[1], std::thread::hardware_concurrency());
+		assert(bytes[0] == bytes[1]);
+	}
+
+#if defined(NVC_ENABLE_THREAD_POOL)
+	thread_pool::set_worker_count(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+#endif
+    nvcIGCRelease(abcIgc);
+}
+
 void RunTest_AlembicToNvc()
 {
 //	test0();
 	test1();
 //	test2();
 //	test3();
+	test4();
+	test5();
+	test6();
+	test7();
 }
@@ -0,0 +1,108 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Concurrency.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+// Every iteration runs exactly once, whatever the granularity, including nested loops.
+static void test0()
+{
+	const int count = 10000;
+	std::vector<std::atomic<int>> hits(count);
+
+	for(int granularity : { 0, 1, 7, 1000, 20000 }) {
+		for(auto& h : hits) {
+			h = 0;
+		}
+		parallel_for(0, count, granularity, [&](int i) { ++hits[i]; });
+		parallel_for_blocked(0, count, granularity, [&](int begin, int end) {
+			for(; begin != end; ++begin) {
+				++hits[begin];
+			}
+		});
+		for(int i = 0; i < count; ++i) {
+			if(hits[i] != 2) {
+				ThrowError("granularity %d: iteration %d ran %d times\n", granularity, i, hits[i].load());
+			}
+		}
+	}
+
+	// Nested loops, every outer iteration waits on an inner one.
+	std::atomic<int> total(0);
+	parallel_for(0, 64, [&](int) {
+		parallel_for(0, 100, [&](int) { ++total; });
+	});
+	if(total != 64 * 100) {
+		ThrowError("nested loops ran %d iterations\n", total.load());
+	}
+
+	std::atomic<int> invoked(0);
+	parallel_invoke([&]() { invoked += 1; }, [&]() { invoked += 10; }, [&]() { invoked += 100; });
+	if(invoked != 111) {
+		ThrowError("parallel_invoke: %d\n", invoked.load());
+	}
+
+	std::vector<int> values(1000, 1);
+	parallel_for_each(values.begin(), values.end(), [](int& v) { v *= 2; });
+	if(std::count(values.begin(), values.end(), 2) != 1000) {
+		ThrowError("parallel_for_each failed\n");
+	}
+}
+
+// Speedup of an evenly split loop over the serial one.
+static void test1()
+{
+	const int count = 256;
+	std::vector<double> results(count);
+	const auto body = [&](int i) {
+		double x = i;
+		for(int k = 0; k < 200000; ++k) {
+			x = std::sqrt(x + k);
+		}
+		results[i] = x;
+	};
+
+	const auto t0 = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < count; ++i) {
+		body(i);
+	}
+	const auto t1 = std::chrono::high_resolution_clock::now();
+	parallel_for(0, count, body);
+	const auto t2 = std::chrono::high_resolution_clock::now();
+
+	const double serialMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+	const double parallelMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+#if defined(NVC_ENABLE_THREAD_POOL)
+	printf("thread pool (%zd workers): ", thread_pool::get_worker_count());
+#endif
+	printf("serial %.1f ms, parallel %.1f ms (x%.1f), checksum %f\n", serialMs, parallelMs, serialMs / parallelMs, results[count / 2]);
+}
+
+#if defined(NVC_ENABLE_THREAD_POOL)
+// The worker count can change between loops, 0 runs them on the calling thread.
+static void test2()
+{
+	const size_t defaultCount = thread_pool::get_worker_count();
+	for(size_t workerCount : { size_t(0), size_t(1), size_t(3), defaultCount }) {
+		thread_pool::set_worker_count(workerCount);
+		if(thread_pool::get_worker_count() != workerCount) {
+			ThrowError("worker count %zd instead of %zd\n", thread_pool::get_worker_count(), workerCount);
+		}
+		std::atomic<int> total(0);
+		parallel_for(0, 1000, [&](int i) { total += i; });
+		if(total != 999 * 1000 / 2) {
+			ThrowError("%zd workers: sum %d\n", workerCount, total.load());
+		}
+	}
+}
+#endif
+
+void RunTest_Concurrency()
+{
+	test0();
+	test1();
+#if defined(NVC_ENABLE_THREAD_POOL)
+	test2();
+#endif
+}
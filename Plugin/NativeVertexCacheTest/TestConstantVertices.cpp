@@ -0,0 +1,289 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/QuantisationDecompressor.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+static const GeomCacheDesc constantDescs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+	{ nvcSEMANTIC_COLORS, DataFormat::Float4 },
+	{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+// No uv1 nor velocities, which the compressor used to read anyway.
+static const GeomCacheDesc pointsAndUV0Descs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+static void appendGrid(std::vector<int32_t>& indices, size_t side)
+{
+	const int32_t w = static_cast<int32_t>(side);
+	for(size_t y = 0; y + 1 < side; ++y) {
+		for(size_t x = 0; x + 1 < side; ++x) {
+			const int32_t v = static_cast<int32_t>(y * side + x);
+			indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+		}
+	}
+}
+
+// A static prop, then a waving cloth. The uv0 and colors of both and the uv1 and velocities of the prop
+// are the same in every frame, the cloth's uv1 scroll. Descriptors without an attribute leave it out.
+static void makeClothScene(InputGeomCache& igc, const GeomCacheDesc* descs, size_t frameCount)
+{
+	const size_t propSide = 12;
+	const size_t clothSide = 40;
+	const size_t propVertexCount = propSide * propSide;
+	const size_t vertexCount = propVertexCount + clothSide * clothSide;
+
+	std::vector<int32_t> indices;
+	appendGrid(indices, propSide);
+	const uint32_t propIndexCount = static_cast<uint32_t>(indices.size());
+	appendGrid(indices, clothSide);
+
+	std::vector<float2> uv0(vertexCount);
+	std::vector<float4> colors(vertexCount);
+	for(size_t i = 0; i < vertexCount; ++i) {
+		const size_t side = i < propVertexCount ? propSide : clothSide;
+		const size_t j = i < propVertexCount ? i : i - propVertexCount;
+		uv0[i] = float2{ static_cast<float>(j % side) / side, static_cast<float>(j / side) / side };
+		colors[i] = float4{ uv0[i][0], uv0[i][1], 0.5f, 1.0f };
+	}
+
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount);
+		std::vector<float2> uv1(vertexCount);
+		std::vector<float3> velocities(vertexCount);
+		for(size_t i = 0; i < vertexCount; ++i) {
+			const float u = uv0[i][0];
+			const float v = uv0[i][1];
+			if(i < propVertexCount) {
+				points[i] = float3{ u - 2.0f, v, 0.25f * u * v };
+				normals[i] = float3{ 0.0f, 0.0f, 1.0f };
+				uv1[i] = uv0[i];
+				velocities[i] = float3{ 0.0f, 0.0f, 0.0f };
+			}
+			else {
+				const float phase = u * 6.0f + iFrame * 0.25f;
+				points[i] = float3{ u, v, 0.1f * std::sin(phase) };
+				const float slope = 0.6f * std::cos(phase);
+				const float length = std::sqrt(slope * slope + 1.0f);
+				normals[i] = float3{ -slope / length, 0.0f, 1.0f / length };
+				uv1[i] = float2{ std::fmod(u + iFrame * 0.01f, 1.0f), v };
+				velocities[i] = float3{ 0.0f, 0.0f, 0.025f * std::cos(phase) * 30.0f };
+			}
+		}
+
+		void* vertices[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+		for(size_t iAttribute = 0; descs[iAttribute].semantic != nullptr; ++iAttribute) {
+			const char* semantic = descs[iAttribute].semantic;
+			vertices[iAttribute] = strcmp(semantic, nvcSEMANTIC_POINTS) == 0 ? static_cast<void*>(points.data())
+				: strcmp(semantic, nvcSEMANTIC_NORMALS) == 0 ? static_cast<void*>(normals.data())
+				: strcmp(semantic, nvcSEMANTIC_UV0) == 0 ? static_cast<void*>(uv0.data())
+				: strcmp(semantic, nvcSEMANTIC_UV1) == 0 ? static_cast<void*>(uv1.data())
+				: strcmp(semantic, nvcSEMANTIC_COLORS) == 0 ? static_cast<void*>(colors.data())
+				: static_cast<void*>(velocities.data());
+		}
+
+		GeomMesh meshes[2] = {
+			{ 0, static_cast<uint32_t>(propVertexCount), 0, 1 },
+			{ static_cast<uint32_t>(propVertexCount), static_cast<uint32_t>(clothSide * clothSide), 1, 1 },
+		};
+		GeomSubmesh submeshes[2] = {
+			{ 0, propIndexCount, Topology::Triangles },
+			{ propIndexCount, static_cast<uint32_t>(indices.size()) - propIndexCount, Topology::Triangles },
+		};
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = meshes;
+		data.meshCount = 2;
+		data.submeshes = submeshes;
+		data.submeshCount = 2;
+		igc.addData(iFrame / 30.0f, &data);
+	}
+}
+
+// A frame's attributes, decoded to floats or as stored for the ones decodeAttribute() doesn't know.
+static std::vector<uint8_t> getFrameBytes(QuantisationDecompressor& decompressor, size_t frameIndex)
+{
+	float time = 0.0f;
+	GeomCacheData data {};
+	if(!decompressor.getData(frameIndex, time, data)) {
+		ThrowError("constant vertices: frame %zd isn't loaded\n", frameIndex);
+	}
+
+	std::vector<uint8_t> bytes;
+	const GeomCacheDesc* descs = decompressor.getDescriptors();
+	for(size_t iAttribute = 0; descs[iAttribute].semantic != nullptr; ++iAttribute) {
+		std::vector<float4> decoded(data.vertexCount);
+		const uint8_t* begin = reinterpret_cast<const uint8_t*>(decoded.data());
+		size_t size = sizeof(float4) * data.vertexCount;
+		if(!decompressor.decodeAttribute(frameIndex, data, iAttribute, 0, data.vertexCount, decoded.data())) {
+			begin = static_cast<const uint8_t*>(data.vertices[iAttribute]);
+			size = getSizeOfDataFormat(descs[iAttribute].format) * data.vertexCount;
+		}
+		bytes.insert(bytes.end(), begin, begin + size);
+	}
+	return bytes;
+}
+
+// Constant vertices decode exactly as if every frame stored them, in any order, with any coding.
+static void test0()
+{
+	const size_t frameCount = 25;
+	InputGeomCache igc(constantDescs);
+	makeClothScene(igc, constantDescs, frameCount);
+
+	struct Case {
+		const char* name;
+		bool isEntropyCoded;
+		uint32_t bits;
+	};
+	const Case cases[] = {
+		{ "16 bits", false, 16 },
+		{ "16 bits rans", true, 16 },
+		{ "11 bits", false, 11 },
+		{ "11 bits rans", true, 11 },
+	};
+
+	for(const auto& c : cases) {
+		QuantisationSettings settings;
+		settings.PointBits = c.bits;
+		settings.NormalBits = c.bits;
+		settings.UVBits = c.bits;
+		settings.VelocityBits = c.bits;
+
+		MemoryStream storedStream(0, true);
+		MemoryStream constantStream(0, true);
+		MemoryStream* streams[2] = { &storedStream, &constantStream };
+		QuantisationReport reports[2];
+		for(int isConstant = 0; isConstant < 2; ++isConstant) {
+			settings.ConstantVertices = isConstant != 0;
+			QuantisationCompressor compressor(c.isEntropyCoded, settings);
+			compressor.compress(igc, streams[isConstant]);
+			reports[isConstant] = compressor.getReport();
+
+			streams[isConstant]->seek(0, Stream::SeekOrigin::Begin);
+			quantisation_compression::FileHeader header {};
+			streams[isConstant]->read(&header, sizeof(header));
+			if(((header.Flags & quantisation_compression::FILE_FLAG_CONSTANT_VERTICES) != 0) != (isConstant != 0)) {
+				ThrowError("constant vertices: %s, constant vertices flag isn't %d\n", c.name, isConstant);
+			}
+			if(header.VertexAttributeCount != 6) {
+				ThrowError("constant vertices: %s, %u attributes stored instead of 6\n", c.name, header.VertexAttributeCount);
+			}
+			streams[isConstant]->seek(0, Stream::SeekOrigin::Begin);
+		}
+
+		const QuantisationError* errors[2][5] = {
+			{ &reports[0].Points, &reports[0].Normals, &reports[0].UV0, &reports[0].UV1, &reports[0].Velocities },
+			{ &reports[1].Points, &reports[1].Normals, &reports[1].UV0, &reports[1].UV1, &reports[1].Velocities },
+		};
+		for(size_t i = 0; i < 5; ++i) {
+			if(errors[0][i]->Bits != errors[1][i]->Bits || errors[0][i]->MaxError != errors[1][i]->MaxError
+				|| std::abs(errors[0][i]->RmsError - errors[1][i]->RmsError) > 1e-6f * errors[0][i]->RmsError) {
+				ThrowError("constant vertices: %s, attribute %zd reports different errors\n", c.name, i);
+			}
+		}
+
+		// Every frame stored, read forward, against constant vertices read backward one frame at a time.
+		QuantisationDecompressor expected;
+		expected.open(&storedStream);
+		expected.prefetch(0, frameCount);
+
+		QuantisationDecompressor actual;
+		actual.setCacheBudget(1);
+		actual.open(&constantStream);
+		for(size_t iFrame = frameCount; iFrame-- > 0; ) {
+			actual.setPinnedRange(iFrame, 1);
+			actual.prefetch(iFrame, 1);
+			if(getFrameBytes(expected, iFrame) != getFrameBytes(actual, iFrame)) {
+				ThrowError("constant vertices: %s, frame %zd differs\n", c.name, iFrame);
+			}
+		}
+
+		// The uv0 and colors are constant over all the vertices, frames refer to the same array.
+		QuantisationDecompressor aliased;
+		constantStream.seek(0, Stream::SeekOrigin::Begin);
+		aliased.open(&constantStream);
+		aliased.prefetch(0, frameCount);
+		GeomCacheData first {};
+		GeomCacheData last {};
+		float time = 0.0f;
+		const auto r0 = aliased.getData(0, time, first);
+		const auto r1 = aliased.getData(frameCount - 1, time, last);
+		assert(r0 && r1);
+		if(first.vertices[2] != last.vertices[2] || first.vertices[4] != last.vertices[4] || first.vertices[0] == last.vertices[0]) {
+			ThrowError("constant vertices: %s, constant attributes aren't shared by the frames\n", c.name);
+		}
+		if(aliased.getCacheSize() >= expected.getCacheSize()) {
+			ThrowError("constant vertices: %s, frames take %zd bytes, %zd without constant vertices\n", c.name, aliased.getCacheSize(), expected.getCacheSize());
+		}
+
+		if(constantStream.getLength() >= storedStream.getLength()) {
+			ThrowError("constant vertices: %s, %zd bytes, %zd without constant vertices\n", c.name, constantStream.getLength(), storedStream.getLength());
+		}
+		printf("constant vertices: %-12s %7zd -> %7zd bytes (x%.2f), cache %7zd -> %7zd bytes\n", c.name
+			, storedStream.getLength(), constantStream.getLength(), static_cast<double>(storedStream.getLength()) / constantStream.getLength()
+			, expected.getCacheSize(), aliased.getCacheSize());
+	}
+}
+
+// Caches without uv1 or velocities compress, and keep their uv0.
+static void test1()
+{
+	const size_t frameCount = 3;
+	InputGeomCache igc(pointsAndUV0Descs);
+	makeClothScene(igc, pointsAndUV0Descs, frameCount);
+
+	MemoryStream stream(0, true);
+	QuantisationCompressor compressor;
+	compressor.compress(igc, &stream);
+	stream.seek(0, Stream::SeekOrigin::Begin);
+
+	QuantisationDecompressor decompressor;
+	decompressor.open(&stream);
+	decompressor.prefetch(0, frameCount);
+
+	const GeomCacheDesc* descs = decompressor.getDescriptors();
+	if(getAttributeCount(descs) != 2 || getAttributeIndex(descs, nvcSEMANTIC_UV0) != 1) {
+		ThrowError("constant vertices: points and uv0 only, %zd attributes stored\n", getAttributeCount(descs));
+	}
+
+	float time = 0.0f;
+	GeomCacheData data {};
+	std::vector<float2> uv0;
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		std::vector<float2> decoded(144 + 1600);
+		if(!decompressor.getData(iFrame, time, data) || data.vertexCount != decoded.size()
+			|| !decompressor.decodeAttribute(iFrame, data, 1, 0, data.vertexCount, decoded.data())) {
+			ThrowError("constant vertices: points and uv0 only, frame %zd isn't decoded\n", iFrame);
+		}
+		if(iFrame > 0 && memcmp(uv0.data(), decoded.data(), sizeof(float2) * decoded.size()) != 0) {
+			ThrowError("constant vertices: points and uv0 only, frame %zd uv0 differ\n", iFrame);
+		}
+		uv0 = std::move(decoded);
+	}
+}
+
+void RunTest_ConstantVertices()
+{
+	test0();
+	test1();
+}
@@ -2,6 +2,10 @@
 #include "Plugin/PrecompiledHeader.h"
 #include "Plugin/Stream/FileStream.h"
 #include "Plugin/NativeVertexCacheTest/TestUtil.h"
+#if defined(NVC_FILESTREAM_POSIX_MMAP)
+#include <signal.h> // signal(), SIGXFSZ
+#include <sys/resource.h> // setrlimit(), RLIMIT_FSIZE
+#endif
 
 using namespace nvc;
 using ByteArray = std::vector<uint8_t>;
@@ -60,6 +64,21 @@ static void test0() {
 
 	assert(msSrc.getLength() == ba.size());
 	assert(msDst.getLength() == bb.size());
+
+	// view() must return the same bytes as read() without moving the cursor.
+	{
+		msDst.close();
+		FileStream fs(
+			  dst_filename
+			, FileStream::OpenModes::Random_ReadOnly
+		);
+		fs.seek(3, Stream::SeekOrigin::Begin);
+		const auto* v = static_cast<const uint8_t*>(fs.view(100, 500));
+		assert(v != nullptr);
+		assert(0 == memcmp(v, ba.data() + 100, 500));
+		assert(fs.getPosition() == 3);
+		assert(fs.view(fs.getLength(), 1) == nullptr);
+	}
 }
 
 static void test1() {
@@ -135,11 +154,13 @@ static void test2() {
 			fs.write(buf.data(), buf.size() * sizeof(buf[0]));
 		}
 		const auto t1 = GetHighResolutionClock();
-		printf("%s: %6.2f seconds to write %zd total bytes. (block size = %zd bytes)\n"
+		const auto dt = GetSeconds(t0, t1);
+		printf("%s: %6.2f seconds to write %zd total bytes. (block size = %zd bytes, %f MB/sec)\n"
 			   , __FUNCTION__
-			   , GetSeconds(t0, t1)
+			   , dt
 			   , totalSize
 			   , blockSize
+			   , totalSize / dt / 1024/1024
 		);
 	}
 
@@ -189,18 +210,82 @@ static void test2() {
 			));
 		}
 		const auto t1 = GetHighResolutionClock();
-		printf("%s: %6.2f seconds to read %zd total bytes. (block size = %zd bytes)\n"
+		const auto dt = GetSeconds(t0, t1);
+		printf("%s: %6.2f seconds to read %zd total bytes. (block size = %zd bytes, %f MB/sec)\n"
 			   , __FUNCTION__
-			   , GetSeconds(t0, t1)
+			   , dt
 			   , totalSize
 			   , blockSize
+			   , totalSize / dt / 1024/1024
 		);
 	}
 }
 
+#if defined(NVC_FILESTREAM_POSIX_MMAP)
+// Writes past the file size limit fail as short writes, what was written before stays readable.
+static void test3() {
+	const char* filename = "../../../Data/TestOutput/fs_test_sizelimit.file";
+	const size_t sizeLimit = 4 * 1024 * 1024;
+
+	AutoPrepareCleanFile apcfFilename { filename };
+
+	rlimit previousLimit {};
+	getrlimit(RLIMIT_FSIZE, &previousLimit);
+	rlimit limit = previousLimit;
+	limit.rlim_cur = sizeLimit;
+	setrlimit(RLIMIT_FSIZE, &limit);
+	const auto previousHandler = signal(SIGXFSZ, SIG_IGN);
+
+	size_t writtenSize = 0;
+	bool isShortWrite = false;
+	{
+		FileStream fs(
+			  filename
+			, FileStream::OpenModes::Random_ReadWrite
+		);
+
+		std::vector<uint64_t> buf(64 * 1024 / sizeof(uint64_t));
+		for(size_t iBlock = 0; iBlock < 2 * sizeLimit / (buf.size() * sizeof(buf[0])); ++iBlock) {
+			FillRandom(buf, iBlock, 1);
+			const size_t size = fs.write(buf.data(), buf.size() * sizeof(buf[0]));
+			if(size == 0) {
+				isShortWrite = true;
+				break;
+			}
+			writtenSize += size;
+		}
+
+		if(!isShortWrite || fs.getLength() != writtenSize || fs.getPosition() != writtenSize) {
+			setrlimit(RLIMIT_FSIZE, &previousLimit);
+			signal(SIGXFSZ, previousHandler);
+			ThrowError("FileStream: a write past the file size limit isn't a short write (%zd bytes written)\n", writtenSize);
+		}
+
+		std::vector<uint64_t> refBuf(buf.size());
+		fs.seek(0, Stream::SeekOrigin::Begin);
+		for(size_t iBlock = 0; iBlock < writtenSize / (buf.size() * sizeof(buf[0])); ++iBlock) {
+			FillRandom(refBuf, iBlock, 1);
+			fs.read(buf.data(), buf.size() * sizeof(buf[0]));
+			if(buf != refBuf) {
+				setrlimit(RLIMIT_FSIZE, &previousLimit);
+				signal(SIGXFSZ, previousHandler);
+				ThrowError("FileStream: block %zd differs after a failed write\n", iBlock);
+			}
+		}
+	}
+
+	setrlimit(RLIMIT_FSIZE, &previousLimit);
+	signal(SIGXFSZ, previousHandler);
+	printf("TestFileStream: %zd bytes written before the %zd bytes file size limit\n", writtenSize, sizeLimit);
+}
+#endif
+
 void RunTest_FileStream()
 {
 	test0();
 	test1();
 	test2();
+#if defined(NVC_FILESTREAM_POSIX_MMAP)
+	test3();
+#endif
 }
@@ -0,0 +1,312 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/Compression/NullCompressor.h"
+#include "Plugin/Compression/NullDecompressor.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+// Forwards to a MemoryStream and counts the bytes read through it. Doesn't override view().
+class CountingStream final : public Stream
+{
+public:
+	MemoryStream m_Stream { 0, true };
+	mutable size_t m_ReadSize = 0;
+	bool m_IsReadOnly = false;
+
+	bool canRead() const override { return m_Stream.canRead(); }
+	bool canWrite() const override { return !m_IsReadOnly && m_Stream.canWrite(); }
+	bool canSeek() const override { return m_Stream.canSeek(); }
+	bool isEof() const override { return m_Stream.isEof(); }
+	size_t getPosition() const override { return m_Stream.getPosition(); }
+	size_t getLength() const override { return m_Stream.getLength(); }
+	void setLength(size_t length) override { m_Stream.setLength(length); }
+	void copyTo(Stream* stream, size_t length) override { m_Stream.copyTo(stream, length); }
+	size_t read(void* buffer, size_t length) const override { m_ReadSize += length; return m_Stream.read(buffer, length); }
+	size_t write(const void* buffer, size_t length) override { return m_Stream.write(buffer, length); }
+	void seek(int64_t offset, SeekOrigin origin) override { m_Stream.seek(offset, origin); }
+	void flush() override { m_Stream.flush(); }
+	void close() override { m_Stream.close(); }
+};
+
+// vertexCountRange > 0 varies the vertex count (triangle strips of 3 + [0, vertexCountRange) vertices) every topologyPeriod frames.
+static void makeCache(MemoryStream& stream, size_t frameCount, size_t vertexCountRange = 0, size_t topologyPeriod = 1)
+{
+	const GeomCacheDesc descs[] = {
+		{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+		GEOM_CACHE_DESCRIPTOR_END
+	};
+	InputGeomCache igc(descs);
+
+	const size_t maxVertexCount = 3 + vertexCountRange;
+	std::vector<int32_t> indices((maxVertexCount - 2) * 3);
+	std::vector<float3> points(maxVertexCount);
+	void* vertices[1] = { points.data() };
+
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		const size_t vertexCount = 3 + (vertexCountRange > 0 ? (iFrame / topologyPeriod * 7) % vertexCountRange : 0);
+		const size_t indexCount = (vertexCount - 2) * 3;
+		for(size_t iTriangle = 0; iTriangle < vertexCount - 2; ++iTriangle) {
+			indices[iTriangle * 3 + 0] = static_cast<int32_t>(iTriangle);
+			indices[iTriangle * 3 + 1] = static_cast<int32_t>(iTriangle + 1);
+			indices[iTriangle * 3 + 2] = static_cast<int32_t>(iTriangle + 2);
+		}
+		points[0] = float3{ static_cast<float>(iFrame), 0.0f, 0.0f };
+
+		GeomMesh mesh = { 0, static_cast<uint32_t>(vertexCount), 0, 1 };
+		GeomSubmesh submesh = { 0, static_cast<uint32_t>(indexCount), Topology::Triangles };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indexCount;
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = &mesh;
+		data.meshCount = 1;
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		igc.addData(iFrame / 30.0f, &data);
+	}
+
+	NullCompressor compressor {};
+	compressor.compress(igc, &stream);
+}
+
+// Loaded frame lookup: the cost per getData() must not depend on the number of resident frames.
+static void test0()
+{
+	const size_t lookupCount = 1000000;
+
+	for(size_t frameCount = 10; frameCount <= 100000; frameCount *= 10) {
+		MemoryStream stream(0, true);
+		makeCache(stream, frameCount);
+		stream.seek(0, Stream::SeekOrigin::Begin);
+
+		NullDecompressor decompressor;
+		decompressor.setMappedMode(false);
+		decompressor.setCacheBudget(0);
+		decompressor.open(&stream);
+		assert(decompressor.getFrameCount() == frameCount);
+
+		const auto t0 = std::chrono::high_resolution_clock::now();
+		decompressor.prefetch(0, frameCount);
+		const auto t1 = std::chrono::high_resolution_clock::now();
+
+		Pcg pcg(123, 456);
+		size_t found = 0;
+		size_t checksum = 0;
+		for(size_t iLookup = 0; iLookup < lookupCount; ++iLookup) {
+			const size_t frameIndex = pcg.getUint32() % frameCount;
+
+			float time = 0.0f;
+			GeomCacheData data {};
+			if(decompressor.getData(frameIndex, time, data)) {
+				checksum += data.vertexCount;
+				++found;
+			}
+		}
+		const auto t2 = std::chrono::high_resolution_clock::now();
+		assert(found == lookupCount);
+
+		const double loadNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / frameCount;
+		const double lookupNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / lookupCount;
+		printf("frames(%6zd): load %8.1f ns/frame, lookup %6.1f ns/frame (checksum %zd)\n"
+			, frameCount, loadNs, lookupNs, checksum);
+
+		decompressor.close();
+	}
+}
+
+// Pooled frame blocks: once the cache is at its budget, playback must not touch the heap at all.
+static void test1()
+{
+	const size_t frameCount = 300;
+	const size_t framesInBudget = 8;
+
+	MemoryStream stream(0, true);
+	makeCache(stream, frameCount, 400);
+	stream.seek(0, Stream::SeekOrigin::Begin);
+
+	NullDecompressor decompressor;
+	decompressor.setMappedMode(false);
+	decompressor.setCacheBudget(framesInBudget * FrameBufferPool::getBlockSize(sizeof(float3) * 402 + sizeof(int32_t) * 400 * 3));
+	decompressor.open(&stream);
+
+	const size_t initialAllocationCount = decompressor.getHeapAllocationCount();
+	size_t allocationCounts[3] = {};
+	for(size_t iPass = 0; iPass < 3; ++iPass) {
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			decompressor.setPinnedRange(iFrame, 2);
+			decompressor.prefetch(iFrame, 2);
+
+			float time = 0.0f;
+			GeomCacheData data {};
+			const auto r = decompressor.getData(iFrame, time, data);
+			assert(r);
+			assert((reinterpret_cast<uintptr_t>(data.vertices[0]) % FrameBufferPool::Alignment) == 0);
+			assert(static_cast<const float3*>(data.vertices[0])[0][0] == static_cast<float>(iFrame));
+		}
+		allocationCounts[iPass] = decompressor.getHeapAllocationCount();
+	}
+
+	printf("frame cache: heap allocations per pass %zd, %zd, %zd (%zd frames), pooled %zd bytes\n"
+		, allocationCounts[0] - initialAllocationCount, allocationCounts[1] - allocationCounts[0], allocationCounts[2] - allocationCounts[1]
+		, frameCount, decompressor.getFramePool().getPooledSize());
+	assert(allocationCounts[2] == allocationCounts[1]);
+
+	decompressor.close();
+}
+
+// Shared topology: frames with the same topology as the file or their seek window reference a single copy.
+static void test2()
+{
+	const size_t frameCount = 100;
+	const size_t windowSize = NullCompressor::DefaultSeekWindow;
+
+	for(size_t topologyPeriod = 1; topologyPeriod <= frameCount; topologyPeriod *= windowSize) {
+		MemoryStream stream(0, true);
+		makeCache(stream, frameCount, 400, topologyPeriod);
+		const size_t streamSize = stream.getLength();
+		stream.seek(0, Stream::SeekOrigin::Begin);
+
+		NullDecompressor decompressor;
+		decompressor.setMappedMode(false);
+		decompressor.open(&stream);
+		decompressor.prefetch(0, frameCount);
+
+		size_t sharedCount = 0;
+		GeomCacheData previousData {};
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			float time = 0.0f;
+			GeomCacheData data {};
+			const auto r = decompressor.getData(iFrame, time, data);
+			assert(r);
+			assert(data.indexCount == (data.vertexCount - 2) * 3);
+			assert(static_cast<const int32_t*>(data.indices)[data.indexCount - 1] == static_cast<int32_t>(data.vertexCount - 1));
+
+			if(iFrame > 0 && data.indices == previousData.indices) {
+				++sharedCount;
+			}
+			previousData = data;
+		}
+
+		printf("topology period %3zd: %zd bytes, %zd frames share the previous frame's topology\n"
+			, topologyPeriod, streamSize, sharedCount);
+		assert(topologyPeriod == 1 || sharedCount == frameCount - frameCount / topologyPeriod);
+
+		decompressor.close();
+	}
+}
+
+// Frame index: a random seek reads the frame alone, plus its window topology if the frame shares it.
+static void test3()
+{
+	const size_t frameCount = 100;
+	const size_t windowSize = NullCompressor::DefaultSeekWindow;
+	const size_t seekCount = 200;
+
+	for(size_t topologyPeriod = 1; topologyPeriod <= frameCount; topologyPeriod *= windowSize) {
+		CountingStream stream;
+		makeCache(stream.m_Stream, frameCount, 400, topologyPeriod);
+		stream.seek(0, Stream::SeekOrigin::Begin);
+
+		NullDecompressor decompressor;
+		decompressor.setMappedMode(false);
+		decompressor.setCacheBudget(1); // Only the most recently used frame stays.
+		decompressor.open(&stream);
+
+		Pcg pcg(123, 456);
+		size_t frameIndex = 0;
+		size_t totalReadSize = 0;
+		for(size_t iSeek = 0; iSeek < seekCount; ++iSeek) {
+			// Never the previous frame, the only resident one.
+			frameIndex = (frameIndex + 1 + pcg.getUint32() % (frameCount - 1)) % frameCount;
+
+			decompressor.setPinnedRange(frameIndex, 1);
+			stream.m_ReadSize = 0;
+			decompressor.prefetch(frameIndex, 1);
+			totalReadSize += stream.m_ReadSize;
+
+			float time = 0.0f;
+			GeomCacheData data {};
+			const auto r = decompressor.getData(frameIndex, time, data);
+			assert(r);
+			assert(static_cast<const float3*>(data.vertices[0])[0][0] == static_cast<float>(frameIndex));
+
+			const size_t frameSize = sizeof(null_compression::FrameHeader) + sizeof(float3) * data.vertexCount;
+			const size_t topologySize = sizeof(uint64_t) * 2 + sizeof(GeomMesh) * data.meshCount
+				+ sizeof(GeomSubmesh) * data.submeshCount + sizeof(int32_t) * data.indexCount;
+			if(stream.m_ReadSize > frameSize + sizeof(null_compression::FrameHeader) + topologySize
+				|| (topologyPeriod == frameCount && stream.m_ReadSize != frameSize)) {
+				ThrowError("topology period %zd: reading frame %zd took %zd bytes\n", topologyPeriod, frameIndex, stream.m_ReadSize);
+			}
+		}
+
+		printf("topology period %3zd: %zd bytes read per random seek (%zd bytes per frame in the file)\n"
+			, topologyPeriod, totalReadSize / seekCount, stream.getLength() / frameCount);
+
+		decompressor.close();
+	}
+}
+
+// Mapped mode: frames of a read only stream reference its view(), streams without one are copied from.
+static void test4()
+{
+	const size_t frameCount = 50;
+
+	CountingStream stream;
+	stream.m_IsReadOnly = true;
+	makeCache(stream.m_Stream, frameCount, 400, NullCompressor::DefaultSeekWindow);
+	stream.seek(0, Stream::SeekOrigin::Begin);
+	assert(stream.view(0, 1) == nullptr);
+
+	MemoryStream mappedStream(const_cast<void*>(stream.m_Stream.getBuffer()), stream.getLength(), false);
+
+	NullDecompressor decompressor;
+	decompressor.open(&stream);
+	assert(!decompressor.isMappedMode());
+
+	NullDecompressor mappedDecompressor;
+	mappedDecompressor.open(&mappedStream);
+	assert(mappedDecompressor.isMappedMode());
+
+	decompressor.prefetch(0, frameCount);
+	mappedDecompressor.prefetch(0, frameCount);
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		float time = 0.0f;
+		GeomCacheData data {};
+		GeomCacheData mappedData {};
+		const auto r = decompressor.getData(iFrame, time, data);
+		const auto mappedR = mappedDecompressor.getData(iFrame, time, mappedData);
+		assert(r && mappedR);
+		assert(data.vertexCount == mappedData.vertexCount && data.indexCount == mappedData.indexCount);
+		assert(0 == memcmp(data.vertices[0], mappedData.vertices[0], sizeof(float3) * data.vertexCount));
+		assert(0 == memcmp(data.indices, mappedData.indices, sizeof(int32_t) * data.indexCount));
+
+		const auto* buffer = static_cast<const uint8_t*>(mappedStream.getBuffer());
+		if(data.vertices[0] >= buffer && data.vertices[0] < buffer + stream.getLength()) {
+			ThrowError("frame cache: frame %zd of a stream without view() isn't copied\n", iFrame);
+		}
+		if(mappedData.vertices[0] < buffer || mappedData.vertices[0] >= buffer + mappedStream.getLength()) {
+			ThrowError("frame cache: frame %zd of a mapped stream is copied\n", iFrame);
+		}
+	}
+	printf("frame cache: %zd frames copied without view(), referenced in place with it\n", frameCount);
+
+	mappedDecompressor.close();
+	decompressor.close();
+}
+
+void RunTest_FrameCache()
+{
+	test0();
+	test1();
+	test2();
+	test3();
+	test4();
+}
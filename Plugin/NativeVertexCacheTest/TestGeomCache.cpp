@@ -0,0 +1,192 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Concurrency.h"
+#include "Plugin/Stream/FileStream.h"
+#include "Plugin/Compression/NullCompressor.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCache.h"
+#include "Plugin/OutputGeomCache.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+// A waving grid of side * side vertices with points, normals, tangents, uvs and velocities.
+static void makeGridCache(const char* filename, size_t side, size_t frameCount, bool quantise)
+{
+	const GeomCacheDesc descs[] = {
+		{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+		{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+		{ nvcSEMANTIC_TANGENTS, DataFormat::Float4 },
+		{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+		{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+		{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+		GEOM_CACHE_DESCRIPTOR_END
+	};
+	InputGeomCache igc(descs);
+
+	const size_t vertexCount = side * side;
+	std::vector<float3> points(vertexCount);
+	std::vector<float3> normals(vertexCount);
+	std::vector<float4> tangents(vertexCount, float4{ 1.0f, 0.0f, 0.0f, 1.0f });
+	std::vector<float2> uvs(vertexCount);
+	std::vector<float3> velocities(vertexCount, float3{ 0.0f, 0.0f, 1.0f });
+	std::vector<int32_t> indices;
+	indices.reserve((side - 1) * (side - 1) * 6);
+	for(size_t y = 0; y + 1 < side; ++y) {
+		for(size_t x = 0; x + 1 < side; ++x) {
+			const int32_t i = static_cast<int32_t>(y * side + x);
+			const int32_t s = static_cast<int32_t>(side);
+			indices.insert(indices.end(), { i, i + 1, i + s, i + 1, i + s + 1, i + s });
+		}
+	}
+	void* vertices[6] = { points.data(), normals.data(), tangents.data(), uvs.data(), uvs.data(), velocities.data() };
+
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		for(size_t y = 0; y < side; ++y) {
+			for(size_t x = 0; x < side; ++x) {
+				const size_t i = y * side + x;
+				const float fx = static_cast<float>(x);
+				const float fy = static_cast<float>(y);
+				const float z = std::sin(fx * 0.05f + iFrame * 0.3f) * std::cos(fy * 0.05f);
+				points[i] = float3{ fx, fy, z };
+				const float length = std::sqrt(z * z + 1.0f);
+				normals[i] = float3{ -z / length, 0.0f, 1.0f / length };
+				uvs[i] = float2{ fx / side, fy / side };
+			}
+		}
+
+		GeomMesh mesh = { 0, static_cast<uint32_t>(vertexCount), 0, 1 };
+		GeomSubmesh submesh = { 0, static_cast<uint32_t>(indices.size()), Topology::Triangles };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = &mesh;
+		data.meshCount = 1;
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		igc.addData(iFrame / 30.0f, &data);
+	}
+
+	FileStream fs { filename, FileStream::OpenModes::Random_ReadWrite };
+	if(quantise) {
+		QuantisationCompressor compressor {};
+		compressor.compress(igc, &fs);
+	}
+	else {
+		NullCompressor compressor {};
+		compressor.compress(igc, &fs);
+	}
+}
+
+template<class T>
+static bool isSameArray(const RawVector<T>& lhs, const RawVector<T>& rhs)
+{
+	return lhs.size() == rhs.size() && (lhs.empty() || memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(T)) == 0);
+}
+
+// Tasks over vertex ranges give the same output as the serial conversion.
+static void test0()
+{
+	const char* filenames[] = {
+		"../../../Data/TestOutput/Grid-300x300.nvc",
+		"../../../Data/TestOutput/Grid-300x300.quantisation.nvc",
+	};
+
+	for(int quantise = 0; quantise < 2; ++quantise) {
+		AutoPrepareCleanFile file(filenames[quantise]);
+		makeGridCache(filenames[quantise], 300, 3, quantise != 0);
+
+		GeomCache serialCache;
+		serialCache.setAsyncPrefetch(false);
+		serialCache.setConvertGrainSize(0);
+		const auto r0 = serialCache.open(filenames[quantise]);
+		assert(r0);
+
+		GeomCache parallelCache;
+		parallelCache.setAsyncPrefetch(false);
+		parallelCache.setConvertGrainSize(4099); // Ragged last task.
+		const auto r1 = parallelCache.open(filenames[quantise]);
+		assert(r1);
+
+		for(size_t iFrame = 0; iFrame < serialCache.getFrameCount(); ++iFrame) {
+			serialCache.setCurrentFrameIndex(iFrame);
+			parallelCache.setCurrentFrameIndex(iFrame);
+
+			OutputGeomCache expected;
+			OutputGeomCache actual;
+			const auto r2 = serialCache.assignCurrentDataToMesh(expected);
+			const auto r3 = parallelCache.assignCurrentDataToMesh(actual);
+			assert(r2 && r3);
+
+			if(!isSameArray(expected.indices, actual.indices)
+				|| !isSameArray(expected.points, actual.points)
+				|| !isSameArray(expected.normals, actual.normals)
+				|| !isSameArray(expected.tangents, actual.tangents)
+				|| !isSameArray(expected.uv0, actual.uv0)) {
+				ThrowError("%s: frame %zd differs from the serial conversion\n", filenames[quantise], iFrame);
+			}
+		}
+	}
+}
+
+// assignCurrentDataToMesh() time of a 2M vertex frame from 1 to 16 threads.
+static void test1()
+{
+	const char* filenames[] = {
+		"../../../Data/TestOutput/Grid-1448x1448.nvc",
+		"../../../Data/TestOutput/Grid-1448x1448.quantisation.nvc",
+	};
+	const size_t assignCount = 10;
+
+	printf("assign scaling (%u hardware threads)\n", std::thread::hardware_concurrency());
+	for(int quantise = 0; quantise < 2; ++quantise) {
+		AutoPrepareCleanFile file(filenames[quantise]);
+		makeGridCache(filenames[quantise], 1448, 2, quantise != 0);
+
+		GeomCache geomCache;
+		geomCache.setAsyncPrefetch(false);
+		const auto r0 = geomCache.open(filenames[quantise]);
+		assert(r0);
+		geomCache.setCurrentFrameIndex(1);
+
+		OutputGeomCache output;
+		double oneThreadMs = 0.0;
+		for(size_t threadCount = 1; threadCount <= 16; threadCount *= 2) {
+#if defined(NVC_ENABLE_THREAD_POOL)
+			thread_pool::set_worker_count(threadCount - 1);
+#else
+			// PPL and TBB size themselves, only the serial and the default runs are meaningful.
+			geomCache.setConvertGrainSize(threadCount == 1 ? 0 : DefaultConvertGrainSize);
+#endif
+			const auto r1 = geomCache.assignCurrentDataToMesh(output);
+			assert(r1);
+
+			const auto t0 = std::chrono::high_resolution_clock::now();
+			for(size_t iAssign = 0; iAssign < assignCount; ++iAssign) {
+				geomCache.assignCurrentDataToMesh(output);
+			}
+			const auto t1 = std::chrono::high_resolution_clock::now();
+
+			const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / assignCount;
+			if(threadCount == 1) {
+				oneThreadMs = ms;
+			}
+			printf("  %s %2zd threads: %7.2f ms/frame (x%.2f)\n", quantise ? "quantisation" : "null        ", threadCount, ms, oneThreadMs / ms);
+		}
+	}
+
+#if defined(NVC_ENABLE_THREAD_POOL)
+	thread_pool::set_worker_count(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+#endif
+}
+
+void RunTest_GeomCache()
+{
+	test0();
+	test1();
+}
@@ -0,0 +1,260 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Compression/IndexCoding.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/QuantisationDecompressor.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+static const char* getModeName(IndexCodingMode mode)
+{
+	switch(mode) {
+	case IndexCodingMode::Uint16: return "Uint16";
+	case IndexCodingMode::Deltas: return "Deltas";
+	case IndexCodingMode::Triangles: return "Triangles";
+	default: return "Raw";
+	}
+}
+
+// Triangles of a grid of side * side vertices starting at firstVertex, row by row.
+static void appendGridTriangles(std::vector<int32_t>& indices, size_t side, int32_t firstVertex)
+{
+	const int32_t w = static_cast<int32_t>(side);
+	for(size_t y = 0; y + 1 < side; ++y) {
+		for(size_t x = 0; x + 1 < side; ++x) {
+			const int32_t v = firstVertex + static_cast<int32_t>(y * side + x);
+			indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+		}
+	}
+}
+
+// The triangles in a random order, each one rotated at random.
+static std::vector<int32_t> shuffleTriangles(const std::vector<int32_t>& indices, uint64_t seed)
+{
+	Pcg pcg(seed, 456);
+	const size_t triangleCount = indices.size() / 3;
+	std::vector<size_t> order(triangleCount);
+	FillSequence(order);
+	for(size_t i = triangleCount; i > 1; --i) {
+		std::swap(order[i - 1], order[pcg.getUint32() % i]);
+	}
+
+	std::vector<int32_t> shuffled;
+	for(size_t iTriangle : order) {
+		const size_t rotation = pcg.getUint32() % 3;
+		for(size_t i = 0; i < 3; ++i) {
+			shuffled.push_back(indices[iTriangle * 3 + (i + rotation) % 3]);
+		}
+	}
+	return shuffled;
+}
+
+// Coding then decoding gives the indices back in their order, and damaged codings don't.
+static void test0()
+{
+	struct Case {
+		const char* name;
+		std::vector<int32_t> indices;
+		bool isTriangleList;
+	};
+	std::vector<Case> cases;
+	cases.push_back({ "empty", {}, true });
+	cases.push_back({ "triangle", { 0, 1, 2 }, true });
+	cases.push_back({ "degenerate", { 0, 0, 0, 5, 5, 5, 0, 0, 0 }, true });
+
+	std::vector<int32_t> grid;
+	appendGridTriangles(grid, 50, 0);
+	cases.push_back({ "grid", grid, true });
+	cases.push_back({ "grid lines", grid, false });
+	cases.push_back({ "shuffled grid", shuffleTriangles(grid, 1), true });
+
+	std::vector<int32_t> largeGrid;
+	appendGridTriangles(largeGrid, 300, 0);
+	cases.push_back({ "large grid", largeGrid, true });
+
+	// Several meshes, the second one with vertices past the first.
+	std::vector<int32_t> meshes;
+	appendGridTriangles(meshes, 20, 0);
+	appendGridTriangles(meshes, 30, 400);
+	cases.push_back({ "meshes", meshes, true });
+
+	std::vector<int32_t> extremes = { INT32_MIN, INT32_MAX, 0, -1, INT32_MAX, INT32_MIN, 65535, 65536, -65536 };
+	cases.push_back({ "extremes", extremes, true });
+
+	std::vector<int32_t> random(3000);
+	FillRandom(random);
+	cases.push_back({ "random", random, true });
+
+	std::vector<int32_t> small(3000);
+	FillRandom(small);
+	for(auto& index : small) {
+		index &= 0xFFFF;
+	}
+	cases.push_back({ "random uint16", small, true });
+
+	for(const auto& c : cases) {
+		std::vector<uint8_t> encoded { 0xCD }; // Appending keeps what's there.
+		const size_t encodedSize = encodeIndices(c.indices.data(), c.indices.size(), c.isTriangleList, encoded);
+		if(encodedSize != encoded.size() - 1 || encoded[0] != 0xCD || encodedSize > sizeof(int32_t) * c.indices.size() + 1) {
+			ThrowError("index coding: %s, wrong encoded size\n", c.name);
+		}
+
+		std::vector<int32_t> decoded(c.indices.size(), -7);
+		if(!decodeIndices(encoded.data() + 1, encodedSize, decoded.data(), decoded.size()) || decoded != c.indices) {
+			ThrowError("index coding: %s, decoding differs\n", c.name);
+		}
+
+		if(c.indices.size() > 100) {
+			if(decodeIndices(encoded.data() + 1, encodedSize - 1, decoded.data(), decoded.size())) {
+				ThrowError("index coding: %s, truncated coding decodes\n", c.name);
+			}
+			if(decodeIndices(encoded.data() + 1, encodedSize, decoded.data(), decoded.size() - 3)) {
+				ThrowError("index coding: %s, decodes to fewer indices\n", c.name);
+			}
+		}
+
+		printf("index coding: %-14s %7zd indices, %-9s %8zd bytes (%.2f bytes per index)\n", c.name, c.indices.size()
+			, getModeName(static_cast<IndexCodingMode>(encoded[1])), encodedSize, c.indices.empty() ? 0.0 : static_cast<double>(encodedSize) / c.indices.size());
+	}
+
+	// A grid codes its triangles, about 1.5 bytes each.
+	std::vector<uint8_t> encoded;
+	encodeIndices(largeGrid.data(), largeGrid.size(), true, encoded);
+	if(static_cast<IndexCodingMode>(encoded[0]) != IndexCodingMode::Triangles || encoded.size() * 6 > largeGrid.size() * sizeof(int32_t)) {
+		ThrowError("index coding: grid triangles aren't coded\n");
+	}
+}
+
+// Decode throughput.
+static void test1()
+{
+	const size_t passCount = 20;
+
+	std::vector<int32_t> grid;
+	appendGridTriangles(grid, 1000, 0);
+
+	const std::pair<const char*, std::vector<int32_t>> inputs[] = {
+		{ "grid", grid },
+		{ "shuffled grid", shuffleTriangles(grid, 2) },
+	};
+
+	for(const auto& input : inputs) {
+		const std::vector<int32_t>& indices = input.second;
+		std::vector<uint8_t> encoded;
+		encodeIndices(indices.data(), indices.size(), true, encoded);
+		std::vector<int32_t> decoded(indices.size());
+
+		const auto t0 = std::chrono::high_resolution_clock::now();
+		for(size_t iPass = 0; iPass < passCount; ++iPass) {
+			const auto r = decodeIndices(encoded.data(), encoded.size(), decoded.data(), decoded.size());
+			assert(r);
+		}
+		const auto t1 = std::chrono::high_resolution_clock::now();
+		const double seconds = std::chrono::duration<double>(t1 - t0).count();
+		printf("index coding %-13s x%.2f, %-9s: %7.1f M indices/s\n", input.first
+			, static_cast<double>(sizeof(int32_t) * indices.size()) / encoded.size()
+			, getModeName(static_cast<IndexCodingMode>(encoded[0])), indices.size() * passCount / seconds * 1e-6);
+	}
+}
+
+// Frames with a topology of their own decode to their indices, in any order.
+static void test2()
+{
+	static const GeomCacheDesc descs[] = {
+		{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+		{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+		{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+		{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+		{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+		GEOM_CACHE_DESCRIPTOR_END
+	};
+	const size_t frameCount = 25;
+
+	InputGeomCache igc(descs);
+	std::vector<std::vector<int32_t>> frameIndices(frameCount);
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		// The grid grows, every frame has its own topology.
+		const size_t side = 20 + iFrame;
+		const size_t vertexCount = side * side;
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount, float3{ 0.0f, 0.0f, 1.0f });
+		std::vector<float2> uvs(vertexCount, float2{ 0.0f, 0.0f });
+		std::vector<float2> uv1s(vertexCount, float2{ 0.0f, 0.0f });
+		std::vector<float3> velocities(vertexCount, float3{ 0.0f, 0.0f, 0.0f });
+		for(size_t i = 0; i < vertexCount; ++i) {
+			points[i] = float3{ static_cast<float>(i % side), static_cast<float>(i / side), 0.0f };
+		}
+		std::vector<int32_t>& indices = frameIndices[iFrame];
+		appendGridTriangles(indices, side, 0);
+		if(iFrame % 2 != 0) {
+			indices = shuffleTriangles(indices, iFrame);
+		}
+		void* vertices[5] = { points.data(), normals.data(), uvs.data(), uv1s.data(), velocities.data() };
+
+		GeomMesh mesh = { 0, static_cast<uint32_t>(vertexCount), 0, 1 };
+		GeomSubmesh submesh = { 0, static_cast<uint32_t>(indices.size()), Topology::Triangles };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = &mesh;
+		data.meshCount = 1;
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		igc.addData(iFrame / 30.0f, &data);
+	}
+
+	MemoryStream stream(0, true);
+	{
+		QuantisationCompressor compressor {};
+		compressor.compress(igc, &stream);
+	}
+	stream.seek(0, Stream::SeekOrigin::Begin);
+
+	QuantisationDecompressor sequential;
+	sequential.open(&stream);
+	sequential.prefetch(0, frameCount);
+	MemoryStream randomStream(const_cast<void*>(stream.getBuffer()), stream.getLength(), false);
+	QuantisationDecompressor random;
+	random.setCacheBudget(1);
+	random.open(&randomStream);
+
+	Pcg pcg(123, 456);
+	for(size_t iSeek = 0; iSeek < frameCount * 3; ++iSeek) {
+		float time = 0.0f;
+		GeomCacheData data {};
+		bool r = false;
+		size_t frameIndex = iSeek;
+		if(iSeek < frameCount) {
+			r = sequential.getData(frameIndex, time, data);
+		}
+		else {
+			frameIndex = pcg.getUint32() % frameCount;
+			random.setPinnedRange(frameIndex, 1);
+			random.prefetch(frameIndex, 1);
+			r = random.getData(frameIndex, time, data);
+		}
+
+		const std::vector<int32_t>& expected = frameIndices[frameIndex];
+		if(!r || data.indexCount != expected.size() || memcmp(data.indices, expected.data(), sizeof(int32_t) * expected.size()) != 0) {
+			ThrowError("index coding: quantisation frame %zd indices differ\n", frameIndex);
+		}
+	}
+
+	printf("index coding: quantisation file %zd bytes\n", stream.getLength());
+}
+
+void RunTest_IndexCoding()
+{
+	test0();
+	test1();
+	test2();
+}
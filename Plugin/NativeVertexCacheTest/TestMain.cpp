@@ -7,6 +7,21 @@ void RunTest_MemoryStream();
 void RunTest_FileStream();
 void RunTest_Alembic();
 void RunTest_AlembicToNvc();
+void RunTest_FrameCache();
+void RunTest_PackedTransform();
+void RunTest_Concurrency();
+void RunTest_GeomCache();
+void RunTest_Temporal();
+void RunTest_Rans();
+void RunTest_Pca();
+void RunTest_IndexCoding();
+void RunTest_VertexOrder();
+void RunTest_QuantisationPrecision();
+void RunTest_QuantisationBounds();
+void RunTest_NormalReconstruction();
+void RunTest_ConstantVertices();
+void RunTest_ParallelCompression();
+void RunTest_StreamingCompression();
 
 
 int main(int argc, char *argv[])
@@ -19,6 +34,21 @@ int main(int argc, char *argv[])
         { "+FileStream", RunTest_FileStream },
         { "Alembic", RunTest_Alembic },
         { "+AlembicToNvc", RunTest_AlembicToNvc },
+        { "+FrameCache", RunTest_FrameCache },
+        { "+PackedTransform", RunTest_PackedTransform },
+        { "Concurrency", RunTest_Concurrency },
+        { "+GeomCache", RunTest_GeomCache },
+        { "+Temporal", RunTest_Temporal },
+        { "+Rans", RunTest_Rans },
+        { "+Pca", RunTest_Pca },
+        { "+IndexCoding", RunTest_IndexCoding },
+        { "+VertexOrder", RunTest_VertexOrder },
+        { "+QuantisationPrecision", RunTest_QuantisationPrecision },
+        { "+QuantisationBounds", RunTest_QuantisationBounds },
+        { "+NormalReconstruction", RunTest_NormalReconstruction },
+        { "+ConstantVertices", RunTest_ConstantVertices },
+        { "+ParallelCompression", RunTest_ParallelCompression },
+        { "+StreamingCompression", RunTest_StreamingCompression },
 
         // If first char of the argument name is '+', it means "opt-in" option.
         // add new test here
@@ -36,6 +66,14 @@ int main(int argc, char *argv[])
 				compressionMethod = AbcToNvcCompressionMethod::Quantisation;
 				continue;
             }
+            if(_stricmp(argv[ai], "--cmp-temporal") == 0) {
+				compressionMethod = AbcToNvcCompressionMethod::Temporal;
+				continue;
+            }
+            if(_stricmp(argv[ai], "--cmp-pca") == 0) {
+				compressionMethod = AbcToNvcCompressionMethod::Pca;
+				continue;
+            }
             if(_stricmp(argv[ai], "--abc-to-nvc") == 0) {
                 return AbcToNvc(argv[ai+1], argv[ai+2], compressionMethod);
             }
@@ -46,5 +46,13 @@ void RunTest_MemoryStream()
 			, bb.data()
 			, bb.size()
 		));
+
+		// view() must alias the buffer and keep the cursor.
+		const auto position = msDst.getPosition();
+		const auto* v = static_cast<const uint8_t*>(msDst.view(16, 256));
+		assert(v == static_cast<const uint8_t*>(msDst.getBuffer()) + 16);
+		assert(0 == memcmp(v, ba.data() + 16, 256));
+		assert(msDst.getPosition() == position);
+		assert(msDst.view(msDst.getLength(), 1) == nullptr);
 	}
 }
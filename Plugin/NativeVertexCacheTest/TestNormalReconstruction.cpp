@@ -0,0 +1,355 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Stream/FileStream.h"
+#include "Plugin/Compression/NullCompressor.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/PackedTransform.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCache.h"
+#include "Plugin/OutputGeomCache.h"
+#include "Plugin/VertexNormals.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+#include <thread>
+
+using namespace nvc;
+
+namespace {
+
+float dot3(const float3& a, const float3& b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+float3 normalise3(const float3& v)
+{
+	const float length = std::sqrt(dot3(v, v));
+	return float3{ v[0] / length, v[1] / length, v[2] / length };
+}
+
+// A waving grid of side * side vertices, z = sin(x * 0.05 + phase) * cos(y * 0.05), with its exact normals
+// and tangents. mirrorU flips the u axis, the tangents then point along -x with a w of -1.
+struct WaveGrid
+{
+	WaveGrid(size_t side, bool mirrorU)
+		: side { side }
+		, mirrorU { mirrorU }
+		, points(side * side)
+		, normals(side * side)
+		, tangents(side * side)
+		, uvs(side * side)
+		, velocities(side * side, float3{ 0.0f, 0.0f, 0.0f })
+	{
+		for(size_t y = 0; y + 1 < side; ++y) {
+			for(size_t x = 0; x + 1 < side; ++x) {
+				const int32_t i = static_cast<int32_t>(y * side + x);
+				const int32_t s = static_cast<int32_t>(side);
+				indices.insert(indices.end(), { i, i + 1, i + s, i + 1, i + s + 1, i + s });
+			}
+		}
+	}
+
+	void update(float phase)
+	{
+		for(size_t y = 0; y < side; ++y) {
+			for(size_t x = 0; x < side; ++x) {
+				const size_t i = y * side + x;
+				const float fx = static_cast<float>(x);
+				const float fy = static_cast<float>(y);
+				const float dzdx = 0.05f * std::cos(fx * 0.05f + phase) * std::cos(fy * 0.05f);
+				const float dzdy = -0.05f * std::sin(fx * 0.05f + phase) * std::sin(fy * 0.05f);
+				points[i] = float3{ fx, fy, std::sin(fx * 0.05f + phase) * std::cos(fy * 0.05f) };
+				normals[i] = normalise3(float3{ -dzdx, -dzdy, 1.0f });
+
+				const float sign = mirrorU ? -1.0f : 1.0f;
+				const float3 dPdu = float3{ sign, 0.0f, sign * dzdx };
+				const float nDotT = dot3(normals[i], dPdu);
+				const float3 t = normalise3(float3{ dPdu[0] - normals[i][0] * nDotT, dPdu[1] - normals[i][1] * nDotT, dPdu[2] - normals[i][2] * nDotT });
+				tangents[i] = float4{ t[0], t[1], t[2], sign };
+
+				uvs[i] = float2{ mirrorU ? 1.0f - fx / side : fx / side, fy / side };
+			}
+		}
+	}
+
+	GeomCacheData getData()
+	{
+		vertices[0] = points.data();
+		vertices[1] = normals.data();
+		vertices[2] = tangents.data();
+		vertices[3] = uvs.data();
+		vertices[4] = uvs.data();
+		vertices[5] = velocities.data();
+
+		mesh = GeomMesh{ 0, static_cast<uint32_t>(points.size()), 0, 1 };
+		submesh = GeomSubmesh{ 0, static_cast<uint32_t>(indices.size()), Topology::Triangles };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = points.size();
+		data.meshes = &mesh;
+		data.meshCount = 1;
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		return data;
+	}
+
+	// Not on the border, where the one sided triangles don't average to the exact normal.
+	bool isInterior(size_t i) const
+	{
+		const size_t x = i % side;
+		const size_t y = i / side;
+		return x > 0 && y > 0 && x + 1 < side && y + 1 < side;
+	}
+
+	size_t side;
+	bool mirrorU;
+	std::vector<float3> points;
+	std::vector<float3> normals;
+	std::vector<float4> tangents;
+	std::vector<float2> uvs;
+	std::vector<float3> velocities;
+	std::vector<int32_t> indices;
+	void* vertices[6] {};
+	GeomMesh mesh {};
+	GeomSubmesh submesh {};
+};
+
+const GeomCacheDesc waveGridDescs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+	{ nvcSEMANTIC_TANGENTS, DataFormat::Float4 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+	{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+// Largest angle between the interior reconstructed and exact vectors, in degrees.
+template<class T>
+float getMaxAngle(const WaveGrid& grid, const std::vector<T>& exact, const T* actual)
+{
+	float minCos = 1.0f;
+	for(size_t i = 0; i < exact.size(); ++i) {
+		if(grid.isInterior(i)) {
+			const float3 a { exact[i][0], exact[i][1], exact[i][2] };
+			const float3 b { actual[i][0], actual[i][1], actual[i][2] };
+			minCos = std::min(minCos, dot3(a, b));
+		}
+	}
+	return std::acos(std::max(-1.0f, std::min(minCos, 1.0f))) * 180.0f / 3.14159265f;
+}
+
+} // namespace
+
+// The kernels against the exact normals and tangents of the grid, and the SIMD levels against each other.
+static void test0()
+{
+	for(int mirrorU = 0; mirrorU < 2; ++mirrorU) {
+		WaveGrid grid { 200, mirrorU != 0 };
+		grid.update(0.7f);
+		const GeomCacheData data = grid.getData();
+
+		VertexTriangles triangles;
+		const bool r0 = triangles.update(data);
+		assert(r0);
+		const size_t triangleCount = triangles.getTriangleCount();
+		const size_t vertexCount = triangles.getVertexCount();
+		if(triangleCount != grid.indices.size() / 3 || vertexCount != grid.points.size()) {
+			ThrowError("%zd triangles and %zd vertices instead of %zd and %zd\n", triangleCount, vertexCount, grid.indices.size() / 3, grid.points.size());
+		}
+
+		const SimdLevel supportedLevel = GetSupportedSimdLevel();
+		SetSimdLevel(SimdLevel::Scalar);
+		std::vector<float3> faceNormals(triangleCount);
+		computeFaceNormals(triangles, grid.points.data(), 0, triangleCount, faceNormals.data());
+		for(SimdLevel level : { SimdLevel::SSE41, SimdLevel::AVX2 }) {
+			if(level > supportedLevel) {
+				continue;
+			}
+			SetSimdLevel(level);
+			std::vector<float3> simdFaceNormals(triangleCount);
+			// Ragged ranges for the SIMD tails.
+			for(size_t first = 0; first < triangleCount; first += 1021) {
+				computeFaceNormals(triangles, grid.points.data(), first, std::min<size_t>(1021, triangleCount - first), simdFaceNormals.data());
+			}
+			if(memcmp(faceNormals.data(), simdFaceNormals.data(), triangleCount * sizeof(float3)) != 0) {
+				ThrowError("SIMD level %d face normals differ from the scalar ones\n", static_cast<int>(level));
+			}
+		}
+		SetSimdLevel(supportedLevel);
+
+		std::vector<float3> normals(vertexCount);
+		computeVertexNormals(triangles, faceNormals.data(), 0, vertexCount, normals.data());
+		const float normalAngle = getMaxAngle(grid, grid.normals, normals.data());
+
+		std::vector<float3> faceTangents(triangleCount);
+		std::vector<float3> faceBitangents(triangleCount);
+		computeFaceTangents(triangles, grid.points.data(), grid.uvs.data(), 0, triangleCount, faceTangents.data(), faceBitangents.data());
+		std::vector<float4> tangents(vertexCount);
+		computeVertexTangents(triangles, grid.points.data(), normals.data(), faceTangents.data(), faceBitangents.data(), 0, vertexCount, tangents.data());
+		const float tangentAngle = getMaxAngle(grid, grid.tangents, tangents.data());
+
+		for(size_t i = 0; i < vertexCount; ++i) {
+			if(tangents[i][3] != grid.tangents[i][3]) {
+				ThrowError("vertex %zd: tangent w is %f instead of %f\n", i, tangents[i][3], grid.tangents[i][3]);
+			}
+		}
+		if(normalAngle > 0.1f || tangentAngle > 0.1f) {
+			ThrowError("normals are %f and tangents %f degrees away from the exact ones\n", normalAngle, tangentAngle);
+		}
+		printf("wave grid%s: normals within %.4f, tangents within %.4f degrees\n", mirrorU ? " (mirrored u)" : "", normalAngle, tangentAngle);
+	}
+}
+
+// A file without normals and tangents plays back close to the one storing them once reconstruction is enabled,
+// parallel like serial. It's off by default.
+static void test1()
+{
+	const char* filenames[][2] = {
+		{ "../../../Data/TestOutput/WaveGrid.nvc", "../../../Data/TestOutput/WaveGrid-omitted.nvc" },
+		{ "../../../Data/TestOutput/WaveGrid.quantisation.nvc", "../../../Data/TestOutput/WaveGrid-omitted.quantisation.nvc" },
+	};
+	const size_t side = 300;
+	const size_t frameCount = 4;
+
+	for(int quantise = 0; quantise < 2; ++quantise) {
+		AutoPrepareCleanFile storedFile(filenames[quantise][0]);
+		AutoPrepareCleanFile omittedFile(filenames[quantise][1]);
+		size_t fileSizes[2] = {};
+
+		for(int omit = 0; omit < 2; ++omit) {
+			InputGeomCache igc(waveGridDescs);
+			WaveGrid grid { side, false };
+			for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+				grid.update(iFrame * 0.3f);
+				GeomCacheData data = grid.getData();
+				igc.addData(iFrame / 30.0f, &data);
+			}
+			if(omit) {
+				const bool r0 = igc.removeAttribute(nvcSEMANTIC_NORMALS);
+				const bool r1 = igc.removeAttribute(nvcSEMANTIC_TANGENTS);
+				assert(r0 && r1);
+			}
+
+			FileStream fs { filenames[quantise][omit], FileStream::OpenModes::Random_ReadWrite };
+			if(quantise) {
+				QuantisationCompressor compressor {};
+				compressor.compress(igc, &fs);
+			}
+			else {
+				NullCompressor compressor {};
+				compressor.compress(igc, &fs);
+			}
+			fileSizes[omit] = fs.getLength();
+		}
+
+		GeomCache storedCache;
+		storedCache.setAsyncPrefetch(false);
+		const auto r2 = storedCache.open(filenames[quantise][0]);
+
+		GeomCache serialCache;
+		serialCache.setAsyncPrefetch(false);
+		serialCache.setConvertGrainSize(0);
+		serialCache.setReconstructNormals(true);
+		serialCache.setReconstructTangents(true);
+		const auto r3 = serialCache.open(filenames[quantise][1]);
+
+		GeomCache parallelCache;
+		parallelCache.setAsyncPrefetch(false);
+		parallelCache.setConvertGrainSize(4099); // Ragged last task.
+		parallelCache.setReconstructNormals(true);
+		parallelCache.setReconstructTangents(true);
+		const auto r4 = parallelCache.open(filenames[quantise][1]);
+
+		GeomCache normalsCache;
+		normalsCache.setAsyncPrefetch(false);
+		normalsCache.setConvertGrainSize(4099);
+		normalsCache.setReconstructNormals(true);
+		const auto r8 = normalsCache.open(filenames[quantise][1]);
+
+		GeomCache defaultCache;
+		defaultCache.setAsyncPrefetch(false);
+		const auto r9 = defaultCache.open(filenames[quantise][1]);
+		assert(r2 && r3 && r4 && r8 && r9);
+
+		{
+			OutputGeomCache output;
+			const auto r10 = defaultCache.assignCurrentDataToMesh(output);
+			assert(r10);
+			if(!output.normals.empty() || !output.tangents.empty()) {
+				ThrowError("%s: %zd normals and %zd tangents without enabling reconstruction\n", filenames[quantise][1], output.normals.size(), output.tangents.size());
+			}
+		}
+
+		WaveGrid grid { side, false };
+		float normalAngle = 0.0f;
+		float tangentAngle = 0.0f;
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			storedCache.setCurrentFrameIndex(iFrame);
+			serialCache.setCurrentFrameIndex(iFrame);
+			parallelCache.setCurrentFrameIndex(iFrame);
+
+			OutputGeomCache stored;
+			OutputGeomCache expected;
+			OutputGeomCache actual;
+			const auto r5 = storedCache.assignCurrentDataToMesh(stored);
+			const auto r6 = serialCache.assignCurrentDataToMesh(expected);
+			const auto r7 = parallelCache.assignCurrentDataToMesh(actual);
+			assert(r5 && r6 && r7);
+
+			// Tangents need the uv0.
+			const size_t tangentCount = stored.uv0.empty() ? 0 : grid.points.size();
+			if(expected.normals.size() != grid.points.size() || expected.tangents.size() != tangentCount) {
+				ThrowError("%s: frame %zd has %zd normals and %zd tangents\n", filenames[quantise][1], iFrame, expected.normals.size(), expected.tangents.size());
+			}
+			if(memcmp(expected.normals.data(), actual.normals.data(), expected.normals.size() * sizeof(float3)) != 0
+				|| memcmp(expected.tangents.data(), actual.tangents.data(), expected.tangents.size() * sizeof(float4)) != 0) {
+				ThrowError("%s: frame %zd differs from the serial reconstruction\n", filenames[quantise][1], iFrame);
+			}
+
+			std::vector<float3> storedNormals(stored.normals.begin(), stored.normals.end());
+			std::vector<float4> storedTangents(stored.tangents.begin(), stored.tangents.end());
+			normalAngle = std::max(normalAngle, getMaxAngle(grid, storedNormals, expected.normals.data()));
+			if(tangentCount != 0) {
+				tangentAngle = std::max(tangentAngle, getMaxAngle(grid, storedTangents, expected.tangents.data()));
+			}
+			for(size_t i = 0; i < expected.tangents.size(); ++i) {
+				if(expected.tangents[i][3] != storedTangents[i][3]) {
+					ThrowError("%s: frame %zd vertex %zd has a tangent w of %f\n", filenames[quantise][1], iFrame, i, expected.tangents[i][3]);
+				}
+			}
+		}
+		if(normalAngle > 0.5f || tangentAngle > 0.5f) {
+			ThrowError("%s: normals are %f and tangents %f degrees away from the stored ones\n", filenames[quantise][1], normalAngle, tangentAngle);
+		}
+
+		// The cost of reconstruction per frame, against decoding stored normals and tangents.
+		const size_t assignCount = 10;
+		GeomCache* caches[3] = { &storedCache, &normalsCache, &parallelCache };
+		double frameMs[3] = {};
+		for(size_t iCache = 0; iCache < 3; ++iCache) {
+			OutputGeomCache output;
+			caches[iCache]->assignCurrentDataToMesh(output); // The triangles around each vertex are built once.
+			const auto t0 = GetHighResolutionClock();
+			for(size_t iAssign = 0; iAssign < assignCount; ++iAssign) {
+				caches[iCache]->assignCurrentDataToMesh(output);
+			}
+			const auto t1 = GetHighResolutionClock();
+			frameMs[iCache] = GetSeconds(t0, t1) * 1000.0 / assignCount;
+		}
+
+		printf("%s: %zd bytes instead of %zd, normals within %.4f, tangents within %.4f degrees\n"
+			, filenames[quantise][1], fileSizes[1], fileSizes[0], normalAngle, tangentAngle);
+		printf("%s: %.2f ms/frame stored, %.2f reconstructing the normals, %.2f with the tangents (%u threads)\n"
+			, filenames[quantise][1], frameMs[0], frameMs[1], frameMs[2], std::max(std::thread::hardware_concurrency(), 1u));
+	}
+}
+
+void RunTest_NormalReconstruction()
+{
+	test0();
+	test1();
+}
@@ -0,0 +1,162 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Compression/PackedTransform.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+static const char* getSimdLevelName(SimdLevel level)
+{
+	switch(level) {
+	case SimdLevel::AVX2: return "AVX2";
+	case SimdLevel::SSE41: return "SSE4.1";
+	default: return "Scalar";
+	}
+}
+
+// Random packed data, the counts are not multiples of the SIMD widths so the tails are covered too.
+static void makePackedData(size_t count, std::vector<unorm16x3>& points, std::vector<unorm16x2>& normals)
+{
+	Pcg pcg(123, 456);
+	points.resize(count);
+	normals.resize(count);
+	for(size_t i = 0; i < count; ++i) {
+		for(int k = 0; k < 3; ++k) {
+			points[i][k].data = static_cast<uint16_t>(pcg.getUint32());
+		}
+		for(int k = 0; k < 2; ++k) {
+			normals[i][k].data = static_cast<uint16_t>(pcg.getUint32());
+		}
+	}
+	// The octahedron edges and corners.
+	const uint16_t edges[] = { 0, 32767, 32768, 65535 };
+	for(size_t i = 0; i < 16 && i < count; ++i) {
+		normals[i][0].data = edges[i % 4];
+		normals[i][1].data = edges[i / 4];
+	}
+}
+
+// Every SIMD level matches the scalar kernels, and the scalar kernels match the per element functions.
+static void test0()
+{
+	const size_t count = 1003;
+	const AABB aabb(float3{ -10.0f, 2.0f, 0.5f }, float3{ 20.0f, 0.001f, 300.0f });
+
+	std::vector<unorm16x3> packedPoints;
+	std::vector<unorm16x2> packedNormals;
+	makePackedData(count, packedPoints, packedNormals);
+
+	const SimdLevel supportedLevel = GetSupportedSimdLevel();
+
+	SetSimdLevel(SimdLevel::Scalar);
+	std::vector<float3> scalarPoints(count), scalarNormals(count);
+	std::vector<float4> scalarTangents(count);
+	std::vector<float> scalarUnorms(count * 3);
+	UnpackPoints(aabb, packedPoints.data(), scalarPoints.data(), count);
+	OctDecodeArray(packedNormals.data(), scalarNormals.data(), count);
+	OctDecodeArray(packedNormals.data(), scalarTangents.data(), count);
+	UnpackUnorm16Array(&packedPoints[0][0], scalarUnorms.data(), count * 3);
+
+	for(size_t i = 0; i < count; ++i) {
+		const float3 point = UnpackPoint(aabb, packedPoints[i]);
+		float2 oct; oct[0] = packedNormals[i][0].to_float(); oct[1] = packedNormals[i][1].to_float();
+		const float3 normal = OctDecode(oct);
+		for(int k = 0; k < 3; ++k) {
+			if(!NearEqual(point[k], scalarPoints[i][k], 1e-4f) || !NearEqual(normal[k], scalarNormals[i][k], 1e-5f)) {
+				ThrowError("scalar kernel mismatch at %zd\n", i);
+			}
+		}
+		if(scalarTangents[i][3] != 1.0f || !NearEqual(scalarUnorms[i * 3], packedPoints[i][0].to_float(), 1e-6f)) {
+			ThrowError("scalar kernel mismatch at %zd\n", i);
+		}
+	}
+
+	for(SimdLevel level : { SimdLevel::SSE41, SimdLevel::AVX2 }) {
+		if(level > supportedLevel) {
+			printf("packed transform: %s not supported\n", getSimdLevelName(level));
+			continue;
+		}
+		SetSimdLevel(level);
+
+		std::vector<float3> points(count), normals(count);
+		std::vector<float4> tangents(count);
+		std::vector<float> unorms(count * 3);
+		UnpackPoints(aabb, packedPoints.data(), points.data(), count);
+		OctDecodeArray(packedNormals.data(), normals.data(), count);
+		OctDecodeArray(packedNormals.data(), tangents.data(), count);
+		UnpackUnorm16Array(&packedPoints[0][0], unorms.data(), count * 3);
+
+		for(size_t i = 0; i < count; ++i) {
+			for(int k = 0; k < 3; ++k) {
+				if(!NearEqual(points[i][k], scalarPoints[i][k], 1e-6f)
+					|| !NearEqual(normals[i][k], scalarNormals[i][k], 1e-6f)
+					|| !NearEqual(tangents[i][k], scalarTangents[i][k], 1e-6f)
+					|| !NearEqual(unorms[i * 3 + k], scalarUnorms[i * 3 + k], 1e-6f)) {
+					ThrowError("%s kernel mismatch at %zd\n", getSimdLevelName(level), i);
+				}
+			}
+			if(tangents[i][3] != 1.0f) {
+				ThrowError("%s kernel mismatch at %zd\n", getSimdLevelName(level), i);
+			}
+		}
+		printf("packed transform: %s matches scalar\n", getSimdLevelName(level));
+	}
+
+	SetSimdLevel(supportedLevel);
+}
+
+// Throughput of the batch kernels at each level against the per element loop they replace.
+static void test1()
+{
+	const size_t count = 100000;
+	const size_t passCount = 50;
+	const AABB aabb(float3{ -10.0f, 2.0f, 0.5f }, float3{ 20.0f, 0.001f, 300.0f });
+
+	std::vector<unorm16x3> packedPoints;
+	std::vector<unorm16x2> packedNormals;
+	makePackedData(count, packedPoints, packedNormals);
+	std::vector<float3> points(count), normals(count);
+
+	const auto measure = [&](const char* name, const std::function<void()>& decode) {
+		decode();
+		const auto t0 = std::chrono::high_resolution_clock::now();
+		for(size_t iPass = 0; iPass < passCount; ++iPass) {
+			decode();
+		}
+		const auto t1 = std::chrono::high_resolution_clock::now();
+		const double seconds = std::chrono::duration<double>(t1 - t0).count();
+		printf("%-8s: %8.1f M vertices/s (checksum %f)\n", name, count * passCount / seconds * 1e-6, points[count / 2][0] + normals[count / 2][2]);
+	};
+
+	measure("loop", [&]() {
+		for(size_t i = 0; i < count; ++i) {
+			points[i] = UnpackPoint(aabb, packedPoints[i]);
+		}
+		for(size_t i = 0; i < count; ++i) {
+			float2 oct; oct[0] = packedNormals[i][0].to_float(); oct[1] = packedNormals[i][1].to_float();
+			normals[i] = OctDecode(oct);
+		}
+	});
+
+	const SimdLevel supportedLevel = GetSupportedSimdLevel();
+	for(SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 }) {
+		if(level > supportedLevel) {
+			continue;
+		}
+		SetSimdLevel(level);
+		measure(getSimdLevelName(level), [&]() {
+			UnpackPoints(aabb, packedPoints.data(), points.data(), count);
+			OctDecodeArray(packedNormals.data(), normals.data(), count);
+		});
+	}
+
+	SetSimdLevel(supportedLevel);
+}
+
+void RunTest_PackedTransform()
+{
+	test0();
+	test1();
+}
@@ -0,0 +1,179 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Concurrency.h"
+#include "Plugin/Compression/NullCompressor.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+#include <thread>
+
+using namespace nvc;
+
+static const GeomCacheDesc parallelDescs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	{ nvcSEMANTIC_COLORS, DataFormat::Float4 },
+	{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+// A waving cloth and a second grid which loses its last row of triangles every 7 frames, so the topology
+// is shared by some frames of a seek window and not by others.
+static void makeParallelScene(InputGeomCache& igc, size_t side, size_t frameCount)
+{
+	const size_t clothVertexCount = side * side;
+	const size_t vertexCount = 2 * clothVertexCount;
+	const int32_t w = static_cast<int32_t>(side);
+
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		std::vector<int32_t> indices;
+		for(size_t iMesh = 0; iMesh < 2; ++iMesh) {
+			const size_t rowCount = iMesh == 1 && (iFrame / 7) % 2 == 1 ? side - 2 : side - 1;
+			for(size_t y = 0; y < rowCount; ++y) {
+				for(size_t x = 0; x + 1 < side; ++x) {
+					const int32_t v = static_cast<int32_t>(iMesh * clothVertexCount + y * side + x);
+					indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+				}
+			}
+		}
+		const uint32_t clothIndexCount = static_cast<uint32_t>(6 * (side - 1) * (side - 1));
+
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount);
+		std::vector<float2> uv0(vertexCount);
+		std::vector<float4> colors(vertexCount);
+		std::vector<float3> velocities(vertexCount);
+		for(size_t i = 0; i < vertexCount; ++i) {
+			const size_t j = i % clothVertexCount;
+			const float u = static_cast<float>(j % side) / side;
+			const float v = static_cast<float>(j / side) / side;
+			const float phase = u * 6.0f + v * 3.0f + iFrame * 0.25f + (i < clothVertexCount ? 0.0f : 1.0f);
+			points[i] = float3{ u + (i < clothVertexCount ? 0.0f : 1.5f), v, 0.1f * std::sin(phase) };
+			const float slope = 0.6f * std::cos(phase);
+			const float length = std::sqrt(slope * slope + 1.0f);
+			normals[i] = float3{ -slope / length, 0.0f, 1.0f / length };
+			uv0[i] = float2{ u, v };
+			colors[i] = float4{ u, v, 0.5f + 0.5f * std::sin(phase), 1.0f };
+			velocities[i] = float3{ 0.0f, 0.0f, 0.75f * std::cos(phase) };
+		}
+
+		void* vertices[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {
+			points.data(), normals.data(), uv0.data(), colors.data(), velocities.data()
+		};
+		GeomMesh meshes[2] = {
+			{ 0, static_cast<uint32_t>(clothVertexCount), 0, 1 },
+			{ static_cast<uint32_t>(clothVertexCount), static_cast<uint32_t>(clothVertexCount), 1, 1 },
+		};
+		GeomSubmesh submeshes[2] = {
+			{ 0, clothIndexCount, Topology::Triangles },
+			{ clothIndexCount, static_cast<uint32_t>(indices.size()) - clothIndexCount, Topology::Triangles },
+		};
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = meshes;
+		data.meshCount = 2;
+		data.submeshes = submeshes;
+		data.submeshCount = 2;
+		igc.addData(iFrame / 30.0f, &data);
+	}
+}
+
+static bool isSameReport(const QuantisationReport& lhs, const QuantisationReport& rhs)
+{
+	const QuantisationError* l = &lhs.Points;
+	const QuantisationError* r = &rhs.Points;
+	for(size_t i = 0; i < sizeof(QuantisationReport) / sizeof(QuantisationError); ++i) {
+		if(l[i].Bits != r[i].Bits || l[i].MaxError != r[i].MaxError || l[i].RmsError != r[i].RmsError) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static std::vector<uint8_t> compressToBytes(ICompressor& compressor, const InputGeomCache& igc, double& framesPerSecond)
+{
+	MemoryStream stream;
+	const auto t0 = std::chrono::high_resolution_clock::now();
+	compressor.compress(igc, &stream);
+	const auto t1 = std::chrono::high_resolution_clock::now();
+	framesPerSecond = igc.getDataCount() / std::chrono::duration<double>(t1 - t0).count();
+
+	const uint8_t* begin = static_cast<const uint8_t*>(stream.getBuffer());
+	return std::vector<uint8_t>(begin, begin + stream.getLength());
+}
+
+// Frames encoded in parallel give the file, and the quantisation report, of the serial encoding.
+static void test0()
+{
+	const size_t side = 96;
+	const size_t frameCount = 95; // Not a multiple of the seek window.
+	InputGeomCache igc { parallelDescs };
+	makeParallelScene(igc, side, frameCount);
+
+	QuantisationSettings packed;
+	packed.PointBits = 11;
+	packed.NormalBits = 10;
+	packed.BoundsBlockSize = 1024;
+
+	struct Case
+	{
+		const char* name;
+		bool isQuantised;
+		bool isEntropyCoded;
+		QuantisationSettings settings;
+	};
+	const Case cases[] = {
+		{ "null", false, false, QuantisationSettings{} },
+		{ "quantisation", true, false, QuantisationSettings{} },
+		{ "quantisation 11 bits, rans", true, true, packed },
+	};
+
+	printf("parallel compression (%u hardware threads), %zd frames of %zd vertices\n"
+		, std::thread::hardware_concurrency(), frameCount, 2 * side * side);
+	for(const Case& c : cases) {
+		std::vector<uint8_t> bytes[2];
+		QuantisationReport reports[2];
+		double framesPerSecond[2] = {};
+		for(int parallel = 0; parallel < 2; ++parallel) {
+#if defined(NVC_ENABLE_THREAD_POOL)
+			// Some workers even on a single core, so frames are encoded out of order.
+			thread_pool::set_worker_count(parallel ? std::max(std::thread::hardware_concurrency(), 4u) - 1 : 0);
+#endif
+			if(c.isQuantised) {
+				QuantisationCompressor compressor { c.isEntropyCoded, c.settings };
+				bytes[parallel] = compressToBytes(compressor, igc, framesPerSecond[parallel]);
+				reports[parallel] = compressor.getReport();
+			}
+			else {
+				NullCompressor compressor {};
+				bytes[parallel] = compressToBytes(compressor, igc, framesPerSecond[parallel]);
+			}
+		}
+
+		printf("  %-28s %8zd bytes, serial %7.1f frames/s, parallel %7.1f frames/s\n"
+			, c.name, bytes[0].size(), framesPerSecond[0], framesPerSecond[1]);
+		if(bytes[0] != bytes[1]) {
+			ThrowError("parallel compression: the %s file differs from the serial one\n", c.name);
+		}
+		if(!isSameReport(reports[0], reports[1])) {
+			ThrowError("parallel compression: the %s report differs from the serial one\n", c.name);
+		}
+	}
+
+#if defined(NVC_ENABLE_THREAD_POOL)
+	thread_pool::set_worker_count(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+#endif
+}
+
+void RunTest_ParallelCompression()
+{
+	test0();
+}
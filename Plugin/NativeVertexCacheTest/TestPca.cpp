@@ -0,0 +1,264 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/Compression/PackedTransform.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/PcaCompressor.h"
+#include "Plugin/Compression/PcaDecompressor.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+static const GeomCacheDesc s_ClothDescs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+	{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+static float3 getClothPoint(size_t x, size_t y, size_t frameIndex)
+{
+	const float fx = static_cast<float>(x);
+	const float fy = static_cast<float>(y);
+	const float t = static_cast<float>(frameIndex);
+	return float3{ fx + 0.3f * std::sin(fy * 0.2f + t * 0.05f), fy, 2.0f * std::sin(fx * 0.1f + t * 0.07f) * std::cos(fy * 0.1f) };
+}
+
+static float3 getClothNormal(size_t x, size_t y, size_t frameIndex)
+{
+	const float dz = 0.2f * std::cos(x * 0.1f + frameIndex * 0.07f) * std::cos(y * 0.1f);
+	const float length = std::sqrt(dz * dz + 1.0f);
+	return float3{ -dz / length, 0.0f, 1.0f / length };
+}
+
+// A sheet of side * side vertices waving a little every frame. From frame resizeFrame on, it's one vertex wider.
+static void makeClothCache(InputGeomCache& igc, size_t side, size_t frameCount, size_t resizeFrame = ~size_t(0))
+{
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		const size_t width = iFrame < resizeFrame ? side : side + 1;
+		const size_t vertexCount = width * side;
+
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount);
+		std::vector<float2> uvs(vertexCount);
+		std::vector<float2> uv1s(vertexCount, float2{ 0.0f, 0.0f });
+		std::vector<float3> velocities(vertexCount, float3{ 0.0f, 0.0f, 0.0f });
+		std::vector<int32_t> indices;
+		for(size_t y = 0; y < side; ++y) {
+			for(size_t x = 0; x < width; ++x) {
+				const size_t i = y * width + x;
+				points[i] = getClothPoint(x, y, iFrame);
+				normals[i] = getClothNormal(x, y, iFrame);
+				uvs[i] = float2{ static_cast<float>(x) / width, static_cast<float>(y) / side };
+
+				if(x + 1 < width && y + 1 < side) {
+					const int32_t w = static_cast<int32_t>(width);
+					const int32_t v = static_cast<int32_t>(i);
+					indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+				}
+			}
+		}
+		void* vertices[5] = { points.data(), normals.data(), uvs.data(), uv1s.data(), velocities.data() };
+
+		GeomMesh mesh = { 0, static_cast<uint32_t>(vertexCount), 0, 1 };
+		GeomSubmesh submesh = { 0, static_cast<uint32_t>(indices.size()), Topology::Triangles };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = &mesh;
+		data.meshCount = 1;
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		igc.addData(iFrame / 30.0f, &data);
+	}
+}
+
+// Attribute of a loaded frame, reconstructed or as stored.
+template<class T>
+static std::vector<T> decodeAttribute(IDecompressor& decompressor, size_t frameIndex, const char* semantic)
+{
+	float time = 0.0f;
+	GeomCacheData data {};
+	const auto r = decompressor.getData(frameIndex, time, data);
+	assert(r);
+
+	const int iAttribute = getAttributeIndex(decompressor.getDescriptors(), semantic);
+	std::vector<T> values(data.vertexCount);
+	if(!decompressor.decodeAttribute(frameIndex, data, iAttribute, 0, data.vertexCount, values.data())) {
+		memcpy(values.data(), data.vertices[iAttribute], sizeof(T) * data.vertexCount);
+	}
+	return values;
+}
+
+// Reconstructed points and normals stay within the requested RMS error, random access decodes the same frames
+// as playback, and a sequence whose vertex count changes is stored raw.
+static void test0()
+{
+	const size_t side = 40;
+	const size_t frameCount = 120;
+	const float maxRelativeError = 1e-4f;
+
+	for(size_t resizeFrame : { ~size_t(0), size_t(70) }) {
+		InputGeomCache igc(s_ClothDescs);
+		makeClothCache(igc, side, frameCount, resizeFrame);
+
+		MemoryStream quantisationStream(0, true);
+		MemoryStream pcaStream(0, true);
+		{
+			QuantisationCompressor quantisationCompressor {};
+			quantisationCompressor.compress(igc, &quantisationStream);
+			PcaCompressor pcaCompressor(maxRelativeError);
+			pcaCompressor.compress(igc, &pcaStream);
+		}
+		pcaStream.seek(0, Stream::SeekOrigin::Begin);
+
+		PcaDecompressor playback;
+		playback.open(&pcaStream);
+		playback.prefetch(0, frameCount);
+
+		// RMS and largest error over every value of the sequence. The sheet is side wide, its normals 1 long.
+		double squaredErrors[2] = {};
+		float maxErrors[2] = {};
+		size_t valueCount = 0;
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			const size_t width = iFrame < resizeFrame ? side : side + 1;
+			const std::vector<float3> points = decodeAttribute<float3>(playback, iFrame, nvcSEMANTIC_POINTS);
+			const std::vector<float3> normals = decodeAttribute<float3>(playback, iFrame, nvcSEMANTIC_NORMALS);
+			const std::vector<float2> uvs = decodeAttribute<float2>(playback, iFrame, nvcSEMANTIC_UV0);
+			assert(points.size() == width * side);
+
+			for(size_t y = 0; y < side; ++y) {
+				for(size_t x = 0; x < width; ++x) {
+					const size_t i = y * width + x;
+					const float3 expectedPoint = getClothPoint(x, y, iFrame);
+					const float3 expectedNormal = getClothNormal(x, y, iFrame);
+					for(int k = 0; k < 3; ++k) {
+						const float pointError = std::fabs(points[i][k] - expectedPoint[k]);
+						const float normalError = std::fabs(normals[i][k] - expectedNormal[k]);
+						squaredErrors[0] += pointError * pointError;
+						squaredErrors[1] += normalError * normalError;
+						maxErrors[0] = std::max(maxErrors[0], pointError);
+						maxErrors[1] = std::max(maxErrors[1], normalError);
+					}
+					if(!NearEqual(uvs[i][0], static_cast<float>(x) / width, 1e-4f) || !NearEqual(uvs[i][1], static_cast<float>(y) / side, 1e-4f)) {
+						ThrowError("resize %zd: frame %zd vertex %zd has a wrong uv\n", resizeFrame, iFrame, i);
+					}
+				}
+			}
+			valueCount += points.size() * 3;
+		}
+
+		// The truncation error is within the bound, quantising the basis adds a little.
+		const float rmsErrors[2] = { static_cast<float>(std::sqrt(squaredErrors[0] / valueCount)), static_cast<float>(std::sqrt(squaredErrors[1] / valueCount)) };
+		const float extents[2] = { static_cast<float>(side), 1.0f };
+		for(int iAttribute = 0; iAttribute < 2; ++iAttribute) {
+			if(rmsErrors[iAttribute] > 1.5f * maxRelativeError * extents[iAttribute]) {
+				ThrowError("resize %zd: RMS error %g of %s is over the bound\n", resizeFrame, rmsErrors[iAttribute], iAttribute == 0 ? "points" : "normals");
+			}
+		}
+
+		// Random order with a small cache.
+		PcaDecompressor random;
+		random.setCacheBudget(1);
+		pcaStream.seek(0, Stream::SeekOrigin::Begin);
+		random.open(&pcaStream);
+
+		Pcg pcg(123, 456);
+		for(size_t iSeek = 0; iSeek < frameCount * 2; ++iSeek) {
+			const size_t frameIndex = pcg.getUint32() % frameCount;
+			random.setPinnedRange(frameIndex, 1);
+			random.prefetch(frameIndex, 1);
+
+			float time = 0.0f;
+			GeomCacheData expected {};
+			GeomCacheData actual {};
+			const auto r0 = playback.getData(frameIndex, time, expected);
+			const auto r1 = random.getData(frameIndex, time, actual);
+			assert(r0 && r1);
+			const std::vector<float3> expectedPoints = decodeAttribute<float3>(playback, frameIndex, nvcSEMANTIC_POINTS);
+			const std::vector<float3> actualPoints = decodeAttribute<float3>(random, frameIndex, nvcSEMANTIC_POINTS);
+			if(expected.indexCount != actual.indexCount || memcmp(expected.indices, actual.indices, sizeof(int32_t) * actual.indexCount) != 0
+				|| expectedPoints.size() != actualPoints.size() || memcmp(expectedPoints.data(), actualPoints.data(), sizeof(float3) * actualPoints.size()) != 0) {
+				ThrowError("resize %zd: frame %zd decodes differently out of order\n", resizeFrame, frameIndex);
+			}
+		}
+
+		printf("pca: resize at %3zd, %zd bytes (quantisation %zd bytes, x%.2f), RMS error points %g normals %g, max %g %g\n"
+			, resizeFrame == ~size_t(0) ? 0 : resizeFrame, pcaStream.getLength(), quantisationStream.getLength()
+			, static_cast<double>(quantisationStream.getLength()) / pcaStream.getLength()
+			, rmsErrors[0], rmsErrors[1], maxErrors[0], maxErrors[1]);
+		if(resizeFrame == ~size_t(0)) {
+			assert(pcaStream.getLength() * 4 < quantisationStream.getLength());
+		}
+		else if(maxErrors[0] != 0.0f || maxErrors[1] != 0.0f) {
+			ThrowError("resize %zd: a sequence stored raw doesn't decode exactly\n", resizeFrame);
+		}
+	}
+}
+
+// Size, compression time and reconstruction throughput at each SIMD level.
+static void test1()
+{
+	const size_t side = 300;
+	const size_t frameCount = 300;
+
+	InputGeomCache igc(s_ClothDescs);
+	makeClothCache(igc, side, frameCount);
+
+	MemoryStream quantisationStream(0, true);
+	MemoryStream pcaStream(0, true);
+	QuantisationCompressor quantisationCompressor {};
+	quantisationCompressor.compress(igc, &quantisationStream);
+
+	const auto t0 = std::chrono::high_resolution_clock::now();
+	PcaCompressor pcaCompressor {};
+	pcaCompressor.compress(igc, &pcaStream);
+	const auto t1 = std::chrono::high_resolution_clock::now();
+	printf("pca: %zd bytes (quantisation %zd bytes, x%.2f), compressed in %.2f s\n", pcaStream.getLength(), quantisationStream.getLength()
+		, static_cast<double>(quantisationStream.getLength()) / pcaStream.getLength(), std::chrono::duration<double>(t1 - t0).count());
+
+	pcaStream.seek(0, Stream::SeekOrigin::Begin);
+	PcaDecompressor decompressor;
+	decompressor.open(&pcaStream);
+	decompressor.prefetch(0, frameCount);
+
+	const GeomCacheDesc* descs = decompressor.getDescriptors();
+	std::vector<float> dst(side * side * 4);
+	const SimdLevel supportedLevel = GetSupportedSimdLevel();
+	for(SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 }) {
+		if(level > supportedLevel) {
+			continue;
+		}
+		SetSimdLevel(level);
+
+		const auto t2 = std::chrono::high_resolution_clock::now();
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			float time = 0.0f;
+			GeomCacheData data {};
+			const auto r = decompressor.getData(iFrame, time, data);
+			assert(r);
+			for(size_t iAttribute = 0; iAttribute < getAttributeCount(descs); ++iAttribute) {
+				decompressor.decodeAttribute(iFrame, data, iAttribute, 0, data.vertexCount, dst.data());
+			}
+		}
+		const auto t3 = std::chrono::high_resolution_clock::now();
+		printf("pca: %-6s %6.2f ms/frame\n", level == SimdLevel::AVX2 ? "AVX2" : level == SimdLevel::SSE41 ? "SSE4.1" : "Scalar"
+			, std::chrono::duration<double, std::milli>(t3 - t2).count() / frameCount);
+	}
+	SetSimdLevel(supportedLevel);
+}
+
+void RunTest_Pca()
+{
+	test0();
+	test1();
+}
@@ -0,0 +1,213 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/QuantisationDecompressor.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+#include <cfloat>
+
+using namespace nvc;
+
+static const GeomCacheDesc boundsDescs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+	{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+// A small prop spinning over a large rolling terrain, the prop's vertices first.
+struct PropScene {
+	size_t propVertexCount;
+	size_t vertexCount;
+	std::vector<std::vector<float3>> points;
+};
+
+static void appendGrid(std::vector<int32_t>& indices, size_t side, int32_t firstVertex)
+{
+	const int32_t w = static_cast<int32_t>(side);
+	for(size_t y = 0; y + 1 < side; ++y) {
+		for(size_t x = 0; x + 1 < side; ++x) {
+			const int32_t v = firstVertex + static_cast<int32_t>(y * side + x);
+			indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+		}
+	}
+}
+
+static PropScene makePropScene(InputGeomCache& igc, size_t frameCount)
+{
+	const size_t propSide = 12;
+	const size_t terrainSide = 80;
+
+	PropScene scene;
+	scene.propVertexCount = propSide * propSide;
+	scene.vertexCount = scene.propVertexCount + terrainSide * terrainSide;
+
+	std::vector<int32_t> indices;
+	appendGrid(indices, propSide, 0);
+	const uint32_t propIndexCount = static_cast<uint32_t>(indices.size());
+	appendGrid(indices, terrainSide, static_cast<int32_t>(scene.propVertexCount));
+
+	std::vector<float2> uvs(scene.vertexCount, float2{ 0.0f, 0.0f });
+	std::vector<float3> velocities(scene.vertexCount, float3{ 0.0f, 0.0f, 0.0f });
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		std::vector<float3> points(scene.vertexCount);
+
+		// The prop is 0.2 units wide, 300 units away from the terrain's origin.
+		const float angle = iFrame * 0.2f;
+		for(size_t i = 0; i < scene.propVertexCount; ++i) {
+			const float x = (static_cast<float>(i % propSide) - propSide * 0.5f) * 0.02f;
+			const float y = (static_cast<float>(i / propSide) - propSide * 0.5f) * 0.02f;
+			points[i] = float3{ 300.0f + x * std::cos(angle) - y * std::sin(angle), 5.0f + x * std::sin(angle) + y * std::cos(angle), 2.0f };
+		}
+
+		// The terrain is 400 units wide, its heights roll by.
+		for(size_t i = 0; i < terrainSide * terrainSide; ++i) {
+			const float x = static_cast<float>(i % terrainSide) * 5.0f;
+			const float y = static_cast<float>(i / terrainSide) * 5.0f;
+			const float phase = x * 0.02f + y * 0.01f + iFrame * 0.1f;
+			points[scene.propVertexCount + i] = float3{ x, y, 20.0f * std::sin(phase) };
+		}
+		void* vertices[4] = { points.data(), uvs.data(), uvs.data(), velocities.data() };
+
+		GeomMesh meshes[2] = {
+			{ 0, static_cast<uint32_t>(scene.propVertexCount), 0, 1 },
+			{ static_cast<uint32_t>(scene.propVertexCount), static_cast<uint32_t>(terrainSide * terrainSide), 1, 1 },
+		};
+		GeomSubmesh submeshes[2] = {
+			{ 0, propIndexCount, Topology::Triangles },
+			{ propIndexCount, static_cast<uint32_t>(indices.size()) - propIndexCount, Topology::Triangles },
+		};
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = scene.vertexCount;
+		data.meshes = meshes;
+		data.meshCount = 2;
+		data.submeshes = submeshes;
+		data.submeshCount = 2;
+		igc.addData(iFrame / 30.0f, &data);
+
+		scene.points.push_back(std::move(points));
+	}
+	return scene;
+}
+
+static float getMaxDistance(const float3* a, const float3* b, size_t count)
+{
+	float maxDistance = 0.0f;
+	for(size_t i = 0; i < count; ++i) {
+		float squared = 0.0f;
+		for(size_t c = 0; c < 3; ++c) {
+			squared += (a[i][c] - b[i][c]) * (a[i][c] - b[i][c]);
+		}
+		maxDistance = std::max(maxDistance, std::sqrt(squared));
+	}
+	return maxDistance;
+}
+
+// Per mesh bounds keep a small prop as precise as if it was alone, blocks tighten large meshes further,
+// and any range of vertices decodes the same as the whole frame.
+static void test0()
+{
+	const size_t frameCount = 10;
+
+	InputGeomCache igc(boundsDescs);
+	const PropScene scene = makePropScene(igc, frameCount);
+
+	struct Case {
+		const char* name;
+		uint32_t bits;
+		uint32_t blockSize;
+	};
+	const Case cases[] = {
+		{ "per mesh", 16, 0 },
+		{ "per mesh", 10, 0 },
+		{ "blocks 1024", 10, 1024 },
+		{ "blocks 64", 10, 64 },
+	};
+
+	// Bounds of the whole frame would leave the prop with about the terrain's quantisation step.
+	const float propTolerance = 0.2f * 2.0f / 1024.0f;
+	float lastTerrainError = FLT_MAX;
+	for(const auto& c : cases) {
+		QuantisationSettings settings;
+		settings.PointBits = c.bits;
+		settings.BoundsBlockSize = c.blockSize;
+
+		MemoryStream stream(0, true);
+		QuantisationCompressor compressor(true, settings);
+		compressor.compress(igc, &stream);
+		const QuantisationReport& report = compressor.getReport();
+
+		stream.seek(0, Stream::SeekOrigin::Begin);
+		quantisation_compression::FileHeader header {};
+		stream.read(&header, sizeof(header));
+		if((header.Flags & quantisation_compression::FILE_FLAG_BOUNDS_RANGES) == 0) {
+			ThrowError("quantisation bounds: %s, no bounds ranges flag\n", c.name);
+		}
+		stream.seek(0, Stream::SeekOrigin::Begin);
+
+		QuantisationDecompressor decompressor;
+		decompressor.setCacheBudget(1);
+		decompressor.open(&stream);
+
+		Pcg pcg(123, 456);
+		float propError = 0.0f;
+		float terrainError = 0.0f;
+		std::vector<float3> points(scene.vertexCount);
+		std::vector<float3> part(scene.vertexCount);
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			decompressor.setPinnedRange(iFrame, 1);
+			decompressor.prefetch(iFrame, 1);
+
+			float time = 0.0f;
+			GeomCacheData data {};
+			if(!decompressor.getData(iFrame, time, data) || data.vertexCount != scene.vertexCount
+				|| !decompressor.decodeAttribute(iFrame, data, 0, 0, scene.vertexCount, points.data())) {
+				ThrowError("quantisation bounds: %s, frame %zd isn't decoded\n", c.name, iFrame);
+			}
+
+			const float3* inputPoints = scene.points[iFrame].data();
+			propError = std::max(propError, getMaxDistance(points.data(), inputPoints, scene.propVertexCount));
+			terrainError = std::max(terrainError, getMaxDistance(points.data() + scene.propVertexCount
+				, inputPoints + scene.propVertexCount, scene.vertexCount - scene.propVertexCount));
+
+			// Ranges of vertices starting and ending anywhere, across meshes and blocks.
+			for(size_t iRange = 0; iRange < 20; ++iRange) {
+				const size_t first = pcg.getUint32() % scene.vertexCount;
+				const size_t count = pcg.getUint32() % (scene.vertexCount - first + 1);
+				if(!decompressor.decodeAttribute(iFrame, data, 0, first, count, part.data())
+					|| memcmp(part.data(), points.data() + first, sizeof(float3) * count) != 0) {
+					ThrowError("quantisation bounds: %s, frame %zd vertices [%zd, %zd) differ\n", c.name, iFrame, first, first + count);
+				}
+			}
+		}
+
+		if(std::abs(std::max(propError, terrainError) - report.Points.MaxError) > 1e-4f * (1.0f + report.Points.MaxError)) {
+			ThrowError("quantisation bounds: %s, decoded error %g, reported %g\n", c.name
+				, std::max(propError, terrainError), report.Points.MaxError);
+		}
+		if(propError > propTolerance) {
+			ThrowError("quantisation bounds: %s, prop error %g isn't relative to its own bounds\n", c.name, propError);
+		}
+		if(c.bits == 10 && terrainError > lastTerrainError) {
+			ThrowError("quantisation bounds: %s, smaller blocks increase the terrain error to %g\n", c.name, terrainError);
+		}
+		lastTerrainError = c.bits == 10 ? terrainError : lastTerrainError;
+
+		printf("quantisation bounds: %-11s %2u bits %7zd bytes, prop max %.2e, terrain max %.2e\n"
+			, c.name, c.bits, stream.getLength(), propError, terrainError);
+	}
+}
+
+void RunTest_QuantisationBounds()
+{
+	test0();
+}
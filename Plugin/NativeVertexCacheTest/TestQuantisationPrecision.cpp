@@ -0,0 +1,258 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Compression/PackedTransform.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/QuantisationDecompressor.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+// Bit packing round trips at every width, and expands to unorm16 from 0 to 65535.
+static void test0()
+{
+	Pcg pcg(123, 456);
+	for(uint32_t bits = 1; bits < 16; ++bits) {
+		const uint16_t maxValue = static_cast<uint16_t>((1u << bits) - 1);
+		if(ExpandToUnorm16(0, bits) != 0 || ExpandToUnorm16(maxValue, bits) != 0xFFFF) {
+			ThrowError("quantisation precision: %u bits don't expand to the unorm16 range\n", bits);
+		}
+		if(QuantiseUnorm(-1.0f, bits) != 0 || QuantiseUnorm(2.0f, bits) != maxValue || QuantiseUnorm(NAN, bits) != 0) {
+			ThrowError("quantisation precision: %u bits aren't clamped\n", bits);
+		}
+
+		for(size_t count : { 0, 1, 7, 8, 1001 }) {
+			std::vector<uint16_t> values(count);
+			for(auto& value : values) {
+				value = static_cast<uint16_t>(pcg.getUint32() & maxValue);
+			}
+
+			// The byte past the packing stays untouched.
+			const size_t packedSize = GetBitPackedSize(count, bits);
+			std::vector<uint8_t> packed(packedSize + 1, 0xCD);
+			PackBits(values.data(), count, bits, packed.data());
+			if(packed[packedSize] != 0xCD) {
+				ThrowError("quantisation precision: %u bits pack past their size\n", bits);
+			}
+
+			std::vector<unorm16> unpacked(count);
+			UnpackBitsToUnorm16(packed.data(), count, bits, unpacked.data());
+			for(size_t i = 0; i < count; ++i) {
+				const double expected = values[i] * 65535.0 / maxValue;
+				if(unpacked[i].data != ExpandToUnorm16(values[i], bits) || std::abs(unpacked[i].data - expected) >= 1.0) {
+					ThrowError("quantisation precision: %u bits, value %zd differs\n", bits, i);
+				}
+			}
+		}
+	}
+}
+
+static const GeomCacheDesc descs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+	{ nvcSEMANTIC_TANGENTS, DataFormat::Float4 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+	{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+// A waving grid of side * side vertices, side units wide.
+struct WaveFrames {
+	std::vector<std::vector<float3>> points;
+	std::vector<std::vector<float3>> normals;
+	std::vector<std::vector<float4>> tangents;
+};
+
+static WaveFrames makeWaveCache(InputGeomCache& igc, size_t side, size_t frameCount)
+{
+	WaveFrames frames;
+	const size_t vertexCount = side * side;
+	std::vector<float2> uvs(vertexCount, float2{ 0.0f, 0.0f });
+	std::vector<float3> velocities(vertexCount, float3{ 0.0f, 0.0f, 0.0f });
+	std::vector<int32_t> indices;
+	for(size_t y = 0; y + 1 < side; ++y) {
+		for(size_t x = 0; x + 1 < side; ++x) {
+			const int32_t v = static_cast<int32_t>(y * side + x);
+			const int32_t w = static_cast<int32_t>(side);
+			indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+		}
+	}
+
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount);
+		std::vector<float4> tangents(vertexCount);
+		for(size_t i = 0; i < vertexCount; ++i) {
+			const float x = static_cast<float>(i % side);
+			const float y = static_cast<float>(i / side);
+			const float phase = x * 0.15f + iFrame * 0.3f;
+			const float slope = 0.5f * std::cos(phase) * std::cos(y * 0.1f);
+			const float length = std::sqrt(1.0f + slope * slope);
+			points[i] = float3{ x, y, 3.0f * std::sin(phase) * std::cos(y * 0.1f) };
+			normals[i] = float3{ -slope / length, 0.0f, 1.0f / length };
+			tangents[i] = float4{ 1.0f / length, 0.0f, slope / length, 1.0f };
+		}
+		void* vertices[6] = { points.data(), normals.data(), tangents.data(), uvs.data(), uvs.data(), velocities.data() };
+
+		GeomMesh mesh = { 0, static_cast<uint32_t>(vertexCount), 0, 1 };
+		GeomSubmesh submesh = { 0, static_cast<uint32_t>(indices.size()), Topology::Triangles };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = &mesh;
+		data.meshCount = 1;
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		igc.addData(iFrame / 30.0f, &data);
+
+		frames.points.push_back(std::move(points));
+		frames.normals.push_back(std::move(normals));
+		frames.tangents.push_back(std::move(tangents));
+	}
+	return frames;
+}
+
+static size_t findAttribute(const GeomCacheDesc* descs, const char* semantic)
+{
+	for(size_t iAttribute = 0; iAttribute < getAttributeCount(descs); ++iAttribute) {
+		if(_stricmp(descs[iAttribute].semantic, semantic) == 0) {
+			return iAttribute;
+		}
+	}
+	return ~0u;
+}
+
+static float getDistance(const float* a, const float* b)
+{
+	return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+// Decoded frames are as far from the input as reported, which is within the tolerance in error bounded mode.
+static void test1()
+{
+	const size_t side = 60;
+	const size_t frameCount = 12;
+
+	InputGeomCache igc(descs);
+	const WaveFrames frames = makeWaveCache(igc, side, frameCount);
+	const size_t vertexCount = side * side;
+
+	struct Case {
+		const char* name;
+		bool isEntropyCoded;
+		QuantisationSettings settings;
+	};
+	std::vector<Case> cases;
+	cases.push_back({ "16 bits", false, {} });
+	cases.push_back({ "16 bits rans", true, {} });
+
+	QuantisationSettings twelveBits;
+	twelveBits.PointBits = twelveBits.NormalBits = twelveBits.TangentBits = 12;
+	cases.push_back({ "12 bits", false, twelveBits });
+	cases.push_back({ "12 bits rans", true, twelveBits });
+
+	QuantisationSettings mixedBits;
+	mixedBits.PointBits = 11;
+	mixedBits.NormalBits = 9;
+	mixedBits.TangentBits = 7;
+	cases.push_back({ "11/9/7 bits", false, mixedBits });
+
+	QuantisationSettings bounded;
+	bounded.PointTolerance = 0.01f;
+	cases.push_back({ "0.01 bounded", true, bounded });
+
+	QuantisationSettings coarse;
+	coarse.PointTolerance = 1.0f;
+	coarse.NormalBits = coarse.TangentBits = 1;
+	cases.push_back({ "1.0 bounded", false, coarse });
+
+	size_t fullSize = 0;
+	for(const auto& c : cases) {
+		MemoryStream stream(0, true);
+		QuantisationCompressor compressor(c.isEntropyCoded, c.settings);
+		compressor.compress(igc, &stream);
+		const QuantisationReport& report = compressor.getReport();
+
+		const uint32_t expectedPointBits = c.settings.PointTolerance > 0.0f ? report.Points.Bits : c.settings.PointBits;
+		if(report.Points.Bits != expectedPointBits || report.Normals.Bits != c.settings.NormalBits || report.Tangents.Bits != c.settings.TangentBits
+			|| report.Velocities.Bits != 0 || report.UV0.Bits != 0 || report.UV1.Bits != 0) {
+			ThrowError("quantisation precision: %s, wrong bits reported\n", c.name);
+		}
+		if(c.settings.PointTolerance > 0.0f && (report.Points.Bits >= 16 || report.Points.MaxError > c.settings.PointTolerance)) {
+			ThrowError("quantisation precision: %s, %u point bits with an error of %g\n", c.name, report.Points.Bits, report.Points.MaxError);
+		}
+
+		stream.seek(0, Stream::SeekOrigin::Begin);
+		quantisation_compression::FileHeader header {};
+		stream.read(&header, sizeof(header));
+		const bool isBitPacked = (header.Flags & quantisation_compression::FILE_FLAG_BIT_PACKED) != 0;
+		if(isBitPacked != (report.Points.Bits < 16 || report.Normals.Bits < 16 || report.Tangents.Bits < 16)) {
+			ThrowError("quantisation precision: %s, wrong bit packing flag\n", c.name);
+		}
+		stream.seek(0, Stream::SeekOrigin::Begin);
+
+		// Frames one at a time, so they're read through the frame index and skipped past.
+		QuantisationDecompressor decompressor;
+		decompressor.setCacheBudget(1);
+		decompressor.open(&stream);
+		const GeomCacheDesc* fileDescs = decompressor.getDescriptors();
+		const size_t pointsAttribute = findAttribute(fileDescs, nvcSEMANTIC_POINTS);
+		const size_t normalsAttribute = findAttribute(fileDescs, nvcSEMANTIC_NORMALS);
+		const size_t tangentsAttribute = findAttribute(fileDescs, nvcSEMANTIC_TANGENTS);
+
+		float maxErrors[3] = {};
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount);
+		std::vector<float4> tangents(vertexCount);
+		for(size_t iFrame = frameCount; iFrame-- > 0; ) {
+			decompressor.setPinnedRange(iFrame, 1);
+			decompressor.prefetch(iFrame, 1);
+
+			float time = 0.0f;
+			GeomCacheData data {};
+			if(!decompressor.getData(iFrame, time, data) || data.vertexCount != vertexCount
+				|| !decompressor.decodeAttribute(iFrame, data, pointsAttribute, 0, vertexCount, points.data())
+				|| !decompressor.decodeAttribute(iFrame, data, normalsAttribute, 0, vertexCount, normals.data())
+				|| !decompressor.decodeAttribute(iFrame, data, tangentsAttribute, 0, vertexCount, tangents.data())) {
+				ThrowError("quantisation precision: %s, frame %zd isn't decoded\n", c.name, iFrame);
+			}
+
+			for(size_t i = 0; i < vertexCount; ++i) {
+				maxErrors[0] = std::max(maxErrors[0], getDistance(&points[i][0], &frames.points[iFrame][i][0]));
+				maxErrors[1] = std::max(maxErrors[1], getDistance(&normals[i][0], &frames.normals[iFrame][i][0]));
+				maxErrors[2] = std::max(maxErrors[2], getDistance(&tangents[i][0], &frames.tangents[iFrame][i][0]));
+			}
+		}
+
+		// The decoder may differ from the per element functions in the last bit.
+		const QuantisationError* reported[3] = { &report.Points, &report.Normals, &report.Tangents };
+		for(size_t i = 0; i < 3; ++i) {
+			if(std::abs(maxErrors[i] - reported[i]->MaxError) > 1e-4f * (1.0f + reported[i]->MaxError) || reported[i]->RmsError > reported[i]->MaxError) {
+				ThrowError("quantisation precision: %s, decoded error %g, reported %g\n", c.name, maxErrors[i], reported[i]->MaxError);
+			}
+		}
+
+		if(fullSize == 0) {
+			fullSize = stream.getLength();
+		}
+		printf("quantisation precision: %-13s %7zd bytes (x%.2f), points %2u bits max %.2e rms %.2e, normals %2u bits max %.2e rms %.2e, tangents %2u bits max %.2e\n"
+			, c.name, stream.getLength(), static_cast<double>(fullSize) / stream.getLength()
+			, report.Points.Bits, report.Points.MaxError, report.Points.RmsError
+			, report.Normals.Bits, report.Normals.MaxError, report.Normals.RmsError
+			, report.Tangents.Bits, report.Tangents.MaxError);
+	}
+}
+
+void RunTest_QuantisationPrecision()
+{
+	test0();
+	test1();
+}
@@ -0,0 +1,252 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Compression/PackedTransform.h"
+#include "Plugin/Compression/RansCoding.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/QuantisationDecompressor.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+static const char* getSimdLevelName(SimdLevel level)
+{
+	switch(level) {
+	case SimdLevel::AVX2: return "AVX2";
+	case SimdLevel::SSE41: return "SSE4.1";
+	default: return "Scalar";
+	}
+}
+
+// Bytes with a roughly geometric distribution, like small residuals.
+static std::vector<uint8_t> makeSkewedBytes(size_t size, uint64_t seed)
+{
+	Pcg pcg(seed, 456);
+	std::vector<uint8_t> bytes(size);
+	for(auto& b : bytes) {
+		const uint32_t r = pcg.getUint32();
+		b = static_cast<uint8_t>(r & 0x80000000u ? (r & 3) : (r & 0x10000u ? (r & 31) : (r & 255)));
+	}
+	return bytes;
+}
+
+// Quantised positions along a smooth curve, as uint16 values: high bytes change slowly, low bytes are noisy.
+static std::vector<uint8_t> makeQuantisedValues(size_t count)
+{
+	std::vector<uint8_t> bytes(count * sizeof(uint16_t));
+	for(size_t i = 0; i < count; ++i) {
+		const uint16_t value = static_cast<uint16_t>(32767.5f + 32767.0f * std::sin(i * 0.001f));
+		memcpy(&bytes[i * sizeof(uint16_t)], &value, sizeof(value));
+	}
+	return bytes;
+}
+
+// Encoding then decoding gives the data back at every SIMD level, and damaged codings don't.
+static void test0()
+{
+	std::vector<std::pair<std::vector<uint8_t>, size_t>> cases;
+	cases.push_back({ {}, 1 });
+	cases.push_back({ std::vector<uint8_t>(1, 7), 1 });
+	cases.push_back({ std::vector<uint8_t>(1000, 42), 1 });
+	cases.push_back({ std::vector<uint8_t>{ 1, 2 }, 1 });
+	for(size_t size : { size_t(7), size_t(8), size_t(9), size_t(63), size_t(1001), size_t(100000) }) {
+		cases.push_back({ makeSkewedBytes(size, size), 1 });
+	}
+	std::vector<uint8_t> uniform(65536);
+	FillRandom(uniform);
+	cases.push_back({ uniform, 1 });
+	cases.push_back({ makeQuantisedValues(4099), 2 });
+	cases.push_back({ makeSkewedBytes(3 * 1111, 3), 3 });
+	// A dominant symbol, its frequency is as large as it gets.
+	std::vector<uint8_t> dominant(50000, 9);
+	dominant[1234] = 10;
+	cases.push_back({ dominant, 1 });
+
+	const SimdLevel supportedLevel = GetSupportedSimdLevel();
+	for(const auto& c : cases) {
+		const std::vector<uint8_t>& data = c.first;
+		const size_t stride = c.second;
+
+		std::vector<uint8_t> encoded { 0xCD }; // Appending keeps what's there.
+		const size_t encodedSize = ransEncode(data.data(), data.size(), stride, encoded);
+		if(encodedSize != encoded.size() - 1 || encoded[0] != 0xCD) {
+			ThrowError("rans: %zd bytes, wrong encoded size\n", data.size());
+		}
+
+		for(SimdLevel level : { SimdLevel::Scalar, SimdLevel::AVX2 }) {
+			if(level > supportedLevel) {
+				continue;
+			}
+			SetSimdLevel(level);
+
+			std::vector<uint8_t> decoded(data.size(), 0xCD);
+			if(!ransDecode(encoded.data() + 1, encodedSize, stride, decoded.data(), decoded.size()) || decoded != data) {
+				ThrowError("rans: %zd bytes, stride %zd, %s decoding differs\n", data.size(), stride, getSimdLevelName(level));
+			}
+
+			if(data.size() > 100) {
+				if(ransDecode(encoded.data() + 1, encodedSize - 1, stride, decoded.data(), decoded.size())) {
+					ThrowError("rans: %zd bytes, truncated coding decodes\n", data.size());
+				}
+				std::vector<uint8_t> corrupted(encoded.begin() + 1, encoded.end());
+				corrupted.back() ^= 0x5A;
+				if(ransDecode(corrupted.data(), corrupted.size(), stride, decoded.data(), decoded.size()) && decoded == data) {
+					ThrowError("rans: %zd bytes, corrupted coding decodes to the data\n", data.size());
+				}
+			}
+		}
+		SetSimdLevel(supportedLevel);
+	}
+	printf("rans: %zd cases round trip\n", cases.size());
+}
+
+// Ratio and decode throughput at each level.
+static void test1()
+{
+	const size_t size = 16 << 20;
+	const size_t passCount = 10;
+
+	const std::pair<const char*, std::pair<std::vector<uint8_t>, size_t>> inputs[] = {
+		{ "skewed", { makeSkewedBytes(size, 1), 1 } },
+		{ "quantised", { makeQuantisedValues(size / 2), 2 } },
+	};
+
+	const SimdLevel supportedLevel = GetSupportedSimdLevel();
+	for(const auto& input : inputs) {
+		const std::vector<uint8_t>& data = input.second.first;
+		const size_t stride = input.second.second;
+
+		std::vector<uint8_t> encoded;
+		ransEncode(data.data(), data.size(), stride, encoded);
+		std::vector<uint8_t> decoded(data.size());
+
+		for(SimdLevel level : { SimdLevel::Scalar, SimdLevel::AVX2 }) {
+			if(level > supportedLevel) {
+				continue;
+			}
+			SetSimdLevel(level);
+
+			const auto t0 = std::chrono::high_resolution_clock::now();
+			for(size_t iPass = 0; iPass < passCount; ++iPass) {
+				const auto r = ransDecode(encoded.data(), encoded.size(), stride, decoded.data(), decoded.size());
+				assert(r);
+			}
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			const double seconds = std::chrono::duration<double>(t1 - t0).count();
+			printf("rans %-9s x%.2f, %-6s: %7.1f MB/s\n", input.first, static_cast<double>(data.size()) / encoded.size()
+				, getSimdLevelName(level), data.size() * passCount / seconds * 1e-6);
+		}
+	}
+
+	SetSimdLevel(supportedLevel);
+}
+
+// An entropy coded quantisation file decodes to the same packed frames as a plain one, in any order.
+static void test2()
+{
+	static const GeomCacheDesc descs[] = {
+		{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+		{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+		{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+		{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+		{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+		GEOM_CACHE_DESCRIPTOR_END
+	};
+	const size_t side = 100;
+	const size_t frameCount = 25;
+
+	InputGeomCache igc(descs);
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		const size_t vertexCount = side * side;
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount);
+		std::vector<float2> uvs(vertexCount);
+		std::vector<float2> uv1s(vertexCount, float2{ 0.0f, 0.0f });
+		std::vector<float3> velocities(vertexCount, float3{ 0.0f, 0.0f, 0.0f });
+		std::vector<int32_t> indices;
+		for(size_t y = 0; y < side; ++y) {
+			for(size_t x = 0; x < side; ++x) {
+				const size_t i = y * side + x;
+				const float z = std::sin(x * 0.1f + iFrame * 0.2f) * std::cos(y * 0.1f);
+				points[i] = float3{ static_cast<float>(x), static_cast<float>(y), z };
+				normals[i] = float3{ 0.0f, std::sin(z), std::cos(z) };
+				uvs[i] = float2{ static_cast<float>(x) / side, static_cast<float>(y) / side };
+				if(x + 1 < side && y + 1 < side) {
+					const int32_t v = static_cast<int32_t>(i);
+					const int32_t w = static_cast<int32_t>(side);
+					indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+				}
+			}
+		}
+		void* vertices[5] = { points.data(), normals.data(), uvs.data(), uv1s.data(), velocities.data() };
+
+		GeomMesh mesh = { 0, static_cast<uint32_t>(vertexCount), 0, 1 };
+		GeomSubmesh submesh = { 0, static_cast<uint32_t>(indices.size()), Topology::Triangles };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = &mesh;
+		data.meshCount = 1;
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		igc.addData(iFrame / 30.0f, &data);
+	}
+
+	MemoryStream plainStream(0, true);
+	MemoryStream codedStream(0, true);
+	{
+		QuantisationCompressor plainCompressor {};
+		plainCompressor.compress(igc, &plainStream);
+		QuantisationCompressor codedCompressor(true);
+		codedCompressor.compress(igc, &codedStream);
+	}
+	plainStream.seek(0, Stream::SeekOrigin::Begin);
+	codedStream.seek(0, Stream::SeekOrigin::Begin);
+
+	QuantisationDecompressor plain;
+	plain.open(&plainStream);
+	plain.prefetch(0, frameCount);
+	QuantisationDecompressor coded;
+	coded.setCacheBudget(1);
+	coded.open(&codedStream);
+
+	const GeomCacheDesc* codedDescs = coded.getDescriptors();
+	Pcg pcg(123, 456);
+	for(size_t iSeek = 0; iSeek < frameCount * 2; ++iSeek) {
+		// Sequential, then random.
+		const size_t frameIndex = iSeek < frameCount ? iSeek : pcg.getUint32() % frameCount;
+		coded.setPinnedRange(frameIndex, 1);
+		coded.prefetch(frameIndex, 1);
+
+		float time = 0.0f;
+		GeomCacheData expected {};
+		GeomCacheData actual {};
+		const auto r0 = plain.getData(frameIndex, time, expected);
+		const auto r1 = coded.getData(frameIndex, time, actual);
+		if(!r0 || !r1 || expected.vertexCount != actual.vertexCount) {
+			ThrowError("rans: quantisation frame %zd isn't loaded\n", frameIndex);
+		}
+		for(size_t iAttribute = 0; iAttribute < getAttributeCount(codedDescs); ++iAttribute) {
+			if(memcmp(expected.vertices[iAttribute], actual.vertices[iAttribute], getSizeOfDataFormat(codedDescs[iAttribute].format) * actual.vertexCount) != 0) {
+				ThrowError("rans: quantisation frame %zd decodes differently\n", frameIndex);
+			}
+		}
+	}
+
+	printf("rans: quantisation file %zd bytes, entropy coded %zd bytes (x%.2f)\n", plainStream.getLength(), codedStream.getLength()
+		, static_cast<double>(plainStream.getLength()) / codedStream.getLength());
+}
+
+void RunTest_Rans()
+{
+	test0();
+	test1();
+	test2();
+}
@@ -0,0 +1,377 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/QuantisationDecompressor.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/Stream/FileStream.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/nvcAPI.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+static const GeomCacheDesc streamingDescs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	{ nvcSEMANTIC_COLORS, DataFormat::Float4 },
+	{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+// The buffers of the frame being simulated, overwritten by the next one.
+struct StreamingFrame
+{
+	std::vector<int32_t> indices;
+	std::vector<float3> points;
+	std::vector<float3> normals;
+	std::vector<float2> uv0;
+	std::vector<float4> colors;
+	std::vector<float3> velocities;
+	void* vertices[GEOM_CACHE_MAX_DESCRIPTOR_COUNT] = {};
+	GeomMesh meshes[2] = {};
+	GeomSubmesh submeshes[2] = {};
+};
+
+// Two waving grids. With isTopologyChanging, the second one loses its last row of triangles every 7 frames.
+static GeomCacheData makeStreamingFrame(StreamingFrame& frame, size_t side, size_t iFrame, bool isTopologyChanging)
+{
+	const size_t gridVertexCount = side * side;
+	const size_t vertexCount = 2 * gridVertexCount;
+	const int32_t w = static_cast<int32_t>(side);
+
+	frame.indices.clear();
+	for(size_t iMesh = 0; iMesh < 2; ++iMesh) {
+		const size_t rowCount = isTopologyChanging && iMesh == 1 && (iFrame / 7) % 2 == 1 ? side - 2 : side - 1;
+		for(size_t y = 0; y < rowCount; ++y) {
+			for(size_t x = 0; x + 1 < side; ++x) {
+				const int32_t v = static_cast<int32_t>(iMesh * gridVertexCount + y * side + x);
+				frame.indices.insert(frame.indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+			}
+		}
+	}
+	const uint32_t gridIndexCount = static_cast<uint32_t>(6 * (side - 1) * (side - 1));
+
+	frame.points.resize(vertexCount);
+	frame.normals.resize(vertexCount);
+	frame.uv0.resize(vertexCount);
+	frame.colors.resize(vertexCount);
+	frame.velocities.resize(vertexCount);
+	for(size_t i = 0; i < vertexCount; ++i) {
+		const size_t j = i % gridVertexCount;
+		const float u = static_cast<float>(j % side) / side;
+		const float v = static_cast<float>(j / side) / side;
+		const float phase = u * 6.0f + v * 3.0f + iFrame * 0.25f + (i < gridVertexCount ? 0.0f : 1.0f);
+		frame.points[i] = float3{ u + (i < gridVertexCount ? 0.0f : 1.5f), v, 0.1f * std::sin(phase) };
+		const float slope = 0.6f * std::cos(phase);
+		const float length = std::sqrt(slope * slope + 1.0f);
+		frame.normals[i] = float3{ -slope / length, 0.0f, 1.0f / length };
+		frame.uv0[i] = float2{ u, v };
+		frame.colors[i] = float4{ u, v, 0.5f, 1.0f };
+		frame.velocities[i] = float3{ 0.0f, 0.0f, 0.75f * std::cos(phase) };
+	}
+
+	frame.vertices[0] = frame.points.data();
+	frame.vertices[1] = frame.normals.data();
+	frame.vertices[2] = frame.uv0.data();
+	frame.vertices[3] = frame.colors.data();
+	frame.vertices[4] = frame.velocities.data();
+	frame.meshes[0] = { 0, static_cast<uint32_t>(gridVertexCount), 0, 1 };
+	frame.meshes[1] = { static_cast<uint32_t>(gridVertexCount), static_cast<uint32_t>(gridVertexCount), 1, 1 };
+	frame.submeshes[0] = { 0, gridIndexCount, Topology::Triangles };
+	frame.submeshes[1] = { gridIndexCount, static_cast<uint32_t>(frame.indices.size()) - gridIndexCount, Topology::Triangles };
+
+	GeomCacheData data {};
+	data.indices = frame.indices.data();
+	data.indexCount = frame.indices.size();
+	data.vertices = frame.vertices;
+	data.vertexCount = vertexCount;
+	data.meshes = frame.meshes;
+	data.meshCount = 2;
+	data.submeshes = frame.submeshes;
+	data.submeshCount = 2;
+	return data;
+}
+
+static bool isSameReport(const QuantisationReport& lhs, const QuantisationReport& rhs)
+{
+	const QuantisationError* l = &lhs.Points;
+	const QuantisationError* r = &rhs.Points;
+	for(size_t i = 0; i < sizeof(QuantisationReport) / sizeof(QuantisationError); ++i) {
+		if(l[i].Bits != r[i].Bits || l[i].MaxError != r[i].MaxError || l[i].RmsError != r[i].RmsError) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static std::vector<uint8_t> getStreamBytes(const MemoryStream& stream)
+{
+	const uint8_t* begin = static_cast<const uint8_t*>(stream.getBuffer());
+	return std::vector<uint8_t>(begin, begin + stream.getLength());
+}
+
+// The time, indices and decoded attributes of a frame.
+static std::vector<uint8_t> getFrameBytes(QuantisationDecompressor& decompressor, size_t frameIndex)
+{
+	float time = 0.0f;
+	GeomCacheData data {};
+	decompressor.prefetch(frameIndex, 1);
+	if(!decompressor.getData(frameIndex, time, data)) {
+		ThrowError("streaming compression: frame %zd isn't loaded\n", frameIndex);
+	}
+
+	std::vector<uint8_t> bytes(reinterpret_cast<const uint8_t*>(&time), reinterpret_cast<const uint8_t*>(&time + 1));
+	const uint8_t* indices = static_cast<const uint8_t*>(data.indices);
+	bytes.insert(bytes.end(), indices, indices + sizeof(int32_t) * data.indexCount);
+
+	const GeomCacheDesc* descs = decompressor.getDescriptors();
+	for(size_t iAttribute = 0; descs[iAttribute].semantic != nullptr; ++iAttribute) {
+		std::vector<float4> decoded(data.vertexCount);
+		const uint8_t* begin = reinterpret_cast<const uint8_t*>(decoded.data());
+		size_t size = sizeof(float4) * data.vertexCount;
+		if(!decompressor.decodeAttribute(frameIndex, data, iAttribute, 0, data.vertexCount, decoded.data())) {
+			begin = static_cast<const uint8_t*>(data.vertices[iAttribute]);
+			size = getSizeOfDataFormat(descs[iAttribute].format) * data.vertexCount;
+		}
+		bytes.insert(bytes.end(), begin, begin + size);
+	}
+	return bytes;
+}
+
+// Without anything shared by the whole file, frames added one at a time give the file of compress(), and
+// are written a seek window at a time.
+static void test0()
+{
+	const size_t side = 48;
+	const size_t frameCount = 47; // Not a multiple of the seek window.
+
+	QuantisationSettings packed;
+	packed.PointBits = 11;
+	packed.NormalBits = 10;
+	packed.BoundsBlockSize = 512;
+
+	struct Case
+	{
+		const char* name;
+		bool isEntropyCoded;
+		QuantisationSettings settings;
+	};
+	const Case cases[] = {
+		{ "16 bits", false, QuantisationSettings{} },
+		{ "11 bits rans", true, packed },
+	};
+
+	for(Case c : cases) {
+		c.settings.ConstantVertices = false;
+
+		InputGeomCache igc { streamingDescs };
+		StreamingFrame frame;
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			const GeomCacheData data = makeStreamingFrame(frame, side, iFrame, true);
+			igc.addData(iFrame / 30.0f, &data);
+		}
+
+		MemoryStream expectedStream;
+		QuantisationCompressor expected { c.isEntropyCoded, c.settings };
+		expected.compress(igc, &expectedStream);
+
+		MemoryStream actualStream;
+		QuantisationCompressor actual { c.isEntropyCoded, c.settings };
+		actual.begin(streamingDescs, InputGeomCacheConstantData{}, frameCount, &actualStream);
+		size_t writtenLength = actualStream.getLength();
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			const GeomCacheData data = makeStreamingFrame(frame, side, iFrame, true);
+			actual.addFrame(iFrame / 30.0f, data);
+
+			const bool isWindowWritten = (iFrame + 1) % QuantisationCompressor::DefaultSeekWindow == 0;
+			if(isWindowWritten != (actualStream.getLength() > writtenLength)) {
+				ThrowError("streaming compression: %s, the window of frame %zd %s written\n", c.name, iFrame, isWindowWritten ? "isn't" : "is");
+			}
+			writtenLength = actualStream.getLength();
+		}
+		if(!actual.finish()) {
+			ThrowError("streaming compression: %s, finish() failed\n", c.name);
+		}
+
+		if(getStreamBytes(expectedStream) != getStreamBytes(actualStream)) {
+			ThrowError("streaming compression: %s, the file differs from compress()\n", c.name);
+		}
+		if(!isSameReport(expected.getReport(), actual.getReport())) {
+			ThrowError("streaming compression: %s, the report differs from compress()\n", c.name);
+		}
+		printf("streaming compression: %-12s %zd frames, %zd bytes as compress()\n", c.name, frameCount, actualStream.getLength());
+	}
+}
+
+// With the topology and some attributes the same in every frame, frames added one at a time store them per
+// seek window and per frame, and decode as the file of compress().
+static void test1()
+{
+	const size_t side = 32;
+	const size_t frameCount = 23;
+
+	InputGeomCache igc { streamingDescs };
+	StreamingFrame frame;
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		const GeomCacheData data = makeStreamingFrame(frame, side, iFrame, false);
+		igc.addData(iFrame / 30.0f, &data);
+	}
+
+	MemoryStream expectedStream;
+	QuantisationCompressor expected;
+	expected.compress(igc, &expectedStream);
+
+	MemoryStream actualStream;
+	QuantisationCompressor actual;
+	actual.begin(streamingDescs, InputGeomCacheConstantData{}, frameCount, &actualStream);
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		actual.addFrame(iFrame / 30.0f, makeStreamingFrame(frame, side, iFrame, false));
+	}
+	if(!actual.finish()) {
+		ThrowError("streaming compression: finish() failed\n");
+	}
+
+	const uint32_t sharedFlags = quantisation_compression::FILE_FLAG_SHARED_TOPOLOGY | quantisation_compression::FILE_FLAG_CONSTANT_VERTICES;
+	MemoryStream* streams[2] = { &expectedStream, &actualStream };
+	for(int isStreamed = 0; isStreamed < 2; ++isStreamed) {
+		quantisation_compression::FileHeader header {};
+		streams[isStreamed]->seek(0, Stream::SeekOrigin::Begin);
+		streams[isStreamed]->read(&header, sizeof(header));
+		streams[isStreamed]->seek(0, Stream::SeekOrigin::Begin);
+		if((header.Flags & sharedFlags) != (isStreamed ? 0u : sharedFlags)) {
+			ThrowError("streaming compression: the %s file has flags %x\n", isStreamed ? "streamed" : "compressed", header.Flags);
+		}
+	}
+
+	QuantisationDecompressor expectedDecompressor;
+	expectedDecompressor.open(&expectedStream);
+	QuantisationDecompressor actualDecompressor;
+	actualDecompressor.open(&actualStream);
+	if(actualDecompressor.getFrameCount() != frameCount) {
+		ThrowError("streaming compression: %zd frames instead of %zd\n", actualDecompressor.getFrameCount(), frameCount);
+	}
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		if(getFrameBytes(expectedDecompressor, iFrame) != getFrameBytes(actualDecompressor, iFrame)) {
+			ThrowError("streaming compression: frame %zd differs from compress()\n", iFrame);
+		}
+	}
+	printf("streaming compression: %zd frames, %zd bytes (%zd with the whole sequence)\n", frameCount, actualStream.getLength(), expectedStream.getLength());
+}
+
+// A sequence shorter or longer than the frame count given to begin() fails, the tables are sized for it.
+static void test2()
+{
+	const size_t side = 16;
+	const size_t frameCount = 15;
+	const size_t addedCounts[] = { 0, 7, frameCount - 1, frameCount + 3 };
+
+	for(size_t addedCount : addedCounts) {
+		MemoryStream stream;
+		QuantisationCompressor compressor;
+		compressor.begin(streamingDescs, InputGeomCacheConstantData{}, frameCount, &stream);
+
+		StreamingFrame frame;
+		for(size_t iFrame = 0; iFrame < addedCount; ++iFrame) {
+			const bool isAdded = compressor.addFrame(iFrame / 30.0f, makeStreamingFrame(frame, side, iFrame, false));
+			if(isAdded != (iFrame < frameCount)) {
+				ThrowError("streaming compression: frame %zd of %zd %s added\n", iFrame, frameCount, isAdded ? "is" : "isn't");
+			}
+		}
+		if(compressor.finish()) {
+			ThrowError("streaming compression: finish() succeeds with %zd of %zd frames\n", addedCount, frameCount);
+		}
+	}
+	printf("streaming compression: sequences of the wrong length fail\n");
+}
+
+// The exported entry points, for plugins which can't use the compressor across the DLL boundary, write the
+// file of begin()/addFrame()/finish().
+static void test3()
+{
+	const char* filename = "../../../Data/TestOutput/StreamingCompression.quantisation.nvc";
+	const size_t side = 16;
+	const size_t frameCount = 12;
+
+	AutoPrepareCleanFile file(filename);
+
+	MemoryStream expectedStream;
+	QuantisationCompressor expected;
+	expected.begin(streamingDescs, InputGeomCacheConstantData{}, frameCount, &expectedStream);
+
+	QuantisationExport* actual = nvcQCBegin(filename, streamingDescs, nullptr, static_cast<int>(frameCount), nullptr);
+	if(actual == nullptr) {
+		ThrowError("streaming compression: nvcQCBegin() can't write %s\n", filename);
+	}
+
+	StreamingFrame frame;
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		const GeomCacheData data = makeStreamingFrame(frame, side, iFrame, false);
+		expected.addFrame(iFrame / 30.0f, data);
+		if(!nvcQCAddFrame(actual, iFrame / 30.0f, &data)) {
+			ThrowError("streaming compression: nvcQCAddFrame() fails on frame %zd\n", iFrame);
+		}
+	}
+	expected.finish();
+
+	QuantisationReport report {};
+	if(!nvcQCFinish(actual, &report)) {
+		ThrowError("streaming compression: nvcQCFinish() failed\n");
+	}
+	if(!isSameReport(expected.getReport(), report)) {
+		ThrowError("streaming compression: the report of nvcQCFinish() differs from finish()\n");
+	}
+
+	std::vector<uint8_t> bytes;
+	{
+		FileStream fs { filename, FileStream::OpenModes::Random_ReadOnly };
+		bytes.resize(fs.getLength());
+		fs.read(bytes.data(), bytes.size());
+	}
+	if(bytes != getStreamBytes(expectedStream)) {
+		ThrowError("streaming compression: %s differs from the file of finish()\n", filename);
+	}
+	printf("streaming compression: %zd frames, %zd bytes through nvcQCBegin()\n", frameCount, bytes.size());
+}
+
+// An export to a file which can't be written fails with every compression type, and writes nothing.
+static void test4()
+{
+	const char* filename = "../../../Data/TestOutput/StreamingCompressionMissing/StreamingCompression.nvc";
+	const char* writableFilename = "../../../Data/TestOutput/StreamingCompression.export.nvc";
+	const CompressionType types[] = { CompressionType::Null, CompressionType::Quantize, CompressionType::Temporal, CompressionType::Pca };
+
+	InputGeomCache* igc = nvcIGCCreate(streamingDescs);
+	StreamingFrame frame;
+	for(size_t iFrame = 0; iFrame < 4; ++iFrame) {
+		const GeomCacheData data = makeStreamingFrame(frame, 8, iFrame, false);
+		nvcIGCAddData(igc, iFrame / 30.0f, &data);
+	}
+
+	AutoPrepareCleanFile file(writableFilename);
+	for(CompressionType type : types) {
+		if(nvcIGCExport(igc, filename, type, nullptr, nullptr)) {
+			ThrowError("streaming compression: nvcIGCExport() of type %u succeeds on %s\n", static_cast<uint32_t>(type), filename);
+		}
+		if(!nvcIGCExport(igc, writableFilename, type, nullptr, nullptr)) {
+			ThrowError("streaming compression: nvcIGCExport() of type %u fails on %s\n", static_cast<uint32_t>(type), writableFilename);
+		}
+	}
+	nvcIGCRelease(igc);
+
+	if(nvcQCBegin(filename, streamingDescs, nullptr, 4, nullptr) != nullptr) {
+		ThrowError("streaming compression: nvcQCBegin() succeeds on %s\n", filename);
+	}
+	printf("streaming compression: exports to an unwritable file fail\n");
+}
+
+void RunTest_StreamingCompression()
+{
+	test0();
+	test1();
+	test2();
+	test3();
+	test4();
+}
@@ -0,0 +1,254 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/QuantisationDecompressor.h"
+#include "Plugin/Compression/TemporalCompressor.h"
+#include "Plugin/Compression/TemporalDecompressor.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+static const GeomCacheDesc s_ClothDescs[] = {
+	{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+	{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+	{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+	{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+	{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+	GEOM_CACHE_DESCRIPTOR_END
+};
+
+static float3 getClothPoint(size_t x, size_t y, size_t frameIndex)
+{
+	const float fx = static_cast<float>(x);
+	const float fy = static_cast<float>(y);
+	const float t = static_cast<float>(frameIndex);
+	return float3{ fx + 0.3f * std::sin(fy * 0.2f + t * 0.05f), fy, 2.0f * std::sin(fx * 0.1f + t * 0.07f) * std::cos(fy * 0.1f) };
+}
+
+// A sheet of side * side vertices waving a little every frame. From frame resizeFrame on, it's one vertex wider.
+// uv1 and velocities are all 0, so they aren't stored.
+static void makeClothCache(InputGeomCache& igc, size_t side, size_t frameCount, size_t resizeFrame = ~size_t(0))
+{
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		const size_t width = iFrame < resizeFrame ? side : side + 1;
+		const size_t vertexCount = width * side;
+
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount);
+		std::vector<float2> uvs(vertexCount);
+		std::vector<float2> uv1s(vertexCount, float2{ 0.0f, 0.0f });
+		std::vector<float3> velocities(vertexCount, float3{ 0.0f, 0.0f, 0.0f });
+		std::vector<int32_t> indices;
+		for(size_t y = 0; y < side; ++y) {
+			for(size_t x = 0; x < width; ++x) {
+				const size_t i = y * width + x;
+				points[i] = getClothPoint(x, y, iFrame);
+				const float dz = 0.2f * std::cos(x * 0.1f + iFrame * 0.07f) * std::cos(y * 0.1f);
+				const float length = std::sqrt(dz * dz + 1.0f);
+				normals[i] = float3{ -dz / length, 0.0f, 1.0f / length };
+				uvs[i] = float2{ static_cast<float>(x) / width, static_cast<float>(y) / side };
+
+				if(x + 1 < width && y + 1 < side) {
+					const int32_t w = static_cast<int32_t>(width);
+					const int32_t v = static_cast<int32_t>(i);
+					indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+				}
+			}
+		}
+		void* vertices[5] = { points.data(), normals.data(), uvs.data(), uv1s.data(), velocities.data() };
+
+		GeomMesh mesh = { 0, static_cast<uint32_t>(vertexCount), 0, 1 };
+		GeomSubmesh submesh = { 0, static_cast<uint32_t>(indices.size()), Topology::Triangles };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = &mesh;
+		data.meshCount = 1;
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		igc.addData(iFrame / 30.0f, &data);
+	}
+}
+
+// Decoded attribute of a loaded frame.
+template<class T>
+static std::vector<T> decodeAttribute(IDecompressor& decompressor, size_t frameIndex, const char* semantic)
+{
+	float time = 0.0f;
+	GeomCacheData data {};
+	const auto r0 = decompressor.getData(frameIndex, time, data);
+	assert(r0);
+
+	const int iAttribute = getAttributeIndex(decompressor.getDescriptors(), semantic);
+	std::vector<T> values(data.vertexCount);
+	const auto r1 = decompressor.decodeAttribute(frameIndex, data, iAttribute, 0, data.vertexCount, values.data());
+	assert(r1);
+	return values;
+}
+
+static bool isSamePackedFrame(const GeomCacheDesc* descs, const GeomCacheData& lhs, const GeomCacheData& rhs)
+{
+	if(lhs.vertexCount != rhs.vertexCount || lhs.indexCount != rhs.indexCount
+		|| memcmp(lhs.indices, rhs.indices, sizeof(int32_t) * lhs.indexCount) != 0) {
+		return false;
+	}
+	for(size_t iAttribute = 0; iAttribute < getAttributeCount(descs); ++iAttribute) {
+		if(memcmp(lhs.vertices[iAttribute], rhs.vertices[iAttribute], getSizeOfDataFormat(descs[iAttribute].format) * lhs.vertexCount) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Decoded attributes stay within the quantisation error (of the window bounds for points), and random access
+// decodes the same frames as playback.
+static void test0()
+{
+	const size_t side = 40;
+	const size_t frameCount = 45;
+
+	for(size_t resizeFrame : { ~size_t(0), size_t(15), size_t(23) }) {
+		InputGeomCache igc(s_ClothDescs);
+		makeClothCache(igc, side, frameCount, resizeFrame);
+
+		MemoryStream quantisationStream(0, true);
+		MemoryStream temporalStream(0, true);
+		{
+			QuantisationCompressor quantisationCompressor {};
+			quantisationCompressor.compress(igc, &quantisationStream);
+			TemporalCompressor temporalCompressor {};
+			temporalCompressor.compress(igc, &temporalStream);
+		}
+		temporalStream.seek(0, Stream::SeekOrigin::Begin);
+
+		TemporalDecompressor playback;
+		playback.open(&temporalStream);
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			playback.prefetch(iFrame, 1);
+		}
+
+		const GeomCacheDesc* descs = playback.getDescriptors();
+		assert(getAttributeCount(descs) == 3);
+
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			const size_t width = iFrame < resizeFrame ? side : side + 1;
+			const std::vector<float3> points = decodeAttribute<float3>(playback, iFrame, nvcSEMANTIC_POINTS);
+			const std::vector<float3> normals = decodeAttribute<float3>(playback, iFrame, nvcSEMANTIC_NORMALS);
+			const std::vector<float2> uvs = decodeAttribute<float2>(playback, iFrame, nvcSEMANTIC_UV0);
+			assert(points.size() == width * side);
+
+			for(size_t y = 0; y < side; ++y) {
+				for(size_t x = 0; x < width; ++x) {
+					const size_t i = y * width + x;
+					const float3 expectedPoint = getClothPoint(x, y, iFrame);
+					for(int k = 0; k < 3; ++k) {
+						// The window bounds are the sheet's, a bit wider than its extents.
+						const float tolerance = (k == 0 ? side + 1.0f : k == 1 ? side : 4.0f) / 65535.0f + 1e-4f;
+						if(std::fabs(points[i][k] - expectedPoint[k]) > tolerance) {
+							ThrowError("resize %zd: frame %zd vertex %zd is off by %f\n", resizeFrame, iFrame, i, std::fabs(points[i][k] - expectedPoint[k]));
+						}
+					}
+
+					const float dz = 0.2f * std::cos(x * 0.1f + iFrame * 0.07f) * std::cos(y * 0.1f);
+					const float length = std::sqrt(dz * dz + 1.0f);
+					if(!NearEqual(normals[i][0], -dz / length, 1e-3f) || !NearEqual(normals[i][2], 1.0f / length, 1e-3f)
+						|| !NearEqual(uvs[i][0], static_cast<float>(x) / width, 2.0f / 65535.0f)
+						|| !NearEqual(uvs[i][1], static_cast<float>(y) / side, 2.0f / 65535.0f)) {
+						ThrowError("resize %zd: frame %zd vertex %zd has a wrong normal or uv\n", resizeFrame, iFrame, i);
+					}
+				}
+			}
+		}
+
+		// Random order with a small cache: every frame decodes from the history or a replay of its window.
+		TemporalDecompressor random;
+		random.setCacheBudget(1);
+		temporalStream.seek(0, Stream::SeekOrigin::Begin);
+		random.open(&temporalStream);
+
+		Pcg pcg(123, 456);
+		for(size_t iSeek = 0; iSeek < frameCount * 4; ++iSeek) {
+			const size_t frameIndex = pcg.getUint32() % frameCount;
+			random.setPinnedRange(frameIndex, 1);
+			random.prefetch(frameIndex, 1);
+
+			float time = 0.0f;
+			GeomCacheData expected {};
+			GeomCacheData actual {};
+			const auto r0 = playback.getData(frameIndex, time, expected);
+			const auto r1 = random.getData(frameIndex, time, actual);
+			assert(r0 && r1);
+			if(!isSamePackedFrame(descs, expected, actual)) {
+				ThrowError("resize %zd: frame %zd decodes differently out of order\n", resizeFrame, frameIndex);
+			}
+		}
+
+		printf("temporal: resize at %3zd, %zd bytes (quantisation %zd bytes, x%.2f)\n"
+			, resizeFrame == ~size_t(0) ? 0 : resizeFrame, temporalStream.getLength(), quantisationStream.getLength()
+			, static_cast<double>(quantisationStream.getLength()) / temporalStream.getLength());
+		assert(temporalStream.getLength() < quantisationStream.getLength());
+	}
+}
+
+// Sequential and random access decode throughput against the quantisation codec.
+static void test1()
+{
+	const size_t side = 300;
+	const size_t frameCount = 60;
+
+	InputGeomCache igc(s_ClothDescs);
+	makeClothCache(igc, side, frameCount);
+
+	MemoryStream quantisationStream(0, true);
+	MemoryStream temporalStream(0, true);
+	{
+		QuantisationCompressor quantisationCompressor {};
+		quantisationCompressor.compress(igc, &quantisationStream);
+		TemporalCompressor temporalCompressor {};
+		temporalCompressor.compress(igc, &temporalStream);
+	}
+
+	const auto measure = [&](const char* name, IDecompressor& decompressor, MemoryStream& stream) {
+		stream.seek(0, Stream::SeekOrigin::Begin);
+		decompressor.setCacheBudget(1);
+		decompressor.open(&stream);
+
+		const auto t0 = std::chrono::high_resolution_clock::now();
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			decompressor.setPinnedRange(iFrame, 1);
+			decompressor.prefetch(iFrame, 1);
+		}
+		const auto t1 = std::chrono::high_resolution_clock::now();
+		Pcg pcg(123, 456);
+		for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+			const size_t frameIndex = pcg.getUint32() % frameCount;
+			decompressor.setPinnedRange(frameIndex, 1);
+			decompressor.prefetch(frameIndex, 1);
+		}
+		const auto t2 = std::chrono::high_resolution_clock::now();
+
+		const double sequentialMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / frameCount;
+		const double randomMs = std::chrono::duration<double, std::milli>(t2 - t1).count() / frameCount;
+		printf("%-12s: %8zd bytes, sequential %6.2f ms/frame, random %6.2f ms/frame\n", name, stream.getLength(), sequentialMs, randomMs);
+		decompressor.close();
+	};
+
+	QuantisationDecompressor quantisation;
+	measure("quantisation", quantisation, quantisationStream);
+	TemporalDecompressor temporal;
+	measure("temporal", temporal, temporalStream);
+}
+
+void RunTest_Temporal()
+{
+	test0();
+	test1();
+}
@@ -1,5 +1,6 @@
 #include "Plugin/PrecompiledHeader.h"
 #include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
 #include "./TestUtil.h"
 
 
@@ -40,6 +41,73 @@ void RunTest_Types()
         }
     }
 
+    // half: rounding, denormals, Inf and NaN
+    {
+        struct { float v; uint16_t h; } test_data[] = {
+            { 0.0f, 0x0000 },
+            { -0.0f, 0x8000 },
+            { 1.0f, 0x3c00 },
+            { 65504.0f, 0x7bff },                   // max
+            { 65520.0f, 0x7c00 },                   // rounds to Inf
+            { 1.0f / 16384.0f, 0x0400 },            // min normal
+            { 1.0f / 16777216.0f, 0x0001 },         // min denormal
+            { 1.0f / 33554432.0f, 0x0000 },         // tie, rounds to even
+            { 3.0f / 33554432.0f, 0x0002 },         // tie, rounds to even
+            { 1.0f + 1.0f / 2048.0f, 0x3c00 },      // tie, rounds to even
+            { 1.0f + 3.0f / 2048.0f, 0x3c02 },      // tie, rounds to even
+            { INFINITY, 0x7c00 },
+            { -INFINITY, 0xfc00 },
+        };
+        for (const auto& t : test_data) {
+            half h(t.v);
+            if (h.data != t.h) {
+                ThrowError("%g : %04x\n", t.v, h.data);
+            }
+        }
+        half min_denormal;
+        min_denormal.data = 0x0001;
+        if (min_denormal.to_float() != 1.0f / 16777216.0f) {
+            ThrowError("%04x : %g\n", min_denormal.data, min_denormal.to_float());
+        }
+        if (!std::isnan(half(NAN).to_float())) {
+            ThrowError("NaN : %04x\n", half(NAN).data);
+        }
+    }
+
+    // half: bulk conversions match the per element ones
+    {
+        std::vector<half> halves(65536);
+        for (size_t i = 0; i < halves.size(); ++i) {
+            halves[i].data = static_cast<uint16_t>(i);
+        }
+        std::vector<float> floats(halves.size());
+        half_to_float_array(floats.data(), halves.data(), halves.size());
+        for (size_t i = 0; i < halves.size(); ++i) {
+            const float f = halves[i].to_float();
+            const bool same = std::isnan(f) ? std::isnan(floats[i]) != 0 : memcmp(&f, &floats[i], sizeof(float)) == 0;
+            if (!same) {
+                ThrowError("%04zx : %g %g\n", i, f, floats[i]);
+            }
+            if (!std::isnan(f) && half(f).data != halves[i].data) {
+                ThrowError("%04zx : %04x\n", i, half(f).data);
+            }
+        }
+
+        Pcg pcg(123, 456);
+        for (size_t i = 0; i < floats.size(); ++i) {
+            // Random bits around the half range, denormals to overflow.
+            const uint32_t bits = (pcg.getUint32() & 0x80ffffffu) | ((100u + pcg.getUint32() % 50u) << 23);
+            memcpy(&floats[i], &bits, sizeof(float));
+        }
+        std::vector<half> converted(floats.size());
+        float_to_half_array(converted.data(), floats.data(), floats.size());
+        for (size_t i = 0; i < floats.size(); ++i) {
+            if (converted[i].data != half(floats[i]).data) {
+                ThrowError("%g : %04x %04x\n", floats[i], converted[i].data, half(floats[i]).data);
+            }
+        }
+    }
+
     // snorm16
     {
         float test_data[] = {
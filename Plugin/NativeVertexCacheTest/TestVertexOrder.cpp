@@ -0,0 +1,323 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/Foundation/Pcg.h"
+#include "Plugin/VertexOrder.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Stream/MemoryStream.h"
+#include "Plugin/InputGeomCache.h"
+#include "Plugin/GeomCacheData.h"
+#include "Plugin/NativeVertexCacheTest/TestUtil.h"
+
+using namespace nvc;
+
+// Triangles of a grid of side * side vertices, row by row.
+static std::vector<int32_t> makeGridTriangles(size_t side)
+{
+	std::vector<int32_t> indices;
+	const int32_t w = static_cast<int32_t>(side);
+	for(size_t y = 0; y + 1 < side; ++y) {
+		for(size_t x = 0; x + 1 < side; ++x) {
+			const int32_t v = static_cast<int32_t>(y * side + x);
+			indices.insert(indices.end(), { v, v + 1, v + w, v + 1, v + w + 1, v + w });
+		}
+	}
+	return indices;
+}
+
+// The triangles in a random order.
+static std::vector<int32_t> shuffleTriangles(const std::vector<int32_t>& indices, Pcg& pcg)
+{
+	const size_t triangleCount = indices.size() / 3;
+	std::vector<size_t> order(triangleCount);
+	FillSequence(order);
+	for(size_t i = triangleCount; i > 1; --i) {
+		std::swap(order[i - 1], order[pcg.getUint32() % i]);
+	}
+
+	std::vector<int32_t> shuffled;
+	for(size_t iTriangle : order) {
+		shuffled.insert(shuffled.end(), indices.begin() + iTriangle * 3, indices.begin() + iTriangle * 3 + 3);
+	}
+	return shuffled;
+}
+
+// Triangles as rotations starting with their smallest vertex, sorted: equal if the same triangles with the same winding.
+static std::vector<std::vector<int32_t>> getSortedTriangles(const int32_t* indices, size_t indexCount)
+{
+	std::vector<std::vector<int32_t>> triangles;
+	for(size_t i = 0; i + 2 < indexCount; i += 3) {
+		std::vector<int32_t> t = { indices[i], indices[i + 1], indices[i + 2] };
+		std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+		triangles.push_back(t);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+// Reordering keeps the triangles and their winding, and the cache misses go down.
+static void test0()
+{
+	Pcg pcg(123, 456);
+	const size_t side = 100;
+	const size_t vertexCount = side * side;
+	const std::vector<int32_t> grid = makeGridTriangles(side);
+
+	const std::pair<const char*, std::vector<int32_t>> inputs[] = {
+		{ "grid", grid },
+		{ "shuffled grid", shuffleTriangles(grid, pcg) },
+	};
+
+	for(const auto& input : inputs) {
+		const std::vector<int32_t>& indices = input.second;
+		std::vector<int32_t> optimized(indices.size(), -1);
+		optimizeTriangleOrder(indices.data(), indices.size(), vertexCount, DefaultVertexCacheSize, optimized.data());
+		if(getSortedTriangles(indices.data(), indices.size()) != getSortedTriangles(optimized.data(), optimized.size())) {
+			ThrowError("vertex order: %s, triangles differ\n", input.first);
+		}
+
+		const float before = getCacheMissRatio(indices.data(), indices.size(), vertexCount, DefaultVertexCacheSize);
+		const float after = getCacheMissRatio(optimized.data(), optimized.size(), vertexCount, DefaultVertexCacheSize);
+		if(after > 0.8f || after > before) {
+			ThrowError("vertex order: %s, %.3f cache misses per triangle\n", input.first, after);
+		}
+
+		std::vector<uint32_t> remap(vertexCount);
+		buildVertexFetchRemap(optimized.data(), optimized.size(), vertexCount, remap.data());
+		std::vector<uint32_t> sorted = remap;
+		std::sort(sorted.begin(), sorted.end());
+		for(size_t v = 0; v < vertexCount; ++v) {
+			if(sorted[v] != v) {
+				ThrowError("vertex order: %s, the remap isn't a permutation\n", input.first);
+			}
+		}
+		uint32_t next = 0;
+		for(int32_t index : optimized) {
+			if(remap[index] > next) {
+				ThrowError("vertex order: %s, vertices aren't in order of first use\n", input.first);
+			}
+			next = std::max(next, remap[index] + 1);
+		}
+
+		printf("vertex order: %-13s %.3f -> %.3f cache misses per triangle\n", input.first, before, after);
+	}
+
+	// Partial triangles stay at the end, unused vertices go last.
+	const std::vector<int32_t> partial = { 2, 3, 4, 4, 3, 5, 0 };
+	std::vector<int32_t> optimized(partial.size(), -1);
+	optimizeTriangleOrder(partial.data(), partial.size(), 6, DefaultVertexCacheSize, optimized.data());
+	std::vector<uint32_t> remap(7);
+	buildVertexFetchRemap(partial.data(), partial.size() - 1, 7, remap.data());
+	if(optimized.back() != 0 || remap[2] != 0 || remap[0] != 4 || remap[1] != 5 || remap[6] != 6) {
+		ThrowError("vertex order: partial triangles or unused vertices moved\n");
+	}
+}
+
+struct Mesh {
+	size_t side;
+	bool hasLines;
+};
+
+// Frames of meshes whose triangles and vertices are shuffled, the topology changes every changePeriod frames.
+static void fillCache(InputGeomCache& igc, const std::vector<Mesh>& meshes, size_t frameCount, size_t changePeriod)
+{
+	std::vector<int32_t> indices;
+	std::vector<GeomMesh> geomMeshes;
+	std::vector<GeomSubmesh> geomSubmeshes;
+	std::vector<uint32_t> vertexIds;
+
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		if(iFrame % changePeriod == 0) {
+			Pcg pcg(iFrame / changePeriod, 456);
+			indices.clear();
+			geomMeshes.clear();
+			geomSubmeshes.clear();
+			vertexIds.clear();
+
+			for(const Mesh& mesh : meshes) {
+				const size_t vertexCount = mesh.side * mesh.side;
+				GeomMesh geomMesh = { static_cast<uint32_t>(vertexIds.size()), static_cast<uint32_t>(vertexCount)
+					, static_cast<uint32_t>(geomSubmeshes.size()), 0 };
+
+				// Vertex v of the mesh is stored at position[v], indices are relative to the mesh.
+				std::vector<uint32_t> position(vertexCount);
+				FillSequence(position);
+				for(size_t i = vertexCount; i > 1; --i) {
+					std::swap(position[i - 1], position[pcg.getUint32() % i]);
+				}
+				std::vector<uint32_t> meshVertexIds(vertexCount);
+				for(size_t v = 0; v < vertexCount; ++v) {
+					meshVertexIds[position[v]] = static_cast<uint32_t>(v);
+				}
+				vertexIds.insert(vertexIds.end(), meshVertexIds.begin(), meshVertexIds.end());
+
+				std::vector<int32_t> triangles = shuffleTriangles(makeGridTriangles(mesh.side), pcg);
+				for(auto& index : triangles) {
+					index = static_cast<int32_t>(position[index]);
+				}
+				geomSubmeshes.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(triangles.size()), Topology::Triangles });
+				indices.insert(indices.end(), triangles.begin(), triangles.end());
+				++geomMesh.submeshCount;
+
+				if(mesh.hasLines) {
+					// The grid's first row as lines.
+					std::vector<int32_t> lines;
+					for(size_t x = 0; x + 1 < mesh.side; ++x) {
+						lines.insert(lines.end(), { static_cast<int32_t>(position[x]), static_cast<int32_t>(position[x + 1]) });
+					}
+					geomSubmeshes.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lines.size()), Topology::Lines });
+					indices.insert(indices.end(), lines.begin(), lines.end());
+					++geomMesh.submeshCount;
+				}
+				geomMeshes.push_back(geomMesh);
+			}
+		}
+
+		// A wave over the grid, points follow the vertex ids.
+		const size_t vertexCount = vertexIds.size();
+		std::vector<float3> points(vertexCount);
+		std::vector<float3> normals(vertexCount);
+		std::vector<float2> uvs(vertexCount);
+		std::vector<float2> uv1s(vertexCount, float2{ 0.0f, 0.0f });
+		std::vector<float3> velocities(vertexCount, float3{ 0.0f, 0.0f, 0.0f });
+		for(const GeomMesh& geomMesh : geomMeshes) {
+			const size_t side = static_cast<size_t>(std::sqrt(static_cast<double>(geomMesh.vertexCount)) + 0.5);
+			for(size_t i = geomMesh.vertexOffset; i < geomMesh.vertexOffset + geomMesh.vertexCount; ++i) {
+				const size_t x = vertexIds[i] % side;
+				const size_t y = vertexIds[i] / side;
+				const float z = std::sin(x * 0.1f + iFrame * 0.2f) * std::cos(y * 0.1f);
+				points[i] = float3{ static_cast<float>(x), static_cast<float>(y), z };
+				normals[i] = float3{ 0.0f, std::sin(z), std::cos(z) };
+				uvs[i] = float2{ static_cast<float>(x) / side, static_cast<float>(y) / side };
+			}
+		}
+		void* vertices[5] = { points.data(), normals.data(), uvs.data(), uv1s.data(), velocities.data() };
+
+		GeomCacheData data {};
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.vertices = vertices;
+		data.vertexCount = vertexCount;
+		data.meshes = geomMeshes.data();
+		data.meshCount = geomMeshes.size();
+		data.submeshes = geomSubmeshes.data();
+		data.submeshCount = geomSubmeshes.size();
+		igc.addData(iFrame / 30.0f, &data);
+	}
+}
+
+// The primitives of a submesh as the points of their vertices, sorted.
+static std::vector<std::vector<float>> getSubmeshPoints(const GeomCacheData& data, const GeomMesh& mesh, const GeomSubmesh& submesh)
+{
+	const size_t primitiveSize = submesh.topology == Topology::Triangles ? 3 : 2;
+	const int32_t* indices = static_cast<const int32_t*>(data.indices) + submesh.indexOffset;
+	const float3* points = static_cast<const float3*>(data.vertices[0]) + mesh.vertexOffset;
+
+	std::vector<std::vector<float>> primitives;
+	for(size_t i = 0; i < submesh.indexCount; i += primitiveSize) {
+		std::vector<std::vector<float>> corners;
+		for(size_t j = 0; j < primitiveSize; ++j) {
+			const float3& p = points[indices[i + j]];
+			corners.push_back({ p[0], p[1], p[2] });
+		}
+		// Triangles keep their winding, starting with their smallest corner.
+		if(primitiveSize == 3) {
+			std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+		}
+		std::vector<float> primitive;
+		for(const auto& corner : corners) {
+			primitive.insert(primitive.end(), corner.begin(), corner.end());
+		}
+		primitives.push_back(primitive);
+	}
+	std::sort(primitives.begin(), primitives.end());
+	return primitives;
+}
+
+static size_t getCompressedSize(const InputGeomCache& igc)
+{
+	MemoryStream stream(0, true);
+	QuantisationCompressor compressor(true);
+	compressor.compress(igc, &stream);
+	return stream.getLength();
+}
+
+// Reordering a cache keeps every frame's geometry, consistently over frames with the same topology.
+static void test1()
+{
+	static const GeomCacheDesc descs[] = {
+		{ nvcSEMANTIC_POINTS, DataFormat::Float3 },
+		{ nvcSEMANTIC_NORMALS, DataFormat::Float3 },
+		{ nvcSEMANTIC_UV0, DataFormat::Float2 },
+		{ nvcSEMANTIC_UV1, DataFormat::Float2 },
+		{ nvcSEMANTIC_VELOCITIES, DataFormat::Float3 },
+		GEOM_CACHE_DESCRIPTOR_END
+	};
+	const std::vector<Mesh> meshes = { { 60, true }, { 40, false } };
+	const size_t frameCount = 20;
+	const size_t changePeriod = 7;
+
+	InputGeomCache original(descs);
+	fillCache(original, meshes, frameCount, changePeriod);
+	InputGeomCache optimized(descs);
+	fillCache(optimized, meshes, frameCount, changePeriod);
+
+	const auto t0 = std::chrono::high_resolution_clock::now();
+	optimized.optimizeVertexOrder();
+	const auto t1 = std::chrono::high_resolution_clock::now();
+
+	float missesBefore = 0.0f;
+	float missesAfter = 0.0f;
+	for(size_t iFrame = 0; iFrame < frameCount; ++iFrame) {
+		float time = 0.0f;
+		GeomCacheData before {};
+		GeomCacheData after {};
+		original.getData(iFrame, time, &before);
+		optimized.getData(iFrame, time, &after);
+
+		if(before.indexCount != after.indexCount || before.vertexCount != after.vertexCount
+			|| memcmp(before.meshes, after.meshes, sizeof(GeomMesh) * before.meshCount) != 0
+			|| memcmp(before.submeshes, after.submeshes, sizeof(GeomSubmesh) * before.submeshCount) != 0) {
+			ThrowError("vertex order: frame %zd, counts or ranges changed\n", iFrame);
+		}
+
+		for(size_t iMesh = 0; iMesh < after.meshCount; ++iMesh) {
+			const GeomMesh& mesh = after.meshes[iMesh];
+			for(size_t iSubmesh = mesh.submeshOffset; iSubmesh < mesh.submeshOffset + mesh.submeshCount; ++iSubmesh) {
+				const GeomSubmesh& submesh = after.submeshes[iSubmesh];
+				if(getSubmeshPoints(before, mesh, submesh) != getSubmeshPoints(after, mesh, submesh)) {
+					ThrowError("vertex order: frame %zd, submesh %zd has different primitives\n", iFrame, iSubmesh);
+				}
+				if(submesh.topology == Topology::Triangles) {
+					missesBefore += getCacheMissRatio(static_cast<const int32_t*>(before.indices) + submesh.indexOffset, submesh.indexCount, mesh.vertexCount, DefaultVertexCacheSize);
+					missesAfter += getCacheMissRatio(static_cast<const int32_t*>(after.indices) + submesh.indexOffset, submesh.indexCount, mesh.vertexCount, DefaultVertexCacheSize);
+				}
+			}
+		}
+
+		// Frames with the same topology before still have the same one.
+		if(iFrame % changePeriod != 0) {
+			GeomCacheData previous {};
+			optimized.getData(iFrame - 1, time, &previous);
+			if(memcmp(previous.indices, after.indices, sizeof(int32_t) * after.indexCount) != 0) {
+				ThrowError("vertex order: frame %zd, reordered differently from the previous frame\n", iFrame);
+			}
+		}
+	}
+
+	const size_t submeshCount = frameCount * meshes.size();
+	const size_t sizeBefore = getCompressedSize(original);
+	const size_t sizeAfter = getCompressedSize(optimized);
+	printf("vertex order: %.3f -> %.3f cache misses per triangle, quantisation file %zd -> %zd bytes, reordered in %.2f ms/frame\n"
+		, missesBefore / submeshCount, missesAfter / submeshCount, sizeBefore, sizeAfter
+		, std::chrono::duration<double, std::milli>(t1 - t0).count() / frameCount);
+	if(missesAfter >= missesBefore || sizeAfter >= sizeBefore) {
+		ThrowError("vertex order: reordering doesn't help\n");
+	}
+}
+
+void RunTest_VertexOrder()
+{
+	test0();
+	test1();
+}
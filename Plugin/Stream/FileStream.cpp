@@ -2,12 +2,18 @@
 #include "Plugin/PrecompiledHeader.h"
 
 //! Header Include.
-#if defined(_MSC_VER)
+#include "FileStream.h"
+#if defined(NVC_FILESTREAM_POSIX_MMAP)
+#include <fcntl.h> // open(), O_RDONLY, etc.
+#include <unistd.h> // close(), ftruncate(), sysconf()
+#include <sys/mman.h> // mmap(), mremap(), munmap(), madvise()
+#include <sys/stat.h> // fstat()
+#elif defined(_MSC_VER)
 #include <io.h> // _filelengthi64
 #include <fcntl.h> // _O_RDONLY, etc.
 #endif
-#include "FileStream.h"
 
+#if !defined(NVC_FILESTREAM_POSIX_MMAP)
 namespace {
 	DWORD DWORD_HI(int64_t x) {
 		return static_cast<DWORD>(x >> 32);
@@ -94,6 +100,7 @@ namespace {
 		uint8_t* m_Base;
 	};
 } // Anonymous namespace
+#endif
 
 FileStream::FileStream()
 {
@@ -156,10 +163,39 @@ void FileStream::setLength(size_t length)
 	assert(canWrite());
 
 	const auto sLength = static_cast<int64_t>(length);
-	grow(sLength);
-	m_Length = sLength;
+	if(grow(sLength)) {
+		m_Length = sLength;
+	}
 }
 
+void FileStream::seek(int64_t offset, SeekOrigin origin)
+{
+	assert(canSeek());
+	int64_t nextCursor = -1;
+
+	switch(origin) {
+	default:
+		break;
+	case Stream::SeekOrigin::Begin:
+		nextCursor = offset;
+		break;
+	case Stream::SeekOrigin::Current:
+		nextCursor = m_Cursor + offset;
+		break;
+	case Stream::SeekOrigin::End:
+		nextCursor = m_Length - offset;
+		break;
+	}
+	assert(nextCursor >= 0 && nextCursor <= m_Length);
+
+	m_Cursor = nextCursor;
+}
+
+int64_t FileStream::alignToPageSize(int64_t size) const {
+	return ((size + m_PageSize - 1) / m_PageSize) * m_PageSize;
+}
+
+#if !defined(NVC_FILESTREAM_POSIX_MMAP)
 void FileStream::copyTo(Stream* stream, size_t length)
 {
 	assert(canRead() && stream->canWrite());
@@ -207,7 +243,11 @@ size_t FileStream::write(const void* buffer, size_t length)
 	const auto sLength = static_cast<int64_t>(length);
 	const auto nextCursor = m_Cursor + sLength;
 	if(nextCursor > m_Length) {
-		setLength(nextCursor);
+		// The disk is full, nothing is written.
+		if(!grow(nextCursor)) {
+			return 0;
+		}
+		m_Length = nextCursor;
 	}
 
 	{
@@ -224,27 +264,35 @@ size_t FileStream::write(const void* buffer, size_t length)
 	return length;
 }
 
-void FileStream::seek(int64_t offset, SeekOrigin origin)
+const void* FileStream::view(size_t offset, size_t length) const
 {
-	assert(canSeek());
-	int64_t nextCursor = -1;
+	assert(canRead());
 
-	switch(origin) {
-	default:
-		break;
-	case Stream::SeekOrigin::Begin:
-		nextCursor = offset;
-		break;
-	case Stream::SeekOrigin::Current:
-		nextCursor = m_Cursor + offset;
-		break;
-	case Stream::SeekOrigin::End:
-		nextCursor = m_Length - offset;
-		break;
+	const auto sOffset = static_cast<int64_t>(offset);
+	const auto sLength = static_cast<int64_t>(length);
+	if(sOffset + sLength > m_Length) {
+		return nullptr;
 	}
-	assert(nextCursor >= 0 && nextCursor <= m_Length);
 
-	m_Cursor = nextCursor;
+	// note : writable file mapping is recreated by grow(), so there's no view to hand out.
+	if((m_OpenModes & OpenModes::Write) != 0) {
+		return nullptr;
+	}
+
+	if(m_View == nullptr) {
+		m_View = static_cast<uint8_t*>(MapViewOfFileEx(
+			  m_HandleMap
+			, FILE_MAP_READ
+			, 0
+			, 0
+			, 0
+			, nullptr
+		));
+		if(m_View == nullptr) {
+			return nullptr;
+		}
+	}
+	return m_View + offset;
 }
 
 void FileStream::flush()
@@ -334,6 +382,11 @@ void FileStream::close()
 	// Since we'll close m_HandleMap after this line, must call canWrite() and getLength() here.
 	const auto oCanWrite = canWrite();
 
+	if(m_View != nullptr) {
+		UnmapViewOfFile(m_View);
+		m_View = nullptr;
+	}
+
 	if(m_HandleMap != INVALID_HANDLE_VALUE) {
 		CloseHandle(m_HandleMap);
 		m_HandleMap = INVALID_HANDLE_VALUE;
@@ -385,13 +438,233 @@ bool FileStream::grow(int64_t size)
 	return true;
 }
 
-int64_t FileStream::alignToPageSize(int64_t size) const {
-	return ((size + m_PageSize - 1) / m_PageSize) * m_PageSize;
-}
-
 bool FileStream::truncate(int64_t size) {
 	// _chsize_s
 	// https://msdn.microsoft.com/en-us/library/whx354w1.aspx
 	const auto result = _chsize_s(m_Fd, size);
 	return result == 0;
 }
+
+#else // NVC_FILESTREAM_POSIX_MMAP
+
+// POSIX backend
+//
+// The file is mapped once in open() and stays mapped until close(), so read()/write()
+// are plain memcpy() from/to the mapping and only page faults hit the kernel.
+// Writable streams reserve m_Capacity bytes on disk (ftruncate) and grow() extends the
+// mapping in place with mremap() where available. close() truncates back to m_Length.
+
+void FileStream::copyTo(Stream* stream, size_t length)
+{
+	assert(canRead() && stream->canWrite());
+
+	const auto sLength = static_cast<int64_t>(length);
+	const auto readSize = std::min(m_Length - m_Cursor, sLength);
+	if(readSize > 0) {
+		stream->write(m_Map + m_Cursor, readSize);
+		seek(readSize, SeekOrigin::Current);
+	}
+}
+
+size_t FileStream::read(void* buffer, size_t length) const
+{
+	assert(canRead());
+	const auto sLength = static_cast<int64_t>(length);
+	const auto readSize = std::min(m_Length - m_Cursor, sLength);
+	if(readSize > 0) {
+		memcpy(buffer, m_Map + m_Cursor, readSize);
+		const_cast<FileStream*>(this)->seek(readSize, SeekOrigin::Current);
+	}
+	// note: should we take care about error case?
+	return readSize;
+}
+
+size_t FileStream::write(const void* buffer, size_t length)
+{
+	assert(canWrite());
+
+	const auto sLength = static_cast<int64_t>(length);
+	const auto nextCursor = m_Cursor + sLength;
+	if(nextCursor > m_Length) {
+		// The disk or the address space is full, nothing is written.
+		if(!grow(nextCursor)) {
+			return 0;
+		}
+		m_Length = nextCursor;
+	}
+
+	memcpy(m_Map + m_Cursor, buffer, sLength);
+	seek(sLength, SeekOrigin::Current);
+	return length;
+}
+
+const void* FileStream::view(size_t offset, size_t length) const
+{
+	assert(canRead());
+
+	const auto sOffset = static_cast<int64_t>(offset);
+	const auto sLength = static_cast<int64_t>(length);
+	if(sOffset + sLength > m_Length) {
+		return nullptr;
+	}
+	return m_Map + offset;
+}
+
+void FileStream::flush()
+{
+	assert(isGood());
+	if((m_OpenModes & OpenModes::Write) != 0 && m_Map != nullptr) {
+		msync(m_Map, static_cast<size_t>(m_Length), MS_ASYNC);
+	}
+}
+
+bool FileStream::open(const char* filename, OpenModes openModes) {
+	close();
+	this->m_OpenModes = openModes;
+
+	// note: PROT_WRITE on a MAP_SHARED mapping requires O_RDWR, even for write only streams.
+	int oflag = -1;
+	int advice = MADV_NORMAL;
+
+	switch(openModes) {
+	default:	break;
+	case FileStream::OpenModes::Random_ReadOnly:		oflag = O_RDONLY;						advice = MADV_RANDOM;		break;
+	case FileStream::OpenModes::Sequential_ReadOnly:	oflag = O_RDONLY;						advice = MADV_SEQUENTIAL;	break;
+	case FileStream::OpenModes::Random_WriteOnly:		oflag = O_RDWR | O_CREAT | O_TRUNC;	advice = MADV_RANDOM;		break;
+	case FileStream::OpenModes::Sequential_WriteOnly:	oflag = O_RDWR | O_CREAT | O_TRUNC;	advice = MADV_SEQUENTIAL;	break;
+	case FileStream::OpenModes::Random_ReadWrite:		oflag = O_RDWR | O_CREAT | O_TRUNC;	advice = MADV_RANDOM;		break;
+	case FileStream::OpenModes::Sequential_ReadWrite:	oflag = O_RDWR | O_CREAT | O_TRUNC;	advice = MADV_SEQUENTIAL;	break;
+	}
+	if(oflag == -1) {
+		return false;
+	}
+
+	m_Fd = ::open(filename, oflag | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if(m_Fd < 0) {
+		m_Fd = InvalidFd;
+		return false;
+	}
+
+	m_PageSize = static_cast<int64_t>(sysconf(_SC_PAGESIZE));
+	m_GrowSize = 1024 * 1024;
+
+	if(openModes & OpenModes::CreateAlways) {
+		m_Length = 0;
+	} else {
+		struct stat st {};
+		if(fstat(m_Fd, &st) != 0) {
+			return false;
+		}
+		m_Length = static_cast<int64_t>(st.st_size);
+	}
+
+	if((m_OpenModes & OpenModes::Write) != 0) {
+		const auto capacity = alignToPageSize(m_Length + m_GrowSize);
+		if(ftruncate(m_Fd, capacity) != 0 || !remap(capacity)) {
+			return false;
+		}
+		m_Capacity = capacity;
+	} else {
+		// note: mmap() refuses zero length, an empty file simply stays unmapped.
+		if(m_Length > 0 && !remap(m_Length)) {
+			return false;
+		}
+		m_Capacity = m_Length;
+	}
+
+	if(m_Map != nullptr) {
+		madvise(m_Map, static_cast<size_t>(m_MapLength), advice);
+	}
+
+	return true;
+}
+
+void FileStream::close()
+{
+	// Since we'll unmap after this line, must call canWrite() here.
+	const auto oCanWrite = canWrite();
+
+	unmap();
+
+	if(m_Fd != InvalidFd) {
+		if(oCanWrite) {
+			const auto truncateResult = truncate(m_Length);
+			assert(truncateResult);
+			(void) truncateResult;
+		}
+		::close(m_Fd);
+		m_Fd = InvalidFd;
+	}
+
+	m_OpenModes = OpenModes::None;
+	m_Cursor = 0;
+	m_Length = 0;
+	m_Capacity = 0;
+}
+
+bool FileStream::isGood() const
+{
+	return (m_Fd != InvalidFd) && (m_Map != nullptr || m_Length == 0);
+}
+
+bool FileStream::grow(int64_t size)
+{
+	if(size <= m_Capacity) {
+		return true;
+	}
+
+	assert(canWrite());
+
+	// Grow geometrically so a long sequential write costs O(log n) remaps.
+	const auto capacity = alignToPageSize(std::max(size + m_GrowSize, m_Capacity + m_Capacity / 2));
+	if(ftruncate(m_Fd, capacity) != 0) {
+		return false;
+	}
+	if(!remap(capacity)) {
+		// Keep what was written so far mapped, the stream stays usable up to m_Capacity.
+		if(m_Capacity > 0) {
+			remap(m_Capacity);
+		}
+		return false;
+	}
+	m_Capacity = capacity;
+	return true;
+}
+
+bool FileStream::truncate(int64_t size) {
+	return ftruncate(m_Fd, size) == 0;
+}
+
+bool FileStream::remap(int64_t capacity) {
+	const int prot = ((m_OpenModes & OpenModes::Write) != 0) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+	void* map = MAP_FAILED;
+
+#if defined(__linux__)
+	if(m_Map != nullptr) {
+		map = mremap(m_Map, static_cast<size_t>(m_MapLength), static_cast<size_t>(capacity), MREMAP_MAYMOVE);
+	}
+#else
+	unmap();
+#endif
+	if(map == MAP_FAILED) {
+		unmap();
+		map = mmap(nullptr, static_cast<size_t>(capacity), prot, MAP_SHARED, m_Fd, 0);
+	}
+	if(map == MAP_FAILED) {
+		return false;
+	}
+
+	m_Map = static_cast<uint8_t*>(map);
+	m_MapLength = capacity;
+	return true;
+}
+
+void FileStream::unmap() {
+	if(m_Map != nullptr) {
+		munmap(m_Map, static_cast<size_t>(m_MapLength));
+		m_Map = nullptr;
+		m_MapLength = 0;
+	}
+}
+
+#endif // NVC_FILESTREAM_POSIX_MMAP
@@ -6,6 +6,12 @@
 #include <windows.h>
 #endif
 
+// note: on Windows every access builds a temporary view (MapViewOfFileEx).
+//       on POSIX the whole file is mapped once and remapped when it grows.
+#if !defined(_MSC_VER)
+#define NVC_FILESTREAM_POSIX_MMAP
+#endif
+
 class FileStream final : public Stream
 {
 public:
@@ -47,6 +53,8 @@ public:
 
 	void seek(int64_t offset, SeekOrigin origin) override;
 
+	const void* view(size_t offset, size_t length) const override;
+
 	void flush() override;
 	void close() override;
 
@@ -68,17 +76,28 @@ protected:
 
 	OpenModes m_OpenModes = OpenModes::None;
 	int m_Fd = InvalidFd;
+#if defined(NVC_FILESTREAM_POSIX_MMAP)
+	bool remap(int64_t capacity);
+	void unmap();
+
+	uint8_t* m_Map = nullptr;
+	int64_t m_MapLength = 0;
+#else
 	HANDLE m_HandleMap = INVALID_HANDLE_VALUE;
+	mutable uint8_t* m_View = nullptr; // Whole file read only view, created by the first view() call.
 //	uint8_t* m_Map = nullptr;
 //	const int DefaultWindowLength = 1024 * 1024;
 //	int64_t m_WindowOffset = 0;
 //	int64_t m_WindowLength = DefaultWindowLength;
+#endif
 
 	int64_t m_Cursor = 0;
 	int64_t m_Length = 0;
 	int64_t m_Capacity = 0;
 	int64_t m_PageSize = 0;
 	int64_t m_GrowSize = 0;
+#if !defined(NVC_FILESTREAM_POSIX_MMAP)
 	DWORD m_flProtect = 0;
 	DWORD m_dwDesiredAccess = 0;
+#endif
 };
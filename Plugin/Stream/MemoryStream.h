@@ -49,6 +49,8 @@ public:
 
 	void seek(int64_t offset, SeekOrigin origin) override;
 
+	const void* view(size_t offset, size_t length) const override;
+
 	void flush() override;
 	void close() override;
 
@@ -111,6 +113,18 @@ inline size_t MemoryStream::getLength() const
 	return m_Length;
 }
 
+inline const void* MemoryStream::view(size_t offset, size_t length) const
+{
+	assert(m_Closed == false);
+
+	if (offset + length > m_Length)
+	{
+		return nullptr;
+	}
+
+	return static_cast<const int8_t*>(m_Data) + offset;
+}
+
 template <typename TData>
 TData MemoryStream::read() const
 {
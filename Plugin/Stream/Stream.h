@@ -31,6 +31,12 @@ public:
 
 	virtual void seek(int64_t offset, SeekOrigin origin) = 0;
 
+	// Zero-copy access to the bytes in [offset, offset + length). Doesn't move the cursor.
+	// The returned pointer stays valid for the stream's lifetime, or for writable streams until the stream grows.
+	// Returns nullptr if the range is out of bounds, or if the stream doesn't have its bytes in memory (the
+	// default), callers copy them with read() then.
+	virtual const void* view(size_t /*offset*/, size_t /*length*/) const { return nullptr; }
+
 	virtual void flush() = 0;
 	virtual void close() = 0;
 
@@ -0,0 +1,404 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "VertexNormals.h"
+
+//! Project Includes.
+#include "Plugin/Compression/PackedTransform.h"
+#include "Plugin/Foundation/Simd.h"
+
+namespace nvc {
+
+namespace
+{
+	inline void sub(const float3& a, const float3& b, float* dst)
+	{
+		dst[0] = a[0] - b[0];
+		dst[1] = a[1] - b[1];
+		dst[2] = a[2] - b[2];
+	}
+
+	inline float dot(const float* a, const float* b)
+	{
+		return (a[0] * b[0] + a[1] * b[1]) + a[2] * b[2];
+	}
+
+	inline void cross(const float* a, const float* b, float* dst)
+	{
+		dst[0] = a[1] * b[2] - a[2] * b[1];
+		dst[1] = a[2] * b[0] - a[0] * b[2];
+		dst[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	// v minus its component along the unit vector n, normalised. False if nothing is left.
+	inline bool projectAndNormalise(const float* n, const float* v, float* dst)
+	{
+		const float d = dot(n, v);
+		dst[0] = v[0] - n[0] * d;
+		dst[1] = v[1] - n[1] * d;
+		dst[2] = v[2] - n[2] * d;
+
+		const float lengthSquared = dot(dst, dst);
+		if (!(lengthSquared > 0.0f))
+		{
+			return false;
+		}
+		const float k = 1.0f / sqrtf(lengthSquared);
+		dst[0] *= k;
+		dst[1] *= k;
+		dst[2] *= k;
+		return true;
+	}
+
+	// acos(x) to within 7e-5 radians (Abramowitz and Stegun 4.4.45), plenty for weighting the corners and much
+	// cheaper than std::acos.
+	inline float approximateAcos(float x)
+	{
+		const float a = std::min(std::abs(x), 1.0f);
+		const float r = sqrtf(1.0f - a) * (1.5707288f + a * (-0.2121144f + a * (0.0742610f + a * -0.0187293f)));
+		return x < 0.0f ? 3.14159265f - r : r;
+	}
+
+	//! Face normals, the same operations in every kernel.
+
+	void computeFaceNormalsScalar(const uint32_t* triangles, const float3* points, size_t count, float3* faceNormals)
+	{
+		for (size_t t = 0; t < count; ++t)
+		{
+			const float3& p0 = points[triangles[3 * t + 0]];
+			float e1[3], e2[3];
+			sub(points[triangles[3 * t + 1]], p0, e1);
+			sub(points[triangles[3 * t + 2]], p0, e2);
+			cross(e1, e2, &faceNormals[t][0]);
+		}
+	}
+
+#if NVC_SIMD_X86
+
+	NVC_TARGET_SSE41 void computeFaceNormalsSSE41(const uint32_t* triangles, const float3* points, size_t count, float3* faceNormals)
+	{
+		const float* p = &points[0][0];
+
+		size_t t = 0;
+		for (; t + 4 <= count; t += 4)
+		{
+			const uint32_t* tri = triangles + 3 * t;
+			__m128 e1[3], e2[3];
+			for (int c = 0; c < 3; ++c)
+			{
+				const __m128 p0 = _mm_setr_ps(p[3 * tri[0] + c], p[3 * tri[3] + c], p[3 * tri[6] + c], p[3 * tri[9] + c]);
+				e1[c] = _mm_sub_ps(_mm_setr_ps(p[3 * tri[1] + c], p[3 * tri[4] + c], p[3 * tri[7] + c], p[3 * tri[10] + c]), p0);
+				e2[c] = _mm_sub_ps(_mm_setr_ps(p[3 * tri[2] + c], p[3 * tri[5] + c], p[3 * tri[8] + c], p[3 * tri[11] + c]), p0);
+			}
+
+			alignas(16) float n[3][4];
+			_mm_store_ps(n[0], _mm_sub_ps(_mm_mul_ps(e1[1], e2[2]), _mm_mul_ps(e1[2], e2[1])));
+			_mm_store_ps(n[1], _mm_sub_ps(_mm_mul_ps(e1[2], e2[0]), _mm_mul_ps(e1[0], e2[2])));
+			_mm_store_ps(n[2], _mm_sub_ps(_mm_mul_ps(e1[0], e2[1]), _mm_mul_ps(e1[1], e2[0])));
+			for (int i = 0; i < 4; ++i)
+			{
+				faceNormals[t + i][0] = n[0][i];
+				faceNormals[t + i][1] = n[1][i];
+				faceNormals[t + i][2] = n[2][i];
+			}
+		}
+
+		computeFaceNormalsScalar(triangles + 3 * t, points, count - t, faceNormals + t);
+	}
+
+	// The corners of 8 triangles are gathered, then their components.
+	NVC_TARGET_AVX2 void computeFaceNormalsAVX2(const uint32_t* triangles, const float3* points, size_t count, float3* faceNormals)
+	{
+		const float* p = &points[0][0];
+		const __m256i cornerOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+		const __m256i three = _mm256_set1_epi32(3);
+
+		size_t t = 0;
+		for (; t + 8 <= count; t += 8)
+		{
+			const int* tri = reinterpret_cast<const int*>(triangles + 3 * t);
+			__m256i v[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				v[k] = _mm256_mullo_epi32(_mm256_i32gather_epi32(tri + k, cornerOffsets, 4), three);
+			}
+
+			__m256 e1[3], e2[3];
+			for (int c = 0; c < 3; ++c)
+			{
+				const __m256 p0 = _mm256_i32gather_ps(p + c, v[0], 4);
+				e1[c] = _mm256_sub_ps(_mm256_i32gather_ps(p + c, v[1], 4), p0);
+				e2[c] = _mm256_sub_ps(_mm256_i32gather_ps(p + c, v[2], 4), p0);
+			}
+
+			alignas(32) float n[3][8];
+			_mm256_store_ps(n[0], _mm256_sub_ps(_mm256_mul_ps(e1[1], e2[2]), _mm256_mul_ps(e1[2], e2[1])));
+			_mm256_store_ps(n[1], _mm256_sub_ps(_mm256_mul_ps(e1[2], e2[0]), _mm256_mul_ps(e1[0], e2[2])));
+			_mm256_store_ps(n[2], _mm256_sub_ps(_mm256_mul_ps(e1[0], e2[1]), _mm256_mul_ps(e1[1], e2[0])));
+			for (int i = 0; i < 8; ++i)
+			{
+				faceNormals[t + i][0] = n[0][i];
+				faceNormals[t + i][1] = n[1][i];
+				faceNormals[t + i][2] = n[2][i];
+			}
+		}
+
+		computeFaceNormalsScalar(triangles + 3 * t, points, count - t, faceNormals + t);
+	}
+
+#endif // NVC_SIMD_X86
+
+	// A unit vector perpendicular to n, for vertices without a usable face tangent.
+	void getPerpendicular(const float* n, float* dst)
+	{
+		const float axis[3] = { std::abs(n[0]) < 0.9f ? 1.0f : 0.0f, std::abs(n[0]) < 0.9f ? 0.0f : 1.0f, 0.0f };
+		if (!projectAndNormalise(n, axis, dst))
+		{
+			dst[0] = 1.0f;
+			dst[1] = 0.0f;
+			dst[2] = 0.0f;
+		}
+	}
+}
+
+bool VertexTriangles::isSameTopology(const GeomCacheData& data) const
+{
+	return m_VertexCount == data.vertexCount
+		&& m_Indices.size() == (data.indices ? data.indexCount : 0)
+		&& m_Meshes.size() == (data.meshes ? data.meshCount : 0)
+		&& m_Submeshes.size() == (data.submeshes ? data.submeshCount : 0)
+		&& (m_Indices.empty() || memcmp(m_Indices.data(), data.indices, sizeof(int32_t) * m_Indices.size()) == 0)
+		&& (m_Meshes.empty() || memcmp(m_Meshes.data(), data.meshes, sizeof(GeomMesh) * m_Meshes.size()) == 0)
+		&& (m_Submeshes.empty() || memcmp(m_Submeshes.data(), data.submeshes, sizeof(GeomSubmesh) * m_Submeshes.size()) == 0);
+}
+
+void VertexTriangles::clear()
+{
+	m_VertexCount = 0;
+	m_Triangles.clear();
+	m_CornerOffsets.clear();
+	m_Corners.clear();
+	m_Indices.clear();
+	m_Meshes.clear();
+	m_Submeshes.clear();
+}
+
+bool VertexTriangles::update(const GeomCacheData& data)
+{
+	if (isSameTopology(data))
+	{
+		return !m_Triangles.empty();
+	}
+
+	clear();
+	if (data.indices == nullptr || data.meshes == nullptr || data.submeshes == nullptr)
+	{
+		return false;
+	}
+
+	const int32_t* indices = static_cast<const int32_t*>(data.indices);
+	m_VertexCount = data.vertexCount;
+	m_Indices.assign(indices, indices + data.indexCount);
+	m_Meshes.assign(data.meshes, data.meshes + data.meshCount);
+	m_Submeshes.assign(data.submeshes, data.submeshes + data.submeshCount);
+
+	// The gathers of computeFaceNormals() index the point components with int32_t.
+	if (data.vertexCount >= INT32_MAX / 3)
+	{
+		return false;
+	}
+
+	// Triangles with an index outside of their mesh are skipped.
+	for (const GeomMesh& mesh : m_Meshes)
+	{
+		if (static_cast<size_t>(mesh.vertexOffset) + mesh.vertexCount > data.vertexCount
+			|| static_cast<size_t>(mesh.submeshOffset) + mesh.submeshCount > data.submeshCount)
+		{
+			continue;
+		}
+
+		for (uint32_t iSubmesh = mesh.submeshOffset; iSubmesh < mesh.submeshOffset + mesh.submeshCount; ++iSubmesh)
+		{
+			const GeomSubmesh& submesh = m_Submeshes[iSubmesh];
+			if (submesh.topology != Topology::Triangles
+				|| static_cast<size_t>(submesh.indexOffset) + submesh.indexCount > data.indexCount)
+			{
+				continue;
+			}
+
+			const int32_t* submeshIndices = indices + submesh.indexOffset;
+			for (uint32_t i = 0; i + 3 <= submesh.indexCount; i += 3)
+			{
+				if (std::all_of(submeshIndices + i, submeshIndices + i + 3
+					, [&mesh](int32_t index) { return index >= 0 && static_cast<uint32_t>(index) < mesh.vertexCount; }))
+				{
+					m_Triangles.push_back(mesh.vertexOffset + submeshIndices[i + 0]);
+					m_Triangles.push_back(mesh.vertexOffset + submeshIndices[i + 1]);
+					m_Triangles.push_back(mesh.vertexOffset + submeshIndices[i + 2]);
+				}
+			}
+		}
+	}
+
+	m_CornerOffsets.assign(m_VertexCount + 1, 0);
+	for (const uint32_t v : m_Triangles)
+	{
+		++m_CornerOffsets[v + 1];
+	}
+	for (size_t v = 0; v < m_VertexCount; ++v)
+	{
+		m_CornerOffsets[v + 1] += m_CornerOffsets[v];
+	}
+
+	m_Corners.resize(m_Triangles.size());
+	std::vector<uint32_t> cursors(m_CornerOffsets.begin(), m_CornerOffsets.end() - 1);
+	for (size_t corner = 0; corner < m_Triangles.size(); ++corner)
+	{
+		m_Corners[cursors[m_Triangles[corner]]++] = static_cast<uint32_t>(corner);
+	}
+
+	return !m_Triangles.empty();
+}
+
+void computeFaceNormals(const VertexTriangles& triangles, const float3* points, size_t first, size_t count, float3* faceNormals)
+{
+	assert(first + count <= triangles.getTriangleCount());
+	const uint32_t* firstTriangle = triangles.getTriangles() + 3 * first;
+
+	switch (GetSimdLevel())
+	{
+#if NVC_SIMD_X86
+	case SimdLevel::AVX2:	computeFaceNormalsAVX2(firstTriangle, points, count, faceNormals + first);		break;
+	case SimdLevel::SSE41:	computeFaceNormalsSSE41(firstTriangle, points, count, faceNormals + first);	break;
+#endif
+	default:				computeFaceNormalsScalar(firstTriangle, points, count, faceNormals + first);	break;
+	}
+}
+
+void computeVertexNormals(const VertexTriangles& triangles, const float3* faceNormals, size_t first, size_t count, float3* normals)
+{
+	assert(first + count <= triangles.getVertexCount());
+	const uint32_t* offsets = triangles.getCornerOffsets();
+	const uint32_t* corners = triangles.getCorners();
+
+	for (size_t v = first; v < first + count; ++v)
+	{
+		float n[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i)
+		{
+			const float3& faceNormal = faceNormals[corners[i] / 3];
+			n[0] += faceNormal[0];
+			n[1] += faceNormal[1];
+			n[2] += faceNormal[2];
+		}
+
+		const float lengthSquared = dot(n, n);
+		if (lengthSquared > 0.0f)
+		{
+			const float k = 1.0f / sqrtf(lengthSquared);
+			normals[v][0] = n[0] * k;
+			normals[v][1] = n[1] * k;
+			normals[v][2] = n[2] * k;
+		}
+		else
+		{
+			normals[v][0] = 0.0f;
+			normals[v][1] = 0.0f;
+			normals[v][2] = 1.0f;
+		}
+	}
+}
+
+void computeFaceTangents(const VertexTriangles& triangles, const float3* points, const float2* uvs, size_t first, size_t count
+	, float3* faceTangents, float3* faceBitangents)
+{
+	assert(first + count <= triangles.getTriangleCount());
+	const uint32_t* tri = triangles.getTriangles();
+
+	for (size_t t = first; t < first + count; ++t)
+	{
+		const uint32_t v0 = tri[3 * t + 0];
+		const uint32_t v1 = tri[3 * t + 1];
+		const uint32_t v2 = tri[3 * t + 2];
+
+		float e1[3], e2[3];
+		sub(points[v1], points[v0], e1);
+		sub(points[v2], points[v0], e2);
+		const float du1 = uvs[v1][0] - uvs[v0][0];
+		const float dv1 = uvs[v1][1] - uvs[v0][1];
+		const float du2 = uvs[v2][0] - uvs[v0][0];
+		const float dv2 = uvs[v2][1] - uvs[v0][1];
+
+		// Twice the signed uv area, its sign is the handedness of the uv space (ORIENT_PRESERVING in mikktspace).
+		const float signedArea = du1 * dv2 - dv1 * du2;
+		const float s = signedArea > 0.0f ? 1.0f : (signedArea < 0.0f ? -1.0f : 0.0f);
+		for (int c = 0; c < 3; ++c)
+		{
+			faceTangents[t][c] = (dv2 * e1[c] - dv1 * e2[c]) * s;
+			faceBitangents[t][c] = (du1 * e2[c] - du2 * e1[c]) * s;
+		}
+	}
+}
+
+void computeVertexTangents(const VertexTriangles& triangles, const float3* points, const float3* normals
+	, const float3* faceTangents, const float3* faceBitangents, size_t first, size_t count, float4* tangents)
+{
+	assert(first + count <= triangles.getVertexCount());
+	const uint32_t* tri = triangles.getTriangles();
+	const uint32_t* offsets = triangles.getCornerOffsets();
+	const uint32_t* corners = triangles.getCorners();
+
+	for (size_t v = first; v < first + count; ++v)
+	{
+		const float* n = &normals[v][0];
+		float sumT[3] = { 0.0f, 0.0f, 0.0f };
+		float sumB[3] = { 0.0f, 0.0f, 0.0f };
+
+		for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i)
+		{
+			const uint32_t corner = corners[i];
+			const uint32_t t = corner / 3;
+			const uint32_t k = corner % 3;
+
+			float faceT[3], faceB[3];
+			if (!projectAndNormalise(n, &faceTangents[t][0], faceT))
+			{
+				continue;
+			}
+			const bool hasB = projectAndNormalise(n, &faceBitangents[t][0], faceB);
+
+			// Angle of the corner, between its edges projected on the plane of the normal.
+			float edge1[3], edge2[3], d1[3], d2[3];
+			sub(points[tri[3 * t + (k + 1) % 3]], points[v], edge1);
+			sub(points[tri[3 * t + (k + 2) % 3]], points[v], edge2);
+			if (!projectAndNormalise(n, edge1, d1) || !projectAndNormalise(n, edge2, d2))
+			{
+				continue;
+			}
+			const float angle = approximateAcos(dot(d1, d2));
+
+			for (int c = 0; c < 3; ++c)
+			{
+				sumT[c] += faceT[c] * angle;
+				sumB[c] += hasB ? faceB[c] * angle : 0.0f;
+			}
+		}
+
+		float tangent[3];
+		if (!projectAndNormalise(n, sumT, tangent))
+		{
+			getPerpendicular(n, tangent);
+		}
+
+		// Bitangents are cross(normal, tangent) * w.
+		float bitangent[3];
+		cross(n, tangent, bitangent);
+		tangents[v][0] = tangent[0];
+		tangents[v][1] = tangent[1];
+		tangents[v][2] = tangent[2];
+		tangents[v][3] = dot(bitangent, sumB) < 0.0f ? -1.0f : 1.0f;
+	}
+}
+
+} // namespace nvc
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Plugin/Foundation/Types.h"
+#include "Plugin/GeomCacheData.h"
+
+namespace nvc {
+
+// The triangles around each vertex of a frame, from the triangle submeshes of every mesh, for rebuilding normals
+// and tangents a vertex at a time: vertex ranges are independent and can be reconstructed in parallel.
+class VertexTriangles
+{
+public:
+	// Rebuilds the table unless data has the topology it was last built from.
+	// Returns false if data has no triangles (or invalid ones), the table is then empty.
+	bool update(const GeomCacheData& data);
+	void clear();
+
+	size_t getVertexCount() const { return m_VertexCount; }
+	size_t getTriangleCount() const { return m_Triangles.size() / 3; }
+
+	// Vertices of each triangle, offset by their mesh's vertexOffset.
+	const uint32_t* getTriangles() const { return m_Triangles.data(); }
+
+	// Corners (3 * triangle + 0, 1 or 2) of vertex v are getCorners()[getCornerOffsets()[v], getCornerOffsets()[v + 1]).
+	const uint32_t* getCornerOffsets() const { return m_CornerOffsets.data(); }
+	const uint32_t* getCorners() const { return m_Corners.data(); }
+
+private:
+	bool isSameTopology(const GeomCacheData& data) const;
+
+	size_t m_VertexCount = 0;
+	std::vector<uint32_t> m_Triangles;
+	std::vector<uint32_t> m_CornerOffsets;
+	std::vector<uint32_t> m_Corners;
+
+	// Topology the table was built from.
+	std::vector<int32_t> m_Indices;
+	std::vector<GeomMesh> m_Meshes;
+	std::vector<GeomSubmesh> m_Submeshes;
+};
+
+// Cross product of the edges of triangles [first, first + count), twice their area along their normal.
+// Dispatched like the decode kernels of PackedTransform.h, every SIMD level gives the same results.
+void computeFaceNormals(const VertexTriangles& triangles, const float3* points, size_t first, size_t count, float3* faceNormals);
+
+// Area weighted normals of vertices [first, first + count): the normalised sum of the face normals around each.
+// Vertices without a triangle of non zero area get +Z.
+void computeVertexNormals(const VertexTriangles& triangles, const float3* faceNormals, size_t first, size_t count, float3* normals);
+
+// Directions of increasing u (tangent) and v (bitangent) across triangles [first, first + count), unnormalised
+// and flipped with the uv winding as in MikkTSpace. Zero for triangles with degenerate uvs.
+void computeFaceTangents(const VertexTriangles& triangles, const float3* points, const float2* uvs, size_t first, size_t count
+	, float3* faceTangents, float3* faceBitangents);
+
+// Tangents of vertices [first, first + count) following MikkTSpace: the face tangents projected on the plane of the
+// vertex normal, normalised, and summed weighted by the corner angle; w is the handedness of the uv space.
+// Unlike mikktspace the vertices aren't split where the handedness or the smoothing changes, the existing vertex
+// split is kept. Vertices without a usable face tangent get one perpendicular to their normal.
+void computeVertexTangents(const VertexTriangles& triangles, const float3* points, const float3* normals
+	, const float3* faceTangents, const float3* faceBitangents, size_t first, size_t count, float4* tangents);
+
+} // namespace nvc
@@ -0,0 +1,167 @@
+//! PrecompiledHeader Include.
+#include "Plugin/PrecompiledHeader.h"
+
+//! Header Include.
+#include "VertexOrder.h"
+
+namespace nvc {
+
+void optimizeTriangleOrder(const int32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize, int32_t* dst)
+{
+	const size_t triangleCount = indexCount / 3;
+
+	// The triangles using each vertex, and how many of them aren't emitted yet.
+	std::vector<uint32_t> liveCounts(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		assert(indices[i] >= 0 && static_cast<size_t>(indices[i]) < vertexCount);
+		++liveCounts[indices[i]];
+	}
+
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		offsets[v + 1] = offsets[v] + liveCounts[v];
+	}
+
+	std::vector<uint32_t> triangles(triangleCount * 3);
+	{
+		std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+		{
+			triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	// A vertex is in the cache while fewer than cacheSize vertices entered it after it.
+	std::vector<size_t> cacheTimes(vertexCount, 0);
+	size_t time = cacheSize + 1;
+
+	std::vector<uint8_t> isEmitted(triangleCount, 0);
+	std::vector<int32_t> deadEnds;
+	std::vector<int32_t> candidates;
+	size_t nextVertex = 0;
+	size_t dstCount = 0;
+
+	int32_t fan = -1;
+	for (;;)
+	{
+		if (fan < 0)
+		{
+			// Dead end: back to a recently used vertex with triangles left, else the next one in order.
+			while (!deadEnds.empty() && fan < 0)
+			{
+				if (liveCounts[deadEnds.back()] > 0)
+				{
+					fan = deadEnds.back();
+				}
+				deadEnds.pop_back();
+			}
+			for (; nextVertex < vertexCount && fan < 0; ++nextVertex)
+			{
+				if (liveCounts[nextVertex] > 0)
+				{
+					fan = static_cast<int32_t>(nextVertex);
+				}
+			}
+			if (fan < 0)
+			{
+				break;
+			}
+		}
+
+		// Emit the fan's triangles left.
+		candidates.clear();
+		for (uint32_t k = offsets[fan]; k < offsets[fan + 1]; ++k)
+		{
+			const uint32_t triangle = triangles[k];
+			if (isEmitted[triangle])
+			{
+				continue;
+			}
+			isEmitted[triangle] = 1;
+
+			for (size_t j = 0; j < 3; ++j)
+			{
+				const int32_t v = indices[triangle * 3 + j];
+				dst[dstCount++] = v;
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				--liveCounts[v];
+				if (time - cacheTimes[v] > cacheSize)
+				{
+					cacheTimes[v] = time++;
+				}
+			}
+		}
+
+		// The next fan is the oldest vertex just used which stays cached while its triangles are emitted.
+		fan = -1;
+		size_t bestPriority = 0;
+		for (int32_t v : candidates)
+		{
+			if (liveCounts[v] == 0)
+			{
+				continue;
+			}
+			const size_t age = time - cacheTimes[v];
+			const size_t priority = age + 2 * liveCounts[v] <= cacheSize ? age : 0;
+			if (fan < 0 || priority > bestPriority)
+			{
+				fan = v;
+				bestPriority = priority;
+			}
+		}
+	}
+
+	assert(dstCount == triangleCount * 3);
+	std::copy(indices + triangleCount * 3, indices + indexCount, dst + triangleCount * 3);
+}
+
+void buildVertexFetchRemap(const int32_t* indices, size_t indexCount, size_t vertexCount, uint32_t* remap)
+{
+	const uint32_t Unused = ~0u;
+	std::fill(remap, remap + vertexCount, Unused);
+
+	uint32_t next = 0;
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		assert(indices[i] >= 0 && static_cast<size_t>(indices[i]) < vertexCount);
+		if (remap[indices[i]] == Unused)
+		{
+			remap[indices[i]] = next++;
+		}
+	}
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] == Unused)
+		{
+			remap[v] = next++;
+		}
+	}
+}
+
+float getCacheMissRatio(const int32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return 0.0f;
+	}
+
+	std::vector<size_t> cacheTimes(vertexCount, 0);
+	size_t time = cacheSize + 1;
+	size_t missCount = 0;
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		const int32_t v = indices[i];
+		if (time - cacheTimes[v] > cacheSize)
+		{
+			cacheTimes[v] = time++;
+			++missCount;
+		}
+	}
+	return static_cast<float>(missCount) / triangleCount;
+}
+
+} // namespace nvc
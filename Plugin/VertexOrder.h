@@ -0,0 +1,21 @@
+#pragma once
+
+namespace nvc {
+
+// Size of the post-transform vertex cache the triangle order is optimised for.
+static const size_t DefaultVertexCacheSize = 16;
+
+// Reorders the triangles of indices[indexCount] (a triangle list referencing vertices [0, vertexCount)) for a
+// post-transform cache of cacheSize vertices, into dst. Tipsify (Sander, Nehab and Barczak, 2007): triangles are
+// emitted in fans around a vertex, the next one chosen among the vertices just used which will still be cached
+// when their remaining triangles are emitted. Linear in the index count. Triangles keep their winding.
+void optimizeTriangleOrder(const int32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize, int32_t* dst);
+
+// Numbers the vertices in order of first use in indices[indexCount], unused ones last in their order:
+// remap[vertex] is the new index of vertex, so the vertex buffer is read forwards when drawing.
+void buildVertexFetchRemap(const int32_t* indices, size_t indexCount, size_t vertexCount, uint32_t* remap);
+
+// Average vertex transforms per triangle through a FIFO cache of cacheSize vertices, between 0.5 and 3.
+float getCacheMissRatio(const int32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize);
+
+} // namespace nvc
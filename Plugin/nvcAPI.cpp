@@ -3,6 +3,11 @@
 #include "Plugin/OutputGeomCache.h"
 #include "Plugin/GeomCache.h"
 #include "Plugin/nvcAPI.h"
+#include "Plugin/Stream/FileStream.h"
+#include "Plugin/Compression/NullCompressor.h"
+#include "Plugin/Compression/QuantisationCompressor.h"
+#include "Plugin/Compression/TemporalCompressor.h"
+#include "Plugin/Compression/PcaCompressor.h"
 
 
 nvcAPI nvc::InputGeomCache* nvcIGCCreate(const nvc::GeomCacheDesc *descs, const nvc::InputGeomCacheConstantData* constants)
@@ -25,6 +30,19 @@ nvcAPI void nvcIGCAClearData(nvc::InputGeomCache * self)
         self->clearData();
     }
 }
+nvcAPI void nvcIGCOptimizeVertexOrder(nvc::InputGeomCache *self)
+{
+    if (self) {
+        self->optimizeVertexOrder();
+    }
+}
+nvcAPI int nvcIGCRemoveAttribute(nvc::InputGeomCache *self, const char *semantic)
+{
+    if (self && semantic) {
+        return self->removeAttribute(semantic);
+    }
+    return false;
+}
 
 nvcAPI nvc::InputGeomCacheConstantData* nvcIGCCreateConstantData()
 {
@@ -42,6 +60,105 @@ nvcAPI int nvcIGCAddConstantDataString(nvc::InputGeomCacheConstantData* self, co
 	return -1;
 }
 
+nvcAPI int nvcIGCExport(nvc::InputGeomCache *self, const char *path, nvc::CompressionType type, const nvc::QuantisationSettings *settings, nvc::QuantisationReport *report)
+{
+    if (!self || !path) {
+        return false;
+    }
+
+    if (report) {
+        *report = {};
+    }
+
+    FileStream fs{ path, FileStream::OpenModes::Random_ReadWrite };
+    if (!fs.canWrite()) {
+        return false;
+    }
+
+    bool ret = false;
+    switch (type) {
+    case nvc::CompressionType::Quantize:
+    {
+        nvc::QuantisationCompressor qc{ false, settings ? *settings : nvc::QuantisationSettings{} };
+        ret = qc.compress(*self, &fs);
+        if (report) {
+            *report = qc.getReport();
+        }
+        break;
+    }
+    case nvc::CompressionType::Temporal:
+    {
+        nvc::TemporalCompressor tc{};
+        ret = tc.compress(*self, &fs);
+        break;
+    }
+    case nvc::CompressionType::Pca:
+    {
+        nvc::PcaCompressor pc{};
+        ret = pc.compress(*self, &fs);
+        break;
+    }
+    default:
+    {
+        nvc::NullCompressor nc{};
+        ret = nc.compress(*self, &fs);
+        break;
+    }
+    }
+    return ret;
+}
+
+namespace nvc {
+// The file and the compression of nvcQCBegin().
+struct QuantisationExport
+{
+    QuantisationExport(const char *path, const QuantisationSettings& settings)
+        : Stream{ path, FileStream::OpenModes::Random_ReadWrite }
+        , Compressor{ false, settings }
+    {}
+
+    FileStream Stream;
+    QuantisationCompressor Compressor;
+};
+} // namespace nvc
+
+nvcAPI nvc::QuantisationExport* nvcQCBegin(const char *path, const nvc::GeomCacheDesc *descs, const nvc::InputGeomCacheConstantData* constants, int frameCount, const nvc::QuantisationSettings *settings)
+{
+    if (!path || !descs || frameCount < 0) {
+        return nullptr;
+    }
+
+    auto *self = new nvc::QuantisationExport(path, settings ? *settings : nvc::QuantisationSettings{});
+    if (!self->Stream.canWrite()) {
+        delete self;
+        return nullptr;
+    }
+    self->Compressor.begin(descs, constants ? *constants : nvc::InputGeomCacheConstantData{}, (size_t)frameCount, &self->Stream);
+    return self;
+}
+
+nvcAPI int nvcQCAddFrame(nvc::QuantisationExport *self, float time, const nvc::GeomCacheData *data)
+{
+    if (!self || !data) {
+        return false;
+    }
+    return self->Compressor.addFrame(time, *data);
+}
+
+nvcAPI int nvcQCFinish(nvc::QuantisationExport *self, nvc::QuantisationReport *report)
+{
+    if (!self) {
+        return false;
+    }
+
+    const bool ret = self->Compressor.finish();
+    if (report) {
+        *report = self->Compressor.getReport();
+    }
+    delete self;
+    return ret;
+}
+
 
 nvcAPI nvc::OutputGeomCache* nvcOGCCreate()
 {
@@ -159,6 +276,13 @@ nvcAPI int nvcGCOpen(nvc::GeomCache *self, const char *path)
     return false;
 }
 
+nvcAPI void nvcGCSetCacheBudget(nvc::GeomCache *self, uint64_t bytes)
+{
+    if (self) {
+        self->setCacheBudget(static_cast<size_t>(bytes));
+    }
+}
+
 nvcAPI void nvcGCClose(nvc::GeomCache *self)
 {
     if (self) {
@@ -173,6 +297,28 @@ nvcAPI void nvcGCSetCurrentTime(nvc::GeomCache *self, float time)
     }
 }
 
+nvcAPI void nvcGCSetAsyncPrefetch(nvc::GeomCache *self, int enable)
+{
+    if (self) {
+        self->setAsyncPrefetch(enable != 0);
+    }
+}
+
+nvcAPI void nvcGCSetPrefetchLookAhead(nvc::GeomCache *self, int frames, float seconds)
+{
+    if (self && frames >= 0) {
+        self->setPrefetchLookAhead(static_cast<size_t>(frames), seconds);
+    }
+}
+
+nvcAPI void nvcGCSetReconstruction(nvc::GeomCache *self, int normals, int tangents)
+{
+    if (self) {
+        self->setReconstructNormals(normals != 0);
+        self->setReconstructTangents(tangents != 0);
+    }
+}
+
 nvcAPI int nvcGCGetCurrentCache(nvc::GeomCache *self, nvc::OutputGeomCache *ogc)
 {
     if (self && ogc) {
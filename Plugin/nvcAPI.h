@@ -20,17 +20,36 @@ class InputGeomCache;
 class OutputGeomCache;
 class GeomCache;
 struct InputGeomCacheConstantData;
+struct QuantisationSettings;
+struct QuantisationReport;
+struct QuantisationExport;
 } // namespace nvc
 
 nvcAPI nvc::InputGeomCache* nvcIGCCreate(const nvc::GeomCacheDesc *descs, const nvc::InputGeomCacheConstantData* constants = nullptr);
 nvcAPI void nvcIGCRelease(nvc::InputGeomCache *self);
 nvcAPI void nvcIGCAddData(nvc::InputGeomCache *self, float time, const nvc::GeomCacheData *data);
 nvcAPI void nvcIGCAClearData(nvc::InputGeomCache *self);
+// reorders the triangles and vertices of every frame for the vertex cache (see InputGeomCache::optimizeVertexOrder()).
+nvcAPI void nvcIGCOptimizeVertexOrder(nvc::InputGeomCache *self);
+// drops an attribute of every frame, false if there's none with that semantic.
+nvcAPI int  nvcIGCRemoveAttribute(nvc::InputGeomCache *self, const char *semantic);
 
 nvcAPI nvc::InputGeomCacheConstantData* nvcIGCCreateConstantData();
 nvcAPI void nvcIGCReleaseConstantData(nvc::InputGeomCacheConstantData* self);
 nvcAPI int nvcIGCAddConstantDataString(nvc::InputGeomCacheConstantData* self, const char* str);
 
+// compress to a file, false if it can't be written. settings and report (both optional) are for CompressionType::Quantize.
+// note: nvcGCOpen() picks the decompressor from the file name, so it has to contain "quantisation", "temporal" or
+//       "pca" for the Quantize, Temporal and Pca types respectively (and none of them for Null).
+nvcAPI int  nvcIGCExport(nvc::InputGeomCache *self, const char *path, nvc::CompressionType type, const nvc::QuantisationSettings *settings, nvc::QuantisationReport *report);
+
+// quantised compression to a file a frame at a time, without an InputGeomCache (see QuantisationCompressor::begin()).
+// nvcQCFinish() writes the file's tables and releases self, it fails unless frameCount frames were added.
+// the file name has to contain "quantisation" to be reopened (see nvcIGCExport()).
+nvcAPI nvc::QuantisationExport* nvcQCBegin(const char *path, const nvc::GeomCacheDesc *descs, const nvc::InputGeomCacheConstantData* constants, int frameCount, const nvc::QuantisationSettings *settings);
+nvcAPI int  nvcQCAddFrame(nvc::QuantisationExport *self, float time, const nvc::GeomCacheData *data);
+nvcAPI int  nvcQCFinish(nvc::QuantisationExport *self, nvc::QuantisationReport *report);
+
 nvcAPI nvc::OutputGeomCache* nvcOGCCreate();
 nvcAPI void nvcOGCRelease(nvc::OutputGeomCache *self);
 nvcAPI int  nvcOGCGetMeshCount(nvc::OutputGeomCache *self);
@@ -50,8 +69,13 @@ nvcAPI int  nvcOGCCopyColors(nvc::OutputGeomCache *self, const nvc::GeomMesh *gm
 nvcAPI nvc::GeomCache* nvcGCCreate();
 nvcAPI void nvcGCRelease(nvc::GeomCache *self);
 nvcAPI int  nvcGCOpen(nvc::GeomCache *self, const char *path);
+nvcAPI void nvcGCSetCacheBudget(nvc::GeomCache *self, uint64_t bytes);
 nvcAPI void nvcGCClose(nvc::GeomCache *self);
 nvcAPI void nvcGCSetCurrentTime(nvc::GeomCache *self, float time);
+nvcAPI void nvcGCSetAsyncPrefetch(nvc::GeomCache *self, int enable);
+nvcAPI void nvcGCSetPrefetchLookAhead(nvc::GeomCache *self, int frames, float seconds);
+// rebuilds the normals and tangents missing from the file, off by default (see GeomCache::setReconstructNormals()).
+nvcAPI void nvcGCSetReconstruction(nvc::GeomCache *self, int normals, int tangents);
 nvcAPI int  nvcGCGetCurrentCache(nvc::GeomCache *self, nvc::OutputGeomCache *ogc);
 nvcAPI int  nvcGCGetConstantDataStringSize(nvc::GeomCache *self);
 nvcAPI const char*  nvcGCGetConstantDataString(nvc::GeomCache *self, int index);
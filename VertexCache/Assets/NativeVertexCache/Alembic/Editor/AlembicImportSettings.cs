@@ -31,10 +31,21 @@ namespace NaiveVertexCache.Alembic
         [SerializeField] public bool importCameras = true;
         [SerializeField] public bool importMeshes = true;
         [SerializeField] public bool importPoints = true;
+        [SerializeField] public bool optimizeVertexOrder = false;
 
 
         [SerializeField] public CompressionType compressionType = CompressionType.Quantize;
         [SerializeField] public int blockSize = 30;
+        [SerializeField] public int pointBits = 16;
+        [SerializeField] public int velocityBits = 16;
+        [SerializeField] public int normalBits = 16;
+        [SerializeField] public int tangentBits = 16;
+        [SerializeField] public int uvBits = 16;
+        [SerializeField] public float pointTolerance = 0.0f;
+        [SerializeField] public int boundsBlockSize = 0;
+        [SerializeField] public bool omitNormals = false;
+        [SerializeField] public bool omitTangents = false;
+        [SerializeField] public bool streamFrames = false;
 
         public AlembicImportOptions GetAlembicImportOptions()
         {
@@ -50,6 +61,7 @@ namespace NaiveVertexCache.Alembic
                 import_line_polygon = importLinePolygon,
                 import_triangle_polygon = importTrianglePolygon,
                 import_points = importPoints,
+                optimize_vertex_order = optimizeVertexOrder,
             };
         }
 
@@ -58,6 +70,16 @@ namespace NaiveVertexCache.Alembic
             return new NvcExportOptions {
                 compression_type = compressionType,
                 block_size = blockSize,
+                point_bits = pointBits,
+                velocity_bits = velocityBits,
+                normal_bits = normalBits,
+                tangent_bits = tangentBits,
+                uv_bits = uvBits,
+                point_tolerance = pointTolerance,
+                bounds_block_size = boundsBlockSize,
+                omit_normals = omitNormals,
+                omit_tangents = omitTangents,
+                stream_frames = streamFrames,
             };
         }
     }
@@ -90,6 +90,8 @@ namespace NaiveVertexCache.Alembic
                 DisplayEnumProperty(serializedObject.FindProperty(pathAbcSettings + "normals"), Enum.GetNames(typeof(NormalsMode)));
                 DisplayEnumProperty(serializedObject.FindProperty(pathAbcSettings + "tangents"), Enum.GetNames(typeof(TangentsMode)));
                 EditorGUILayout.PropertyField(serializedObject.FindProperty(pathAbcSettings + "flipFaces"));
+                EditorGUILayout.PropertyField(serializedObject.FindProperty(pathAbcSettings + "optimizeVertexOrder"),
+                    new GUIContent("Optimize Vertex Order", "Reorder triangles and vertices for the GPU vertex cache, which also helps compression."));
                 EditorGUI.indentLevel--;
             }
             EditorGUILayout.Separator();
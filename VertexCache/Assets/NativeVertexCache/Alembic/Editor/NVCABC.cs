@@ -50,6 +50,7 @@ namespace NaiveVertexCache.Alembic
 
         // followings are extended options for nvcabc
         public Bool import_points;
+        public Bool optimize_vertex_order;
 
         public static AlembicImportOptions default_value {
             get
@@ -75,6 +76,7 @@ namespace NaiveVertexCache.Alembic
                     import_line_polygon = true,
                     import_triangle_polygon = true,
                     import_points = true,
+                    optimize_vertex_order = false,
                 };
             }
         }
@@ -87,6 +89,23 @@ namespace NaiveVertexCache.Alembic
         public CompressionType compression_type;
         public int block_size;
 
+        // quantisation precision in bits per component, 1 to 16
+        public int point_bits;
+        public int velocity_bits;
+        public int normal_bits;
+        public int tangent_bits;
+        public int uv_bits;
+        // if > 0, points get the fewest bits keeping them within this world space distance (point_bits is ignored)
+        public float point_tolerance;
+        // points and velocities are quantised per mesh, or per block of this many vertices of a mesh if > 0
+        public int bounds_block_size;
+        // leave normals (and tangents) out of the file, they're reconstructed from the points when playing
+        public Bool omit_normals;
+        public Bool omit_tangents;
+        // with Quantize, compress each sample as it's read: memory stays bounded by a seek window, but the file
+        // can't share the topology or the constant vertices of the sequence
+        public Bool stream_frames;
+
         public static NvcExportOptions default_value
         {
             get
@@ -95,11 +114,39 @@ namespace NaiveVertexCache.Alembic
                 {
                     compression_type = CompressionType.Quantize,
                     block_size = 30,
+                    point_bits = 16,
+                    velocity_bits = 16,
+                    normal_bits = 16,
+                    tangent_bits = 16,
+                    uv_bits = 16,
+                    point_tolerance = 0.0f,
+                    bounds_block_size = 0,
+                    omit_normals = false,
+                    omit_tangents = false,
+                    stream_frames = false,
                 };
             }
         }
     };
 
+    // achieved quantisation error of an attribute over all frames
+    public struct NvcAttributeError
+    {
+        public int bits; // 0 if the attribute isn't stored
+        public float max_error;
+        public float rms_error;
+    };
+
+    public struct NvcExportReport
+    {
+        public NvcAttributeError points;
+        public NvcAttributeError velocities;
+        public NvcAttributeError normals;
+        public NvcAttributeError tangents;
+        public NvcAttributeError uv0;
+        public NvcAttributeError uv1;
+    };
+
     public struct XformData
     {
         public float time;
@@ -136,7 +183,8 @@ namespace NaiveVertexCache.Alembic
         public void Release() { nvcabcReleaseContext(self); self = IntPtr.Zero; }
         public bool Open(string path_to_abc, ref AlembicImportOptions opt) { return nvcabcOpen(self, path_to_abc, ref opt); }
 
-        public bool ExportNVC(string path_to_nvc, ref NvcExportOptions opt) { return nvcabcExportNVC(self, path_to_nvc, ref opt); }
+        public bool ExportNVC(string path_to_nvc, ref NvcExportOptions opt) { NvcExportReport report; return nvcabcExportNVC(self, path_to_nvc, ref opt, out report); }
+        public bool ExportNVC(string path_to_nvc, ref NvcExportOptions opt, out NvcExportReport report) { return nvcabcExportNVC(self, path_to_nvc, ref opt, out report); }
 
         public int nodeCount { get { return nvcabcGetNodeCount(self); } }
         public string GetNodeName(int i) { return Misc.S(nvcabcGetNodeName(self, i)); }
@@ -151,7 +199,7 @@ namespace NaiveVertexCache.Alembic
         [DllImport("AlembicToGeomCache")] static extern void nvcabcReleaseContext(IntPtr self);
         [DllImport("AlembicToGeomCache")] static extern bool nvcabcOpen(IntPtr self, string path_to_abc, ref AlembicImportOptions opt);
 
-        [DllImport("AlembicToGeomCache")] static extern bool nvcabcExportNVC(IntPtr self, string path_to_nvc, ref NvcExportOptions opt);
+        [DllImport("AlembicToGeomCache")] static extern bool nvcabcExportNVC(IntPtr self, string path_to_nvc, ref NvcExportOptions opt, out NvcExportReport report);
 
         [DllImport("AlembicToGeomCache")] static extern int nvcabcGetNodeCount(IntPtr self);
         [DllImport("AlembicToGeomCache")] static extern IntPtr nvcabcGetNodeName(IntPtr self, int i);
@@ -10,6 +10,9 @@ namespace NaiveVertexCache
     {
         [SerializeField] string m_path;
         [SerializeField] float m_time;
+        // rebuild the normals and tangents of files exported without them, at a cost per frame
+        [SerializeField] bool m_reconstructNormals = false;
+        [SerializeField] bool m_reconstructTangents = false;
         float m_timePrev = float.MinValue;
 
         PinnedList<int>     m_indices = new PinnedList<int>();
@@ -35,6 +38,7 @@ namespace NaiveVertexCache
             if (!m_gc && m_path != null && m_path.Length > 0)
             {
                 m_gc = GeomCache.Create();
+                m_gc.SetReconstruction(m_reconstructNormals, m_reconstructTangents);
                 if (!m_gc.Open(m_path))
                 {
                     CloseNVC();
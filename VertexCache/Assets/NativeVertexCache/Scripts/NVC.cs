@@ -33,6 +33,8 @@ namespace NaiveVertexCache
     {
         Null,
         Quantize,
+        Temporal,
+        Pca,
     };
 
     public enum Topology
@@ -190,8 +192,12 @@ namespace NaiveVertexCache
 
         public bool Open(string path) { return nvcGCOpen(self, path); }
         public void Close() { nvcGCClose(self); }
+        public ulong cacheBudget { set { nvcGCSetCacheBudget(self, value); } }
 
         public float time { set { nvcGCSetCurrentTime(self, value); } }
+        public bool asyncPrefetch { set { nvcGCSetAsyncPrefetch(self, value ? 1 : 0); } }
+        public void SetPrefetchLookAhead(int frames, float seconds) { nvcGCSetPrefetchLookAhead(self, frames, seconds); }
+        public void SetReconstruction(bool normals, bool tangents) { nvcGCSetReconstruction(self, normals ? 1 : 0, tangents ? 1 : 0); }
         public bool Assign(OutputGeomCache ogc) { return nvcGCGetCurrentCache(self, ogc); }
 
         public string GetPath(int meshIndex) { return Misc.S(nvcGCGetConstantDataString(self, meshIndex)); }
@@ -200,8 +206,12 @@ namespace NaiveVertexCache
         [DllImport("NativeVertexCache")] static extern GeomCache nvcGCCreate();
         [DllImport("NativeVertexCache")] static extern void nvcGCRelease(IntPtr self);
         [DllImport("NativeVertexCache")] static extern bool nvcGCOpen(IntPtr self, string path);
+        [DllImport("NativeVertexCache")] static extern void nvcGCSetCacheBudget(IntPtr self, ulong bytes);
         [DllImport("NativeVertexCache")] static extern void nvcGCClose(IntPtr self);
         [DllImport("NativeVertexCache")] static extern void nvcGCSetCurrentTime(IntPtr self, float time);
+        [DllImport("NativeVertexCache")] static extern void nvcGCSetAsyncPrefetch(IntPtr self, int enable);
+        [DllImport("NativeVertexCache")] static extern void nvcGCSetPrefetchLookAhead(IntPtr self, int frames, float seconds);
+        [DllImport("NativeVertexCache")] static extern void nvcGCSetReconstruction(IntPtr self, int normals, int tangents);
         [DllImport("NativeVertexCache")] static extern bool nvcGCGetCurrentCache(IntPtr self, OutputGeomCache ogc);
 
         [DllImport("NativeVertexCache")] static extern int nvcGCGetConstantDataStringSize(IntPtr self);